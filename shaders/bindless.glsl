@@ -0,0 +1,72 @@
+// 全局 bindless descriptor set (set 0)，和 BindlessHeap 的绑定一一对应
+// 非片段着色器 (计算 / 顶点 / task / mesh) 在 include 之前定义 BINDLESS_RESOURCES_ONLY：
+// 只要资源声明，不要用到 gl_FragCoord / 导数的材质采样
+#extension GL_EXT_nonuniform_qualifier : require
+
+struct Material {
+	vec4 baseColor;     // 颜色倍增
+	uint textureIndex;  // textures[] 下标，0xFFFFFFFF 表示没有贴图
+	uint samplerIndex;  // samplers[] 下标
+	uint virtualTexture; // 虚拟纹理页表在 uintBuffers[] 里的下标，0xFFFFFFFF 表示不用
+	uint pad0;
+};
+
+// 每帧的场景数据，和 vk_types.h 里的 GPUSceneData 一致
+const uint MAX_SHADOW_CASCADES = 4;
+struct SceneData {
+	mat4 invViewProj;
+	vec4 lightDirection;  // xyz 光传播的方向，w 阴影里剩下的亮度
+	vec2 renderExtent;
+	uint cascadeCount;
+	uint shadowSampler;
+	mat4 cascadeViewProj[MAX_SHADOW_CASCADES];
+	uint shadowTextures[MAX_SHADOW_CASCADES];
+	vec4 shadowParams;    // x: 一个纹素的 UV 大小
+	uvec4 clusterGrid;    // xyz: froxel 格子数，w: 光源数
+	vec4 clusterDepth;    // x: near，y: far，z / w: slice = log(depth) * z + w
+	vec4 clusterProjection; // xy: 半视角的正切
+	uvec4 clusterBuffers; // buffers[] 下标：x 光源表，y 格子表 (offset, count)，z 下标表，w 下标计数
+};
+
+// 点光源，和 vk_clustered_lights.h 里的 GPUPointLight 一致
+struct PointLight {
+	vec4 positionRadius;  // xyz 相机空间位置，w 影响半径
+	vec4 colorIntensity;
+};
+
+const uint INVALID_INDEX = 0xFFFFFFFFu;
+
+layout (set = 0, binding = 0) uniform texture2D textures[];
+layout (set = 0, binding = 1) uniform sampler samplers[];
+layout (set = 0, binding = 2) buffer UintBuffer {
+	uint data[];
+} uintBuffers[];
+layout (set = 0, binding = 3) readonly buffer MaterialTable {
+	Material materials[];
+} materialTable;
+layout (set = 0, binding = 4) readonly buffer SceneBuffer {
+	SceneData scene;
+} sceneData;
+// 全局 buffers[] (binding 2) 的视图：光源表
+layout (set = 0, binding = 2) readonly buffer PointLightBuffer {
+	PointLight lights[];
+} pointLights[];
+
+#ifndef BINDLESS_RESOURCES_ONLY
+#include "virtual_texture.glsl"
+#include "shadows.glsl"
+#include "clustered_lights.glsl"
+
+vec4 sample_material(uint materialIndex, vec2 uv)
+{
+	Material m = materialTable.materials[nonuniformEXT(materialIndex)];
+	vec4 color = m.baseColor;
+	if (m.virtualTexture != INVALID_INDEX) {
+		color *= sample_virtual(m.virtualTexture, uv);
+	}
+	if (m.textureIndex != INVALID_INDEX) {
+		color *= texture(sampler2D(textures[nonuniformEXT(m.textureIndex)], samplers[nonuniformEXT(m.samplerIndex)]), uv);
+	}
+	return color;
+}
+#endif
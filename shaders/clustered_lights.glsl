@@ -0,0 +1,57 @@
+// 分簇的点光源 (bindless.glsl 在片段着色器里 include)
+// froxel 的光源列表由 light_cluster.comp 每帧生成；相机空间位置由深度和 gl_FragCoord 还原，顶点着色器不用改
+
+vec3 fragment_view_position()
+{
+	SceneData scene = sceneData.scene;
+	vec2 ndc = gl_FragCoord.xy / scene.renderExtent * 2.0 - 1.0;
+	float n = scene.clusterDepth.x;
+	float f = scene.clusterDepth.y;
+	// 深度 0..1 的透视投影反解出到相机平面的距离
+	float depth = n * f / (f - gl_FragCoord.z * (f - n));
+	// 投影翻转了 Y：NDC 的 y 向下，相机空间 y 向上
+	return vec3(ndc.x * scene.clusterProjection.x * depth, -ndc.y * scene.clusterProjection.y * depth, -depth);
+}
+
+// 所有点光源照到这个片段的光 (相机空间)
+vec3 clustered_lighting(vec3 viewPosition)
+{
+	// 法线取屏幕空间导数 (面法线)，必须在分支之前算；朝向相机的一面
+	vec3 normal = normalize(cross(dFdx(viewPosition), dFdy(viewPosition)));
+	if (dot(normal, viewPosition) > 0.0) {
+		normal = -normal;
+	}
+
+	SceneData scene = sceneData.scene;
+	uint lightCount = scene.clusterGrid.w;
+	if (lightCount == 0) {
+		return vec3(0.0);
+	}
+
+	uvec3 grid = scene.clusterGrid.xyz;
+	uvec2 tile = min(uvec2(gl_FragCoord.xy / scene.renderExtent * vec2(grid.xy)), grid.xy - 1u);
+	float slice = log(-viewPosition.z) * scene.clusterDepth.z + scene.clusterDepth.w;
+	uint cluster = tile.x + (tile.y + uint(clamp(slice, 0.0, float(grid.z - 1u))) * grid.y) * grid.x;
+
+	uint offset = uintBuffers[scene.clusterBuffers.y].data[cluster * 2];
+	uint count = uintBuffers[scene.clusterBuffers.y].data[cluster * 2 + 1];
+
+	vec3 result = vec3(0.0);
+	for (uint i = 0; i < count; i++) {
+		uint lightIndex = uintBuffers[scene.clusterBuffers.z].data[offset + i];
+		PointLight light = pointLights[scene.clusterBuffers.x].lights[lightIndex];
+		vec3 toLight = light.positionRadius.xyz - viewPosition;
+		float distanceSq = dot(toLight, toLight);
+		float radius = light.positionRadius.w;
+		if (distanceSq >= radius * radius) {
+			continue;
+		}
+		// 平方反比，乘一个在半径处平滑降到 0 的窗口
+		float ratio = distanceSq / (radius * radius);
+		float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+		float attenuation = window * window / (distanceSq + 1.0);
+		float lambert = max(dot(normal, toLight * inversesqrt(distanceSq)), 0.0);
+		result += light.colorIntensity.rgb * light.colorIntensity.a * attenuation * lambert;
+	}
+	return result;
+}
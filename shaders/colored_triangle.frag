@@ -1,12 +1,22 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "bindless.glsl"
 
 // 从顶点着色器接收的颜色 (插值后)
 layout (location = 0) in vec3 inColor;
+layout (location = 1) in vec2 inUV;
+layout (location = 2) flat in uint inMaterial;
 
 // 输出到屏幕的颜色
 layout (location = 0) out vec4 outFragColor;
 
 void main() {
-    // 输出颜色，Alpha 设为 1.0
-    outFragColor = vec4(inColor, 1.0f);
-}
\ No newline at end of file
+    // 顶点颜色 * 材质 (材质按下标从全局表里取)
+    // 光照 = 方向光 (阴影里只剩环境光) + 所在 froxel 的点光源
+    vec4 color = vec4(inColor, 1.0f) * sample_material(inMaterial, inUV);
+    vec3 pointLighting = clustered_lighting(fragment_view_position());
+    float lit = shadow_visibility(fragment_world_position());
+    color.rgb *= mix(sceneData.scene.lightDirection.w, 1.0, lit) + pointLighting;
+    outFragColor = color;
+}
@@ -0,0 +1,92 @@
+// meshlet 路径的公共定义 (先 include bindless.glsl)，结构和 vk_meshlet.h 一致 (std430)
+
+struct Meshlet {
+	vec4 sphere;         // xyz 中心，w 半径 (物体空间)
+	vec4 cone;           // xyz 法线锥的轴，w 是 cutoff (>= 1 表示不做背面剔除)
+	uint vertexOffset;
+	uint triangleOffset;
+	uint vertexCount;
+	uint triangleCount;
+};
+
+struct MeshletDraw {
+	mat4 model;
+	vec4 data;
+	uint dataBuffer;
+	uint vertexBuffer;
+	uint firstMeshlet;
+	uint meshletCount;
+	uint material;
+	uint commandOffset;
+	uint countIndex;
+	uint vertexBase;
+	uint triangleBase;
+	uint pad0;
+	uint pad1;
+	uint pad2;
+};
+
+struct MeshletFrameData {
+	mat4 viewProj;
+	vec4 frustum[6];
+	vec4 cameraPosition;
+	uint drawCount;
+	uint pad0;
+	uint pad1;
+	uint pad2;
+};
+
+struct DrawIndexedCommand {
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+// 全局 buffers[] (binding 2) 的几种视图
+layout (set = 0, binding = 2) readonly buffer MeshletFrameBuffer {
+	MeshletFrameData frame;
+	MeshletDraw draws[];
+} meshletFrames[];
+
+layout (set = 0, binding = 2) readonly buffer MeshletBuffer {
+	Meshlet meshlets[];
+} meshletBuffers[];
+
+layout (set = 0, binding = 2) writeonly buffer DrawCommandBuffer {
+	DrawIndexedCommand commands[];
+} drawCommands[];
+
+layout (push_constant) uniform MeshletPushConstants {
+	uint frameBuffer;   // 帧头 + 绘制表
+	uint countBuffer;   // [0] 可见簇总数，[1..] 每个网格组的命令数
+	uint commandBuffer; // 回退路径的间接命令
+	uint drawIndex;     // mesh shader 路径：这次画哪个绘制
+} meshletPush;
+
+// 视锥 + 法线锥剔除 (包围球按模型矩阵的最大轴缩放放大)
+bool meshlet_visible(MeshletDraw draw, Meshlet meshlet)
+{
+	MeshletFrameData frame = meshletFrames[meshletPush.frameBuffer].frame;
+
+	vec3 center = (draw.model * vec4(meshlet.sphere.xyz, 1.0)).xyz;
+	float scale = sqrt(max(max(dot(draw.model[0].xyz, draw.model[0].xyz), dot(draw.model[1].xyz, draw.model[1].xyz)),
+		dot(draw.model[2].xyz, draw.model[2].xyz)));
+	float radius = meshlet.sphere.w * scale;
+
+	for (int i = 0; i < 6; i++) {
+		if (dot(frame.frustum[i].xyz, center) + frame.frustum[i].w < -radius) {
+			return false;
+		}
+	}
+
+	if (meshlet.cone.w < 1.0) {
+		vec3 axis = normalize(mat3(draw.model) * meshlet.cone.xyz);
+		vec3 toCenter = center - frame.cameraPosition.xyz;
+		if (dot(toCenter, axis) >= meshlet.cone.w * length(toCenter) + radius) {
+			return false;
+		}
+	}
+	return true;
+}
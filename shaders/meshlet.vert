@@ -0,0 +1,26 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#define BINDLESS_RESOURCES_ONLY
+#include "bindless.glsl"
+#include "meshlet.glsl"
+
+// 回退路径：剔除之后的簇用普通顶点输入绘制，绘制数据按 firstInstance (gl_InstanceIndex) 取
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec3 vColor;
+layout (location = 3) in float vUvX;
+layout (location = 4) in float vUvY;
+
+layout (location = 0) out vec3 outColor;
+layout (location = 1) out vec2 outUV;
+layout (location = 2) flat out uint outMaterial;
+
+void main()
+{
+	MeshletDraw draw = meshletFrames[meshletPush.frameBuffer].draws[gl_InstanceIndex];
+	gl_Position = meshletFrames[meshletPush.frameBuffer].frame.viewProj * draw.model * vec4(vPosition, 1.0f);
+	outColor = vColor;
+	outUV = vec2(vUvX, vUvY);
+	outMaterial = draw.material;
+}
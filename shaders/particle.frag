@@ -0,0 +1,17 @@
+#version 450
+
+// 粒子公告板：圆形的软边光点 (加法混合，alpha 不变)
+layout (location = 0) in vec3 inColor;
+layout (location = 1) in vec2 inCorner;
+
+layout (location = 0) out vec4 outFragColor;
+
+void main()
+{
+	float distance2 = dot(inCorner, inCorner);
+	if (distance2 >= 1.0) {
+		discard;
+	}
+	float falloff = 1.0 - distance2;
+	outFragColor = vec4(inColor * falloff * falloff, 0.0);
+}
@@ -0,0 +1,43 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+
+#define BINDLESS_RESOURCES_ONLY
+#include "bindless.glsl"
+#include "particles.glsl"
+
+// 粒子公告板：没有顶点缓冲区，实例是模拟写好的存活表里的一项，6 个顶点拼成面向相机的四边形
+// 实例数由 GPU 写进间接参数
+
+layout (set = 0, binding = 2) readonly buffer ParticleReadBuffer {
+	Particle particles[];
+} particleReads[];
+
+layout (set = 0, binding = 2) readonly buffer ParticleIndexBuffer {
+	uint indices[];
+} particleIndices[];
+
+layout (location = 0) out vec3 outColor;
+layout (location = 1) out vec2 outCorner;
+
+const vec2 CORNERS[6] = vec2[](
+	vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+	vec2(1.0, 1.0), vec2(-1.0, 1.0), vec2(-1.0, -1.0));
+
+void main()
+{
+	ParticleFrame frame = particleFrames[particlePush.frameBuffer].frame;
+	// 模拟把这一帧的结果写进了另一张存活表
+	uint index = particleIndices[particlePush.listBuffer].indices[alive_list(frame.parity ^ 1u) + gl_InstanceIndex];
+	Particle particle = particleReads[particlePush.particleBuffer].particles[index];
+
+	vec2 corner = CORNERS[gl_VertexIndex];
+	vec3 world = particle.position + (frame.cameraRight.xyz * corner.x + frame.cameraUp.xyz * corner.y) * particle.size;
+	gl_Position = frame.viewProj * vec4(world, 1.0);
+
+	// 刚出生时很快淡入，后半段寿命慢慢淡出；加法混合，颜色预先乘上不透明度
+	float t = particle.age / particle.lifetime;
+	float fade = smoothstep(0.0, 0.05, t) * (1.0 - smoothstep(0.6, 1.0, t));
+	vec4 color = unpackUnorm4x8(particle.color);
+	outColor = color.rgb * color.a * fade;
+	outCorner = corner;
+}
@@ -0,0 +1,96 @@
+// GPU 粒子的公共定义，和 vk_particles.h 一致
+// 在 bindless.glsl 之后 include；粒子本身的 buffer 视图由各个着色器按需要声明 (计算着色器可写，顶点着色器只读)
+
+const uint MAX_PARTICLES = 1048576;
+const uint PARTICLE_GROUP_SIZE = 64;
+
+// 计数 buffer 的布局 (uint 下标)
+const uint COUNTER_DRAW = 0;      // VkDrawIndirectCommand
+const uint COUNTER_DISPATCH = 4;  // VkDispatchIndirectCommand
+const uint COUNTER_DEAD = 8;
+const uint COUNTER_ALIVE = 9;     // 两张存活表各一个
+const uint COUNTER_EMITTED = 11;  // 累计，不清零
+const uint COUNTER_DROPPED = 12;
+
+// 下标表：空闲表 + 两张存活表，各 MAX_PARTICLES 个
+const uint LIST_DEAD = 0;
+uint alive_list(uint parity)
+{
+	return (1u + parity) * MAX_PARTICLES;
+}
+
+struct Particle {
+	vec3 position;
+	float age;
+	vec3 velocity;
+	float lifetime;
+	uint color;     // unorm8 x 4
+	float size;
+	uint pad0;
+	uint pad1;
+};
+
+struct Emitter {
+	vec3 position;
+	float radius;
+	vec3 velocity;
+	float spread;
+	vec4 color;
+	float lifetime;
+	float size;
+	uint count;
+	uint seed;
+};
+
+struct ParticleFrame {
+	mat4 viewProj;
+	vec4 cameraRight;   // w: 时间步长
+	vec4 cameraUp;      // w: 反弹系数
+	vec4 gravityDrag;
+	uint emitterCount;
+	uint parity;
+	uint depthTexture;
+	uint depthSampler;
+	float collisionThickness;
+	uint pad0;
+	uint pad1;
+	uint pad2;
+};
+
+layout (set = 0, binding = 2) readonly buffer ParticleFrameBuffer {
+	ParticleFrame frame;
+} particleFrames[];
+
+layout (push_constant) uniform ParticlePushConstants {
+	uint particleBuffer;
+	uint listBuffer;
+	uint counterBuffer;
+	uint frameBuffer;
+	uint emitterBuffer;
+	uint mode;
+	uint pad0;
+	uint pad1;
+} particlePush;
+
+// PCG 哈希：发射时的随机数 (同一个种子结果一样，回放可重复)
+uint pcg_hash(uint value)
+{
+	uint state = value * 747796405u + 2891336453u;
+	uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+float random01(inout uint state)
+{
+	state = pcg_hash(state);
+	return float(state >> 8) * (1.0 / 16777216.0);
+}
+
+// 单位球内均匀分布
+vec3 random_in_sphere(inout uint state)
+{
+	float z = random01(state) * 2.0 - 1.0;
+	float angle = random01(state) * 6.2831853;
+	float r = sqrt(max(1.0 - z * z, 0.0));
+	return vec3(r * cos(angle), r * sin(angle), z) * pow(random01(state), 1.0 / 3.0);
+}
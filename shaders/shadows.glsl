@@ -0,0 +1,37 @@
+// 级联阴影 (bindless.glsl 在片段着色器里 include)
+// 世界坐标由 gl_FragCoord 还原，所以任何绘制路径的片段着色器都能直接用
+
+vec3 fragment_world_position()
+{
+	SceneData scene = sceneData.scene;
+	vec2 ndc = gl_FragCoord.xy / scene.renderExtent * 2.0 - 1.0;
+	vec4 world = scene.invViewProj * vec4(ndc, gl_FragCoord.z, 1.0);
+	return world.xyz / world.w;
+}
+
+// 1 = 完全照亮，0 = 完全在阴影里
+// 按顺序找第一个覆盖这个点的级联 (越靠前越精细)，3x3 PCF；不在任何级联里的算照亮
+float shadow_visibility(vec3 worldPosition)
+{
+	SceneData scene = sceneData.scene;
+	float texel = scene.shadowParams.x;
+	for (uint i = 0; i < scene.cascadeCount; i++) {
+		vec4 clip = scene.cascadeViewProj[i] * vec4(worldPosition, 1.0);
+		vec3 ndc = clip.xyz / clip.w;
+		vec2 uv = ndc.xy * 0.5 + 0.5;
+		if (any(lessThan(uv, vec2(texel * 2.0))) || any(greaterThan(uv, vec2(1.0 - texel * 2.0))) || ndc.z > 1.0) {
+			continue;
+		}
+
+		uint textureIndex = scene.shadowTextures[i];
+		float lit = 0.0;
+		for (int y = -1; y <= 1; y++) {
+			for (int x = -1; x <= 1; x++) {
+				vec3 coord = vec3(uv + vec2(x, y) * texel, ndc.z);
+				lit += texture(sampler2DShadow(textures[nonuniformEXT(textureIndex)], samplers[nonuniformEXT(scene.shadowSampler)]), coord);
+			}
+		}
+		return lit / 9.0;
+	}
+	return 1.0;
+}
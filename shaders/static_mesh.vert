@@ -0,0 +1,48 @@
+#version 460
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_multiview : require
+
+#define BINDLESS_RESOURCES_ONLY
+#include "bindless.glsl"
+
+// 静态几何：命令缓冲区录制一次反复执行，每帧的数据都从 buffer 里读 (结构和 vk_static_draws.h 一致，std430)
+// 物体按 firstInstance (gl_InstanceIndex) 取自己的实例
+// 多视角渲染 (viewMask != 0) 时几何只提交一次，第 gl_ViewIndex 层用 viewProj[view + gl_ViewIndex]；普通渲染 gl_ViewIndex 是 0
+layout (location = 0) in vec3 vPosition;
+layout (location = 1) in vec3 vNormal;
+layout (location = 2) in vec3 vColor;
+layout (location = 3) in float vUvX;
+layout (location = 4) in float vUvY;
+
+layout (location = 0) out vec3 outColor;
+layout (location = 1) out vec2 outUV;
+layout (location = 2) flat out uint outMaterial;
+
+struct StaticInstance {
+	mat4 model;
+	vec4 data;
+	uint material;
+	uint pad0;
+	uint pad1;
+	uint pad2;
+};
+
+// 全局 buffers[] (binding 2) 的视图：帧头 (每个视角一个 viewProj，0 是相机，之后是阴影级联) + 实例表
+layout (set = 0, binding = 2) readonly buffer StaticFrameBuffer {
+	mat4 viewProj[1 + MAX_SHADOW_CASCADES];
+	StaticInstance instances[];
+} staticFrames[];
+
+layout (push_constant) uniform StaticPushConstants {
+	uint frameBuffer;
+	uint view;
+} staticPush;
+
+void main()
+{
+	StaticInstance instance = staticFrames[staticPush.frameBuffer].instances[gl_InstanceIndex];
+	gl_Position = staticFrames[staticPush.frameBuffer].viewProj[staticPush.view + uint(gl_ViewIndex)] * instance.model * vec4(vPosition, 1.0f);
+	outColor = vColor;
+	outUV = vec2(vUvX, vUvY);
+	outMaterial = instance.material;
+}
@@ -3,14 +3,19 @@
 layout (location = 0) in vec3 vPosition;
 layout (location = 1) in vec3 vNormal;
 layout (location = 2) in vec3 vColor;
+layout (location = 3) in float vUvX;
+layout (location = 4) in float vUvY;
 
 layout (location = 0) out vec3 outColor;
+layout (location = 1) out vec2 outUV;
+layout (location = 2) flat out uint outMaterial;
 
 // [新增] Push Constants 定义
 // 这就像是一个全局变量，由 C++ 直接塞进来
 layout(push_constant) uniform PushConstants {
     vec4 data;         // <--- 新增这个来接收 C++ 里的 padding
 	mat4 renderMatrix; // 渲染矩阵 (模型+视图+投影)
+	uint materialIndex; // 材质表下标 (bindless)
 } pushConstants;
 
 void main()
@@ -19,4 +24,6 @@ void main()
 	// 注意矩阵乘法的顺序：矩阵 * 向量
 	gl_Position = pushConstants.renderMatrix * vec4(vPosition, 1.0f);
 	outColor = vColor;
-}
\ No newline at end of file
+	outUV = vec2(vUvX, vUvY);
+	outMaterial = pushConstants.materialIndex;
+}
@@ -0,0 +1,66 @@
+// 虚拟纹理采样 + 反馈写入
+// 页表 buffer 的头部布局和 VirtualTexture::write_header() 一一对应
+#ifndef VIRTUAL_TEXTURE_GLSL
+#define VIRTUAL_TEXTURE_GLSL
+
+const uint VT_HEADER_UINTS = 32;
+const uint VT_FEEDBACK_DIVISOR = 8;
+const uint VT_INVALID = 0xFFFFFFFFu;
+
+// 反馈：每 8x8 像素只有一个像素写 (位置逐帧抖动，64 帧覆盖整块)
+void vt_write_feedback(uint table, uint pageId)
+{
+	uint feedback = uintBuffers[nonuniformEXT(table)].data[9];
+	uint feedbackWidth = uintBuffers[nonuniformEXT(table)].data[10];
+	uint feedbackCount = uintBuffers[nonuniformEXT(table)].data[11];
+	uint jitter = (uintBuffers[nonuniformEXT(table)].data[12] * 37u) & 63u;
+
+	uvec2 fragCoord = uvec2(gl_FragCoord.xy);
+	if ((fragCoord.x & 7u) != (jitter & 7u) || (fragCoord.y & 7u) != (jitter >> 3)) {
+		return;
+	}
+	uint index = (fragCoord.y / VT_FEEDBACK_DIVISOR) * feedbackWidth + fragCoord.x / VT_FEEDBACK_DIVISOR;
+	if (index < feedbackCount) {
+		uintBuffers[nonuniformEXT(feedback)].data[index] = pageId;
+	}
+}
+
+vec4 sample_virtual(uint table, vec2 uv)
+{
+	uint sizeInPages = uintBuffers[nonuniformEXT(table)].data[0];
+	uint mipCount = uintBuffers[nonuniformEXT(table)].data[1];
+	uint pageSize = uintBuffers[nonuniformEXT(table)].data[2];
+	uint border = uintBuffers[nonuniformEXT(table)].data[3];
+	uint tileSize = uintBuffers[nonuniformEXT(table)].data[5];
+	float physicalSize = float(uintBuffers[nonuniformEXT(table)].data[6]);
+	uint physicalTexture = uintBuffers[nonuniformEXT(table)].data[7];
+	uint physicalSampler = uintBuffers[nonuniformEXT(table)].data[8];
+
+	// 1. 根据屏幕空间导数算出需要的 mip (导数必须在分支之外算)
+	uv = fract(uv);
+	vec2 texel = uv * float(sizeInPages * pageSize);
+	vec2 dx = dFdx(texel);
+	vec2 dy = dFdy(texel);
+	float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1.0));
+	uint mip = min(uint(lod), mipCount - 1);
+
+	uint side = max(sizeInPages >> mip, 1u);
+	uvec2 page = min(uvec2(uv * float(side)), uvec2(side - 1));
+	vt_write_feedback(table, (mip << 24) | (page.y << 12) | page.x);
+
+	// 2. 查页表：得到实际驻留的 (可能更粗的) 页在物理缓存里的位置
+	uint entry = uintBuffers[nonuniformEXT(table)].data[VT_HEADER_UINTS + uintBuffers[nonuniformEXT(table)].data[16 + mip] + page.y * side + page.x];
+	if (entry == VT_INVALID) {
+		return vec4(1.0);
+	}
+	uvec2 slot = uvec2(entry & 0xFFu, (entry >> 8) & 0xFFu);
+	uint residentMip = entry >> 16;
+
+	// 3. 在驻留页内的坐标 -> 物理缓存坐标 (跳过 border)
+	float residentSide = float(max(sizeInPages >> residentMip, 1u));
+	vec2 inPage = fract(uv * residentSide);
+	vec2 physical = vec2(slot * tileSize + border) + inPage * float(pageSize);
+	return textureLod(sampler2D(textures[nonuniformEXT(physicalTexture)], samplers[nonuniformEXT(physicalSampler)]), physical / physicalSize, 0.0);
+}
+
+#endif
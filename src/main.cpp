@@ -1,17 +1,62 @@
 ﻿#include "vk_engine.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 int main(int argc, char* argv[])
 {
 	VulkanEngine engine;
 
-	// 1. 初始化 (弹窗)
+	// 0. 命令行
+	//   --capture <file.vcap>                   正常运行，同时把提交的每一帧写进抓帧文件
+	//   --replay <file.vcap> [--iterations N]   无窗口重放抓帧 N 遍，打印帧时间统计
+	//   --allow-frame-allocs                    调试版默认在稳定状态的 draw() 有堆分配时断言失败，这个选项只打印警告
+	//   --log <file>                            日志同时写到文件
+	//   --log-level debug|info|warn|error       低于这个级别的日志不输出 (默认 info)
+	std::string logPath;
+	vklog::Level logLevel = vklog::Level::Info;
+	for (int i = 1; i < argc; i++) {
+		const std::string arg = argv[i];
+		if (arg == "--capture" && i + 1 < argc) {
+			engine._capturePath = argv[++i];
+		}
+		else if (arg == "--replay" && i + 1 < argc) {
+			engine._replayPath = argv[++i];
+		}
+		else if (arg == "--iterations" && i + 1 < argc) {
+			engine._replayIterations = (uint32_t)std::max(1, std::atoi(argv[++i]));
+		}
+		else if (arg == "--allow-frame-allocs") {
+			engine._assertNoFrameAllocations = false;
+		}
+		else if (arg == "--log" && i + 1 < argc) {
+			logPath = argv[++i];
+		}
+		else if (arg == "--log-level" && i + 1 < argc) {
+			if (!vklog::parse_level(argv[++i], logLevel)) {
+				vklog::error() << "Unknown log level: " << argv[i];
+			}
+		}
+		else {
+			vklog::error() << "Unknown argument: " << arg;
+		}
+	}
+
+	// 1. 日志的后台线程 (在这之前的日志同步写控制台)，然后初始化 (弹窗；回放时不弹)
+	vklog::init(logPath.c_str(), logLevel);
 	engine.init();	
 
-	// 2. 运行 (卡在这里循环)
-	engine.run();	
+	// 2. 运行 (卡在这里循环)，或者回放完就退出
+	if (!engine._replayPath.empty()) {
+		engine.replay();
+	}
+	else {
+		engine.run();
+	}
 
 	// 3. 清理 (关闭)
 	engine.cleanup();	
+	vklog::shutdown();
 
 	return 0;
 }
\ No newline at end of file
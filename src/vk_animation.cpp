@@ -0,0 +1,369 @@
+#include "vk_animation.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VKANIM_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace vkanim {
+
+	namespace {
+
+		constexpr float SQRT2 = 1.41421356f;
+
+		// 贪心的曲线化简：从 start 出发尽量往后延伸，[start, end] 中间的每一帧都能由两端插值还原 (fits) 才算数
+		template<typename Fits>
+		void reduce(uint32_t frameCount, std::vector<uint32_t>& keys, Fits fits)
+		{
+			keys.clear();
+			keys.push_back(0);
+			uint32_t start = 0;
+			while (start + 1 < frameCount) {
+				uint32_t end = start + 1;
+				for (uint32_t candidate = start + 2; candidate < frameCount; candidate++) {
+					bool ok = true;
+					for (uint32_t frame = start + 1; frame < candidate && ok; frame++) {
+						ok = fits(start, candidate, frame);
+					}
+					if (!ok) {
+						break;
+					}
+					end = candidate;
+				}
+				keys.push_back(end);
+				start = end;
+			}
+		}
+
+		// 两个旋转之间的夹角 (弧度)；用 conj(a) * b 的虚部长度和实部求 atan2，dot 接近 1 时 acos 的精度不够
+		float rotation_error(const glm::quat& a, const glm::quat& b)
+		{
+			const glm::quat d = glm::conjugate(a) * b;
+			return 2.0f * std::atan2(glm::length(glm::vec3(d.x, d.y, d.z)), std::abs(d.w));
+		}
+
+		QuantizedRotation quantize_rotation(const glm::quat& q)
+		{
+			const float c[4] = { q.x, q.y, q.z, q.w };
+			uint32_t largest = 0;
+			for (uint32_t i = 1; i < 4; i++) {
+				if (std::abs(c[i]) > std::abs(c[largest])) {
+					largest = i;
+				}
+			}
+			// q 和 -q 是同一个旋转：让省掉的分量是正的，还原时取正的平方根
+			const float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+			float rest[3];
+			uint32_t n = 0;
+			for (uint32_t i = 0; i < 4; i++) {
+				if (i != largest) {
+					rest[n++] = c[i] * sign;
+				}
+			}
+			auto encode = [](float v, float maxValue) {
+				return (uint16_t)std::lround((std::clamp(v * SQRT2, -1.0f, 1.0f) * 0.5f + 0.5f) * maxValue);
+			};
+			QuantizedRotation r;
+			r.v[0] = (uint16_t)(encode(rest[0], 32767.0f) | ((largest & 1u) << 15));
+			r.v[1] = (uint16_t)(encode(rest[1], 32767.0f) | ((largest >> 1) << 15));
+			r.v[2] = encode(rest[2], 65535.0f);
+			return r;
+		}
+
+		glm::quat dequantize_rotation(const QuantizedRotation& r)
+		{
+			const uint32_t largest = (r.v[0] >> 15) | ((r.v[1] >> 15) << 1);
+			auto decode = [](uint32_t v, float maxValue) {
+				return ((float)v / maxValue * 2.0f - 1.0f) / SQRT2;
+			};
+			const float rest[3] = { decode(r.v[0] & 0x7FFFu, 32767.0f), decode(r.v[1] & 0x7FFFu, 32767.0f), decode(r.v[2], 65535.0f) };
+			float c[4];
+			uint32_t n = 0;
+			for (uint32_t i = 0; i < 4; i++) {
+				c[i] = i == largest ? 0.0f : rest[n++];
+			}
+			c[largest] = std::sqrt(std::max(0.0f, 1.0f - rest[0] * rest[0] - rest[1] * rest[1] - rest[2] * rest[2]));
+			return glm::quat(c[3], c[0], c[1], c[2]);
+		}
+
+		// 夹住 frame 的两个关键帧 (k0, k0 + 1) 和插值权重；只有一个关键帧时两个都是它
+		void find_keys(const uint16_t* frames, uint32_t count, float frame, uint32_t& k0, uint32_t& k1, float& weight)
+		{
+			if (count <= 1) {
+				k0 = 0;
+				k1 = 0;
+				weight = 0.0f;
+				return;
+			}
+			const uint16_t* it = std::upper_bound(frames, frames + count, frame, [](float f, uint16_t key) { return f < (float)key; });
+			k1 = std::clamp((uint32_t)(it - frames), 1u, count - 1);
+			k0 = k1 - 1;
+			weight = std::clamp((frame - (float)frames[k0]) / (float)(frames[k1] - frames[k0]), 0.0f, 1.0f);
+		}
+
+		// out = a + (b - a) * w：旋转先把 b 翻到和 a 同一个半球再线性插值、归一化 (nlerp)，平移直接线性插值
+		// 权重每个关节一个 (weightStride = 1) 或者全部相同 (weightStride = 0)；out 可以和 a / b 是同一个
+		void interpolate(const Pose& a, const Pose& b, const float* rotationWeights, const float* translationWeights,
+			uint32_t weightStride, Pose& out)
+		{
+			const uint32_t count = (uint32_t)out.qx.size(); // 已经按 4 对齐
+#ifdef VKANIM_SSE
+			const __m128 one = _mm_set1_ps(1.0f);
+			const __m128 epsilon = _mm_set1_ps(1e-12f);
+			const __m128 signBit = _mm_set1_ps(-0.0f);
+			for (uint32_t i = 0; i < count; i += 4) {
+				const __m128 rw = weightStride ? _mm_loadu_ps(rotationWeights + i) : _mm_set1_ps(*rotationWeights);
+				const __m128 tw = weightStride ? _mm_loadu_ps(translationWeights + i) : _mm_set1_ps(*translationWeights);
+
+				const __m128 ax = _mm_loadu_ps(&a.qx[i]);
+				const __m128 ay = _mm_loadu_ps(&a.qy[i]);
+				const __m128 az = _mm_loadu_ps(&a.qz[i]);
+				const __m128 aw = _mm_loadu_ps(&a.qw[i]);
+				__m128 bx = _mm_loadu_ps(&b.qx[i]);
+				__m128 by = _mm_loadu_ps(&b.qy[i]);
+				__m128 bz = _mm_loadu_ps(&b.qz[i]);
+				__m128 bw = _mm_loadu_ps(&b.qw[i]);
+				const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+				const __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signBit);
+				bx = _mm_xor_ps(bx, flip);
+				by = _mm_xor_ps(by, flip);
+				bz = _mm_xor_ps(bz, flip);
+				bw = _mm_xor_ps(bw, flip);
+
+				const __m128 x = _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(bx, ax), rw));
+				const __m128 y = _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(by, ay), rw));
+				const __m128 z = _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(bz, az), rw));
+				const __m128 w = _mm_add_ps(aw, _mm_mul_ps(_mm_sub_ps(bw, aw), rw));
+				const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(w, w)));
+				const __m128 inverse = _mm_div_ps(one, _mm_sqrt_ps(_mm_max_ps(lengthSq, epsilon)));
+				_mm_storeu_ps(&out.qx[i], _mm_mul_ps(x, inverse));
+				_mm_storeu_ps(&out.qy[i], _mm_mul_ps(y, inverse));
+				_mm_storeu_ps(&out.qz[i], _mm_mul_ps(z, inverse));
+				_mm_storeu_ps(&out.qw[i], _mm_mul_ps(w, inverse));
+
+				const __m128 atx = _mm_loadu_ps(&a.tx[i]);
+				const __m128 aty = _mm_loadu_ps(&a.ty[i]);
+				const __m128 atz = _mm_loadu_ps(&a.tz[i]);
+				_mm_storeu_ps(&out.tx[i], _mm_add_ps(atx, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&b.tx[i]), atx), tw)));
+				_mm_storeu_ps(&out.ty[i], _mm_add_ps(aty, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&b.ty[i]), aty), tw)));
+				_mm_storeu_ps(&out.tz[i], _mm_add_ps(atz, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&b.tz[i]), atz), tw)));
+			}
+#else
+			for (uint32_t i = 0; i < count; i++) {
+				const float rw = rotationWeights[i * weightStride];
+				const float tw = translationWeights[i * weightStride];
+				const float dot = a.qx[i] * b.qx[i] + a.qy[i] * b.qy[i] + a.qz[i] * b.qz[i] + a.qw[i] * b.qw[i];
+				const float sign = dot < 0.0f ? -1.0f : 1.0f;
+				const float x = a.qx[i] + (b.qx[i] * sign - a.qx[i]) * rw;
+				const float y = a.qy[i] + (b.qy[i] * sign - a.qy[i]) * rw;
+				const float z = a.qz[i] + (b.qz[i] * sign - a.qz[i]) * rw;
+				const float w = a.qw[i] + (b.qw[i] * sign - a.qw[i]) * rw;
+				const float inverse = 1.0f / std::sqrt(std::max(x * x + y * y + z * z + w * w, 1e-12f));
+				out.qx[i] = x * inverse;
+				out.qy[i] = y * inverse;
+				out.qz[i] = z * inverse;
+				out.qw[i] = w * inverse;
+				out.tx[i] = a.tx[i] + (b.tx[i] - a.tx[i]) * tw;
+				out.ty[i] = a.ty[i] + (b.ty[i] - a.ty[i]) * tw;
+				out.tz[i] = a.tz[i] + (b.tz[i] - a.tz[i]) * tw;
+			}
+#endif
+		}
+	}
+
+	size_t Clip::compressed_size() const
+	{
+		return rotationTracks.size() * sizeof(Track) + translationTracks.size() * sizeof(Track) +
+			rotationFrames.size() * sizeof(uint16_t) + rotationKeys.size() * sizeof(QuantizedRotation) +
+			translationFrames.size() * sizeof(uint16_t) + translationKeys.size() * sizeof(QuantizedTranslation) +
+			translationMin.size() * sizeof(glm::vec3) + translationExtent.size() * sizeof(glm::vec3);
+	}
+
+	Clip compress(const RawClip& raw, const CompressionSettings& settings)
+	{
+		Clip clip;
+		if (raw.frameCount == 0 || raw.frameCount > 65536 || raw.jointCount == 0 || raw.jointCount > MAX_JOINTS ||
+			raw.frames.size() != (size_t)raw.frameCount * raw.jointCount || raw.sampleRate <= 0.0f) {
+			vklog::error() << "Invalid animation clip (" << raw.frameCount << " frames, " << raw.jointCount << " joints)";
+			return clip;
+		}
+
+		clip.sampleRate = raw.sampleRate;
+		clip.frameCount = raw.frameCount;
+		clip.jointCount = raw.jointCount;
+		clip.duration = (float)(raw.frameCount - 1) / raw.sampleRate;
+		clip.rotationTracks.resize(raw.jointCount);
+		clip.translationTracks.resize(raw.jointCount);
+		clip.translationMin.resize(raw.jointCount);
+		clip.translationExtent.resize(raw.jointCount);
+
+		std::vector<glm::quat> rotations(raw.frameCount);
+		std::vector<glm::vec3> translations(raw.frameCount);
+		std::vector<uint32_t> keys;
+		for (uint32_t joint = 0; joint < raw.jointCount; joint++) {
+			// 1. 旋转：相邻帧放到同一个半球，插值走最短路径
+			for (uint32_t frame = 0; frame < raw.frameCount; frame++) {
+				glm::quat q = glm::normalize(raw.frames[(size_t)frame * raw.jointCount + joint].rotation);
+				if (frame > 0 && glm::dot(q, rotations[frame - 1]) < 0.0f) {
+					q = -q;
+				}
+				rotations[frame] = q;
+				translations[frame] = raw.frames[(size_t)frame * raw.jointCount + joint].translation;
+			}
+
+			reduce(raw.frameCount, keys, [&](uint32_t a, uint32_t b, uint32_t frame) {
+				const float t = (float)(frame - a) / (float)(b - a);
+				const glm::quat q = glm::normalize(rotations[a] * (1.0f - t) + rotations[b] * t);
+				return rotation_error(q, rotations[frame]) <= settings.rotationTolerance;
+			});
+			clip.rotationTracks[joint] = { (uint32_t)clip.rotationKeys.size(), (uint32_t)keys.size() };
+			for (uint32_t key : keys) {
+				clip.rotationFrames.push_back((uint16_t)key);
+				clip.rotationKeys.push_back(quantize_rotation(rotations[key]));
+			}
+
+			// 2. 平移：留下的关键帧按它们的包围盒量化
+			reduce(raw.frameCount, keys, [&](uint32_t a, uint32_t b, uint32_t frame) {
+				const float t = (float)(frame - a) / (float)(b - a);
+				const glm::vec3 p = translations[a] * (1.0f - t) + translations[b] * t;
+				return glm::length(p - translations[frame]) <= settings.translationTolerance;
+			});
+			glm::vec3 lo = translations[keys[0]];
+			glm::vec3 hi = lo;
+			for (uint32_t key : keys) {
+				lo = glm::min(lo, translations[key]);
+				hi = glm::max(hi, translations[key]);
+			}
+			const glm::vec3 extent = hi - lo;
+			clip.translationMin[joint] = lo;
+			clip.translationExtent[joint] = extent;
+			clip.translationTracks[joint] = { (uint32_t)clip.translationKeys.size(), (uint32_t)keys.size() };
+			for (uint32_t key : keys) {
+				QuantizedTranslation q;
+				for (int c = 0; c < 3; c++) {
+					const float normalized = extent[c] > 0.0f ? (translations[key][c] - lo[c]) / extent[c] : 0.0f;
+					q.v[c] = (uint16_t)std::lround(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f);
+				}
+				clip.translationFrames.push_back((uint16_t)key);
+				clip.translationKeys.push_back(q);
+			}
+		}
+		return clip;
+	}
+
+	void Pose::resize(uint32_t joints)
+	{
+		if (joints == jointCount && !qx.empty()) {
+			return;
+		}
+		jointCount = joints;
+		const size_t padded = ((size_t)joints + 3) & ~(size_t)3;
+		qx.assign(padded, 0.0f);
+		qy.assign(padded, 0.0f);
+		qz.assign(padded, 0.0f);
+		qw.assign(padded, 1.0f);
+		tx.assign(padded, 0.0f);
+		ty.assign(padded, 0.0f);
+		tz.assign(padded, 0.0f);
+	}
+
+	void sample(const Clip& clip, float time, Pose& out, PoseScratch& scratch)
+	{
+		out.resize(clip.jointCount);
+		if (clip.frameCount == 0) {
+			return;
+		}
+
+		float frame = 0.0f;
+		if (clip.duration > 0.0f) {
+			float t = std::fmod(time, clip.duration);
+			if (t < 0.0f) {
+				t += clip.duration;
+			}
+			frame = t * clip.sampleRate;
+		}
+
+		// 每条曲线找夹住这一帧的两个关键帧，解码进两个临时姿势 (标量，随机访问)，插值统一按 4 个关节一组做
+		Pose& keys0 = scratch.keys0;
+		Pose& keys1 = scratch.keys1;
+		std::pmr::vector<float>& rotationWeights = scratch.rotationWeights;
+		std::pmr::vector<float>& translationWeights = scratch.translationWeights;
+		keys0.resize(clip.jointCount);
+		keys1.resize(clip.jointCount);
+		rotationWeights.assign(out.qx.size(), 0.0f);
+		translationWeights.assign(out.qx.size(), 0.0f);
+
+		for (uint32_t joint = 0; joint < clip.jointCount; joint++) {
+			const Track& rotation = clip.rotationTracks[joint];
+			uint32_t k0, k1;
+			find_keys(&clip.rotationFrames[rotation.firstKey], rotation.keyCount, frame, k0, k1, rotationWeights[joint]);
+			const glm::quat q0 = dequantize_rotation(clip.rotationKeys[rotation.firstKey + k0]);
+			const glm::quat q1 = dequantize_rotation(clip.rotationKeys[rotation.firstKey + k1]);
+			keys0.qx[joint] = q0.x;
+			keys0.qy[joint] = q0.y;
+			keys0.qz[joint] = q0.z;
+			keys0.qw[joint] = q0.w;
+			keys1.qx[joint] = q1.x;
+			keys1.qy[joint] = q1.y;
+			keys1.qz[joint] = q1.z;
+			keys1.qw[joint] = q1.w;
+
+			const Track& translation = clip.translationTracks[joint];
+			find_keys(&clip.translationFrames[translation.firstKey], translation.keyCount, frame, k0, k1, translationWeights[joint]);
+			const glm::vec3& lo = clip.translationMin[joint];
+			const glm::vec3 scale = clip.translationExtent[joint] / 65535.0f;
+			const QuantizedTranslation& t0 = clip.translationKeys[translation.firstKey + k0];
+			const QuantizedTranslation& t1 = clip.translationKeys[translation.firstKey + k1];
+			keys0.tx[joint] = lo.x + t0.v[0] * scale.x;
+			keys0.ty[joint] = lo.y + t0.v[1] * scale.y;
+			keys0.tz[joint] = lo.z + t0.v[2] * scale.z;
+			keys1.tx[joint] = lo.x + t1.v[0] * scale.x;
+			keys1.ty[joint] = lo.y + t1.v[1] * scale.y;
+			keys1.tz[joint] = lo.z + t1.v[2] * scale.z;
+		}
+
+		interpolate(keys0, keys1, rotationWeights.data(), translationWeights.data(), 1, out);
+	}
+
+	void blend(const Pose& a, const Pose& b, float weight, Pose& out)
+	{
+		// 关节数不同的两个姿势 (不同骨架) 不能混合，直接用 a
+		if (a.jointCount != b.jointCount) {
+			if (&out != &a) {
+				out = a;
+			}
+			return;
+		}
+		if (&out != &a && &out != &b) {
+			out.resize(a.jointCount);
+		}
+		interpolate(a, b, &weight, &weight, 0, out);
+	}
+
+	void skinning_matrices(const Skeleton& skeleton, const Pose& pose, glm::vec4* out, PoseScratch& scratch)
+	{
+		const uint32_t jointCount = skeleton.joint_count();
+		std::pmr::vector<glm::mat4>& model = scratch.model;
+		model.resize(jointCount);
+		for (uint32_t joint = 0; joint < jointCount; joint++) {
+			// 姿势里没有的关节保持绑定姿势 (蒙皮矩阵是单位矩阵)
+			glm::mat4 skin(1.0f);
+			if (joint < pose.jointCount) {
+				glm::mat4 local = glm::mat4_cast(glm::quat(pose.qw[joint], pose.qx[joint], pose.qy[joint], pose.qz[joint]));
+				local[3] = glm::vec4(pose.tx[joint], pose.ty[joint], pose.tz[joint], 1.0f);
+				const int32_t parent = skeleton.parents[joint];
+				model[joint] = parent >= 0 ? model[parent] * local : local;
+				skin = model[joint] * skeleton.inverseBind[joint];
+			}
+			else {
+				model[joint] = glm::inverse(skeleton.inverseBind[joint]);
+			}
+			for (uint32_t row = 0; row < 3; row++) {
+				out[joint * 3 + row] = glm::vec4(skin[0][row], skin[1][row], skin[2][row], skin[3][row]);
+			}
+		}
+	}
+}
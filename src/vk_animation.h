@@ -0,0 +1,123 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <memory_resource>
+
+// 骨骼动画 (纯 CPU，可以在工作线程上跑)
+// - 骨架：关节按父在前、子在后排列，逆绑定矩阵把模型空间的顶点变到关节空间
+// - 压缩片段：每个关节的旋转 / 平移各是一条曲线
+//   导入时先做曲线化简 (能用两边关键帧线性插值还原到误差以内的帧去掉)，
+//   留下的旋转量化成 smallest-three 48 位，平移按这条曲线的包围盒量化成 3 x 16 位
+// - 采样 / 混合：姿势按分量分开存 (SoA)，插值一次处理 4 个关节 (SSE)，没有 SSE 时退回标量
+// - 蒙皮矩阵：局部姿势 -> 模型空间 -> 乘逆绑定矩阵，写成 3 行 vec4 (仿射矩阵转置后的前 3 行)，给 skinning.comp 用
+namespace vkanim {
+
+	constexpr uint32_t MAX_JOINTS = 256;
+
+	struct Skeleton {
+		std::vector<int32_t> parents;        // 父关节下标，-1 是根；父关节下标总是比自己小
+		std::vector<glm::mat4> inverseBind;  // 绑定姿势下模型空间 -> 关节空间
+
+		uint32_t joint_count() const { return (uint32_t)parents.size(); }
+	};
+
+	// 一个关节相对父关节的变换 (没有缩放)
+	struct JointTransform {
+		glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+		glm::vec3 translation{ 0.0f };
+	};
+
+	// 未压缩的片段 (导入 / 烘焙时用)：frames[frame * jointCount + joint]
+	struct RawClip {
+		float sampleRate{ 30.0f };
+		uint32_t frameCount{ 0 };
+		uint32_t jointCount{ 0 };
+		std::vector<JointTransform> frames;
+	};
+
+	struct CompressionSettings {
+		float rotationTolerance{ 0.001f };    // 弧度
+		float translationTolerance{ 0.0005f }; // 距离单位
+	};
+
+	// 一条曲线在关键帧表里的范围
+	struct Track {
+		uint32_t firstKey;
+		uint32_t keyCount;
+	};
+
+	// smallest-three：绝对值最大的分量省掉 (由另外三个还原)，它的下标放在 v[0]、v[1] 的最高位
+	// 其余三个分量在 [-1/√2, 1/√2] 里，v[0]、v[1] 各 15 位，v[2] 16 位
+	struct QuantizedRotation {
+		uint16_t v[3];
+	};
+
+	// 按曲线的包围盒归一化到 [0, 65535]
+	struct QuantizedTranslation {
+		uint16_t v[3];
+	};
+
+	struct Clip {
+		float duration{ 0.0f };
+		float sampleRate{ 30.0f };
+		uint32_t frameCount{ 0 };
+		uint32_t jointCount{ 0 };
+		// 每个关节一条旋转曲线、一条平移曲线；关键帧按帧号升序，第一帧和最后一帧一定在
+		std::vector<Track> rotationTracks;
+		std::vector<Track> translationTracks;
+		std::vector<uint16_t> rotationFrames;
+		std::vector<QuantizedRotation> rotationKeys;
+		std::vector<uint16_t> translationFrames;
+		std::vector<QuantizedTranslation> translationKeys;
+		std::vector<glm::vec3> translationMin;    // 每个关节
+		std::vector<glm::vec3> translationExtent;
+
+		size_t compressed_size() const;
+	};
+
+	// 帧数超过 65536 或者关节数不对时返回空片段 (frameCount 为 0)
+	Clip compress(const RawClip& raw, const CompressionSettings& settings = {});
+
+	// 一个顶点受哪几个关节影响 (最多 4 个)；权重不用归一化，上传时量化成 8 位并补齐到总和 1
+	struct SkinWeights {
+		uint8_t joints[4]{};
+		glm::vec4 weights{ 1.0f, 0.0f, 0.0f, 0.0f };
+	};
+
+	// SoA 姿势，长度按 4 对齐 (补上的关节是单位变换)
+	// 内存来自构造时给的 memory_resource (工作线程上是这一帧的 arena)
+	struct Pose {
+		Pose() = default;
+		explicit Pose(std::pmr::memory_resource* resource)
+			: qx(resource), qy(resource), qz(resource), qw(resource), tx(resource), ty(resource), tz(resource) {}
+
+		uint32_t jointCount{ 0 };
+		std::pmr::vector<float> qx, qy, qz, qw;
+		std::pmr::vector<float> tx, ty, tz;
+
+		void resize(uint32_t joints);
+	};
+
+	// sample / skinning_matrices 的临时数据：一批实例共用一份，容量够了之后不再分配
+	// (放在帧 arena 上时尤其重要：arena 不回收单次分配，每次调用各拿一份会一直涨到帧末)
+	struct PoseScratch {
+		PoseScratch() = default;
+		explicit PoseScratch(std::pmr::memory_resource* resource)
+			: keys0(resource), keys1(resource), rotationWeights(resource), translationWeights(resource), model(resource) {}
+
+		Pose keys0, keys1;                       // 夹住采样时间的两个关键帧
+		std::pmr::vector<float> rotationWeights;
+		std::pmr::vector<float> translationWeights;
+		std::pmr::vector<glm::mat4> model;       // 模型空间的关节矩阵
+	};
+
+	// time 超出片段长度时循环；out 按片段的关节数重新分配 (容量够时不分配)
+	void sample(const Clip& clip, float time, Pose& out, PoseScratch& scratch);
+	// out = a * (1 - weight) + b * weight，旋转走最短路径的 nlerp；out 可以是 a 或 b
+	void blend(const Pose& a, const Pose& b, float weight, Pose& out);
+	// 局部姿势 -> 每个关节 3 个 vec4 的蒙皮矩阵 (out 至少 3 * 骨架关节数)
+	void skinning_matrices(const Skeleton& skeleton, const Pose& pose, glm::vec4* out, PoseScratch& scratch);
+}
@@ -0,0 +1,191 @@
+#include "vk_arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+void LinearArena::init(size_t capacity)
+{
+	release();
+	_capacity = capacity;
+	_base = capacity > 0 ? static_cast<std::byte*>(::operator new(capacity, std::align_val_t(BLOCK_ALIGNMENT))) : nullptr;
+}
+
+void LinearArena::release()
+{
+	reset();
+	if (_base) {
+		::operator delete(_base, std::align_val_t(BLOCK_ALIGNMENT));
+		_base = nullptr;
+	}
+	_capacity = 0;
+}
+
+void* LinearArena::allocate_raw(size_t size, size_t alignment)
+{
+	size = std::max<size_t>(size, 1);
+	if (_base && alignment <= BLOCK_ALIGNMENT) {
+		const size_t offset = (_offset + alignment - 1) & ~(alignment - 1);
+		if (offset + size <= _capacity) {
+			_offset = offset + size;
+			_peak = std::max(_peak, used());
+			return _base + offset;
+		}
+	}
+
+	// 主块不够 (或者对齐要求比块还大)：这一次单独从堆上拿，reset 时再把主块放大
+	const size_t blockAlignment = std::max(alignment, BLOCK_ALIGNMENT);
+	std::byte* block = static_cast<std::byte*>(::operator new(size, std::align_val_t(blockAlignment)));
+	_overflow.emplace_back(block, blockAlignment);
+	_overflowBytes += size;
+	_overflows++;
+	_peak = std::max(_peak, used());
+	return block;
+}
+
+void LinearArena::reset()
+{
+	if (!_overflow.empty()) {
+		for (const auto& [block, alignment] : _overflow) {
+			::operator delete(block, std::align_val_t(alignment));
+		}
+		_overflow.clear();
+
+		// 下一帧多半还要这么多：主块换成这一帧的用量再留一半余量
+		const size_t needed = _offset + _overflowBytes;
+		if (_base) {
+			::operator delete(_base, std::align_val_t(BLOCK_ALIGNMENT));
+		}
+		_capacity = needed + needed / 2;
+		_base = static_cast<std::byte*>(::operator new(_capacity, std::align_val_t(BLOCK_ALIGNMENT)));
+	}
+	_offset = 0;
+	_overflowBytes = 0;
+}
+
+namespace {
+
+	std::atomic<uint32_t> g_nextArenasId{ 1 };
+
+	// 调用线程在哪个 FrameArenas 里登记过、它的那一组 arena (每个帧槽位一个)
+	struct ThreadArenaSlot {
+		uint32_t owner{ 0 };
+		LinearArena* arenas{ nullptr };
+	};
+	thread_local ThreadArenaSlot t_arenaSlot;
+
+	thread_local uint64_t t_heapAllocations = 0;
+}
+
+void FrameArenas::init(uint32_t frameSlots, size_t bytesPerArena)
+{
+	_frameSlots = std::max(frameSlots, 1u);
+	_bytesPerArena = bytesPerArena;
+	_slot.store(0, std::memory_order_relaxed);
+	_id = g_nextArenasId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameArenas::cleanup()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_threads.clear();
+	// 线程记住的旧 arena 指针作废，再用时重新登记
+	_id = g_nextArenasId.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameArenas::begin_frame(uint64_t frameNumber)
+{
+	const uint32_t slot = (uint32_t)(frameNumber % _frameSlots);
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	size_t used = 0;
+	for (const std::unique_ptr<LinearArena[]>& arenas : _threads) {
+		used += arenas[slot].used();
+		arenas[slot].reset();
+	}
+	_lastUsed = used;
+	_slot.store(slot, std::memory_order_release);
+}
+
+LinearArena& FrameArenas::local()
+{
+	if (t_arenaSlot.owner != _id) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::unique_ptr<LinearArena[]> arenas = std::make_unique<LinearArena[]>(_frameSlots);
+		for (uint32_t i = 0; i < _frameSlots; i++) {
+			arenas[i].init(_bytesPerArena);
+		}
+		t_arenaSlot = { _id, arenas.get() };
+		_threads.push_back(std::move(arenas));
+	}
+	return t_arenaSlot.arenas[_slot.load(std::memory_order_acquire)];
+}
+
+FrameArenaStats FrameArenas::stats() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	FrameArenaStats out;
+	out.threads = (uint32_t)_threads.size();
+	out.used = _lastUsed;
+	for (const std::unique_ptr<LinearArena[]>& arenas : _threads) {
+		for (uint32_t i = 0; i < _frameSlots; i++) {
+			out.peak = std::max(out.peak, arenas[i].peak());
+			out.overflows += arenas[i].overflows();
+		}
+	}
+	return out;
+}
+
+uint64_t vkarena::thread_heap_allocations()
+{
+	return t_heapAllocations;
+}
+
+// 替换全局的 operator new / delete，只是在前面数一下 (数组和 nothrow 版本默认转发到这几个)
+void* operator new(std::size_t size)
+{
+	t_heapAllocations++;
+	if (void* pointer = std::malloc(size > 0 ? size : 1)) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	t_heapAllocations++;
+	const size_t align = (size_t)alignment;
+#ifdef _MSC_VER
+	void* pointer = _aligned_malloc(size > 0 ? size : 1, align);
+#else
+	void* pointer = std::aligned_alloc(align, std::max((size + align - 1) & ~(align - 1), align));
+#endif
+	if (pointer) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+#ifdef _MSC_VER
+	_aligned_free(pointer);
+#else
+	std::free(pointer);
+#endif
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(pointer, alignment);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+// 每帧的线性 (bump) 分配器
+// - 分配就是把偏移往后推，释放什么都不做；整块在 reset 时一起作废
+// - 本身就是 std::pmr::memory_resource：std::pmr::vector<T> v(&arena)；非 pmr 的容器用 ArenaAllocator<T>
+// - 主块用完了就从堆上另拿一块 (这一帧照常能用)，reset 时把主块换成够大的，之后的帧不再溢出
+// - 不加锁：一个 arena 只在一个线程上用
+class LinearArena final : public std::pmr::memory_resource {
+public:
+	LinearArena() = default;
+	~LinearArena() override { release(); }
+
+	LinearArena(const LinearArena&) = delete;
+	LinearArena& operator=(const LinearArena&) = delete;
+
+	void init(size_t capacity);
+	void release();
+
+	void* allocate_raw(size_t size, size_t alignment);
+	template <typename T>
+	T* allocate_array(size_t count) { return static_cast<T*>(allocate_raw(count * sizeof(T), alignof(T))); }
+
+	// 之前的分配全部作废
+	void reset();
+
+	size_t used() const { return _offset + _overflowBytes; }
+	size_t capacity() const { return _capacity; }
+	size_t peak() const { return _peak; }
+	uint32_t overflows() const { return _overflows; } // 累计从堆上另拿的块
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override { return allocate_raw(bytes, alignment); }
+	void do_deallocate(void*, size_t, size_t) override {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+	std::byte* _base{ nullptr };
+	size_t _capacity{ 0 };
+	size_t _offset{ 0 };
+	std::vector<std::pair<std::byte*, size_t>> _overflow; // 溢出的块 (reset 时还给堆)
+	size_t _overflowBytes{ 0 };
+	size_t _peak{ 0 };
+	uint32_t _overflows{ 0 };
+};
+
+// 标准分配器接口的适配：std::vector<T, ArenaAllocator<T>> v(ArenaAllocator<T>(arena))
+template <typename T>
+class ArenaAllocator {
+public:
+	using value_type = T;
+
+	ArenaAllocator(LinearArena& arena) noexcept : _arena(&arena) {}
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept : _arena(other.arena()) {}
+
+	T* allocate(size_t count) { return _arena->allocate_array<T>(count); }
+	void deallocate(T*, size_t) noexcept {}
+
+	LinearArena* arena() const noexcept { return _arena; }
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const noexcept { return _arena == other.arena(); }
+
+private:
+	LinearArena* _arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+struct FrameArenaStats {
+	uint32_t threads{ 0 };    // 用过 arena 的线程
+	size_t used{ 0 };         // 最近一次 reset 之前，这个槽位所有线程用了多少
+	size_t peak{ 0 };         // 单个 arena 用过的最多字节
+	uint32_t overflows{ 0 };  // 累计
+};
+
+// 每个帧槽位 × 每个线程一个 LinearArena
+// begin_frame 在等过这个槽位上一次的 fence 之后调用，把这个槽位所有线程的 arena 重置
+// 帧里的临时数据 (包括这一帧等着完成的工作线程任务) 都从 local() 拿，不能留到下一次用到同一个槽位的帧
+class FrameArenas {
+public:
+	FrameArenas() = default;
+	FrameArenas(const FrameArenas&) = delete;
+	FrameArenas& operator=(const FrameArenas&) = delete;
+
+	void init(uint32_t frameSlots, size_t bytesPerArena);
+	void cleanup();
+
+	void begin_frame(uint64_t frameNumber);
+	// 当前帧、调用线程的 arena；线程第一次调用时登记 (只有这一次加锁和分配)
+	LinearArena& local();
+
+	FrameArenaStats stats() const;
+
+private:
+	uint32_t _frameSlots{ 1 };
+	size_t _bytesPerArena{ 0 };
+	std::atomic<uint32_t> _slot{ 0 };
+	uint32_t _id{ 0 };                  // 区分不同的 FrameArenas (线程记住的编号只对登记它的那个有效)
+
+	mutable std::mutex _mutex;          // 登记线程 / begin_frame / stats
+	std::vector<std::unique_ptr<LinearArena[]>> _threads; // 每个线程 _frameSlots 个
+	size_t _lastUsed{ 0 };
+};
+
+// 调试用的堆分配计数：全局 operator new 被替换成计数版本 (vk_arena.cpp)，只统计调用线程自己的分配
+// 用法：前后各取一次，差值就是中间这段代码 (在这个线程上) 的堆分配次数
+namespace vkarena {
+	uint64_t thread_heap_allocations();
+}
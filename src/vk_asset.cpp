@@ -0,0 +1,126 @@
+#include "vk_asset.h"
+#include "vk_spirv.h"
+
+#include <cstring>
+
+namespace vkasset {
+
+	bool validate(const uint8_t* data, size_t size, const char* name)
+	{
+		if (!is_asset(data, size)) {
+			vklog::error() << "Not a baked asset: " << name;
+			return false;
+		}
+
+		const AssetHeader* header = reinterpret_cast<const AssetHeader*>(data);
+		if (header->version != ASSET_VERSION) {
+			vklog::error() << "Baked asset version " << header->version << " != " << ASSET_VERSION << ", re-run AssetBaker: " << name;
+			return false;
+		}
+		if (header->fileSize != size || sizeof(AssetHeader) + (uint64_t)header->sectionCount * sizeof(SectionEntry) > size) {
+			vklog::error() << "Baked asset is truncated: " << name;
+			return false;
+		}
+
+		const SectionEntry* sections = reinterpret_cast<const SectionEntry*>(data + sizeof(AssetHeader));
+		for (uint32_t i = 0; i < header->sectionCount; i++) {
+			const SectionEntry& section = sections[i];
+			if (section.offset % ASSET_ALIGNMENT != 0 || section.offset > size || section.size > size - section.offset) {
+				vklog::error() << "Baked asset has a bad section table: " << name;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool AssetView::open(const uint8_t* data, size_t size, const char* name)
+	{
+		if (!validate(data, size, name)) {
+			return false;
+		}
+		_data = data;
+		_header = reinterpret_cast<const AssetHeader*>(data);
+		_sections = reinterpret_cast<const SectionEntry*>(data + sizeof(AssetHeader));
+		return true;
+	}
+
+	std::span<const uint8_t> AssetView::section(SectionType type) const
+	{
+		for (uint32_t i = 0; i < _header->sectionCount; i++) {
+			if (_sections[i].type == type) {
+				return { _data + _sections[i].offset, (size_t)_sections[i].size };
+			}
+		}
+		return {};
+	}
+
+	bool AssetView::verify() const
+	{
+		for (uint32_t i = 0; i < _header->sectionCount; i++) {
+			const SectionEntry& section = _sections[i];
+			if (vkspirv::hash_fnv1a(_data + section.offset, (size_t)section.size) != section.contentHash) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool load_texture(const AssetView& asset, ImageData& out)
+	{
+		const TextureInfo* info = asset.info<TextureInfo>(SectionType::TextureInfo);
+		const std::span<const ImageLevel> levels = asset.array<ImageLevel>(SectionType::Levels);
+		const std::span<const uint8_t> pixels = asset.section(SectionType::Pixels);
+		if (asset.header().kind != AssetKind::Texture || !info || levels.size() != info->levelCount || levels.empty()) {
+			return false;
+		}
+		for (const ImageLevel& level : levels) {
+			if (level.offset > pixels.size() || level.size > pixels.size() - level.offset) {
+				return false;
+			}
+		}
+
+		out.format = info->format;
+		out.width = info->width;
+		out.height = info->height;
+		out.generateMips = info->generateMips != 0;
+		out.levels.assign(levels.begin(), levels.end());
+		out.pixels.assign(pixels.begin(), pixels.end());
+		return true;
+	}
+}
+
+bool MeshAssetFile::open(const char* path)
+{
+	if (!_file.open(path)) {
+		vklog::error() << "Could not open mesh asset: " << path;
+		return false;
+	}
+	if (!_view.open(_file.data(), _file.size(), path)) {
+		_file.close();
+		return false;
+	}
+
+	using namespace vkasset;
+	_info = _view.info<MeshInfo>(SectionType::MeshInfo);
+	_vertices = _view.array<Vertex>(SectionType::Vertices);
+	_indices = _view.array<uint32_t>(SectionType::Indices);
+
+	// 只检查计数是否和段大小对得上，顶点 / 索引本身不看
+	const bool ok = _view.header().kind == AssetKind::Mesh && _info && _info->vertexLayout == VertexLayout::Full &&
+		_vertices.size() == _info->vertexCount && _indices.size() == _info->indexCount &&
+		_info->lodCount > 0 && _info->lodCount <= vklod::MAX_LODS;
+	if (!ok) {
+		vklog::error() << "Malformed mesh asset: " << path;
+		_file.close();
+		return false;
+	}
+	for (uint32_t lod = 0; lod < _info->lodCount; lod++) {
+		const vklod::Lod& range = _info->lods[lod];
+		if (range.firstIndex > _info->indexCount || range.indexCount > _info->indexCount - range.firstIndex) {
+			vklog::error() << "Malformed mesh asset: " << path;
+			_file.close();
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_file.h"
+#include "vk_image_loader.h"
+#include "vk_mesh_lod.h"
+
+// 烘焙资源 (.vasset)：AssetBaker 离线生成，运行时内存映射后按段直接拷进 staging，不做任何解析和逐元素转换
+// [AssetHeader][SectionEntry * sectionCount][各段数据...]
+// 所有段都按 ASSET_ALIGNMENT 对齐；网格顶点就是引擎的 Vertex 布局，索引是 uint32
+// sourceHash 是源文件内容 + 烘焙参数的哈希，烘焙工具据此跳过没有变化的输入
+namespace vkasset {
+
+	constexpr uint32_t ASSET_MAGIC = 0x54534156; // "VAST"
+	constexpr uint32_t ASSET_VERSION = 1;
+	constexpr uint32_t ASSET_ALIGNMENT = 16;
+
+	enum class AssetKind : uint32_t {
+		Mesh = 1,
+		Texture = 2,
+	};
+
+	enum class SectionType : uint32_t {
+		MeshInfo = 1,     // MeshInfo
+		Vertices = 2,     // Vertex[]
+		Indices = 3,      // uint32_t[]，所有 LOD 首尾相接
+		TextureInfo = 16, // TextureInfo
+		Levels = 17,      // ImageLevel[]，偏移相对 Pixels 段
+		Pixels = 18,      // 所有 mip 依次紧密排列
+	};
+
+	// 顶点布局 (以后可能有压缩的变体，运行时按它选拷贝方式)
+	enum class VertexLayout : uint32_t {
+		Full = 0, // Vertex，44 字节
+	};
+
+	struct AssetHeader {
+		uint32_t magic;
+		uint32_t version;
+		AssetKind kind;
+		uint32_t sectionCount;
+		uint64_t sourceHash;
+		uint64_t fileSize;
+	};
+
+	struct SectionEntry {
+		SectionType type;
+		uint32_t pad0;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t contentHash; // vkspirv::hash_fnv1a，verify() 用
+	};
+
+	struct MeshInfo {
+		VertexLayout vertexLayout;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t lodCount;
+		glm::vec3 center;
+		float radius;
+		vklod::Lod lods[vklod::MAX_LODS];
+	};
+
+	struct TextureInfo {
+		VkFormat format;
+		uint32_t width;
+		uint32_t height;
+		uint32_t levelCount;
+		uint32_t generateMips; // 只有第 0 层，剩下的由 GPU 生成
+		uint32_t pad0[3];
+	};
+
+	static_assert(sizeof(AssetHeader) % 8 == 0, "AssetHeader must stay 8-byte aligned");
+	static_assert(sizeof(SectionEntry) % 8 == 0, "SectionEntry must stay 8-byte aligned");
+	static_assert(sizeof(Vertex) == 44, "Baked vertices are the engine Vertex layout");
+
+	// 只校验头和段表 (magic / 版本 / 每段都在文件内且对齐)，不碰段内容
+	bool validate(const uint8_t* data, size_t size, const char* name);
+
+	// 一个已经映射 (或已经读进内存) 的烘焙资源，只是段表上的视图
+	class AssetView {
+	public:
+		bool open(const uint8_t* data, size_t size, const char* name);
+
+		const AssetHeader& header() const { return *_header; }
+		std::span<const uint8_t> section(SectionType type) const;
+
+		template<typename T>
+		const T* info(SectionType type) const
+		{
+			std::span<const uint8_t> bytes = section(type);
+			return bytes.size() >= sizeof(T) ? reinterpret_cast<const T*>(bytes.data()) : nullptr;
+		}
+
+		template<typename T>
+		std::span<const T> array(SectionType type) const
+		{
+			std::span<const uint8_t> bytes = section(type);
+			return { reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T) };
+		}
+
+		// 逐段重新算内容哈希 (烘焙工具 / 调试用，运行时加载不做)
+		bool verify() const;
+
+	private:
+		const uint8_t* _data{ nullptr };
+		const AssetHeader* _header{ nullptr };
+		const SectionEntry* _sections{ nullptr };
+	};
+
+	// 烘焙好的纹理 -> ImageData (像素段整段拷贝一次)
+	bool load_texture(const AssetView& asset, ImageData& out);
+
+	inline bool is_asset(const uint8_t* data, size_t size)
+	{
+		return size >= sizeof(AssetHeader) && reinterpret_cast<const AssetHeader*>(data)->magic == ASSET_MAGIC;
+	}
+}
+
+// 内存映射的烘焙网格：顶点 / 索引段直接指向映射内存
+class MeshAssetFile {
+public:
+	bool open(const char* path);
+	void close() { _file.close(); }
+
+	const vkasset::MeshInfo& info() const { return *_info; }
+	std::span<const Vertex> vertices() const { return _vertices; }
+	std::span<const uint32_t> indices() const { return _indices; }
+	std::span<const vklod::Lod> lods() const { return { _info->lods, _info->lodCount }; }
+
+private:
+	MappedFile _file;
+	vkasset::AssetView _view;
+	const vkasset::MeshInfo* _info{ nullptr };
+	std::span<const Vertex> _vertices;
+	std::span<const uint32_t> _indices;
+};
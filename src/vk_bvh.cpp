@@ -0,0 +1,823 @@
+#include "vk_bvh.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VKBVH_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace vkbvh {
+
+	namespace {
+
+		constexpr float BIG = std::numeric_limits<float>::max();
+		constexpr uint32_t SAH_BINS = 16;
+		constexpr size_t SMALL_SPLIT = 16; // 不超过这么多物体时不分桶
+
+		// 空槽位 / 删掉的物体：反的包围盒，和什么都不相交
+		const Aabb EMPTY_BOX = { glm::vec3(BIG), glm::vec3(-BIG) };
+
+		bool is_empty(const Aabb& box)
+		{
+			return box.lo.x > box.hi.x || box.lo.y > box.hi.y || box.lo.z > box.hi.z;
+		}
+
+		Aabb merge(const Aabb& a, const Aabb& b)
+		{
+			return { glm::min(a.lo, b.lo), glm::max(a.hi, b.hi) };
+		}
+
+		float area(const Aabb& box)
+		{
+			if (is_empty(box)) {
+				return 0.0f;
+			}
+			const glm::vec3 d = box.hi - box.lo;
+			return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+		}
+
+		Aabb slot_box(const Node& node, uint32_t slot)
+		{
+			return { glm::vec3(node.loX[slot], node.loY[slot], node.loZ[slot]), glm::vec3(node.hiX[slot], node.hiY[slot], node.hiZ[slot]) };
+		}
+
+		void set_slot_box(Node& node, uint32_t slot, const Aabb& box)
+		{
+			node.loX[slot] = box.lo.x;
+			node.loY[slot] = box.lo.y;
+			node.loZ[slot] = box.lo.z;
+			node.hiX[slot] = box.hi.x;
+			node.hiY[slot] = box.hi.y;
+			node.hiZ[slot] = box.hi.z;
+		}
+
+		Aabb node_box(const Node& node)
+		{
+			Aabb box = EMPTY_BOX;
+			for (uint32_t slot = 0; slot < 4; slot++) {
+				box = merge(box, slot_box(node, slot));
+			}
+			return box;
+		}
+
+		bool overlaps(const Aabb& a, const Aabb& b)
+		{
+			return a.lo.x <= b.hi.x && a.hi.x >= b.lo.x && a.lo.y <= b.hi.y && a.hi.y >= b.lo.y && a.lo.z <= b.hi.z && a.hi.z >= b.lo.z;
+		}
+
+		// 预先算好的射线：方向分量为 0 时换成极小值，倒数是有限的大数 (不会出现 0 * inf)
+		struct PreparedRay {
+			glm::vec3 origin;
+			glm::vec3 inverse;
+		};
+
+		PreparedRay prepare(const Ray& ray)
+		{
+			PreparedRay prepared;
+			prepared.origin = ray.origin;
+			for (int axis = 0; axis < 3; axis++) {
+				const float d = ray.direction[axis];
+				prepared.inverse[axis] = 1.0f / (std::abs(d) < 1e-20f ? std::copysign(1e-20f, d) : d);
+			}
+			return prepared;
+		}
+
+		// 射线进入包围盒的距离，没打中 (或者比 maxDistance 远) 时返回 false
+		// 反的包围盒要单独排除：方向分量接近 0 时两个平面的距离是正负无穷，看起来像打中了
+		bool intersect(const PreparedRay& ray, const Aabb& box, float maxDistance, float& distance)
+		{
+			if (is_empty(box)) {
+				return false;
+			}
+			float tmin = 0.0f;
+			float tmax = maxDistance;
+			for (int axis = 0; axis < 3; axis++) {
+				const float t0 = (box.lo[axis] - ray.origin[axis]) * ray.inverse[axis];
+				const float t1 = (box.hi[axis] - ray.origin[axis]) * ray.inverse[axis];
+				tmin = std::max(tmin, std::min(t0, t1));
+				tmax = std::min(tmax, std::max(t0, t1));
+			}
+			distance = tmin;
+			return tmin <= tmax;
+		}
+
+		// 一条射线对一个节点的 4 个槽位：打中的槽位放进 mask 的低 4 位，进入距离写进 distances
+		uint32_t intersect_node(const PreparedRay& ray, const Node& node, float maxDistance, float distances[4])
+		{
+#ifdef VKBVH_SSE
+			const __m128 ox = _mm_set1_ps(ray.origin.x);
+			const __m128 oy = _mm_set1_ps(ray.origin.y);
+			const __m128 oz = _mm_set1_ps(ray.origin.z);
+			const __m128 ix = _mm_set1_ps(ray.inverse.x);
+			const __m128 iy = _mm_set1_ps(ray.inverse.y);
+			const __m128 iz = _mm_set1_ps(ray.inverse.z);
+			const __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.loX), ox), ix);
+			const __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.hiX), ox), ix);
+			const __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.loY), oy), iy);
+			const __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.hiY), oy), iy);
+			const __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.loZ), oz), iz);
+			const __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.hiZ), oz), iz);
+			const __m128 tmin = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_max_ps(_mm_min_ps(z0, z1), _mm_setzero_ps()));
+			const __m128 tmax = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_min_ps(_mm_max_ps(z0, z1), _mm_set1_ps(maxDistance)));
+			_mm_storeu_ps(distances, tmin);
+			// 反的包围盒 (空槽位 / 子树全删光了) 只看 x 就够：它三个轴都是反的
+			const __m128 valid = _mm_cmple_ps(_mm_load_ps(node.loX), _mm_load_ps(node.hiX));
+			return (uint32_t)_mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(tmin, tmax), valid));
+#else
+			uint32_t mask = 0;
+			for (uint32_t slot = 0; slot < 4; slot++) {
+				if (intersect(ray, slot_box(node, slot), maxDistance, distances[slot])) {
+					mask |= 1u << slot;
+				}
+			}
+			return mask;
+#endif
+		}
+
+		// 一个包围盒对一个节点的 4 个槽位
+		uint32_t overlap_node(const Aabb& box, const Node& node)
+		{
+#ifdef VKBVH_SSE
+			__m128 hit = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.loX), _mm_set1_ps(box.hi.x)), _mm_cmpge_ps(_mm_load_ps(node.hiX), _mm_set1_ps(box.lo.x)));
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.loY), _mm_set1_ps(box.hi.y)), _mm_cmpge_ps(_mm_load_ps(node.hiY), _mm_set1_ps(box.lo.y))));
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmple_ps(_mm_load_ps(node.loZ), _mm_set1_ps(box.hi.z)), _mm_cmpge_ps(_mm_load_ps(node.hiZ), _mm_set1_ps(box.lo.z))));
+			return (uint32_t)_mm_movemask_ps(hit);
+#else
+			uint32_t mask = 0;
+			for (uint32_t slot = 0; slot < 4; slot++) {
+				if (overlaps(slot_box(node, slot), box)) {
+					mask |= 1u << slot;
+				}
+			}
+			return mask;
+#endif
+		}
+
+		// 视锥：每个平面取包围盒在法线方向上最远的角 (p 顶点)，它在平面背面就整个在外面
+		// 平面固定，按法线的符号预先选好取 lo 还是 hi，4 个槽位一起算
+		uint32_t frustum_node(const glm::vec4 planes[6], const Node& node)
+		{
+#ifdef VKBVH_SSE
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (uint32_t i = 0; i < 6; i++) {
+				const glm::vec4& p = planes[i];
+				const __m128 px = _mm_load_ps(p.x >= 0.0f ? node.hiX : node.loX);
+				const __m128 py = _mm_load_ps(p.y >= 0.0f ? node.hiY : node.loY);
+				const __m128 pz = _mm_load_ps(p.z >= 0.0f ? node.hiZ : node.loZ);
+				__m128 d = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(p.x)), _mm_set1_ps(p.w));
+				d = _mm_add_ps(d, _mm_mul_ps(py, _mm_set1_ps(p.y)));
+				d = _mm_add_ps(d, _mm_mul_ps(pz, _mm_set1_ps(p.z)));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(d, _mm_setzero_ps()));
+			}
+			return (uint32_t)_mm_movemask_ps(inside);
+#else
+			uint32_t mask = 0xF;
+			for (uint32_t i = 0; i < 6; i++) {
+				const glm::vec4& p = planes[i];
+				for (uint32_t slot = 0; slot < 4; slot++) {
+					const float d = (p.x >= 0.0f ? node.hiX[slot] : node.loX[slot]) * p.x + (p.y >= 0.0f ? node.hiY[slot] : node.loY[slot]) * p.y +
+						(p.z >= 0.0f ? node.hiZ[slot] : node.loZ[slot]) * p.z + p.w;
+					if (d < 0.0f) {
+						mask &= ~(1u << slot);
+					}
+				}
+			}
+			return mask;
+#endif
+		}
+
+		bool in_frustum(const glm::vec4 planes[6], const Aabb& box)
+		{
+			if (is_empty(box)) {
+				return false;
+			}
+			for (uint32_t i = 0; i < 6; i++) {
+				const glm::vec4& p = planes[i];
+				const glm::vec3 corner(p.x >= 0.0f ? box.hi.x : box.lo.x, p.y >= 0.0f ? box.hi.y : box.lo.y, p.z >= 0.0f ? box.hi.z : box.lo.z);
+				if (glm::dot(glm::vec3(p), corner) + p.w < 0.0f) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		// 节点 / 槽位测试之后的公共遍历：test 返回命中的槽位，物体交给 out
+		template<typename Test>
+		void collect_objects(const Snapshot& snapshot, Test&& test, std::vector<uint32_t>& out)
+		{
+			if (snapshot.nodes.empty()) {
+				return;
+			}
+			thread_local std::vector<uint32_t> stack;
+			stack.clear();
+			stack.push_back(0);
+			while (!stack.empty()) {
+				const Node& node = snapshot.nodes[stack.back()];
+				stack.pop_back();
+				uint32_t mask = test(node);
+				while (mask) {
+					const uint32_t slot = (uint32_t)std::countr_zero(mask);
+					mask &= mask - 1;
+					const uint32_t child = node.children[slot];
+					if (child == INVALID_INDEX) {
+						continue;
+					}
+					if (child & OBJECT_BIT) {
+						out.push_back(child & ~OBJECT_BIT);
+					}
+					else {
+						stack.push_back(child);
+					}
+				}
+			}
+		}
+	}
+
+	void raycast(const Snapshot& snapshot, std::span<const Ray> rays, std::span<RayHit> hits)
+	{
+		struct Entry {
+			uint32_t node;
+			float distance;
+		};
+		thread_local std::vector<Entry> stack;
+
+		for (size_t r = 0; r < rays.size() && r < hits.size(); r++) {
+			const PreparedRay ray = prepare(rays[r]);
+			RayHit best = {};
+			float bestDistance = rays[r].maxDistance;
+
+			// 还没进树的物体先测，给遍历一个更近的上界
+			for (size_t i = 0; i < snapshot.extraObjects.size(); i++) {
+				float distance;
+				if (intersect(ray, snapshot.extraBounds[i], bestDistance, distance)) {
+					bestDistance = distance;
+					best = { snapshot.extraObjects[i], distance };
+				}
+			}
+
+			// 由近到远：打中的子节点按进入距离排序后倒着压栈，出栈时比当前最近的还远就跳过
+			stack.clear();
+			if (!snapshot.nodes.empty()) {
+				stack.push_back({ 0, 0.0f });
+			}
+			while (!stack.empty()) {
+				const Entry entry = stack.back();
+				stack.pop_back();
+				if (entry.distance > bestDistance) {
+					continue;
+				}
+				const Node& node = snapshot.nodes[entry.node];
+				float distances[4];
+				uint32_t mask = intersect_node(ray, node, bestDistance, distances);
+
+				Entry children[4];
+				uint32_t childCount = 0;
+				while (mask) {
+					const uint32_t slot = (uint32_t)std::countr_zero(mask);
+					mask &= mask - 1;
+					const uint32_t child = node.children[slot];
+					if (child == INVALID_INDEX) {
+						continue;
+					}
+					if (child & OBJECT_BIT) {
+						if (distances[slot] <= bestDistance) {
+							bestDistance = distances[slot];
+							best = { child & ~OBJECT_BIT, distances[slot] };
+						}
+					}
+					else {
+						children[childCount++] = { child, distances[slot] };
+					}
+				}
+				std::sort(children, children + childCount, [](const Entry& a, const Entry& b) { return a.distance > b.distance; });
+				for (uint32_t i = 0; i < childCount; i++) {
+					stack.push_back(children[i]);
+				}
+			}
+			hits[r] = best;
+		}
+	}
+
+	void query_box(const Snapshot& snapshot, const Aabb& box, std::vector<uint32_t>& out)
+	{
+		for (size_t i = 0; i < snapshot.extraObjects.size(); i++) {
+			if (overlaps(snapshot.extraBounds[i], box)) {
+				out.push_back(snapshot.extraObjects[i]);
+			}
+		}
+		collect_objects(snapshot, [&](const Node& node) { return overlap_node(box, node); }, out);
+	}
+
+	void query_frustum(const Snapshot& snapshot, const glm::vec4 planes[6], std::vector<uint32_t>& out)
+	{
+		for (size_t i = 0; i < snapshot.extraObjects.size(); i++) {
+			if (in_frustum(planes, snapshot.extraBounds[i])) {
+				out.push_back(snapshot.extraObjects[i]);
+			}
+		}
+		collect_objects(snapshot, [&](const Node& node) { return frustum_node(planes, node); }, out);
+	}
+
+	void frustum_planes(const glm::mat4& viewProj, glm::vec4 out[6])
+	{
+		// 深度 0..1：近平面就是第 3 行 (和 MeshletRenderer 一样)
+		auto row = [&](int i) { return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]); };
+		const glm::vec4 planes[6] = {
+			row(3) + row(0), row(3) - row(0),
+			row(3) + row(1), row(3) - row(1),
+			row(2), row(3) - row(2),
+		};
+		for (uint32_t i = 0; i < 6; i++) {
+			out[i] = planes[i] / glm::length(glm::vec3(planes[i]));
+		}
+	}
+}
+
+using namespace vkbvh;
+
+namespace {
+
+	struct BuildRef {
+		Aabb box;
+		glm::vec3 centroid;
+		uint32_t object;
+	};
+
+	// 按质心分桶的 SAH，把 [begin, end) 分成两段，返回分界；质心全部重合时按下标对半分
+	size_t split(std::vector<BuildRef>& refs, size_t begin, size_t end)
+	{
+		Aabb centroids = { refs[begin].centroid, refs[begin].centroid };
+		for (size_t i = begin; i < end; i++) {
+			centroids.lo = glm::min(centroids.lo, refs[i].centroid);
+			centroids.hi = glm::max(centroids.hi, refs[i].centroid);
+		}
+		const glm::vec3 extent = centroids.hi - centroids.lo;
+
+		// 范围很小时分桶的固定开销 (48 个桶 + 扫描) 比收益大：沿质心最长的轴从中间分
+		if (end - begin <= SMALL_SPLIT) {
+			const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+			const size_t mid = begin + (end - begin) / 2;
+			std::nth_element(refs.begin() + begin, refs.begin() + mid, refs.begin() + end,
+				[axis](const BuildRef& a, const BuildRef& b) { return a.centroid[axis] < b.centroid[axis]; });
+			return mid;
+		}
+
+		struct Bin {
+			Aabb box;
+			uint32_t count;
+		};
+		Bin bins[3][SAH_BINS];
+		glm::vec3 scale;
+		for (int axis = 0; axis < 3; axis++) {
+			for (Bin& bin : bins[axis]) {
+				bin = { EMPTY_BOX, 0 };
+			}
+			scale[axis] = extent[axis] > 1e-6f ? SAH_BINS / extent[axis] : 0.0f;
+		}
+		// 三个轴一次扫完 (只读一遍 refs)
+		for (size_t i = begin; i < end; i++) {
+			const BuildRef& ref = refs[i];
+			const glm::vec3 offset = (ref.centroid - centroids.lo) * scale;
+			for (int axis = 0; axis < 3; axis++) {
+				Bin& bin = bins[axis][std::min((uint32_t)offset[axis], SAH_BINS - 1)];
+				bin.box.lo = glm::min(bin.box.lo, ref.box.lo);
+				bin.box.hi = glm::max(bin.box.hi, ref.box.hi);
+				bin.count++;
+			}
+		}
+
+		float bestCost = std::numeric_limits<float>::max();
+		int bestAxis = -1;
+		uint32_t bestBin = 0;
+		for (int axis = 0; axis < 3; axis++) {
+			if (scale[axis] == 0.0f) {
+				continue;
+			}
+			// 从右往左累计，再从左往右扫一遍：cost = 左面积 * 左数量 + 右面积 * 右数量
+			float rightArea[SAH_BINS];
+			uint32_t rightCount[SAH_BINS];
+			Aabb box = EMPTY_BOX;
+			uint32_t count = 0;
+			for (uint32_t b = SAH_BINS - 1; b > 0; b--) {
+				box = merge(box, bins[axis][b].box);
+				count += bins[axis][b].count;
+				rightArea[b] = area(box);
+				rightCount[b] = count;
+			}
+			box = EMPTY_BOX;
+			count = 0;
+			for (uint32_t b = 1; b < SAH_BINS; b++) {
+				box = merge(box, bins[axis][b - 1].box);
+				count += bins[axis][b - 1].count;
+				if (count == 0 || rightCount[b] == 0) {
+					continue;
+				}
+				const float cost = area(box) * count + rightArea[b] * rightCount[b];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = b;
+				}
+			}
+		}
+
+		if (bestAxis >= 0) {
+			const float axisScale = scale[bestAxis];
+			const float lo = centroids.lo[bestAxis];
+			auto middle = std::partition(refs.begin() + begin, refs.begin() + end, [&](const BuildRef& ref) {
+				return std::min((uint32_t)((ref.centroid[bestAxis] - lo) * axisScale), SAH_BINS - 1) < bestBin;
+			});
+			const size_t mid = (size_t)(middle - refs.begin());
+			if (mid > begin && mid < end) {
+				return mid;
+			}
+		}
+		return begin + (end - begin) / 2;
+	}
+
+	struct Builder {
+		std::vector<BuildRef>& refs;
+		std::vector<Node>& nodes;
+		std::vector<uint32_t>& parents;
+		std::vector<std::pair<uint32_t, uint32_t>>& slots;
+		double totalArea{ 0.0 };
+
+		// [begin, end) 至少两个物体，返回节点下标和它的包围盒
+		uint32_t build_node(size_t begin, size_t end, uint32_t parentSlot, Aabb& bounds)
+		{
+			const uint32_t index = (uint32_t)nodes.size();
+			nodes.emplace_back();
+			parents.push_back(parentSlot);
+			for (uint32_t slot = 0; slot < 4; slot++) {
+				set_slot_box(nodes[index], slot, EMPTY_BOX);
+				nodes[index].children[slot] = INVALID_INDEX;
+			}
+
+			// 最多 4 组：不超过 4 个物体时一个一组，否则切两半、两半再各切一次
+			size_t bounds4[5];
+			uint32_t groups = 0;
+			const size_t count = end - begin;
+			if (count <= 4) {
+				for (size_t i = begin; i <= end; i++) {
+					bounds4[groups++] = i;
+				}
+				groups--;
+			}
+			else {
+				const size_t mid = split(refs, begin, end);
+				bounds4[groups++] = begin;
+				if (mid - begin > 1) {
+					bounds4[groups++] = split(refs, begin, mid);
+				}
+				bounds4[groups++] = mid;
+				if (end - mid > 1) {
+					bounds4[groups++] = split(refs, mid, end);
+				}
+				bounds4[groups] = end;
+			}
+
+			bounds = EMPTY_BOX;
+			for (uint32_t slot = 0; slot < groups; slot++) {
+				const size_t first = bounds4[slot];
+				const size_t last = bounds4[slot + 1];
+				Aabb box;
+				uint32_t child;
+				if (last - first == 1) {
+					box = refs[first].box;
+					child = OBJECT_BIT | refs[first].object;
+					slots.push_back({ refs[first].object, index * 4 + slot });
+				}
+				else {
+					child = build_node(first, last, index * 4 + slot, box);
+				}
+				set_slot_box(nodes[index], slot, box);
+				nodes[index].children[slot] = child;
+				totalArea += area(box);
+				bounds = merge(bounds, box);
+			}
+			return index;
+		}
+	};
+}
+
+void SceneBvh::build(std::vector<std::pair<uint32_t, Aabb>> objects, Build& out)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	out.tree = std::make_shared<Snapshot>();
+	out.parents.clear();
+	out.slots.clear();
+	out.area = 0.0;
+
+	std::vector<BuildRef> refs;
+	refs.reserve(objects.size());
+	for (const auto& [object, box] : objects) {
+		refs.push_back({ box, (box.lo + box.hi) * 0.5f, object });
+	}
+	objects = {};
+
+	if (!refs.empty()) {
+		// 大约 N / 3 个节点 (每个节点 4 个槽位，其中一个指向父节点以外的都是物体或子节点)
+		out.tree->nodes.reserve(refs.size() / 2 + 1);
+		out.parents.reserve(refs.size() / 2 + 1);
+		out.slots.reserve(refs.size());
+		Builder builder{ refs, out.tree->nodes, out.parents, out.slots };
+		if (refs.size() == 1) {
+			// 一个物体也放进一个节点，根永远是节点
+			Node root = {};
+			for (uint32_t slot = 0; slot < 4; slot++) {
+				set_slot_box(root, slot, EMPTY_BOX);
+				root.children[slot] = INVALID_INDEX;
+			}
+			set_slot_box(root, 0, refs[0].box);
+			root.children[0] = OBJECT_BIT | refs[0].object;
+			out.tree->nodes.push_back(root);
+			out.parents.push_back(INVALID_INDEX);
+			out.slots.push_back({ refs[0].object, 0 });
+			builder.totalArea = area(refs[0].box);
+		}
+		else {
+			Aabb bounds;
+			builder.build_node(0, refs.size(), INVALID_INDEX, bounds);
+		}
+		out.area = builder.totalArea;
+	}
+	out.spare = std::make_shared<Snapshot>(*out.tree);
+	out.ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void SceneBvh::init(JobSystem* jobs)
+{
+	_jobs = jobs;
+	_current = std::make_shared<Snapshot>();
+}
+
+void SceneBvh::mark(uint32_t object)
+{
+	if (!_objects[object].pending) {
+		_objects[object].pending = true;
+		_pending.push_back(object);
+	}
+}
+
+void SceneBvh::set_bounds(uint32_t object, const Aabb& bounds)
+{
+	if ((object & OBJECT_BIT) != 0) {
+		return;
+	}
+	if (object >= _objects.size()) {
+		_objects.resize((size_t)object + 1);
+	}
+	Object& state = _objects[object];
+	if (state.alive && state.bounds.lo == bounds.lo && state.bounds.hi == bounds.hi) {
+		return;
+	}
+	if (!state.alive) {
+		state.alive = true;
+		_aliveCount++;
+	}
+	state.bounds = bounds;
+	mark(object);
+}
+
+void SceneBvh::remove(uint32_t object)
+{
+	if (object >= _objects.size() || !_objects[object].alive) {
+		return;
+	}
+	_objects[object].alive = false;
+	_aliveCount--;
+	mark(object);
+}
+
+std::shared_ptr<const Snapshot> SceneBvh::snapshot() const
+{
+	std::lock_guard<std::mutex> lock(_snapshotMutex);
+	return _current;
+}
+
+std::vector<std::pair<uint32_t, Aabb>> SceneBvh::collect() const
+{
+	std::vector<std::pair<uint32_t, Aabb>> objects;
+	objects.reserve(_aliveCount);
+	for (uint32_t object = 0; object < _objects.size(); object++) {
+		if (_objects[object].alive) {
+			objects.push_back({ object, _objects[object].bounds });
+		}
+	}
+	return objects;
+}
+
+void SceneBvh::start_rebuild()
+{
+	// 按现在的包围盒拷一份交给工作线程；之后改过的物体记在 _changedDuringBuild 里
+	_build = std::make_shared<Build>();
+	_changedDuringBuild.clear();
+	_jobs->submit([build = _build, objects = collect()]() mutable {
+		SceneBvh::build(std::move(objects), *build);
+		build->done.store(true, std::memory_order_release);
+	});
+}
+
+std::shared_ptr<Snapshot> SceneBvh::install(Build& build)
+{
+	for (Object& object : _objects) {
+		object.slot = INVALID_INDEX;
+		object.extra = INVALID_INDEX;
+	}
+	for (const auto& [object, slot] : build.slots) {
+		_objects[object].slot = slot;
+	}
+	_parents = std::move(build.parents);
+	_area = build.area;
+	_buildArea = build.area;
+	_garbage = 0;
+	_updatesSinceBuild = 0;
+	_moved = false;
+	_stats.rebuilds++;
+	_stats.buildMs = build.ms;
+
+	// 拓扑换了：上一版不能再拿来补节点，换成和新树一样的副本
+	build.tree->generation = ++_generation;
+	build.spare->generation = _generation;
+	_spare = std::move(build.spare);
+	_lastDirty.clear();
+	_dirty.clear();
+	return std::move(build.tree);
+}
+
+std::shared_ptr<Snapshot> SceneBvh::writable()
+{
+	std::shared_ptr<Snapshot> next;
+	// 上一版只剩这里一个引用 (查询都放手了)：补上上次改的节点就和当前版一样了
+	// use_count 之后的 acquire 屏障：放手的线程对它的读在我们改写之前完成
+	if (_spare && _spare.use_count() == 1 && _spare->generation == _current->generation) {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		next = std::move(_spare);
+		for (uint32_t node : _lastDirty) {
+			next->nodes[node] = _current->nodes[node];
+		}
+		next->extraObjects = _current->extraObjects;
+		next->extraBounds = _current->extraBounds;
+	}
+	else {
+		next = std::make_shared<Snapshot>(*_current);
+	}
+	_spare.reset();
+	return next;
+}
+
+void SceneBvh::refit(Snapshot& tree, uint32_t slot, const Aabb& bounds)
+{
+	uint32_t node = slot >> 2;
+	Aabb box = bounds;
+	for (;;) {
+		Node& target = tree.nodes[node];
+		const Aabb old = slot_box(target, slot & 3);
+		if (old.lo == box.lo && old.hi == box.hi) {
+			return;
+		}
+		_area += (double)area(box) - (double)area(old);
+		set_slot_box(target, slot & 3, box);
+		_dirty.push_back(node);
+
+		// 父节点里指向这个节点的槽位 = 这个节点 4 个槽位的并集
+		slot = _parents[node];
+		if (slot == INVALID_INDEX) {
+			return;
+		}
+		box = node_box(target);
+		node = slot >> 2;
+	}
+}
+
+void SceneBvh::apply(Snapshot& tree, uint32_t object)
+{
+	Object& state = _objects[object];
+	state.pending = false;
+	if (_build) {
+		_changedDuringBuild.push_back(object);
+	}
+
+	if (state.slot != INVALID_INDEX) {
+		if (state.alive) {
+			refit(tree, state.slot, state.bounds);
+			_moved = true;
+			_stats.refits++;
+		}
+		else {
+			// 删掉的物体槽位清空，下次重建时才真正去掉
+			refit(tree, state.slot, EMPTY_BOX);
+			tree.nodes[state.slot >> 2].children[state.slot & 3] = INVALID_INDEX;
+			_dirty.push_back(state.slot >> 2);
+			state.slot = INVALID_INDEX;
+			_garbage++;
+		}
+		return;
+	}
+
+	// 不在树里：放进 extra (逐个测)，删掉时和最后一个交换
+	if (state.alive) {
+		if (state.extra == INVALID_INDEX) {
+			state.extra = (uint32_t)tree.extraObjects.size();
+			tree.extraObjects.push_back(object);
+			tree.extraBounds.push_back(state.bounds);
+		}
+		else {
+			tree.extraBounds[state.extra] = state.bounds;
+		}
+	}
+	else if (state.extra != INVALID_INDEX) {
+		const uint32_t last = tree.extraObjects.back();
+		tree.extraObjects[state.extra] = last;
+		tree.extraBounds[state.extra] = tree.extraBounds.back();
+		_objects[last].extra = state.extra;
+		tree.extraObjects.pop_back();
+		tree.extraBounds.pop_back();
+		state.extra = INVALID_INDEX;
+	}
+}
+
+void SceneBvh::publish(std::shared_ptr<Snapshot> next)
+{
+	std::sort(_dirty.begin(), _dirty.end());
+	_dirty.erase(std::unique(_dirty.begin(), _dirty.end()), _dirty.end());
+	_stats.refitNodes = (uint32_t)_dirty.size();
+	_lastDirty.swap(_dirty);
+	_dirty.clear();
+
+	next->version = _current->version + 1;
+	std::shared_ptr<Snapshot> previous;
+	{
+		std::lock_guard<std::mutex> lock(_snapshotMutex);
+		previous = std::move(_current);
+		_current = std::move(next);
+	}
+	// 同一棵树的上一版留着，下次没人用时拿来改
+	if (previous->generation == _current->generation) {
+		_spare = std::move(previous);
+	}
+}
+
+void SceneBvh::update()
+{
+	_stats.refits = 0;
+	_stats.refitNodes = 0;
+	_updatesSinceBuild++;
+	std::shared_ptr<Snapshot> next;
+
+	// 1. 还没有树而物体已经很多 (比如刚加载完场景)：直接在这里建，不让查询逐个测一大堆物体
+	if (!_build && _current->nodes.empty() && _aliveCount >= SYNC_BUILD_OBJECTS) {
+		Build result;
+		build(collect(), result);
+		next = install(result);
+		// 改动都已经包含在新树里了
+		for (uint32_t object : _pending) {
+			_objects[object].pending = false;
+		}
+		_pending.clear();
+	}
+	// 2. 后台建好的树：换上之后把建树期间改过的物体 (移动 / 新加 / 删掉) 再处理一遍
+	else if (_build && _build->done.load(std::memory_order_acquire)) {
+		next = install(*_build);
+		_build.reset();
+		for (uint32_t object : _changedDuringBuild) {
+			mark(object);
+		}
+		_changedDuringBuild.clear();
+	}
+
+	// 3. 这一次的改动
+	if (!_pending.empty()) {
+		if (!next) {
+			next = writable();
+		}
+		for (uint32_t object : _pending) {
+			apply(*next, object);
+		}
+		_pending.clear();
+	}
+	if (next) {
+		publish(std::move(next));
+	}
+
+	_stats.objects = _aliveCount;
+	_stats.nodes = (uint32_t)_current->nodes.size();
+	_stats.extra = (uint32_t)_current->extraObjects.size();
+	_stats.quality = _buildArea > 0.0 ? (float)(_area / _buildArea) : 1.0f;
+
+	// 4. 需要时开始后台重建 (同时只有一个)
+	if (!_build && _jobs) {
+		const bool tooManyExtra = _stats.extra > MAX_EXTRA_OBJECTS || (_current->nodes.empty() && _stats.extra > 0);
+		const bool degraded = _stats.quality > REBUILD_QUALITY;
+		const bool garbage = _garbage > 0 && (float)_garbage > REBUILD_GARBAGE * (float)std::max(_aliveCount, 1u);
+		const bool periodic = _moved && _updatesSinceBuild >= REBUILD_INTERVAL;
+		if (tooManyExtra || degraded || garbage || periodic) {
+			start_rebuild();
+		}
+	}
+}
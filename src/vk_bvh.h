@@ -0,0 +1,160 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_jobs.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+// 场景查询用的 BVH (纯 CPU，物体级别的包围盒)
+// - 4 叉树：每个节点 4 个槽位，包围盒按分量分开存 (SoA)，一次 SSE 测 4 个子包围盒；槽位要么是子节点，要么直接是一个物体
+// - 构建：按质心分桶的 SAH，每个节点先切两半、两半再各切一次；节点按先序排列，子节点下标总比父节点大
+// - 物体移动：只改它所在的槽位，沿父节点往上合并包围盒 (refit)，拓扑不变
+// - 树的质量 (所有槽位包围盒的面积和) 变差、新物体太多或者隔一段时间，就在工作线程上按当时的包围盒重建，建好后在下一次 update 换上
+// - 查询 (射线 / 视锥 / 包围盒) 只读一个不可变的快照，任何线程都可以同时查；
+//   所有者每次 update 发布新快照，正在用旧快照的查询不受影响 (快照没人用了才回收，下一次 update 只补改过的节点)
+namespace vkbvh {
+
+	constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+	constexpr uint32_t OBJECT_BIT = 0x80000000u; // 槽位里是物体 (低位是物体编号)，否则是子节点下标
+
+	struct Aabb {
+		glm::vec3 lo{ 0.0f };
+		glm::vec3 hi{ 0.0f };
+	};
+
+	struct alignas(16) Node {
+		float loX[4], loY[4], loZ[4];
+		float hiX[4], hiY[4], hiZ[4];
+		uint32_t children[4]; // 空槽位是 INVALID_INDEX，包围盒是反的 (lo > hi)，什么都测不中
+	};
+	static_assert(sizeof(Node) == 112);
+
+	// 不可变的快照：nodes[0] 是根；还没进树的物体 (上次重建之后才加入的) 在 extra 里逐个测
+	struct Snapshot {
+		std::vector<Node> nodes;
+		std::vector<uint32_t> extraObjects;
+		std::vector<Aabb> extraBounds;
+		uint64_t version{ 0 };    // 每次发布加一
+		uint64_t generation{ 0 }; // 第几棵树 (重建之后拓扑不同)
+	};
+
+	struct Ray {
+		glm::vec3 origin;
+		glm::vec3 direction;      // 不用归一化，距离按 direction 的长度计
+		float maxDistance{ 1e30f };
+	};
+
+	struct RayHit {
+		uint32_t object{ INVALID_INDEX }; // 没打中时是 INVALID_INDEX
+		float distance{ 0.0f };           // 射线进入物体包围盒的位置
+	};
+
+	// 一批射线：每条找最近的物体包围盒 (hits 和 rays 一样长)
+	// 只到包围盒这一级，需要精确到三角形的调用方用返回的物体自己再测
+	void raycast(const Snapshot& snapshot, std::span<const Ray> rays, std::span<RayHit> hits);
+	// 和包围盒相交的物体，追加到 out
+	void query_box(const Snapshot& snapshot, const Aabb& box, std::vector<uint32_t>& out);
+	// 和视锥相交 (或者在里面) 的物体，追加到 out；planes 朝内，xyz 是法线，w 是距离
+	void query_frustum(const Snapshot& snapshot, const glm::vec4 planes[6], std::vector<uint32_t>& out);
+	// 从 viewProj (深度 0..1) 的行提取视锥平面
+	void frustum_planes(const glm::mat4& viewProj, glm::vec4 out[6]);
+}
+
+struct BvhStats {
+	uint32_t objects{ 0 };     // 活着的物体
+	uint32_t nodes{ 0 };
+	uint32_t extra{ 0 };       // 还没进树的物体
+	uint32_t refits{ 0 };      // 最近一次 update 移动的物体
+	uint32_t refitNodes{ 0 };  // 最近一次 update 改过的节点
+	uint32_t rebuilds{ 0 };    // 累计 (同步 + 后台)
+	float quality{ 1.0f };     // 当前面积和 / 建树时的面积和
+	float buildMs{ 0.0f };     // 最近一次建树
+};
+
+// BVH 的所有者：增删物体、update 都只在一个线程上 (模拟线程) 调用；snapshot() 和查询函数可以在任何线程上调用
+class SceneBvh {
+public:
+	// 面积和比建树时大这么多倍 / 没进树的物体超过这么多 / 删掉的物体超过这么多比例就重建
+	static constexpr float REBUILD_QUALITY = 1.3f;
+	static constexpr uint32_t MAX_EXTRA_OBJECTS = 256;
+	static constexpr float REBUILD_GARBAGE = 0.1f;
+	// 有物体在动时，至少每隔这么多次 update 重建一次 (refit 只会让包围盒越来越松)
+	static constexpr uint32_t REBUILD_INTERVAL = 600;
+	// 树为空时没进树的物体超过这么多，直接在调用线程上建第一棵树
+	static constexpr uint32_t SYNC_BUILD_OBJECTS = 4096;
+
+	void init(JobSystem* jobs);
+
+	// 物体编号由调用方给 (比如 PacketDraw::object)，包围盒不变时什么都不做
+	void set_bounds(uint32_t object, const vkbvh::Aabb& bounds);
+	void remove(uint32_t object);
+
+	// 把这一次的改动发布成新快照：换上建好的树、refit 移动过的物体、需要时开始后台重建
+	void update();
+
+	// 当前快照 (拿着它期间不会被修改)
+	std::shared_ptr<const vkbvh::Snapshot> snapshot() const;
+
+	const BvhStats& stats() const { return _stats; }
+
+private:
+	struct Object {
+		vkbvh::Aabb bounds;
+		uint32_t slot{ vkbvh::INVALID_INDEX }; // 节点 * 4 + 槽位，不在树里时是 INVALID_INDEX
+		uint32_t extra{ vkbvh::INVALID_INDEX };// Snapshot::extraObjects 下标
+		bool alive{ false };
+		bool pending{ false };                 // 在 _pending 里
+	};
+
+	// 后台建树的结果 (工作线程写，done 之后所有者读)
+	struct Build {
+		std::atomic<bool> done{ false };
+		std::shared_ptr<vkbvh::Snapshot> tree;
+		std::shared_ptr<vkbvh::Snapshot> spare; // tree 的副本 (也在工作线程上拷)，换上之后第一次 update 不用整个拷贝
+		std::vector<uint32_t> parents;  // 每个节点：父节点 * 4 + 槽位
+		std::vector<std::pair<uint32_t, uint32_t>> slots; // (物体, 节点 * 4 + 槽位)
+		double area{ 0.0 };
+		float ms{ 0.0f };
+	};
+
+	static void build(std::vector<std::pair<uint32_t, vkbvh::Aabb>> objects, Build& out);
+	std::vector<std::pair<uint32_t, vkbvh::Aabb>> collect() const;
+	void mark(uint32_t object);
+	void start_rebuild();
+	std::shared_ptr<vkbvh::Snapshot> install(Build& build);
+	// 下一版快照：上一版没人用时拿来补改过的节点，否则整个拷贝
+	std::shared_ptr<vkbvh::Snapshot> writable();
+	// 一个物体的改动落到树 / extra 上
+	void apply(vkbvh::Snapshot& tree, uint32_t object);
+	// 改一个槽位的包围盒并往上合并，改过的节点记进 _dirty
+	void refit(vkbvh::Snapshot& tree, uint32_t slot, const vkbvh::Aabb& bounds);
+	void publish(std::shared_ptr<vkbvh::Snapshot> next);
+
+	JobSystem* _jobs{ nullptr };
+
+	std::vector<Object> _objects;
+	std::vector<uint32_t> _pending;     // 这次 update 要处理的物体
+	std::vector<uint32_t> _parents;     // 当前树每个节点的父槽位
+	uint32_t _aliveCount{ 0 };
+	uint32_t _garbage{ 0 };             // 树里已经删掉的物体 (槽位包围盒清空了)
+	double _area{ 0.0 };                // 当前树所有槽位包围盒的面积和
+	double _buildArea{ 0.0 };
+	uint32_t _updatesSinceBuild{ 0 };
+	bool _moved{ false };               // 建树之后有物体动过
+
+	// 快照：_current 是发布的版本，_spare 是上一版 (没人用时拿来改成下一版，只补 _lastDirty 和这次改的节点)
+	std::shared_ptr<vkbvh::Snapshot> _current;
+	std::shared_ptr<vkbvh::Snapshot> _spare;
+	std::vector<uint32_t> _dirty;
+	std::vector<uint32_t> _lastDirty;
+	mutable std::mutex _snapshotMutex; // 只保护 _current 这个指针本身的读写
+	uint64_t _generation{ 0 };
+
+	// 后台重建：开始之后改过的物体，换上新树时再 refit 一遍
+	std::shared_ptr<Build> _build;
+	std::vector<uint32_t> _changedDuringBuild;
+
+	BvhStats _stats{};
+};
@@ -0,0 +1,276 @@
+#include "vk_capture.h"
+
+#include <cstring>
+
+namespace {
+	template<typename T>
+	std::span<const uint8_t> bytes_of(const T& value)
+	{
+		return { reinterpret_cast<const uint8_t*>(&value), sizeof(T) };
+	}
+
+	template<typename T>
+	std::span<const uint8_t> bytes_of(std::span<const T> values)
+	{
+		return { reinterpret_cast<const uint8_t*>(values.data()), values.size_bytes() };
+	}
+
+	// chunk 数据在文件里没有对齐保证，一律拷出来
+	template<typename T>
+	T read_pod(const uint8_t* data)
+	{
+		T value;
+		memcpy(&value, data, sizeof(T));
+		return value;
+	}
+}
+
+// ---------------- CaptureWriter ----------------
+
+bool CaptureWriter::open(const char* path, VkExtent2D extent)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_out.open(path, std::ios::binary | std::ios::trunc);
+	if (!_out) {
+		vklog::error() << "Could not create capture: " << path;
+		return false;
+	}
+
+	_header = {};
+	_header.magic = vkcap::CAPTURE_MAGIC;
+	_header.version = vkcap::CAPTURE_VERSION;
+	_header.width = extent.width;
+	_header.height = extent.height;
+	_out.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+	_bytes = sizeof(_header);
+
+	vklog::info() << "Capturing to " << path;
+	return true;
+}
+
+void CaptureWriter::close()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_out.is_open()) {
+		return;
+	}
+
+	// 回填帧数
+	_out.seekp(0);
+	_out.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+	_out.close();
+
+	vklog::info() << "Capture finished: " << _header.frameCount << " frames, " << _bytes / 1024 << " KB";
+}
+
+void CaptureWriter::write_chunk(vkcap::ChunkType type, std::initializer_list<std::span<const uint8_t>> parts)
+{
+	// 调用方已经加锁
+	vkcap::ChunkHeader chunk = {};
+	chunk.type = (uint32_t)type;
+	for (const auto& part : parts) {
+		chunk.size += (uint32_t)part.size();
+	}
+
+	_out.write(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+	for (const auto& part : parts) {
+		_out.write(reinterpret_cast<const char*>(part.data()), (std::streamsize)part.size());
+	}
+	_bytes += sizeof(chunk) + chunk.size;
+}
+
+void CaptureWriter::write_mesh(uint32_t mesh, std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_out.is_open()) {
+		return;
+	}
+
+	vkcap::MeshRecord record = {};
+	record.mesh = mesh;
+	record.vertexCount = (uint32_t)vertices.size();
+	record.indexCount = (uint32_t)indices.size();
+	write_chunk(vkcap::ChunkType::Mesh, { bytes_of(record), bytes_of(vertices), bytes_of(indices) });
+}
+
+void CaptureWriter::write_material(uint32_t material, const GPUMaterial& data)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_out.is_open()) {
+		return;
+	}
+
+	vkcap::MaterialRecord record = {};
+	record.material = material;
+	record.data = data;
+	write_chunk(vkcap::ChunkType::Material, { bytes_of(record) });
+}
+
+void CaptureWriter::write_texture(uint32_t texture, const std::string& path, bool srgb)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_out.is_open()) {
+		return;
+	}
+
+	vkcap::TextureRecord record = {};
+	record.texture = texture;
+	record.srgb = srgb ? 1 : 0;
+	write_chunk(vkcap::ChunkType::Texture, { bytes_of(record), { reinterpret_cast<const uint8_t*>(path.data()), path.size() } });
+}
+
+void CaptureWriter::write_frame(const FramePacket& packet)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_out.is_open()) {
+		return;
+	}
+
+	vkcap::FrameRecord record = {};
+	record.simFrame = packet.simFrame;
+	record.view = packet.view;
+	record.clearColor = packet.clearColor;
+	record.cameraPosition = packet.cameraPosition;
+	record.fovY = packet.fovY;
+	record.zNear = packet.zNear;
+	record.zFar = packet.zFar;
+	record.lightDirection = packet.lightDirection;
+	record.drawCount = (uint32_t)packet.draws.size();
+	record.lightCount = (uint32_t)packet.lights.size();
+	record.emitterCount = (uint32_t)packet.emitters.size();
+	write_chunk(vkcap::ChunkType::Frame, { bytes_of(record), bytes_of(std::span<const PacketDraw>(packet.draws)),
+		bytes_of(std::span<const PacketLight>(packet.lights)), bytes_of(std::span<const PacketEmitter>(packet.emitters)) });
+
+	_header.frameCount++;
+}
+
+// ---------------- CaptureReader ----------------
+
+bool CaptureReader::open(const char* path)
+{
+	if (!_file.open(path)) {
+		vklog::error() << "Could not map capture: " << path;
+		return false;
+	}
+	if (_file.size() < sizeof(vkcap::CaptureHeader)) {
+		vklog::error() << "Invalid capture: " << path;
+		_file.close();
+		return false;
+	}
+
+	_header = read_pod<vkcap::CaptureHeader>(_file.data());
+	if (_header.magic != vkcap::CAPTURE_MAGIC || _header.version != vkcap::CAPTURE_VERSION ||
+		_header.width == 0 || _header.height == 0) {
+		vklog::error() << "Invalid or outdated capture: " << path;
+		_file.close();
+		return false;
+	}
+
+	rewind();
+	return true;
+}
+
+void CaptureReader::close()
+{
+	_file.close();
+	_header = {};
+	_offset = 0;
+}
+
+bool CaptureReader::next(vkcap::Chunk& out)
+{
+	if (!_file.is_open() || _offset + sizeof(vkcap::ChunkHeader) > _file.size()) {
+		return false;
+	}
+
+	const vkcap::ChunkHeader chunk = read_pod<vkcap::ChunkHeader>(_file.data() + _offset);
+	const size_t dataOffset = _offset + sizeof(vkcap::ChunkHeader);
+	if (dataOffset + chunk.size > _file.size()) {
+		// 进程没有正常退出时最后一个 chunk 可能不完整，之前的照常可用
+		vklog::error() << "Capture is truncated at offset " << _offset;
+		_offset = _file.size();
+		return false;
+	}
+
+	out.type = (vkcap::ChunkType)chunk.type;
+	out.data = _file.data() + dataOffset;
+	out.size = chunk.size;
+	_offset = dataOffset + chunk.size;
+	return true;
+}
+
+bool CaptureReader::read_mesh(const vkcap::Chunk& chunk, uint32_t& mesh, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	if (chunk.type != vkcap::ChunkType::Mesh || chunk.size < sizeof(vkcap::MeshRecord)) {
+		return false;
+	}
+	const vkcap::MeshRecord record = read_pod<vkcap::MeshRecord>(chunk.data);
+	const size_t vertexBytes = (size_t)record.vertexCount * sizeof(Vertex);
+	const size_t indexBytes = (size_t)record.indexCount * sizeof(uint32_t);
+	if (chunk.size != sizeof(record) + vertexBytes + indexBytes) {
+		return false;
+	}
+
+	mesh = record.mesh;
+	vertices.resize(record.vertexCount);
+	memcpy(vertices.data(), chunk.data + sizeof(record), vertexBytes);
+	indices.resize(record.indexCount);
+	memcpy(indices.data(), chunk.data + sizeof(record) + vertexBytes, indexBytes);
+	return true;
+}
+
+bool CaptureReader::read_material(const vkcap::Chunk& chunk, uint32_t& material, GPUMaterial& data)
+{
+	if (chunk.type != vkcap::ChunkType::Material || chunk.size != sizeof(vkcap::MaterialRecord)) {
+		return false;
+	}
+	const vkcap::MaterialRecord record = read_pod<vkcap::MaterialRecord>(chunk.data);
+	material = record.material;
+	data = record.data;
+	return true;
+}
+
+bool CaptureReader::read_texture(const vkcap::Chunk& chunk, uint32_t& texture, std::string& path, bool& srgb)
+{
+	if (chunk.type != vkcap::ChunkType::Texture || chunk.size < sizeof(vkcap::TextureRecord)) {
+		return false;
+	}
+	const vkcap::TextureRecord record = read_pod<vkcap::TextureRecord>(chunk.data);
+	texture = record.texture;
+	srgb = record.srgb != 0;
+	path.assign(reinterpret_cast<const char*>(chunk.data + sizeof(record)), chunk.size - sizeof(record));
+	return true;
+}
+
+bool CaptureReader::read_frame(const vkcap::Chunk& chunk, FramePacket& packet)
+{
+	if (chunk.type != vkcap::ChunkType::Frame || chunk.size < sizeof(vkcap::FrameRecord)) {
+		return false;
+	}
+	const vkcap::FrameRecord record = read_pod<vkcap::FrameRecord>(chunk.data);
+	const size_t drawBytes = (size_t)record.drawCount * sizeof(PacketDraw);
+	const size_t lightBytes = (size_t)record.lightCount * sizeof(PacketLight);
+	const size_t emitterBytes = (size_t)record.emitterCount * sizeof(PacketEmitter);
+	if (chunk.size != sizeof(record) + drawBytes + lightBytes + emitterBytes) {
+		return false;
+	}
+
+	packet.simFrame = record.simFrame;
+	packet.quit = false;
+	packet.view = record.view;
+	packet.clearColor = record.clearColor;
+	packet.cameraPosition = record.cameraPosition;
+	packet.fovY = record.fovY;
+	packet.zNear = record.zNear;
+	packet.zFar = record.zFar;
+	packet.lightDirection = record.lightDirection;
+	packet.draws.resize(record.drawCount);
+	memcpy(packet.draws.data(), chunk.data + sizeof(record), drawBytes);
+	packet.lights.resize(record.lightCount);
+	memcpy(packet.lights.data(), chunk.data + sizeof(record) + drawBytes, lightBytes);
+	packet.emitters.resize(record.emitterCount);
+	memcpy(packet.emitters.data(), chunk.data + sizeof(record) + drawBytes + lightBytes, emitterBytes);
+	packet.animations.clear(); // 姿势不进抓帧文件：蒙皮物体回放时按绑定姿势画
+	return true;
+}
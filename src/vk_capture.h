@@ -0,0 +1,129 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_file.h"
+#include "vk_frame_packet.h"
+
+#include <fstream>
+#include <mutex>
+#include <type_traits>
+
+// 命令流抓帧 (.vcap)：引擎层的提交内容，不是 Vulkan 命令
+// 文件 = CaptureHeader + 一串 chunk (ChunkHeader + 数据)，按发生顺序排列
+// - 资源 chunk：网格顶点、材质、纹理加载 (只记路径)，下标是抓帧时的下标，回放时重新映射
+// - 帧 chunk：一个 FramePacket (相机、清屏色、每个物体的管线 / 网格 / 材质 / 矩阵 / 数据)
+// 资源 chunk 一定排在第一次引用它的帧之前
+namespace vkcap {
+
+	constexpr uint32_t CAPTURE_MAGIC = 0x50414356; // "VCAP"
+	constexpr uint32_t CAPTURE_VERSION = 6; // 2: 网格带索引，PacketDraw 带 object；3: PacketDraw 带 flags；4: 帧带光方向；5: 帧带点光源；6: 帧带粒子发射器
+
+	enum class ChunkType : uint32_t {
+		Mesh = 1,     // MeshRecord + Vertex[vertexCount] + uint32_t[indexCount]
+		Material = 2, // MaterialRecord
+		Texture = 3,  // TextureRecord + 路径 (不含结尾的 0)
+		Frame = 4,    // FrameRecord + PacketDraw[drawCount] + PacketLight[lightCount] + PacketEmitter[emitterCount]
+	};
+
+	struct CaptureHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;      // 抓帧时的窗口大小，回放用同样大小的离屏目标
+		uint32_t height;
+		uint32_t frameCount; // 关闭文件时回填
+		uint32_t pad0;
+	};
+
+	struct ChunkHeader {
+		uint32_t type; // ChunkType
+		uint32_t size; // 不含 ChunkHeader 本身
+	};
+
+	struct MeshRecord {
+		uint32_t mesh;
+		uint32_t vertexCount;
+		uint32_t indexCount;  // LOD 0 的索引 (回放时重新生成 LOD 链)
+		uint32_t pad0;
+	};
+
+	struct MaterialRecord {
+		uint32_t material;
+		uint32_t pad0;
+		GPUMaterial data;
+	};
+
+	struct TextureRecord {
+		uint32_t texture;
+		uint32_t srgb;
+	};
+
+	struct FrameRecord {
+		uint64_t simFrame;
+		glm::mat4 view;
+		glm::vec4 clearColor;
+		glm::vec3 cameraPosition;
+		float fovY;
+		float zNear;
+		float zFar;
+		uint32_t drawCount;
+		uint32_t emitterCount;
+		glm::vec3 lightDirection;
+		uint32_t lightCount;
+	};
+
+	static_assert(std::is_trivially_copyable_v<PacketDraw>, "PacketDraw is written to captures as raw bytes");
+	static_assert(std::is_trivially_copyable_v<PacketLight>, "PacketLight is written to captures as raw bytes");
+	static_assert(std::is_trivially_copyable_v<PacketEmitter>, "PacketEmitter is written to captures as raw bytes");
+	static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex is written to captures as raw bytes");
+
+	struct Chunk {
+		ChunkType type;
+		const uint8_t* data;
+		uint32_t size;
+	};
+}
+
+// 写 .vcap：资源创建和渲染线程的帧可能来自不同线程，内部加锁
+class CaptureWriter {
+public:
+	~CaptureWriter() { close(); }
+
+	bool open(const char* path, VkExtent2D extent);
+	void close();
+	bool is_open() const { return _out.is_open(); }
+
+	void write_mesh(uint32_t mesh, std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+	void write_material(uint32_t material, const GPUMaterial& data);
+	void write_texture(uint32_t texture, const std::string& path, bool srgb);
+	void write_frame(const FramePacket& packet);
+
+private:
+	void write_chunk(vkcap::ChunkType type, std::initializer_list<std::span<const uint8_t>> parts);
+
+	std::mutex _mutex;
+	std::ofstream _out;
+	vkcap::CaptureHeader _header{};
+	uint64_t _bytes{ 0 };
+};
+
+// 读 .vcap (内存映射)，按顺序取 chunk；read_* 把 chunk 解成记录，长度不对时返回 false
+class CaptureReader {
+public:
+	bool open(const char* path);
+	void close();
+
+	const vkcap::CaptureHeader& header() const { return _header; }
+
+	bool next(vkcap::Chunk& out);
+	void rewind() { _offset = sizeof(vkcap::CaptureHeader); }
+
+	static bool read_mesh(const vkcap::Chunk& chunk, uint32_t& mesh, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+	static bool read_material(const vkcap::Chunk& chunk, uint32_t& material, GPUMaterial& data);
+	static bool read_texture(const vkcap::Chunk& chunk, uint32_t& texture, std::string& path, bool& srgb);
+	static bool read_frame(const vkcap::Chunk& chunk, FramePacket& packet);
+
+private:
+	MappedFile _file;
+	vkcap::CaptureHeader _header{};
+	size_t _offset{ 0 };
+};
@@ -0,0 +1,137 @@
+#include "vk_clustered_lights.h"
+
+#include <cmath>
+
+#include <glm/trigonometric.hpp>
+
+bool ClusteredLights::init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless)
+{
+	_device = device;
+	_memory = memory;
+	_bindless = bindless;
+
+	auto create = [this](VkDeviceSize size, VmaMemoryUsage memoryUsage, AllocatedBuffer& out, void** mapped) {
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.pNext = nullptr;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		if (!_memory->create_buffer(bufferInfo, memoryUsage, MemoryCategory::Other, out)) {
+			vklog::error() << "Failed to allocate light cluster buffer (" << size << " bytes)";
+			return false;
+		}
+		if (mapped) {
+			vmaMapMemory(_memory->allocator(), out._allocation, mapped);
+		}
+		return true;
+	};
+
+	if (!create((VkDeviceSize)MAX_LIGHTS * sizeof(GPUPointLight), VMA_MEMORY_USAGE_CPU_TO_GPU, _lights, (void**)&_lightData) ||
+		!create(sizeof(uint32_t), VMA_MEMORY_USAGE_CPU_TO_GPU, _counter, (void**)&_counterData) ||
+		!create(cluster_buffer_size(), VMA_MEMORY_USAGE_GPU_ONLY, _clusters, nullptr) ||
+		!create(index_buffer_size(), VMA_MEMORY_USAGE_GPU_ONLY, _indices, nullptr)) {
+		return false;
+	}
+	*_counterData = 0;
+	_lightSlot = _bindless->add_storage_buffer(_lights._buffer);
+	_counterSlot = _bindless->add_storage_buffer(_counter._buffer);
+	_clusterSlot = _bindless->add_storage_buffer(_clusters._buffer);
+	_indexSlot = _bindless->add_storage_buffer(_indices._buffer);
+	return true;
+}
+
+void ClusteredLights::cleanup()
+{
+	// bindless 槽位随全局 set 一起释放
+	if (_device == VK_NULL_HANDLE) {
+		return;
+	}
+	if (_lightData) {
+		vmaUnmapMemory(_memory->allocator(), _lights._allocation);
+		_memory->destroy_buffer(_lights);
+	}
+	if (_counterData) {
+		vmaUnmapMemory(_memory->allocator(), _counter._allocation);
+		_memory->destroy_buffer(_counter);
+	}
+	if (_clusters._buffer != VK_NULL_HANDLE) {
+		_memory->destroy_buffer(_clusters);
+	}
+	if (_indices._buffer != VK_NULL_HANDLE) {
+		_memory->destroy_buffer(_indices);
+	}
+	_lightData = nullptr;
+	_counterData = nullptr;
+	_clusters = {};
+	_indices = {};
+	_device = VK_NULL_HANDLE;
+}
+
+void ClusteredLights::set_pipeline(VkPipelineLayout layout, VkPipeline pipeline)
+{
+	_layout = layout;
+	_pipeline = pipeline;
+}
+
+void ClusteredLights::begin_frame(const glm::mat4& view, float fovY, float aspect, float zNear, float zFar)
+{
+	// 上一帧的计数已经完成 (等过 fence)，先读出来再清零
+	_stats.lightIndices = *_counterData;
+	*_counterData = 0;
+
+	_view = view;
+	_tanHalfY = std::tan(glm::radians(fovY) * 0.5f);
+	_tanHalfX = _tanHalfY * aspect;
+	_zNear = zNear;
+	_zFar = zFar;
+	_lightCount = 0;
+	_stats.lights = 0;
+	_stats.culled = 0;
+	_stats.dropped = 0;
+}
+
+bool ClusteredLights::add_light(const glm::vec3& position, float radius, const glm::vec3& color, float intensity)
+{
+	if (_lightCount >= MAX_LIGHTS) {
+		_stats.dropped++;
+		return false;
+	}
+
+	// 完全在视锥外的光源不交给 GPU (深度方向 + 左右上下四个面，半径按面的法线长度放大)
+	const glm::vec3 p = glm::vec3(_view * glm::vec4(position, 1.0f));
+	const float depth = -p.z;
+	if (depth + radius < _zNear || depth - radius > _zFar ||
+		std::abs(p.x) - radius * std::sqrt(1.0f + _tanHalfX * _tanHalfX) > _tanHalfX * depth ||
+		std::abs(p.y) - radius * std::sqrt(1.0f + _tanHalfY * _tanHalfY) > _tanHalfY * depth) {
+		_stats.culled++;
+		return true;
+	}
+
+	GPUPointLight& light = _lightData[_lightCount++];
+	light.positionRadius = glm::vec4(p, radius);
+	light.colorIntensity = glm::vec4(color, intensity);
+	_stats.lights++;
+	return true;
+}
+
+void ClusteredLights::fill_scene(GPUSceneData& scene) const
+{
+	// 深度切分：slice = log(depth) * scale + bias，和计算着色器里 near * (far / near)^(slice / GRID_Z) 互逆
+	const float sliceScale = (float)GRID_Z / std::log(_zFar / _zNear);
+	scene.clusterGrid = glm::uvec4(GRID_X, GRID_Y, GRID_Z, _pipeline != VK_NULL_HANDLE ? _lightCount : 0);
+	scene.clusterDepth = glm::vec4(_zNear, _zFar, sliceScale, -std::log(_zNear) * sliceScale);
+	scene.clusterProjection = glm::vec4(_tanHalfX, _tanHalfY, 0.0f, 0.0f);
+	scene.clusterBuffers = glm::uvec4(_lightSlot, _clusterSlot, _indexSlot, _counterSlot);
+}
+
+void ClusteredLights::bin(VkCommandBuffer cmd)
+{
+	if (_pipeline == VK_NULL_HANDLE || _lightCount == 0) {
+		return;
+	}
+
+	// 格子、光源表下标都在场景数据里，不需要 push constant
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+	_bindless->bind(cmd, _layout, VK_PIPELINE_BIND_POINT_COMPUTE);
+	vkCmdDispatch(cmd, GRID_X, GRID_Y, GRID_Z);
+}
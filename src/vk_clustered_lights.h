@@ -0,0 +1,91 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_descriptors.h"
+#include "vk_memory.h"
+
+// 分簇前向光照 (点光源)
+// 视锥按屏幕 GRID_X x GRID_Y 块、深度方向 GRID_Z 层 (对数切分) 分成 froxel，格子完全由这一帧的投影决定
+// 每帧：CPU 把光源变换到相机空间写进光源表 -> 计算着色器每个工作组一个 froxel，
+// 用 froxel 的 AABB 和光源包围球求交，把相交的光源下标紧凑地写进全局下标表 (offset + count)
+// -> 片段着色器只遍历自己所在 froxel 的光源，光源再多，每个像素也只付相交的那几个的代价
+// 只在渲染线程上使用；FRAMES_IN_FLIGHT = 1，写之前已经等过 fence
+
+// 和 shaders/bindless.glsl 里的 PointLight 一致 (std430)
+struct GPUPointLight {
+	glm::vec4 positionRadius; // xyz 相机空间的位置，w 影响半径
+	glm::vec4 colorIntensity; // rgb 颜色，a 强度
+};
+
+struct LightClusterStats {
+	uint32_t lights{ 0 };       // 这一帧交给 GPU 的光源
+	uint32_t culled{ 0 };       // 在 CPU 上就确定不在视锥里的光源
+	uint32_t dropped{ 0 };      // 光源表满了丢掉的
+	uint32_t lightIndices{ 0 }; // 上一帧所有 froxel 的光源下标总数
+};
+
+class ClusteredLights {
+public:
+	static constexpr uint32_t GRID_X = 16;
+	static constexpr uint32_t GRID_Y = 9;
+	static constexpr uint32_t GRID_Z = 24;
+	static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+	static constexpr uint32_t MAX_LIGHTS = 4096;
+	// 和 light_cluster.comp 一致：单个 froxel 最多记这么多光源 (工作组共享内存的大小)
+	static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 256;
+	// 全局下标表：平均每个 froxel 64 个，超出的 froxel 记成 0 个
+	static constexpr uint32_t MAX_LIGHT_INDICES = CLUSTER_COUNT * 64;
+
+	bool init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless);
+	void cleanup();
+
+	// 分簇计算管线 (light_cluster.comp)；没有管线时不分簇，片段着色器看到 0 个光源
+	void set_pipeline(VkPipelineLayout layout, VkPipeline pipeline);
+
+	// 每帧：begin_frame -> add_light... -> fill_scene -> (light binning pass) bin
+	void begin_frame(const glm::mat4& view, float fovY, float aspect, float zNear, float zFar);
+	// 世界空间的点光源；表满了返回 false
+	bool add_light(const glm::vec3& position, float radius, const glm::vec3& color, float intensity);
+	// 分簇相关的字段：格子、深度切分、光源 / 格子 / 下标表的 bindless 下标
+	void fill_scene(GPUSceneData& scene) const;
+
+	void bin(VkCommandBuffer cmd);
+
+	VkBuffer cluster_buffer() const { return _clusters._buffer; }
+	VkDeviceSize cluster_buffer_size() const { return (VkDeviceSize)CLUSTER_COUNT * 2 * sizeof(uint32_t); }
+	VkBuffer index_buffer() const { return _indices._buffer; }
+	VkDeviceSize index_buffer_size() const { return (VkDeviceSize)MAX_LIGHT_INDICES * sizeof(uint32_t); }
+
+	const LightClusterStats& stats() const { return _stats; }
+
+private:
+	VkDevice _device{ VK_NULL_HANDLE };
+	MemoryManager* _memory{ nullptr };
+	BindlessHeap* _bindless{ nullptr };
+
+	VkPipelineLayout _layout{ VK_NULL_HANDLE };
+	VkPipeline _pipeline{ VK_NULL_HANDLE };
+
+	// 光源表 (CPU 每帧写) 和下标分配计数 (CPU 每帧清零，计算着色器原子加) 常驻映射
+	// 格子表 (每个 froxel 的 offset + count) 和下标表只在 GPU 上
+	AllocatedBuffer _lights{};
+	GPUPointLight* _lightData{ nullptr };
+	AllocatedBuffer _counter{};
+	uint32_t* _counterData{ nullptr };
+	AllocatedBuffer _clusters{};
+	AllocatedBuffer _indices{};
+	uint32_t _lightSlot{ INVALID_SLOT };
+	uint32_t _counterSlot{ INVALID_SLOT };
+	uint32_t _clusterSlot{ INVALID_SLOT };
+	uint32_t _indexSlot{ INVALID_SLOT };
+
+	// 这一帧的相机
+	glm::mat4 _view{ 1.0f };
+	float _tanHalfX{ 0.0f };
+	float _tanHalfY{ 0.0f };
+	float _zNear{ 0.1f };
+	float _zFar{ 1.0f };
+	uint32_t _lightCount{ 0 };
+
+	LightClusterStats _stats{};
+};
@@ -0,0 +1,195 @@
+#include "vk_compute.h"
+#include "vk_initializers.h"
+
+bool AsyncCompute::init(VkDevice device, VkQueue computeQueue, uint32_t computeFamily, VkQueue graphicsQueue, uint32_t graphicsFamily)
+{
+	_device = device;
+	_computeQueue = computeQueue;
+	_graphicsQueue = graphicsQueue;
+	_computeFamily = computeFamily;
+	_families[0] = graphicsFamily;
+	_families[1] = computeFamily;
+
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = computeFamily;
+	if (vkCreateCommandPool(_device, &poolInfo, nullptr, &_commandPool) != VK_SUCCESS) {
+		vklog::error() << "Failed to create compute command pool";
+		return false;
+	}
+
+	_computeTimeline = create_timeline();
+	_graphicsTimeline = create_timeline();
+	if (_computeTimeline == VK_NULL_HANDLE || _graphicsTimeline == VK_NULL_HANDLE) {
+		return false;
+	}
+
+	vklog::info() << "Async compute: " << (is_async() ? "separate queue family " : "falling back to graphics queue family ")
+		<< computeFamily;
+	return true;
+}
+
+void AsyncCompute::cleanup()
+{
+	// 调用方已经 vkDeviceWaitIdle
+	if (_device == VK_NULL_HANDLE) {
+		return;
+	}
+	vkDestroySemaphore(_device, _computeTimeline, nullptr);
+	vkDestroySemaphore(_device, _graphicsTimeline, nullptr);
+	vkDestroyCommandPool(_device, _commandPool, nullptr); // 命令缓冲区随池释放
+	_inFlight.clear();
+	_free.clear();
+	_device = VK_NULL_HANDLE;
+}
+
+VkSemaphore AsyncCompute::create_timeline()
+{
+	VkSemaphoreTypeCreateInfo typeInfo = {};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.pNext = nullptr;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo info = vkinit::semaphore_create_info();
+	info.pNext = &typeInfo;
+
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	if (vkCreateSemaphore(_device, &info, nullptr, &semaphore) != VK_SUCCESS) {
+		vklog::error() << "Failed to create timeline semaphore";
+		return VK_NULL_HANDLE;
+	}
+	return semaphore;
+}
+
+void AsyncCompute::share(VkBufferCreateInfo& info) const
+{
+	if (_families[0] != _families[1]) {
+		info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		info.queueFamilyIndexCount = 2;
+		info.pQueueFamilyIndices = _families;
+	}
+}
+
+void AsyncCompute::share(VkImageCreateInfo& info) const
+{
+	if (_families[0] != _families[1]) {
+		info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		info.queueFamilyIndexCount = 2;
+		info.pQueueFamilyIndices = _families;
+	}
+}
+
+void AsyncCompute::recycle()
+{
+	uint64_t completed = 0;
+	vkGetSemaphoreCounterValue(_device, _computeTimeline, &completed);
+
+	for (size_t i = 0; i < _inFlight.size();) {
+		if (_inFlight[i].value <= completed) {
+			_free.push_back(_inFlight[i].cmd);
+			_inFlight[i] = _inFlight.back();
+			_inFlight.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+VkCommandBuffer AsyncCompute::begin()
+{
+	recycle();
+
+	VkCommandBuffer cmd = VK_NULL_HANDLE;
+	if (!_free.empty()) {
+		cmd = _free.back();
+		_free.pop_back();
+		vkResetCommandBuffer(cmd, 0);
+	}
+	else {
+		VkCommandBufferAllocateInfo allocInfo = vkinit::command_buffer_allocate_info(_commandPool);
+		if (vkAllocateCommandBuffers(_device, &allocInfo, &cmd) != VK_SUCCESS) {
+			vklog::error() << "Failed to allocate compute command buffer";
+			return VK_NULL_HANDLE;
+		}
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.pNext = nullptr;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(cmd, &beginInfo);
+	return cmd;
+}
+
+uint64_t AsyncCompute::submit(VkCommandBuffer cmd, VkPipelineStageFlags2 graphicsWaitStage, uint64_t waitGraphicsValue)
+{
+	vkEndCommandBuffer(cmd);
+
+	const uint64_t value = _computeValue + 1;
+
+	VkCommandBufferSubmitInfo cmdInfo = vkinit::command_buffer_submit_info(cmd);
+	VkSemaphoreSubmitInfo waitInfo = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, _graphicsTimeline, waitGraphicsValue);
+	VkSemaphoreSubmitInfo signalInfo = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, _computeTimeline, value);
+
+	VkSubmitInfo2 submit = {};
+	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	submit.pNext = nullptr;
+	submit.waitSemaphoreInfoCount = waitGraphicsValue > 0 ? 1 : 0;
+	submit.pWaitSemaphoreInfos = &waitInfo;
+	submit.commandBufferInfoCount = 1;
+	submit.pCommandBufferInfos = &cmdInfo;
+	submit.signalSemaphoreInfoCount = 1;
+	submit.pSignalSemaphoreInfos = &signalInfo;
+
+	if (vkQueueSubmit2(_computeQueue, 1, &submit, VK_NULL_HANDLE) != VK_SUCCESS) {
+		vklog::error() << "Failed to submit compute command buffer!";
+		_free.push_back(cmd);
+		return _computeValue;
+	}
+
+	_computeValue = value;
+	_inFlight.push_back({ cmd, value });
+	_pendingWaitStages |= graphicsWaitStage;
+	return value;
+}
+
+bool AsyncCompute::graphics_wait(VkSemaphoreSubmitInfo& out)
+{
+	// 只等最新的值就够了：时间线是单调的，之前提交的计算也都完成了
+	if (_pendingWaitStages == 0 || _waitedValue == _computeValue) {
+		return false;
+	}
+
+	out = vkinit::semaphore_submit_info(_pendingWaitStages, _computeTimeline, _computeValue);
+	_waitedValue = _computeValue;
+	_pendingWaitStages = 0;
+	return true;
+}
+
+VkSemaphoreSubmitInfo AsyncCompute::graphics_signal()
+{
+	_graphicsValue++;
+	return vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, _graphicsTimeline, _graphicsValue);
+}
+
+bool AsyncCompute::is_complete(uint64_t computeValue) const
+{
+	uint64_t completed = 0;
+	vkGetSemaphoreCounterValue(_device, _computeTimeline, &completed);
+	return completed >= computeValue;
+}
+
+void AsyncCompute::wait(uint64_t computeValue) const
+{
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.pNext = nullptr;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &_computeTimeline;
+	waitInfo.pValues = &computeValue;
+	vkWaitSemaphores(_device, &waitInfo, UINT64_MAX);
+}
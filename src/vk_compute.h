@@ -0,0 +1,68 @@
+#pragma once
+
+#include "vk_types.h"
+
+// 异步计算
+// 剔除 / 粒子模拟 / 蒙皮 / 后处理这类计算工作提交到单独的计算队列，和图形队列上的光栅化重叠执行
+// 两个队列之间用时间线信号量交接：
+// - 计算 -> 图形：submit() 发出一个计算时间线值，图形队列下一次提交在声明的阶段等它 (之前的阶段照常重叠)
+// - 图形 -> 计算：每次帧提交发出一个图形时间线值，submit() 可以先等某个值 (比如后处理要读这一帧的画面)
+// 设备没有独立的计算队列时退回图形队列：接口和同步完全一样，只是不再重叠
+// 两个队列族不同时，两边都要访问的 buffer / 图像用 share() 设成 CONCURRENT，不做队列族所有权转移
+// 只能在渲染线程上使用 (退回图形队列时和帧提交共用同一个 VkQueue)
+class AsyncCompute {
+public:
+	bool init(VkDevice device, VkQueue computeQueue, uint32_t computeFamily, VkQueue graphicsQueue, uint32_t graphicsFamily);
+	void cleanup();
+
+	bool is_async() const { return _computeQueue != _graphicsQueue; }
+	VkQueue queue() const { return _computeQueue; }
+	uint32_t queue_family() const { return _computeFamily; }
+
+	// 两个队列都要访问的资源：队列族不同时改成 CONCURRENT 共享
+	void share(VkBufferCreateInfo& info) const;
+	void share(VkImageCreateInfo& info) const;
+
+	// 取一个已经 begin 的命令缓冲区 (执行完的会被回收复用)
+	VkCommandBuffer begin();
+	// 结束录制并提交到计算队列，返回这批工作的计算时间线值
+	// graphicsWaitStage：图形队列从哪个阶段开始需要这批结果 (间接绘制参数用 DRAW_INDIRECT，顶点数据用 VERTEX_ATTRIBUTE_INPUT)，
+	//                    0 表示图形队列不需要等它 (比如结果只给下一批计算用)
+	// waitGraphicsValue：非 0 时先等图形队列到达这个值
+	uint64_t submit(VkCommandBuffer cmd, VkPipelineStageFlags2 graphicsWaitStage, uint64_t waitGraphicsValue = 0);
+
+	// 帧提交时调用：上次帧提交之后有需要等待的计算工作时填好等待信息并返回 true
+	bool graphics_wait(VkSemaphoreSubmitInfo& out);
+	// 帧提交时调用：返回这次提交要发出的图形时间线值
+	VkSemaphoreSubmitInfo graphics_signal();
+	uint64_t graphics_value() const { return _graphicsValue; } // 最近一次帧提交会发出的值
+
+	bool is_complete(uint64_t computeValue) const;
+	void wait(uint64_t computeValue) const;
+
+private:
+	struct Batch {
+		VkCommandBuffer cmd;
+		uint64_t value;
+	};
+
+	VkSemaphore create_timeline();
+	void recycle();
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	VkQueue _computeQueue{ VK_NULL_HANDLE };
+	VkQueue _graphicsQueue{ VK_NULL_HANDLE };
+	uint32_t _computeFamily{ 0 };
+	uint32_t _families[2]{};
+
+	VkCommandPool _commandPool{ VK_NULL_HANDLE };
+	std::vector<Batch> _inFlight;
+	std::vector<VkCommandBuffer> _free;
+
+	VkSemaphore _computeTimeline{ VK_NULL_HANDLE };
+	VkSemaphore _graphicsTimeline{ VK_NULL_HANDLE };
+	uint64_t _computeValue{ 0 };   // 最近一次计算提交发出的值
+	uint64_t _graphicsValue{ 0 };  // 最近一次帧提交发出的值
+	uint64_t _waitedValue{ 0 };    // 图形队列已经等过的计算值
+	VkPipelineStageFlags2 _pendingWaitStages{ 0 }; // 还没被图形队列等过的计算工作，图形队列需要它们的阶段
+};
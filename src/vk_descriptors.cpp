@@ -0,0 +1,277 @@
+#include "vk_descriptors.h"
+
+#include <algorithm>
+
+void SlotAllocator::init(uint32_t capacity)
+{
+	_capacity = capacity;
+	_next = 0;
+	_free.clear();
+	_retired.clear();
+}
+
+uint32_t SlotAllocator::allocate()
+{
+	if (!_free.empty()) {
+		uint32_t slot = _free.back();
+		_free.pop_back();
+		return slot;
+	}
+	if (_next < _capacity) {
+		return _next++;
+	}
+	return INVALID_SLOT;
+}
+
+void SlotAllocator::release(uint32_t slot, uint64_t frameNumber)
+{
+	if (slot == INVALID_SLOT || slot >= _next) {
+		return;
+	}
+	_retired.emplace_back(frameNumber, slot);
+}
+
+void SlotAllocator::recycle(uint64_t frameNumber)
+{
+	while (!_retired.empty() && _retired.front().first + RETIRE_FRAMES <= frameNumber) {
+		_free.push_back(_retired.front().second);
+		_retired.pop_front();
+	}
+}
+
+bool BindlessHeap::init(VkDevice device, VkPhysicalDevice gpu)
+{
+	_device = device;
+
+	// 1. 根据设备上限确定各个数组的大小
+	VkPhysicalDeviceVulkan12Properties props12 = {};
+	props12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_PROPERTIES;
+	VkPhysicalDeviceProperties2 props = {};
+	props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	props.pNext = &props12;
+	vkGetPhysicalDeviceProperties2(gpu, &props);
+
+	const uint32_t maxTextures = std::min({ 16384u,
+		props12.maxDescriptorSetUpdateAfterBindSampledImages,
+		props12.maxPerStageDescriptorUpdateAfterBindSampledImages });
+	const uint32_t maxSamplers = std::min({ 256u,
+		props12.maxDescriptorSetUpdateAfterBindSamplers,
+		props12.maxPerStageDescriptorUpdateAfterBindSamplers });
+	// 材质表和场景数据各占一个 storage buffer
+	const uint32_t maxBuffers = std::min({ 8192u,
+		props12.maxDescriptorSetUpdateAfterBindStorageBuffers - 2,
+		props12.maxPerStageDescriptorUpdateAfterBindStorageBuffers - 2 });
+
+	_textureSlots.init(maxTextures);
+	_samplerSlots.init(maxSamplers);
+	_bufferSlots.init(maxBuffers);
+
+	// 2. 创建 set layout
+	const VkShaderStageFlags stages = VK_SHADER_STAGE_ALL;
+	_bindings = {
+		{ TEXTURE_BINDING, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, maxTextures, stages, nullptr },
+		{ SAMPLER_BINDING, VK_DESCRIPTOR_TYPE_SAMPLER, maxSamplers, stages, nullptr },
+		{ BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxBuffers, stages, nullptr },
+		{ MATERIAL_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, stages, nullptr },
+		{ SCENE_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, stages, nullptr },
+	};
+
+	// 没写过的槽位允许是无效的 (PARTIALLY_BOUND)，绑定后还能继续更新 (UPDATE_AFTER_BIND)
+	const VkDescriptorBindingFlags arrayFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+		VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+	const VkDescriptorBindingFlags bindingFlags[] = { arrayFlags, arrayFlags, arrayFlags,
+		VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT, VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT };
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo = {};
+	flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	flagsInfo.pNext = nullptr;
+	flagsInfo.bindingCount = (uint32_t)_bindings.size();
+	flagsInfo.pBindingFlags = bindingFlags;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &flagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layoutInfo.bindingCount = (uint32_t)_bindings.size();
+	layoutInfo.pBindings = _bindings.data();
+
+	if (vkCreateDescriptorSetLayout(_device, &layoutInfo, nullptr, &_layout) != VK_SUCCESS) {
+		vklog::error() << "Failed to create bindless descriptor set layout";
+		return false;
+	}
+
+	// 3. 创建 pool 并分配唯一的一个 set
+	VkDescriptorPoolSize poolSizes[] = {
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, maxTextures },
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, maxSamplers },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxBuffers + 2 },
+	};
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 3;
+	poolInfo.pPoolSizes = poolSizes;
+
+	if (vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_pool) != VK_SUCCESS) {
+		vklog::error() << "Failed to create bindless descriptor pool";
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.pNext = nullptr;
+	allocInfo.descriptorPool = _pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &_layout;
+
+	if (vkAllocateDescriptorSets(_device, &allocInfo, &_set) != VK_SUCCESS) {
+		vklog::error() << "Failed to allocate bindless descriptor set";
+		return false;
+	}
+
+	vklog::info() << "Bindless heap: " << maxTextures << " textures, " << maxSamplers << " samplers, "
+		<< maxBuffers << " buffers";
+	return true;
+}
+
+void BindlessHeap::cleanup()
+{
+	// set 随 pool 一起释放
+	vkDestroyDescriptorPool(_device, _pool, nullptr);
+	vkDestroyDescriptorSetLayout(_device, _layout, nullptr);
+	_pool = VK_NULL_HANDLE;
+	_layout = VK_NULL_HANDLE;
+	_set = VK_NULL_HANDLE;
+}
+
+uint32_t BindlessHeap::add_texture(VkImageView view, VkImageLayout layout)
+{
+	uint32_t slot = _textureSlots.allocate();
+	if (slot == INVALID_SLOT) {
+		vklog::error() << "Bindless texture slots exhausted";
+		return INVALID_SLOT;
+	}
+	update_texture(slot, view, layout);
+	return slot;
+}
+
+void BindlessHeap::update_texture(uint32_t slot, VkImageView view, VkImageLayout layout)
+{
+	VkDescriptorImageInfo imageInfo = { VK_NULL_HANDLE, view, layout };
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = _set;
+	write.dstBinding = TEXTURE_BINDING;
+	write.dstArrayElement = slot;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	write.pImageInfo = &imageInfo;
+	vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+}
+
+void BindlessHeap::remove_texture(uint32_t slot)
+{
+	_textureSlots.release(slot, _frameNumber);
+}
+
+uint32_t BindlessHeap::add_sampler(VkSampler sampler)
+{
+	uint32_t slot = _samplerSlots.allocate();
+	if (slot == INVALID_SLOT) {
+		vklog::error() << "Bindless sampler slots exhausted";
+		return INVALID_SLOT;
+	}
+
+	VkDescriptorImageInfo samplerInfo = { sampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED };
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = _set;
+	write.dstBinding = SAMPLER_BINDING;
+	write.dstArrayElement = slot;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+	write.pImageInfo = &samplerInfo;
+	vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+	return slot;
+}
+
+void BindlessHeap::remove_sampler(uint32_t slot)
+{
+	_samplerSlots.release(slot, _frameNumber);
+}
+
+uint32_t BindlessHeap::add_storage_buffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	uint32_t slot = _bufferSlots.allocate();
+	if (slot == INVALID_SLOT) {
+		vklog::error() << "Bindless buffer slots exhausted";
+		return INVALID_SLOT;
+	}
+
+	VkDescriptorBufferInfo bufferInfo = { buffer, offset, range };
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = _set;
+	write.dstBinding = BUFFER_BINDING;
+	write.dstArrayElement = slot;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+	return slot;
+}
+
+void BindlessHeap::remove_storage_buffer(uint32_t slot)
+{
+	_bufferSlots.release(slot, _frameNumber);
+}
+
+void BindlessHeap::set_material_buffer(VkBuffer buffer, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo bufferInfo = { buffer, 0, range };
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = _set;
+	write.dstBinding = MATERIAL_BINDING;
+	write.dstArrayElement = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+}
+
+void BindlessHeap::set_scene_buffer(VkBuffer buffer, VkDeviceSize range)
+{
+	VkDescriptorBufferInfo bufferInfo = { buffer, 0, range };
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = _set;
+	write.dstBinding = SCENE_BINDING;
+	write.dstArrayElement = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+}
+
+void BindlessHeap::begin_frame(uint64_t frameNumber)
+{
+	_frameNumber = frameNumber;
+	_textureSlots.recycle(frameNumber);
+	_samplerSlots.recycle(frameNumber);
+	_bufferSlots.recycle(frameNumber);
+}
+
+void BindlessHeap::bind(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, VkPipelineBindPoint bindPoint) const
+{
+	vkCmdBindDescriptorSets(cmd, bindPoint, pipelineLayout, SET_INDEX, 1, &_set, 0, nullptr);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "vk_types.h"
+
+constexpr uint32_t INVALID_SLOT = 0xFFFFFFFF;
+
+// 稳定下标分配器
+// 下标一旦分配就不会变；释放后先退休几帧，确认 GPU 不再使用后才会被复用
+class SlotAllocator {
+public:
+	static constexpr uint64_t RETIRE_FRAMES = 2;
+
+	void init(uint32_t capacity);
+
+	uint32_t allocate(); // 满了返回 INVALID_SLOT
+	void release(uint32_t slot, uint64_t frameNumber);
+	void recycle(uint64_t frameNumber); // 把已经过了退休期的下标放回空闲列表
+
+	uint32_t capacity() const { return _capacity; }
+	uint32_t live_count() const { return _next - (uint32_t)_free.size() - (uint32_t)_retired.size(); }
+
+private:
+	uint32_t _capacity{ 0 };
+	uint32_t _next{ 0 };                                // 从未分配过的最小下标
+	std::vector<uint32_t> _free;
+	std::deque<std::pair<uint64_t, uint32_t>> _retired; // (释放时的帧号, 下标)
+};
+
+// 全局 bindless descriptor set (固定在 set 0)
+// 一个 set 里放超大的 texture / sampler / storage buffer 数组 + 材质表 + 场景数据
+// 使用 PARTIALLY_BOUND + UPDATE_AFTER_BIND，每帧只绑定一次，资源增删不用重新绑定
+class BindlessHeap {
+public:
+	static constexpr uint32_t SET_INDEX = 0;
+
+	static constexpr uint32_t TEXTURE_BINDING = 0;  // texture2D textures[]
+	static constexpr uint32_t SAMPLER_BINDING = 1;  // sampler samplers[]
+	static constexpr uint32_t BUFFER_BINDING = 2;   // buffer buffers[]
+	static constexpr uint32_t MATERIAL_BINDING = 3; // GPUMaterial materials[]
+	static constexpr uint32_t SCENE_BINDING = 4;    // GPUSceneData (每帧的相机 / 光照 / 阴影)
+
+	bool init(VkDevice device, VkPhysicalDevice gpu);
+	void cleanup();
+
+	VkDescriptorSetLayout layout() const { return _layout; }
+	std::span<const VkDescriptorSetLayoutBinding> bindings() const { return _bindings; }
+
+	uint32_t add_texture(VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	void update_texture(uint32_t slot, VkImageView view, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	void remove_texture(uint32_t slot);
+
+	uint32_t add_sampler(VkSampler sampler);
+	void remove_sampler(uint32_t slot);
+
+	uint32_t add_storage_buffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+	void remove_storage_buffer(uint32_t slot);
+
+	void set_material_buffer(VkBuffer buffer, VkDeviceSize range);
+	void set_scene_buffer(VkBuffer buffer, VkDeviceSize range);
+
+	// 每帧开始时调用 (CPU 已经等过这一帧的 fence)
+	void begin_frame(uint64_t frameNumber);
+
+	void bind(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, VkPipelineBindPoint bindPoint) const;
+
+	uint32_t texture_count() const { return _textureSlots.live_count(); }
+	uint32_t buffer_count() const { return _bufferSlots.live_count(); }
+
+private:
+	VkDevice _device{ VK_NULL_HANDLE };
+	VkDescriptorSetLayout _layout{ VK_NULL_HANDLE };
+	VkDescriptorPool _pool{ VK_NULL_HANDLE };
+	VkDescriptorSet _set{ VK_NULL_HANDLE };
+	std::vector<VkDescriptorSetLayoutBinding> _bindings;
+
+	SlotAllocator _textureSlots;
+	SlotAllocator _samplerSlots;
+	SlotAllocator _bufferSlots;
+	uint64_t _frameNumber{ 0 };
+};
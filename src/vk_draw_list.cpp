@@ -0,0 +1,147 @@
+#include "vk_draw_list.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+	// 每轮 11 位：6 轮覆盖 64 位，直方图 (8KB) 还放得进 L1
+	constexpr uint32_t RADIX_BITS = 11;
+	constexpr uint32_t RADIX_BUCKETS = 1u << RADIX_BITS;
+	constexpr uint32_t RADIX_MASK = RADIX_BUCKETS - 1;
+	constexpr uint32_t RADIX_PASSES = (64 + RADIX_BITS - 1) / RADIX_BITS;
+}
+
+void DrawList::clear()
+{
+	_entries.clear();
+	_draws.clear();
+	_stats = {};
+}
+
+void DrawList::reserve(size_t count)
+{
+	_entries.reserve(count);
+	_scratch.reserve(count);
+	_draws.reserve(count);
+}
+
+void DrawList::add(uint64_t key, uint32_t pipeline, uint32_t mesh, uint32_t material, const glm::mat4& matrix, const glm::vec4& data,
+	uint32_t vertexOffset)
+{
+	Draw draw;
+	draw.pipeline = pipeline;
+	draw.mesh = mesh;
+	draw.vertexOffset = vertexOffset;
+	draw.constants.data = data;
+	draw.constants.render_matrix = matrix;
+	draw.constants.material_index = material;
+
+	_entries.push_back({ key, (uint32_t)_draws.size(), 0 });
+	_draws.push_back(draw);
+}
+
+void DrawList::sort()
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	const size_t count = _entries.size();
+	if (count > 1) {
+		// 一次遍历统计所有轮次的直方图
+		uint32_t histograms[RADIX_PASSES][RADIX_BUCKETS];
+		memset(histograms, 0, sizeof(histograms));
+		for (const SortEntry& entry : _entries) {
+			for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+				histograms[pass][(entry.key >> (pass * RADIX_BITS)) & RADIX_MASK]++;
+			}
+		}
+
+		_scratch.resize(count);
+		SortEntry* src = _entries.data();
+		SortEntry* dst = _scratch.data();
+
+		for (uint32_t pass = 0; pass < RADIX_PASSES; pass++) {
+			uint32_t* histogram = histograms[pass];
+			const uint32_t shift = pass * RADIX_BITS;
+
+			// 所有键这一段都相同 (键的大部分高位通常如此)，这一轮不改变顺序
+			if (histogram[(src[0].key >> shift) & RADIX_MASK] == count) {
+				continue;
+			}
+
+			uint32_t offset = 0;
+			for (uint32_t bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+				const uint32_t n = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += n;
+			}
+			for (size_t i = 0; i < count; i++) {
+				const SortEntry entry = src[i];
+				dst[histogram[(entry.key >> shift) & RADIX_MASK]++] = entry;
+			}
+			std::swap(src, dst);
+		}
+
+		if (src != _entries.data()) {
+			_entries.swap(_scratch);
+		}
+	}
+
+	_stats.sortMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void DrawList::record(VkCommandBuffer cmd, VkPipelineLayout layout, VkShaderStageFlags pushStages,
+	std::span<const VkPipeline> pipelines, std::span<const DrawMesh> meshes)
+{
+	uint32_t boundPipeline = UINT32_MAX;
+	VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+	VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+
+	_stats.draws = 0;
+	_stats.pipelineBinds = 0;
+	_stats.vertexBufferBinds = 0;
+	_stats.indexBufferBinds = 0;
+	_stats.triangles = 0;
+	uint32_t indexedDraws = 0;
+
+	for (const SortEntry& entry : _entries) {
+		const Draw& draw = _draws[entry.index];
+		if (draw.pipeline >= pipelines.size() || draw.mesh >= meshes.size()) {
+			continue;
+		}
+		const DrawMesh& mesh = meshes[draw.mesh];
+
+		if (draw.pipeline != boundPipeline) {
+			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[draw.pipeline]);
+			boundPipeline = draw.pipeline;
+			_stats.pipelineBinds++;
+		}
+		if (mesh.vertexBuffer != boundVertexBuffer) {
+			const VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(cmd, 0, 1, &mesh.vertexBuffer, &offset);
+			boundVertexBuffer = mesh.vertexBuffer;
+			_stats.vertexBufferBinds++;
+		}
+
+		vkCmdPushConstants(cmd, layout, pushStages, 0, sizeof(MeshPushConstants), &draw.constants);
+
+		if (mesh.indexCount > 0) {
+			if (mesh.indexBuffer != boundIndexBuffer) {
+				vkCmdBindIndexBuffer(cmd, mesh.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+				boundIndexBuffer = mesh.indexBuffer;
+				_stats.indexBufferBinds++;
+			}
+			vkCmdDrawIndexed(cmd, mesh.indexCount, 1, mesh.firstIndex, (int32_t)(mesh.firstVertex + draw.vertexOffset), 0);
+			_stats.triangles += mesh.indexCount / 3;
+			indexedDraws++;
+		}
+		else {
+			vkCmdDraw(cmd, mesh.vertexCount, 1, mesh.firstVertex + draw.vertexOffset, 0);
+			_stats.triangles += mesh.vertexCount / 3;
+		}
+		_stats.draws++;
+	}
+
+	// 不排序时每个绘制都要绑一次管线和顶点缓冲区 (索引绘制还有索引缓冲区)
+	const uint32_t naiveBinds = _stats.draws * 2 + indexedDraws;
+	_stats.bindsSkipped = naiveBinds - (_stats.pipelineBinds + _stats.vertexBufferBinds + _stats.indexBufferBinds);
+}
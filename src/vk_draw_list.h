@@ -0,0 +1,105 @@
+#pragma once
+
+#include "vk_types.h"
+
+// 64 位排序键：排序之后相同的管线 / 材质 / 网格挨在一起，录制时跳过重复的绑定
+// 不透明: pass(4) | pipeline(10) | material(16) | mesh(16) | depth(18)   状态优先，同状态内由近到远
+// 透明:   pass(4) | depth(18, 反转) | pipeline(10) | material(16) | mesh(16)   必须由远到近
+namespace drawkey {
+
+	constexpr uint32_t PASS_BITS = 4;
+	constexpr uint32_t PIPELINE_BITS = 10;
+	constexpr uint32_t MATERIAL_BITS = 16;
+	constexpr uint32_t MESH_BITS = 16;
+	constexpr uint32_t DEPTH_BITS = 18;
+	static_assert(PASS_BITS + PIPELINE_BITS + MATERIAL_BITS + MESH_BITS + DEPTH_BITS == 64);
+
+	constexpr uint32_t MAX_PIPELINES = 1u << PIPELINE_BITS;
+	constexpr uint32_t MAX_MESHES = 1u << MESH_BITS;
+
+	// depth01：0 是近平面，1 是远平面 (超出范围的会被截断)
+	inline uint32_t quantize_depth(float depth01)
+	{
+		const float d = depth01 < 0.0f ? 0.0f : (depth01 > 1.0f ? 1.0f : depth01);
+		return (uint32_t)(d * (float)((1u << DEPTH_BITS) - 1));
+	}
+
+	inline uint64_t opaque(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth)
+	{
+		return ((uint64_t)(pass & 0xF) << 60) |
+			((uint64_t)(pipeline & 0x3FF) << 50) |
+			((uint64_t)(material & 0xFFFF) << 34) |
+			((uint64_t)(mesh & 0xFFFF) << 18) |
+			(uint64_t)(depth & 0x3FFFF);
+	}
+
+	inline uint64_t translucent(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t depth)
+	{
+		const uint32_t farToNear = ((1u << DEPTH_BITS) - 1) - (depth & 0x3FFFF);
+		return ((uint64_t)(pass & 0xF) << 60) |
+			((uint64_t)farToNear << 42) |
+			((uint64_t)(pipeline & 0x3FF) << 32) |
+			((uint64_t)(material & 0xFFFF) << 16) |
+			(uint64_t)(mesh & 0xFFFF);
+	}
+}
+
+// 网格表里的一项：indexCount 为 0 时用 vkCmdDraw
+struct DrawMesh {
+	VkBuffer vertexBuffer{ VK_NULL_HANDLE };
+	VkBuffer indexBuffer{ VK_NULL_HANDLE };
+	uint32_t firstVertex{ 0 };
+	uint32_t vertexCount{ 0 };
+	uint32_t firstIndex{ 0 };
+	uint32_t indexCount{ 0 };
+};
+
+struct DrawListStats {
+	uint32_t draws{ 0 };
+	uint32_t pipelineBinds{ 0 };
+	uint32_t vertexBufferBinds{ 0 };
+	uint32_t indexBufferBinds{ 0 };
+	uint32_t bindsSkipped{ 0 };   // 排序之后省掉的重复绑定
+	uint32_t triangles{ 0 };
+	float sortMs{ 0.0f };
+};
+
+// 一帧的绘制列表
+// 每个绘制只是一条紧凑记录 (键 + 下标)，LSD 基数排序 (每轮 11 位，所有位都相同的轮次直接跳过)
+// 录制时管线、顶点 / 索引缓冲区只在和上一个绘制不同的时候绑定；材质走 bindless，只是 push constant 里的下标
+class DrawList {
+public:
+	void clear();
+	void reserve(size_t count);
+
+	// vertexOffset 加在网格的 firstVertex 上 (蒙皮实例：同一个网格项，顶点在输出 buffer 里各占一段)
+	void add(uint64_t key, uint32_t pipeline, uint32_t mesh, uint32_t material, const glm::mat4& matrix, const glm::vec4& data = glm::vec4(1.0f),
+		uint32_t vertexOffset = 0);
+	void sort();
+
+	// pipelines / meshes 用 add 时给的下标索引；所有管线共享 layout 和 push constant 范围
+	void record(VkCommandBuffer cmd, VkPipelineLayout layout, VkShaderStageFlags pushStages,
+		std::span<const VkPipeline> pipelines, std::span<const DrawMesh> meshes);
+
+	size_t size() const { return _entries.size(); }
+	const DrawListStats& stats() const { return _stats; }
+
+private:
+	struct SortEntry {
+		uint64_t key;
+		uint32_t index; // _draws 下标
+		uint32_t pad;
+	};
+
+	struct Draw {
+		uint32_t pipeline;
+		uint32_t mesh;
+		uint32_t vertexOffset;
+		MeshPushConstants constants;
+	};
+
+	std::vector<SortEntry> _entries;
+	std::vector<SortEntry> _scratch;
+	std::vector<Draw> _draws;
+	DrawListStats _stats{};
+};
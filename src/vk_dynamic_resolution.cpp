@@ -0,0 +1,137 @@
+#include "vk_dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+// ============================================================
+// GpuFrameTimer
+// ============================================================
+
+bool GpuFrameTimer::init(VkDevice device, VkPhysicalDevice gpu)
+{
+	_device = device;
+
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(gpu, &properties);
+	if (!properties.limits.timestampComputeAndGraphics || properties.limits.timestampPeriod <= 0.0f) {
+		vklog::info() << "GPU timestamps not supported, dynamic resolution disabled";
+		return false;
+	}
+	_periodNs = properties.limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = 2;
+
+	if (vkCreateQueryPool(_device, &poolInfo, nullptr, &_pool) != VK_SUCCESS) {
+		vklog::error() << "Failed to create timestamp query pool";
+		_pool = VK_NULL_HANDLE;
+		return false;
+	}
+	return true;
+}
+
+void GpuFrameTimer::cleanup()
+{
+	if (_pool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(_device, _pool, nullptr);
+		_pool = VK_NULL_HANDLE;
+	}
+	_pending = false;
+}
+
+void GpuFrameTimer::begin(VkCommandBuffer cmd)
+{
+	if (_pool == VK_NULL_HANDLE) {
+		return;
+	}
+	vkCmdResetQueryPool(cmd, _pool, 0, 2);
+	vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, _pool, 0);
+}
+
+void GpuFrameTimer::end(VkCommandBuffer cmd)
+{
+	if (_pool == VK_NULL_HANDLE) {
+		return;
+	}
+	vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, _pool, 1);
+	_pending = true;
+}
+
+bool GpuFrameTimer::read(float& milliseconds)
+{
+	if (!_pending) {
+		return false;
+	}
+	_pending = false;
+
+	uint64_t timestamps[2] = {};
+	if (vkGetQueryPoolResults(_device, _pool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+		return false;
+	}
+	if (timestamps[1] <= timestamps[0]) {
+		return false;
+	}
+	milliseconds = (float)((double)(timestamps[1] - timestamps[0]) * _periodNs / 1000000.0);
+	return true;
+}
+
+// ============================================================
+// DynamicResolution
+// ============================================================
+
+void DynamicResolution::init(float targetMs, float minScale, float maxScale)
+{
+	_targetMs = targetMs;
+	_minScale = minScale;
+	_maxScale = maxScale;
+	_scale = maxScale;
+	_fullResMs = 0.0f;
+	_cooldown = 0;
+}
+
+float DynamicResolution::update(float gpuMs)
+{
+	if (gpuMs <= 0.0f) {
+		return _scale;
+	}
+
+	// 换算成全分辨率下的时间再平滑，这样缩放比变化本身不会让平滑值滞后
+	const float fullMs = gpuMs / (_scale * _scale);
+	if (_fullResMs == 0.0f) {
+		_fullResMs = fullMs;
+	}
+	else {
+		const float alpha = fullMs > _fullResMs ? 0.3f : 0.05f;
+		_fullResMs += alpha * (fullMs - _fullResMs);
+	}
+
+	if (_cooldown > 0) {
+		_cooldown--;
+		return _scale;
+	}
+
+	float desired = std::sqrt(_targetMs / _fullResMs);
+	if (std::abs(desired - _scale) < DEADBAND * _scale) {
+		return _scale;
+	}
+
+	desired = std::clamp(desired, _scale - MAX_STEP, _scale + MAX_STEP);
+	desired = std::clamp(std::round(desired / QUANTUM) * QUANTUM, _minScale, _maxScale);
+
+	if (desired != _scale) {
+		_scale = desired;
+		_cooldown = COOLDOWN_FRAMES;
+	}
+	return _scale;
+}
+
+VkExtent2D DynamicResolution::scaled(VkExtent2D maxExtent) const
+{
+	VkExtent2D extent;
+	extent.width = std::clamp((uint32_t)(maxExtent.width * _scale + 0.5f), 1u, maxExtent.width);
+	extent.height = std::clamp((uint32_t)(maxExtent.height * _scale + 0.5f), 1u, maxExtent.height);
+	return extent;
+}
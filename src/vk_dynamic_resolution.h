@@ -0,0 +1,58 @@
+#pragma once
+
+#include "vk_types.h"
+
+// GPU 帧时间
+// 每帧在命令缓冲区首尾各写一个时间戳，下一帧等完 fence 之后再读，读结果不会等待 GPU
+class GpuFrameTimer {
+public:
+	bool init(VkDevice device, VkPhysicalDevice gpu); // 设备不支持图形队列时间戳时返回 false
+	void cleanup();
+
+	void begin(VkCommandBuffer cmd); // 命令缓冲区开头
+	void end(VkCommandBuffer cmd);   // 命令缓冲区末尾
+
+	// 帧 fence 之后调用；上一帧没有写时间戳 (或结果还没好) 时返回 false
+	bool read(float& milliseconds);
+
+	bool supported() const { return _pool != VK_NULL_HANDLE; }
+
+private:
+	VkDevice _device{ VK_NULL_HANDLE };
+	VkQueryPool _pool{ VK_NULL_HANDLE };
+	float _periodNs{ 0.0f }; // 一个时间戳单位是多少纳秒
+	bool _pending{ false };
+};
+
+// 动态分辨率控制器
+// 像素开销近似和缩放比的平方成正比：实测时间先除以 scale^2 换算成全分辨率的时间，
+// 平滑之后取 sqrt(目标 / 全分辨率时间) 作为新的缩放比
+// - 指数平滑：变慢时平滑得少 (尽快降分辨率)，变快时平滑得多 (慢慢升回去)
+// - 目标附近留一个死区，调整后冷却几帧 (时间戳结果本来就晚一帧)，避免来回抖动
+class DynamicResolution {
+public:
+	void init(float targetMs, float minScale = 0.5f, float maxScale = 1.0f);
+
+	// 喂一帧的 GPU 时间，返回新的缩放比
+	float update(float gpuMs);
+
+	float scale() const { return _scale; }
+	float predicted_ms() const { return _fullResMs * _scale * _scale; } // 当前缩放比下预计的 GPU 时间
+	float target_ms() const { return _targetMs; }
+
+	// 按当前缩放比算出的渲染尺寸 (maxExtent 是附件实际分配的大小)
+	VkExtent2D scaled(VkExtent2D maxExtent) const;
+
+private:
+	static constexpr float DEADBAND = 0.05f;   // 新旧缩放比相差 5% 以内不调整
+	static constexpr float MAX_STEP = 0.1f;    // 一次最多调整的缩放比
+	static constexpr float QUANTUM = 1.0f / 64.0f;
+	static constexpr uint32_t COOLDOWN_FRAMES = 4;
+
+	float _targetMs{ 16.0f };
+	float _minScale{ 0.5f };
+	float _maxScale{ 1.0f };
+	float _scale{ 1.0f };
+	float _fullResMs{ 0.0f }; // 平滑后的全分辨率 GPU 时间
+	uint32_t _cooldown{ 0 };
+};
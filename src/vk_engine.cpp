@@ -2,15 +2,20 @@
 
 #include "vk_engine.h"// 包含 Vulkan 引擎的头文件
 #include "vk_initializers.h"// 包含我们自定义的初始化辅助函数
+#include "vk_asset.h"// 烘焙资源 (.vasset)
 
-#include<fstream>
 // 引入 SDL
 // 这里的路径依赖于我们刚才 CMake 的 include 目录设置
 // 如果报错找不到，试试 <SDL2/SDL.h>
 #include <SDL.h>// SDL 主头文件
 #include <SDL_vulkan.h>// SDL 的 Vulkan 扩展
 
+#include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <cmath>// 数学库
+#include <filesystem>
+#include <unordered_map>
 #include <glm/gtx/transform.hpp>// GLM 变换扩展
 
 #include <VkBootstrap.h>// 引入 vk-bootstrap，简化 Vulkan 初始化
@@ -32,19 +37,19 @@ VkPipeline PipelineBuilder::build_pipeline(VkDevice device) {// 根据配置构
     colorBlending.pNext = nullptr;
     colorBlending.logicOpEnable = VK_FALSE;
     colorBlending.logicOp = VK_LOGIC_OP_COPY;
-    colorBlending.attachmentCount = 1;
+    colorBlending.attachmentCount = _renderInfo.colorAttachmentCount; // 只有深度的管线 (阴影) 没有颜色附件
     colorBlending.pAttachments = &_colorBlendAttachment;
 
     // 3. 设置动态状态 (Dynamic State) [关键!]
-    // 允许我们在绘制时改变视口大小，而不用重建管线
-    std::vector<VkDynamicState> dynamicStates = {
+    // 允许我们在绘制时改变视口大小，而不用重建管线 (固定的两项，放在栈上)
+    const VkDynamicState dynamicStates[] = {
         VK_DYNAMIC_STATE_VIEWPORT,
         VK_DYNAMIC_STATE_SCISSOR
     };
     VkPipelineDynamicStateCreateInfo dynamicInfo = {};
     dynamicInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicInfo.dynamicStateCount = (uint32_t)dynamicStates.size();
-    dynamicInfo.pDynamicStates = dynamicStates.data();
+    dynamicInfo.dynamicStateCount = (uint32_t)std::size(dynamicStates);
+    dynamicInfo.pDynamicStates = dynamicStates;
 
     // 4. 组装最终的 CreateInfo
     VkGraphicsPipelineCreateInfo pipelineInfo = {};
@@ -67,20 +72,158 @@ VkPipeline PipelineBuilder::build_pipeline(VkDevice device) {// 根据配置构
     // 5. 真正的创建调用
     VkPipeline newPipeline;
     if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &newPipeline) != VK_SUCCESS) {
-        std::cout << "[ERROR] Failed to create pipeline" << std::endl;
+        vklog::error() << "Failed to create pipeline";
         return VK_NULL_HANDLE; // 失败返回空句柄
     }
     return newPipeline;
 }
 
+VkPipeline ComputePipelineBuilder::build_pipeline(VkDevice device) {// 根据配置构建计算管线
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = nullptr;
+    pipelineInfo.stage = _shaderStage;
+    pipelineInfo.layout = _pipelineLayout;
+
+    VkPipeline newPipeline;
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &newPipeline) != VK_SUCCESS) {
+        vklog::error() << "Failed to create compute pipeline";
+        return VK_NULL_HANDLE;
+    }
+    return newPipeline;
+}
+
 void VulkanEngine::init()
 {
-    // 1. 初始化 SDL 和 窗口
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
-        std::cout << "[ERROR] Could not initialize SDL! Error: " << SDL_GetError() << std::endl;
+    // 0. 回放：先读抓帧文件头，离屏目标按抓帧时的窗口大小创建
+    _headless = !_replayPath.empty();
+    if (_headless) {
+        if (!_replayReader.open(_replayPath.c_str())) {
+            return;
+        }
+        _windowExtent = { _replayReader.header().width, _replayReader.header().height };
+    }
+
+    // 工作线程池 (纯 CPU，不依赖 Vulkan)，启动图的 Worker 阶段也跑在上面
+    _jobs.init();
+    _frameArenas.init(FRAMES_IN_FLIGHT, 1 << 20);
+    _streamer.init(&_jobs);
+    _sceneBvh.init(&_jobs);
+
+    // 启动依赖图：不依赖设备的活 (窗口、实例、读 shader 包、生成网格) 一开始就并行进行，
+    // 设备创建好之后 VMA / 命令池 / 管线 / 上传再分头进行
+    // 用 MemoryManager 分配的阶段 (交换链的离屏目标、descriptor、网格、渲染图) 用依赖串起来，它不是线程安全的
+    using Stage = StartupGraph::StageThread;
+    vkb::Instance vkbInstance;
+    vklod::MeshLodChain cube;
+    SkinnedDemo tentacle;
+
+    // 1. SDL 窗口 (必须在主线程；headless 不需要)
+    const auto window = _startup.add_stage("window", Stage::Main, {}, [this]() { return init_window(); });
+
+    // 2. Vulkan 实例 (加载器 + 验证层，和窗口互不依赖)
+    const auto instance = _startup.add_stage("instance", Stage::Worker, {}, [&]() { return init_instance(vkbInstance); });
+
+    // 3. 映射 shader 包并预读进页缓存 (构建时由 ShaderPacker 生成)
+    const auto shaderPack = _startup.add_stage("shader_pack", Stage::Worker, {}, [this]() {
+        if (!_shaderPack.open("shaders/shaders.pak")) {
+            vklog::error() << "Shader pack missing, rebuild the ShaderPack target";
+            return false; // 没有包就建不出任何管线，下游的阶段都不用跑了
+        }
+        _shaderPack.prefetch();
+        return true;
+    });
+
+    // 4. 默认网格的顶点和 LOD 链 (纯 CPU)
+    const auto geometry = _startup.add_stage("default_geometry", Stage::Worker, {}, [&]() {
+        const std::vector<Vertex> vertices = build_cube_vertices();
+        cube = vklod::build_chain(vertices, {});
+        tentacle = build_tentacle();
+        return true;
+    });
+
+    // 5. surface + 选 GPU + 逻辑设备 (surface 需要窗口，放在主线程)
+    const auto device = _startup.add_stage("device", Stage::Main, { window, instance }, [&]() { return init_device(vkbInstance); });
+
+    // 6. VMA (依赖 Instance/Device)，分配按类别记账、走各自的池
+    const auto memory = _startup.add_stage("memory", Stage::Worker, { device }, [this]() {
+        if (!_memory.init(_instance, _chosenGPU, _device, _supportsMemoryBudget)) {
+            return false;
+        }
+        _allocator = _memory.allocator();
+        vklog::info() << "Vulkan Memory Allocator Initialized!";
+
+        // 抓帧从这里开始：之后创建的材质 / 网格 / 纹理都会先于用到它们的帧写进文件
+        if (!_capturePath.empty()) {
+            _capture.open(_capturePath.c_str(), _windowExtent);
+        }
+        return true;
+    });
+
+    // 7. 命令池和同步原语、异步计算 (依赖 Device)
+    const auto commands = _startup.add_stage("commands", Stage::Worker, { device }, [this]() {
+        init_commands();
+        init_sync_structures();
+        return _compute.init(_device, _computeQueue, _computeQueueFamily, _graphicsQueue, _graphicsQueueFamily);
+    });
+
+    // 8. 交换链 (依赖 Device/Surface，有的平台要求在窗口线程上创建；headless 时用 VMA 分配离屏目标)
+    const auto swapchain = _startup.add_stage("swapchain", Stage::Main, { memory }, [this]() {
+        init_swapchain();
+        return true;
+    });
+
+    // 9. bindless 全局 set 和材质表 (依赖 VMA，必须在管线之前；蒙皮的输出 buffer 要按异步计算的队列族共享)
+    const auto descriptors = _startup.add_stage("descriptors", Stage::Worker, { swapchain, commands }, [this]() {
+        return init_descriptors() &&
+            _meshlets.init(_device, &_memory, &_bindless, _supportsMeshShaders) &&
+            _staticDraws.init(_device, _graphicsQueueFamily, &_memory, &_bindless) &&
+            _shadows.init(_device, &_memory, &_bindless) &&
+            _clusteredLights.init(_device, &_memory, &_bindless) &&
+            _skinning.init(_device, &_memory, &_bindless, &_compute, &_jobs, &_frameArenas) &&
+            _particles.init(_device, _chosenGPU, &_memory, &_bindless);
+    });
+
+    // 10. 管线 (依赖全局 set layout / shader 包)，和下面的上传、渲染图同时进行
+    _startup.add_stage("pipelines", Stage::Worker, { descriptors, shaderPack }, [this]() {
+        if (!init_pipelines()) {
+            return false;
+        }
+        vklog::info() << "Pipelines Initialized!";
+        return true;
+    });
+
+    // 11. 上传默认网格 (依赖 VMA / 顶点数据)
+    const auto defaultData = _startup.add_stage("default_data", Stage::Worker, { descriptors, geometry }, [&]() { return init_default_data(cube, tentacle); });
+
+    // 12. 渲染图 (依赖交换链 / 虚拟纹理)
+    _startup.add_stage("render_graph", Stage::Worker, { defaultData }, [this]() { return init_render_graph(); });
+
+    // ====================================================
+    // [关键修正] 只有当所有步骤都跑通了，才标记引擎已初始化！
+    // ====================================================
+    const bool ok = _startup.run(_jobs);
+    _startup.report();
+    if (!ok) {
+        vklog::error() << "Engine initialization failed!";
         return;
     }
 
+    _isInitialized = true;
+    vklog::info() << "Engine Fully Initialized!";
+}
+
+bool VulkanEngine::init_window()
+{
+    if (_headless) {
+        return true;
+    }
+
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        vklog::error() << "Could not initialize SDL! Error: " << SDL_GetError();
+        return false;
+    }
+
     SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
 
     _window = SDL_CreateWindow(
@@ -93,50 +236,16 @@ void VulkanEngine::init()
     );
 
     if (!_window) {
-        std::cout << "[ERROR] Could not create window! Error: " << SDL_GetError() << std::endl;
-        return;
+        vklog::error() << "Could not create window! Error: " << SDL_GetError();
+        return false;
     }
-    
-    // [注意] 这里不要设置 _isInitialized = true！
-    std::cout << "[INFO] SDL Initialized & Window Created!" << std::endl;
-
-    // 2. 初始化核心 Vulkan 对象
-    init_vulkan(); 
-
-    // 3. 初始化 VMA (依赖 Instance/Device)
-    VmaAllocatorCreateInfo allocatorInfo = {};
-    allocatorInfo.physicalDevice = _chosenGPU;
-    allocatorInfo.device = _device;
-    allocatorInfo.instance = _instance;
-    allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
-    vmaCreateAllocator(&allocatorInfo, &_allocator);
 
-    std::cout << "[INFO] Vulkan Memory Allocator Initialized!" << std::endl;
-
-    // 4. 初始化交换链 (依赖 Device/Surface)
-    init_swapchain(); // 这里面通常也会设定 _depthImageFormat
-
-    // 5. 初始化命令和同步 (依赖 Device)
-    init_commands();      
-    init_sync_structures();
-
-    // 6. 初始化资源 (依赖 VMA / CommandPool)
-    init_default_data(); // 上传顶点数据
-
-    // 7. 初始化管线 (依赖 Swapchain 格式 / RenderPass信息)
-    init_pipelines(); 
-    
-    std::cout << "[INFO] Pipelines Initialized!" << std::endl;
-
-    // ====================================================
-    // [关键修正] 只有当所有步骤都跑通了，才标记引擎已初始化！
-    // ====================================================
-    _isInitialized = true;
-    std::cout << "[INFO] Engine Fully Initialized!" << std::endl;
+    vklog::info() << "SDL Initialized & Window Created!";
+    return true;
 }
 
 // [新增] 实现 Vulkan 初始化逻辑
-void VulkanEngine::init_vulkan()// 初始化 Vulkan
+bool VulkanEngine::init_instance(vkb::Instance& vkbInstance)// 创建 Vulkan 实例
 {
 	// 1. 创建 Instance (实例)
 	// vkb::InstanceBuilder 是一个“建造者模式”的工具，帮我们配置参数
@@ -145,28 +254,101 @@ void VulkanEngine::init_vulkan()// 初始化 Vulkan
 	auto inst_ret = builder.set_app_name("Example Vulkan Application")
 		.request_validation_layers(true) // [重要] 开启验证层！这是新手救星
 		.require_api_version(1, 3, 0)    // 我们使用 Vulkan 1.3
-		.use_default_debug_messenger()   // 自动把报错打印到控制台
+		.set_debug_callback(vklog::debug_callback) // 开启调试信使，验证层的报错走异步日志 (不在驱动调用里同步打印，重复的会被限流)
+		.set_headless(_headless)         // 回放时没有窗口，不需要 surface 扩展
 		.build();
 
 	// 检查 Instance 是否创建成功
-	vkb::Instance vkb_inst = inst_ret.value();
+	if (!inst_ret) {
+		vklog::error() << "Failed to create Vulkan instance";
+		return false;
+	}
+	vkbInstance = inst_ret.value();
 
 	// 保存 Instance 句柄
-	_instance = vkb_inst.instance;
-	_debug_messenger = vkb_inst.debug_messenger;
+	_instance = vkbInstance.instance;
+	_debug_messenger = vkbInstance.debug_messenger;
+	return true;
+}
 
+bool VulkanEngine::init_device(const vkb::Instance& vkbInstance)// 创建 surface、选择 GPU、创建逻辑设备
+{
 	// 2. 创建 Surface (表面)
 	// SDL 帮我们处理了不同操作系统（Windows/Linux）的细节
-	SDL_Vulkan_CreateSurface(_window, _instance, &_surface);
+	// headless 时没有 surface，选显卡也不检查呈现能力
+	_surface = VK_NULL_HANDLE;
+	if (!_headless) {
+		SDL_Vulkan_CreateSurface(_window, _instance, &_surface);
+	}
 
 	// 3. 选择 GPU (物理设备)
 	// vkb::PhysicalDeviceSelector 会帮我们找到最强的一张显卡
-	vkb::PhysicalDeviceSelector selector{ vkb_inst };
-	vkb::PhysicalDevice physicalDevice = selector
+	vkb::PhysicalDeviceSelector selector{ vkbInstance };
+
+	// Vulkan 1.0 特性：片段着色器写 storage buffer (虚拟纹理反馈)，间接绘制带 firstInstance (meshlet 回退路径的绘制下标)，
+	// 一次间接绘制多条命令 (静态物体按组绘制)
+	VkPhysicalDeviceFeatures features = {};
+	features.fragmentStoresAndAtomics = VK_TRUE;
+	features.drawIndirectFirstInstance = VK_TRUE;
+	features.multiDrawIndirect = VK_TRUE;
+
+	// Vulkan 1.1 特性：多视角渲染 (一次提交画到多层附件，静态阴影缓存用)
+	VkPhysicalDeviceVulkan11Features features11 = {};
+	features11.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_11_FEATURES;
+	features11.multiview = VK_TRUE;
+
+	// Vulkan 1.3 特性：动态渲染 + synchronization2
+	VkPhysicalDeviceVulkan13Features features13 = {};
+	features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_13_FEATURES;
+	features13.dynamicRendering = VK_TRUE;
+	features13.synchronization2 = VK_TRUE;
+
+	// Vulkan 1.2 特性：buffer device address (VMA 用到) + descriptor indexing (bindless)
+	VkPhysicalDeviceVulkan12Features features12 = {};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+	features12.bufferDeviceAddress = VK_TRUE;
+	features12.descriptorIndexing = VK_TRUE;
+	features12.runtimeDescriptorArray = VK_TRUE;
+	features12.descriptorBindingPartiallyBound = VK_TRUE;
+	features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+	features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+	features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+	features12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+	features12.timelineSemaphore = VK_TRUE; // 异步计算和图形队列之间的交接
+	features12.drawIndirectCount = VK_TRUE; // meshlet 回退路径：命令条数由剔除着色器决定
+
+	auto physicalDeviceRet = selector
 		.set_minimum_version(1, 3)     // 显卡必须支持 Vulkan 1.3
+		.set_required_features(features)
+		.set_required_features_13(features13)
+		.set_required_features_12(features12)
+		.set_required_features_11(features11)
 		.set_surface(_surface)         // 显卡必须能画到这个窗口上
-		.select()
-		.value();
+		.select();
+	if (!physicalDeviceRet) {
+		vklog::error() << "No suitable GPU found";
+		return false;
+	}
+	vkb::PhysicalDevice physicalDevice = physicalDeviceRet.value();
+
+	// 可选特性：BC 压缩纹理 (几乎所有桌面显卡都支持)
+	VkPhysicalDeviceFeatures optionalFeatures = {};
+	optionalFeatures.textureCompressionBC = VK_TRUE;
+	_supportsBC = physicalDevice.enable_features_if_present(optionalFeatures);
+
+	// 可选扩展：显存预算 (驱动告诉我们这个进程在每个堆上还能用多少)
+	_supportsMemoryBudget = physicalDevice.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+	// 可选扩展：mesh shader (task + mesh)，没有时 meshlet 走计算剔除 + 间接绘制
+	if (physicalDevice.is_extension_present(VK_EXT_MESH_SHADER_EXTENSION_NAME)) {
+		VkPhysicalDeviceMeshShaderFeaturesEXT meshFeatures = {};
+		meshFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+		meshFeatures.taskShader = VK_TRUE;
+		meshFeatures.meshShader = VK_TRUE;
+		_supportsMeshShaders = physicalDevice.enable_extension_features_if_present(meshFeatures) &&
+			physicalDevice.enable_extension_if_present(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+	}
 
 		
 	// 4. 创建 Device (逻辑设备)
@@ -182,15 +364,75 @@ void VulkanEngine::init_vulkan()// 初始化 Vulkan
     _graphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
     _graphicsQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
 
+	// 计算队列：优先专用的 (只能计算)，其次和图形分开的队列族，都没有就退回图形队列 (照常提交，只是不能重叠)
+	// vk-bootstrap 默认给每个队列族都建了一个队列
+	auto dedicatedCompute = vkbDevice.get_dedicated_queue(vkb::QueueType::compute);
+	auto separateCompute = vkbDevice.get_queue(vkb::QueueType::compute);
+	if (dedicatedCompute) {
+		_computeQueue = dedicatedCompute.value();
+		_computeQueueFamily = vkbDevice.get_dedicated_queue_index(vkb::QueueType::compute).value();
+	}
+	else if (separateCompute) {
+		_computeQueue = separateCompute.value();
+		_computeQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::compute).value();
+	}
+	else {
+		_computeQueue = _graphicsQueue;
+		_computeQueueFamily = _graphicsQueueFamily;
+	}
+
 	
 
-	std::cout << "[INFO] Vulkan Device Initialized!" << std::endl;
-	std::cout << "[INFO] GPU: " << physicalDevice.name << std::endl;
+	vklog::info() << "Vulkan Device Initialized!";
+	vklog::info() << "GPU: " << physicalDevice.name;
+	return true;
 }
 
-// 在 init_vulkan 之后添加这个函数
+// 在 init_device 之后添加这个函数
 void VulkanEngine::init_swapchain()// 初始化交换链
 {
+	// headless：一张离屏图像代替交换链 (只有一张，"索引" 永远是 0)
+	if (_headless) {
+		_swapchain = VK_NULL_HANDLE;
+		_swapchainImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = _swapchainImageFormat;
+		imageInfo.extent = { _windowExtent.width, _windowExtent.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (!_memory.create_image(imageInfo, MemoryCategory::Attachments, _headlessTarget)) {
+			vklog::error() << "Failed to create headless render target";
+			return;
+		}
+		_headlessTarget._imageExtent = imageInfo.extent;
+		_headlessTarget._imageFormat = imageInfo.format;
+
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.image = _headlessTarget._image;
+		viewInfo.format = _swapchainImageFormat;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.layerCount = 1;
+		if (vkCreateImageView(_device, &viewInfo, nullptr, &_headlessTarget._imageView) != VK_SUCCESS) {
+			vklog::error() << "Failed to create headless render target view";
+		}
+
+		_swapchainImages = { _headlessTarget._image };
+		_swapchainImageViews = { _headlessTarget._imageView };
+
+		vklog::info() << "Headless Render Target Initialized! (" << _windowExtent.width << "x" << _windowExtent.height << ")";
+		return;
+	}
+
 	vkb::SwapchainBuilder swapchainBuilder{_chosenGPU, _device, _surface };
 
 	vkb::Swapchain vkbSwapchain = swapchainBuilder
@@ -199,6 +441,7 @@ void VulkanEngine::init_swapchain()// 初始化交换链
 		// MAILBOX 是最理想的 (三重缓冲，无撕裂，低延迟)，如果没有就回退到 FIFO (传统垂直同步)
 		.set_desired_present_mode(VK_PRESENT_MODE_MAILBOX_KHR) 
 		.set_desired_extent(_windowExtent.width, _windowExtent.height)
+		.add_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_DST_BIT) // 场景画在离屏 draw image 上，最后 blit 进来
 		.build()
 		.value();
 
@@ -211,63 +454,8 @@ void VulkanEngine::init_swapchain()// 初始化交换链
 	_swapchainImages = vkbSwapchain.get_images().value();
 	_swapchainImageViews = vkbSwapchain.get_image_views().value();
 
-	std::cout << "[INFO] Swapchain Initialized!" << std::endl;
-	std::cout << "[INFO] Format: " << _swapchainImageFormat << " | Images: " << _swapchainImages.size() << std::endl;
-
-	// 创建深度缓冲区 (Depth Buffer)
-    // --------------------------------------------------------
-    
-    // 1. 设置深度图格式 (D32_SFLOAT 是最常用的高精度深度格式)
-    _depthImage._imageFormat = VK_FORMAT_D32_SFLOAT;
-    _depthImage._imageExtent = {
-        _windowExtent.width,
-        _windowExtent.height,
-        1
-    };
-
-    VkImageCreateInfo dimg_info = {};
-    dimg_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    dimg_info.pNext = nullptr;
-    dimg_info.imageType = VK_IMAGE_TYPE_2D;
-    dimg_info.format = _depthImage._imageFormat;
-    // extent 定义了长宽深
-    dimg_info.extent = _depthImage._imageExtent;
-    dimg_info.mipLevels = 1;
-    dimg_info.arrayLayers = 1;
-    dimg_info.samples = VK_SAMPLE_COUNT_1_BIT;
-    dimg_info.tiling = VK_IMAGE_TILING_OPTIMAL; // 让显卡自己优化内存布局
-    // 关键：告诉显卡这张图是用作深度/模板附件的
-    dimg_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-
-    // 2. 分配显存 (VMA)
-    VmaAllocationCreateInfo dimg_allocinfo = {};
-    dimg_allocinfo.usage = VMA_MEMORY_USAGE_GPU_ONLY; // 深度图只在 GPU 上用
-    dimg_allocinfo.requiredFlags = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    vmaCreateImage(_allocator, &dimg_info, &dimg_allocinfo, 
-        &_depthImage._image, 
-        &_depthImage._allocation, 
-        nullptr);
-
-    // 3. 创建 ImageView (让管线能看到这张图)
-    VkImageViewCreateInfo dview_info = {};
-    dview_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    dview_info.pNext = nullptr;
-    dview_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    dview_info.image = _depthImage._image;
-    dview_info.format = _depthImage._imageFormat;
-    dview_info.subresourceRange.baseMipLevel = 0;
-    dview_info.subresourceRange.levelCount = 1;
-    dview_info.subresourceRange.baseArrayLayer = 0;
-    dview_info.subresourceRange.layerCount = 1;
-    dview_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT; // 标记为深度方面
-
-    if (vkCreateImageView(_device, &dview_info, nullptr, &_depthImage._imageView) != VK_SUCCESS) {
-        std::cout << "[ERROR] Failed to create depth image view!" << std::endl;
-    }
-
-    std::cout << "[INFO] Depth Buffer Created!" << std::endl;
-
+	vklog::info() << "Swapchain Initialized!";
+	vklog::info() << "Format: " << _swapchainImageFormat << " | Images: " << _swapchainImages.size();
 }
 
 void VulkanEngine::init_commands()// 初始化命令系统
@@ -284,7 +472,7 @@ void VulkanEngine::init_commands()// 初始化命令系统
 	commandPoolInfo.queueFamilyIndex = _graphicsQueueFamily;
 
 	if (vkCreateCommandPool(_device, &commandPoolInfo, nullptr, &_commandPool) != VK_SUCCESS) {
-		std::cout << "[ERROR] Failed to create Command Pool" << std::endl;
+		vklog::error() << "Failed to create Command Pool";
 		return; // 实际工程中应该抛异常
 	}
 
@@ -298,10 +486,10 @@ void VulkanEngine::init_commands()// 初始化命令系统
 	cmdAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY; // 主缓冲区 (可以直接提交给队列)
 
 	if (vkAllocateCommandBuffers(_device, &cmdAllocInfo, &_mainCommandBuffer) != VK_SUCCESS) {
-		std::cout << "[ERROR] Failed to allocate Command Buffer" << std::endl;
+		vklog::error() << "Failed to allocate Command Buffer";
 	}
 
-	std::cout << "[INFO] Command Pool & Buffer Created!" << std::endl;
+	vklog::info() << "Command Pool & Buffer Created!";
 }
 
 void VulkanEngine::init_sync_structures()//	
@@ -318,7 +506,7 @@ void VulkanEngine::init_sync_structures()//
 	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
 	if (vkCreateFence(_device, &fenceInfo, nullptr, &_renderFence) != VK_SUCCESS) {
-		std::cout << "[ERROR] Failed to create Fence" << std::endl;
+		vklog::error() << "Failed to create Fence";
 	}
 
 	// 2. 创建 Semaphores (信号量)
@@ -328,13 +516,13 @@ void VulkanEngine::init_sync_structures()//
 	semaphoreInfo.flags = 0;
 
 	if (vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_presentSemaphore) != VK_SUCCESS) {
-		std::cout << "[ERROR] Failed to create Present Semaphore" << std::endl;
+		vklog::error() << "Failed to create Present Semaphore";
 	}
 	if (vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_renderSemaphore) != VK_SUCCESS) {
-		std::cout << "[ERROR] Failed to create Render Semaphore" << std::endl;
+		vklog::error() << "Failed to create Render Semaphore";
 	}
 
-	std::cout << "[INFO] Sync Structures (Fence/Semaphores) Created!" << std::endl;
+	vklog::info() << "Sync Structures (Fence/Semaphores) Created!";
 }
 
 // 清理函数
@@ -343,30 +531,84 @@ void VulkanEngine::cleanup()
 	if (_isInitialized) {
     vkDeviceWaitIdle(_device); // 1. 确保 GPU 停工
 
+    // 抓帧文件回填帧数并关闭
+    _capture.close();
+    _replayReader.close();
+
+    // 纹理 (先等工作线程停下，再释放图像)
+    _streamer.cleanup();
+    _textures.cleanup();
+    _virtualTexture.cleanup();
+    _jobs.cleanup();
+    _frameArenas.cleanup();
+
     // 2. 销毁管线相关 (Pipeline & Layout)
-    vkDestroyPipelineLayout(_device, _trianglePipelineLayout, nullptr);
+    // pipeline layout / set layout 归 _layoutCache 所有
     vkDestroyPipeline(_device, _trianglePipeline, nullptr);
+    vkDestroyPipeline(_device, _meshletCullPipeline, nullptr);
+    vkDestroyPipeline(_device, _meshletPipeline, nullptr);
+    for (VkPipeline pipeline : _staticPipelines) {
+        vkDestroyPipeline(_device, pipeline, nullptr);
+    }
+    vkDestroyPipeline(_device, _shadowPipeline, nullptr);
+    for (VkPipeline pipeline : _shadowStaticPipelines) {
+        vkDestroyPipeline(_device, pipeline, nullptr);
+    }
+    vkDestroyPipeline(_device, _lightClusterPipeline, nullptr);
+    vkDestroyPipeline(_device, _skinningPipeline, nullptr);
+    vkDestroyPipeline(_device, _particleEmitPipeline, nullptr);
+    vkDestroyPipeline(_device, _particleSimulatePipeline, nullptr);
+    vkDestroyPipeline(_device, _particleArgsPipeline, nullptr);
+    vkDestroyPipeline(_device, _particlePipeline, nullptr);
+    _layoutCache.cleanup();
+    _shaderPack.close();
+
+    // bindless 全局 set / 默认采样器
+    vkDestroySampler(_device, _defaultSampler, nullptr);
+    _bindless.cleanup();
 
     // 3. 销毁同步对象 (Fences & Semaphores)
     vkDestroyFence(_device, _renderFence, nullptr);
     vkDestroySemaphore(_device, _presentSemaphore, nullptr);
     vkDestroySemaphore(_device, _renderSemaphore, nullptr);
+    _compute.cleanup();
 
     // ==========================================================
     // [关键修正区] 销毁资源顺序
     // 原则：先销毁依赖 VMA 的资源 (Image/Buffer)，最后销毁 VMA 本身
     // ==========================================================
     
-    // 4.1 销毁顶点缓冲区
-    vmaDestroyBuffer(_allocator, _vertexBuffer._buffer, _vertexBuffer._allocation);
-
-    // 4.2 销毁深度图相关
-    vkDestroyImageView(_device, _depthImage._imageView, nullptr);
+    // 4.1 销毁顶点 / 索引缓冲区、材质表
+    for (MeshAsset& asset : _meshAssets) {
+        _memory.destroy_buffer(asset.vertexBuffer);
+        _memory.destroy_buffer(asset.indexBuffer);
+    }
+    _meshlets.cleanup();
+    _staticDraws.cleanup();
+    _shadows.cleanup();
+    _clusteredLights.cleanup();
+    _skinning.cleanup();
+    _particles.cleanup();
+    vmaUnmapMemory(_allocator, _materialBuffer._allocation);
+    _memory.destroy_buffer(_materialBuffer);
+    vmaUnmapMemory(_allocator, _sceneBuffer._allocation);
+    _memory.destroy_buffer(_sceneBuffer);
+
+    _gpuTimer.cleanup();
+
+    // 4.2 销毁渲染图的瞬态图像 (深度图等)
     // VMA 分配器必须还活着，才能销毁 Image！
-    vmaDestroyImage(_allocator, _depthImage._image, _depthImage._allocation);
+    _renderGraph.cleanup();
+
+    // headless 的离屏目标代替了交换链图片
+    if (_headless) {
+        vkDestroyImageView(_device, _headlessTarget._imageView, nullptr);
+        _memory.destroy_image(_headlessTarget);
+        _swapchainImageViews.clear();
+    }
 
-    // 4.3 确认所有 Image/Buffer 都销毁了，现在可以安全销毁 VMA 分配器了
-    vmaDestroyAllocator(_allocator); 
+    // 4.3 确认所有 Image/Buffer 都销毁了，现在可以安全销毁 VMA 分配器了 (还有没释放的分配会打印出来)
+    _memory.cleanup();
 
     // ==========================================================
 
@@ -379,13 +621,17 @@ void VulkanEngine::cleanup()
     for (int i = 0; i < _swapchainImageViews.size(); i++) {
         vkDestroyImageView(_device, _swapchainImageViews[i], nullptr);
     }
-    vkDestroySwapchainKHR(_device, _swapchain, nullptr);
+    if (!_headless) {
+        vkDestroySwapchainKHR(_device, _swapchain, nullptr);
+    }
 
     // 7. 销毁逻辑设备 (Device)
     vkDestroyDevice(_device, nullptr);
 
     // 8. 销毁表面 (Surface)
-    vkDestroySurfaceKHR(_instance, _surface, nullptr);
+    if (!_headless) {
+        vkDestroySurfaceKHR(_instance, _surface, nullptr);
+    }
 
     // 9. 销毁调试信使
     vkb::destroy_debug_utils_messenger(_instance, _debug_messenger);
@@ -394,13 +640,15 @@ void VulkanEngine::cleanup()
     vkDestroyInstance(_instance, nullptr);
 
     // 11. 销毁窗口
-    SDL_DestroyWindow(_window);
-    SDL_Quit();
+    if (!_headless) {
+        SDL_DestroyWindow(_window);
+        SDL_Quit();
+    }
 }
 	
 }
 
-void VulkanEngine::draw()
+void VulkanEngine::draw(const FramePacket& packet)
 {
 	// =================================================================
 	// 1. 等待上一帧完成 (CPU 等待 GPU)
@@ -412,14 +660,43 @@ void VulkanEngine::draw()
 	// 必须手动重置围栏，将其变回 Unsignaled 状态，以便下一帧使用
 	vkResetFences(_device, 1, &_renderFence);
 
+	// 用到这个槽位的上一帧已经完成，它的临时分配可以整体作废
+	_frameArenas.begin_frame(_frameNumber);
+
+	// GPU 已经用完之前的帧，退休期满的 bindless 槽位可以复用了
+	_bindless.begin_frame(_frameNumber);
+	_materialSlots.recycle(_frameNumber);
+
+	// 上一帧的碎片整理拷贝已经完成，切换到新位置；定期检查预算
+	_memory.update(_frameNumber);
+
+	// 提交新解码好的纹理，把上传完成的纹理切换进 bindless 表
+	_textures.update(_frameNumber, _frameArenas.local());
+	// 按上一帧给出的优先级发起这一帧预算内的读 (读完的在工作线程上解码，之后才进上传)
+	_streamer.update();
+
+	// 动态分辨率：用上一帧的 GPU 时间决定这一帧的渲染大小
+	float gpuMs = 0.0f;
+	if (_gpuTimer.read(gpuMs)) {
+		_lastGpuMs = gpuMs;
+		_dynamicResolution.update(gpuMs);
+	}
+	_renderExtent = _dynamicResolution.scaled(_windowExtent);
+	if (_hasVirtualTexture) {
+		_virtualTexture.set_feedback_extent(_renderExtent);
+	}
+
 	// =================================================================
 	// 2. 获取交换链图片 (请求画布)
 	// =================================================================
 	
-	uint32_t swapchainImageIndex;
+	uint32_t swapchainImageIndex = 0;
 	// 询问交换链下一张可用的图片索引。
 	// 当图片可用时，显卡会发出信号给 _presentSemaphore (我们不需要在 CPU 端等待)
-	vkAcquireNextImageKHR(_device, _swapchain, 1000000000, _presentSemaphore, nullptr, &swapchainImageIndex);
+	// headless 时只有一张离屏图像，不用 acquire
+	if (!_headless) {
+		vkAcquireNextImageKHR(_device, _swapchain, 1000000000, _presentSemaphore, nullptr, &swapchainImageIndex);
+	}
 
 	// =================================================================
 	// 3. 记录命令缓冲区 (写清单)
@@ -434,216 +711,370 @@ void VulkanEngine::draw()
 	cmdBeginInfo.pNext = nullptr;// 无扩展
 	cmdBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;//	 我们只会用这次
 	vkBeginCommandBuffer(_mainCommandBuffer, &cmdBeginInfo);// 开始记录
+	_gpuTimer.begin(_mainCommandBuffer);
+
+	// 碎片整理：每帧搬几个分配 (拷贝排在渲染之前，下一帧才切换)
+	_memory.record_moves(_mainCommandBuffer);
+
+	// 渲染图负责所有的布局转换和 barrier (交换链 UNDEFINED -> COLOR_ATTACHMENT -> PRESENT_SRC，深度图等)
+	_renderGraph.set_imported_image(_rgSwapchain, _swapchainImages[swapchainImageIndex], _swapchainImageViews[swapchainImageIndex]);
+	_currentPacket = &packet; // pass 的执行函数从这里读这一帧的相机和物体
+	build_draws(packet);
+	_renderGraph.execute(_mainCommandBuffer);
+	_currentPacket = nullptr;
+
+	// 结束记录
+	_gpuTimer.end(_mainCommandBuffer);
+	vkEndCommandBuffer(_mainCommandBuffer);
+
+	// =================================================================
+	// 4. 提交给 GPU (Execute)
+	// =================================================================
+
+	VkSemaphoreSubmitInfo waits[2];
+	VkSemaphoreSubmitInfo signals[2];
+	uint32_t waitCount = 0;
+	uint32_t signalCount = 0;
 
-	// --- [关键步骤] 图片布局转换 (Layout Transition) ---
-	// 图片刚拿来时是 "Undefined" 状态，或者是上次呈现后的 "Present" 状态。
-	// 我们必须把它变成 "Color Attachment" (可绘制) 状态才能往上画画。
+	// 等待信号量：_presentSemaphore (等交换链把图给我们)
+	// 交换链图片只在最后的 upscale blit 里用到，场景渲染不用等它
+	// headless 时没有交换链，不等也不发信号量
+	if (!_headless) {
+		waits[waitCount++] = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, _presentSemaphore);
+	}
+	// 异步计算的结果：只在真正用到它的阶段等，之前的阶段和计算队列重叠
+	if (_compute.graphics_wait(waits[waitCount])) {
+		waitCount++;
+	}
+
+	// 完成信号量：_renderSemaphore (画完了通知交换链)，以及图形时间线 (计算队列可以等这一帧的结果)
+	if (!_headless) {
+		signals[signalCount++] = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, _renderSemaphore);
+	}
+	signals[signalCount++] = _compute.graphics_signal();
+
+	// 提交命令缓冲区
+	VkCommandBufferSubmitInfo cmdInfo = vkinit::command_buffer_submit_info(_mainCommandBuffer);
+
+	VkSubmitInfo2 submit = {};
+	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	submit.waitSemaphoreInfoCount = waitCount;
+	submit.pWaitSemaphoreInfos = waits;
+	submit.commandBufferInfoCount = 1;
+	submit.pCommandBufferInfos = &cmdInfo;
+	submit.signalSemaphoreInfoCount = signalCount;
+	submit.pSignalSemaphoreInfos = signals;
+
+	// 提交！并把 _renderFence 传进去，这样 CPU 就能知道这帧什么时候算完
+	if (vkQueueSubmit2(_graphicsQueue, 1, &submit, _renderFence) != VK_SUCCESS) {
+		vklog::error() << "Failed to submit draw command buffer!";
+	}
+
+	// =================================================================
+	// 5. 呈现 (Present)
+	// =================================================================
 	
-	VkImageMemoryBarrier imgBarrier = {};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED; // 我们不关心它之前是什么
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // 目标：最佳绘制状态
-	imgBarrier.image = _swapchainImages[swapchainImageIndex]; // 指定要转换哪张图
-	imgBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;// 颜色图
-	imgBarrier.subresourceRange.baseMipLevel = 0;// 从第 0 层开始
-	imgBarrier.subresourceRange.levelCount = 1;// 仅第 0 层
-	imgBarrier.subresourceRange.baseArrayLayer = 0;// 从第 0 层开始
-	imgBarrier.subresourceRange.layerCount = 1;// 仅一层
-	imgBarrier.srcAccessMask = 0;// 之前不需要等待任何操作
-	imgBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;// 之后要等待写入颜色
-
-	// 这是一个 Pipeline Barrier，用于在 GPU 内部协调流水线阶段
-	vkCmdPipelineBarrier(
-		_mainCommandBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // 来源阶段：一开始
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // 目标阶段：输出颜色时
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &imgBarrier // 也就是上面的那个 barrier
-	);
-
-	// [修正] 1. 添加深度图的布局转换 Barrier (必须在 BeginRendering 之前执行)
-	VkImageMemoryBarrier depthBarrier = {};
-	depthBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	depthBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-	depthBarrier.image = _depthImage._image;
-	depthBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-	depthBarrier.subresourceRange.levelCount = 1;
-	depthBarrier.subresourceRange.layerCount = 1;
-	depthBarrier.srcAccessMask = 0;
-	depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-	vkCmdPipelineBarrier(
-		_mainCommandBuffer,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &depthBarrier
-	);
+	if (!_headless) {
+		VkPresentInfoKHR presentInfo = {};
+		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+		presentInfo.swapchainCount = 1;
+		presentInfo.pSwapchains = &_swapchain;
+
+		// 等待信号量：_renderSemaphore (等显卡画完)
+		presentInfo.waitSemaphoreCount = 1;
+		presentInfo.pWaitSemaphores = &_renderSemaphore;
+
+		presentInfo.pImageIndices = &swapchainImageIndex;
+
+		vkQueuePresentKHR(_graphicsQueue, &presentInfo);
+	}
+
+	// 首帧已经提交：从 init() 开始算的启动时间
+	if (_frameNumber == 0) {
+		vklog::info() << "Time to first frame: " << _startup.elapsed_ms() << " ms";
+	}
+
+	// 帧数加一
+	_frameNumber++;
+}
+
+void VulkanEngine::build_draws(const FramePacket& packet)// 选 LOD，收集这一帧的绘制
+{
+	// 1. 投影矩阵：相机参数来自帧数据包，宽高比按这一帧实际的渲染分辨率
+    glm::mat4 projection = glm::perspective(glm::radians(packet.fovY), (float)_renderExtent.width / (float)_renderExtent.height, packet.zNear, packet.zFar);
+    
+    // [修正] GLM 的 Y 轴是向上的，Vulkan 的 Y 轴是向下的。
+    // 我们把 Y 轴翻转一下，否则画面是倒的
+    projection[1][1] *= -1;
+    const glm::mat4 viewProj = projection * packet.view;
+
+    // 2. 数据包里的可见物体放进绘制列表，每个物体按投影误差选 LOD
+    // 有 meshlet 的网格交给 MeshletRenderer (按簇剔除)，静态物体交给 StaticDrawCache (命令录一次反复用)，装不下时照常走绘制列表
+    // projScale：距离 1 处 1 个单位的误差投影到屏幕上是多少像素 (按实际渲染高度，动态分辨率降下来时自然选更粗的级别)
+    // 排序键 = pass | 管线 | 材质 | 网格 (具体到 LOD) | 量化深度 (物体中心在相机空间的深度)
+    const float projScale = (float)_renderExtent.height / (2.0f * std::tan(glm::radians(packet.fovY) * 0.5f));
+    _drawList.clear();
+    _meshlets.begin_frame(viewProj, packet.cameraPosition);
+    _staticDraws.begin_frame(viewProj);
+    const float aspect = (float)_renderExtent.width / (float)_renderExtent.height;
+    _shadows.begin_frame(packet.view, packet.fovY, aspect, packet.zNear, packet.zFar, packet.lightDirection);
+
+    // 点光源：变换到相机空间写进光源表，视锥外的直接丢掉；分簇在 GPU 上做
+    _clusteredLights.begin_frame(packet.view, packet.fovY, aspect, packet.zNear, packet.zFar);
+    for (const PacketLight& light : packet.lights) {
+        _clusteredLights.add_light(light.position, light.radius, light.color, light.intensity);
+    }
+
+    // 粒子：这里只写帧参数和这一帧的发射器，粒子本身在渲染图里的几个计算 pass 上模拟
+    _particles.begin_frame(packet.view, viewProj);
+    for (const PacketEmitter& emitter : packet.emitters) {
+        _particles.add_emitter(emitter.position, emitter.radius, emitter.velocity, emitter.spread,
+            emitter.color, emitter.lifetime, emitter.size, emitter.count);
+    }
+
+    // 蒙皮：姿势在工作线程上算好，蒙皮提交到异步计算队列，和下面的绘制收集 / 录制重叠
+    // 图形队列这一帧的提交在顶点输入阶段等它，forward 和阴影读的是同一份蒙皮结果
+    _skinning.begin_frame();
+    _skinnedOffsets.assign(packet.draws.size(), INVALID_SLOT);
+    for (const PacketAnimation& animation : packet.animations) {
+        if (animation.draw >= packet.draws.size()) {
+            continue;
+        }
+        const PacketDraw& draw = packet.draws[animation.draw];
+        if (!(draw.flags & DRAW_SKINNED) || draw.mesh >= _meshAssets.size() || _meshAssets[draw.mesh].skin == INVALID_SLOT) {
+            continue;
+        }
+        _skinnedOffsets[animation.draw] = _skinning.add_instance(_meshAssets[draw.mesh].skin, animation.clips[0], animation.times[0],
+            animation.clips[1], animation.times[1], animation.blend);
+    }
+    _skinning.end_frame();
+
+    for (size_t drawIndex = 0; drawIndex < packet.draws.size(); drawIndex++) {
+        const PacketDraw& draw = packet.draws[drawIndex];
+        if (draw.mesh >= _meshAssets.size()) {
+            continue;
+        }
+        const MeshAsset& asset = _meshAssets[draw.mesh];
+
+        // 到包围球表面的距离，最大轴缩放同时放大误差和半径
+        const float scale = std::sqrt(std::max({ glm::dot(glm::vec3(draw.model[0]), glm::vec3(draw.model[0])),
+            glm::dot(glm::vec3(draw.model[1]), glm::vec3(draw.model[1])), glm::dot(glm::vec3(draw.model[2]), glm::vec3(draw.model[2])) }));
+        const glm::vec3 center = glm::vec3(draw.model * glm::vec4(asset.center, 1.0f));
+        const float distance = std::max(glm::length(center - packet.cameraPosition) - asset.radius * scale, packet.zNear);
+
+        // 还在流式加载的贴图按最近的使用者排队
+        if (draw.material < MAX_MATERIALS && _materialTextures[draw.material] != INVALID_SLOT) {
+            _textures.touch(_materialTextures[draw.material], distance);
+        }
+
+        if (draw.object >= _objectLods.size()) {
+            _objectLods.resize((size_t)draw.object + 1, UINT8_MAX);
+        }
+        const uint32_t previous = _objectLods[draw.object] == UINT8_MAX ? UINT32_MAX : _objectLods[draw.object];
+        const uint32_t lod = vklod::select_lod({ asset.lodErrors, asset.lodCount }, scale, distance, projScale,
+            _lodThresholdPx, _lodHysteresis, previous);
+        _objectLods[draw.object] = (uint8_t)lod;
+
+        const uint32_t mesh = asset.firstDrawMesh + lod;
+        const float viewDepth = -(packet.view * draw.model[3]).z;
+        const float depth01 = (viewDepth - packet.zNear) / (packet.zFar - packet.zNear);
+
+        // 这一帧蒙皮了的物体：画输出 buffer 里自己那一段 (没蒙皮的照常按绑定姿势当普通网格画)
+        if (_skinnedOffsets[drawIndex] != INVALID_SLOT) {
+            DrawMesh skinned = _meshes[asset.skinnedDrawMesh];
+            skinned.firstVertex += _skinnedOffsets[drawIndex];
+            _shadows.add_caster(skinned, draw.model, center, asset.radius * scale);
+            _drawList.add(drawkey::opaque(0, draw.pipeline, draw.material, asset.skinnedDrawMesh, drawkey::quantize_depth(depth01)),
+                draw.pipeline, asset.skinnedDrawMesh, draw.material, viewProj * draw.model, draw.data, _skinnedOffsets[drawIndex]);
+            continue;
+        }
+
+        if (asset.meshletMesh != INVALID_SLOT && _meshlets.add_draw(asset.meshletMesh, asset.firstMeshlet[lod], asset.meshletCount[lod],
+                draw.model, draw.data, draw.material)) {
+            _shadows.add_caster(_meshes[mesh], draw.model, center, asset.radius * scale);
+            continue;
+        }
+
+        // 进了静态缓存的物体由阴影的静态层画，其余的都是动态投影物体
+        if ((draw.flags & DRAW_STATIC) && _staticDraws.add(draw.object, draw.pipeline, _meshes[mesh], draw.material, draw.model, draw.data)) {
+            continue;
+        }
+        _shadows.add_caster(_meshes[mesh], draw.model, center, asset.radius * scale);
+
+        _drawList.add(drawkey::opaque(0, draw.pipeline, draw.material, mesh, drawkey::quantize_depth(depth01)),
+            draw.pipeline, mesh, draw.material, viewProj * draw.model, draw.data);
+    }
+
+    // 静态物体的集合 / 绑定 / 分辨率有变化时在这里重新录制，否则只是改写了几项实例和间接命令
+    _staticDraws.end_frame(_renderExtent);
 
+    // 阴影：静态物体的版本决定静态缓存要不要重画，级联矩阵定下来之后交给静态缓存的额外视角
+    _shadows.end_frame(_staticDraws.version());
+    for (uint32_t i = 0; i < MAX_SHADOW_CASCADES; i++) {
+        _staticDraws.set_view(1 + i, _shadows.view_proj(i));
+    }
+
+    GPUSceneData scene = {};
+    scene.invViewProj = glm::inverse(viewProj);
+    scene.lightDirection = glm::vec4(glm::normalize(packet.lightDirection), _shadowAmbient);
+    scene.renderExtent = glm::vec2((float)_renderExtent.width, (float)_renderExtent.height);
+    _shadows.fill_scene(scene);
+    _clusteredLights.fill_scene(scene);
+    *_sceneData = scene;
+
+    // 3. 排序：pass | 管线 | 材质 | 网格 (具体到 LOD) | 量化深度
+    _drawList.sort();
+}
+
+void VulkanEngine::draw_forward(VkCommandBuffer cmd)
+{
 	// 准备深度附件的信息
 	VkRenderingAttachmentInfo depthAttachment = {};
     depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
-    depthAttachment.imageView = _depthImage._imageView;
-    depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; // 最佳深度写入状态
+    depthAttachment.imageView = _renderGraph.image_view(_rgDepth);
+    depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; // 渲染图已经转换到这个布局
     depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR; // 每一帧开始时清空深度
     depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     depthAttachment.clearValue.depthStencil = { 1.0f, 0 }; // 清空值为 1.0 (最远)
 
 	// --- [动态渲染] 开始画画 (Dynamic Rendering) ---
 	
-	// 计算一个闪烁的颜色 (根据帧数 frameNumber)
-	float flash = std::abs(std::sin(_frameNumber / 120.f));
-	VkClearValue clearValue = { { 0.0f, 0.0f, flash, 1.0f } }; // 蓝色通道闪烁
+	// 清屏颜色由模拟线程决定 (蓝色通道闪烁)
+	const glm::vec4& clear = _currentPacket->clearColor;
+	VkClearValue clearValue = { { clear.r, clear.g, clear.b, clear.a } };
 	VkRenderingAttachmentInfo colorAttachment = {};
 	colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
-	colorAttachment.imageView = _swapchainImageViews[swapchainImageIndex];
-	colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // 必须匹配上面的转换
+	colorAttachment.imageView = _renderGraph.image_view(_rgDraw);
+	colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL; // 渲染图已经转换到这个布局
 	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR; // 加载时：清屏
 	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // 结束后：保存结果
 	colorAttachment.clearValue = clearValue;
 
 	VkRenderingInfo renderInfo = {};
 	renderInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
-	renderInfo.renderArea = { 0, 0, _windowExtent.width, _windowExtent.height };
+	renderInfo.renderArea = { 0, 0, _renderExtent.width, _renderExtent.height }; // 只画 draw image 左上角的一部分
 	renderInfo.layerCount = 1;
 	renderInfo.colorAttachmentCount = 1;
 	renderInfo.pColorAttachments = &colorAttachment;// 指定颜色附件
 	renderInfo.pDepthAttachment = &depthAttachment;// 指定深度附件
 
+	// 静态物体：动态渲染里内联命令和二级命令缓冲区不能混用
+	// 先开一个只执行缓存命令的渲染 (负责清屏)，其余的绘制在第二个渲染里接着画 (LOAD)
+	if (!_staticDraws.empty()) {
+		renderInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+		vkCmdBeginRendering(cmd, &renderInfo);
+		_staticDraws.execute(cmd);
+		vkCmdEndRendering(cmd);
+
+		// 两个渲染之间附件的写 -> 读写 (光栅化顺序只在一个渲染之内保证)
+		VkMemoryBarrier2 barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+		barrier.srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+		barrier.dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+			VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		VkDependencyInfo dependency = {};
+		dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		dependency.memoryBarrierCount = 1;
+		dependency.pMemoryBarriers = &barrier;
+		vkCmdPipelineBarrier2(cmd, &dependency);
+
+		renderInfo.flags = 0;
+		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	}
+
 	// 开始动态渲染 (Vulkan 1.3 核心功能)
-	vkCmdBeginRendering(_mainCommandBuffer, &renderInfo);
+	vkCmdBeginRendering(cmd, &renderInfo);
 // 现在我们可以像以前那样记录绘图命令了！
 // =============================================================
 	
-	// 1. 绑定管线
-    vkCmdBindPipeline(_mainCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _trianglePipeline);// 绑定三角形管线
+	// 0. 绑定 bindless 全局 set (一帧只绑定一次，所有管线的 layout 对 set 0 兼容)
+	_bindless.bind(cmd, _trianglePipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
 
-    // 2. 设置动态视口 (Dynamic Viewport)
+    // 1. 设置动态视口 (Dynamic Viewport)
     VkViewport viewport = {};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
-    viewport.width = (float)_windowExtent.width;
-    viewport.height = (float)_windowExtent.height;
+    viewport.width = (float)_renderExtent.width;
+    viewport.height = (float)_renderExtent.height;
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(_mainCommandBuffer, 0, 1, &viewport);
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
 
-    // 3. 设置动态剪裁 (Dynamic Scissor)
+    // 2. 设置动态剪裁 (Dynamic Scissor)
     VkRect2D scissor = {};
     scissor.offset = { 0, 0 };
-    scissor.extent = _windowExtent;
-    vkCmdSetScissor(_mainCommandBuffer, 0, 1, &scissor);
-
-	// [新增] 2. 绑定顶点缓冲区 (Bind Vertex Buffer)
-    VkDeviceSize offset = 0;
-    // 绑定到 0 号槽位，使用 _vertexBuffer._buffer
-    vkCmdBindVertexBuffers(_mainCommandBuffer, 0, 1, &_vertexBuffer._buffer, &offset);
-
-	// 1. 创建一个简单的摄像机位置
-    glm::vec3 camPos = { 0.f, 0.f, -10.f }; // 往后拉一点，这样能看到原点
-    glm::mat4 view = glm::translate(glm::mat4(1.f), camPos);
-    
-    // 2. 创建透视投影矩阵 (Perspective Projection)
-    // fov=70度, 宽高比=窗口宽高比, 近平面=0.1, 远平面=200
-    glm::mat4 projection = glm::perspective(glm::radians(70.f), (float)_windowExtent.width / (float)_windowExtent.height, 0.1f, 200.0f);
-    
-    // [修正] GLM 的 Y 轴是向上的，Vulkan 的 Y 轴是向下的。
-    // 我们把 Y 轴翻转一下，否则画面是倒的
-    projection[1][1] *= -1;
-
-    // 3. 计算模型矩阵 (Model Matrix) - 让它自转
-    glm::mat4 model = glm::rotate(glm::mat4(1.f), glm::radians(_frameNumber * 0.4f), glm::vec3(0, 1, 0));
-
-    // 4. 最终矩阵 = 投影 * 视图 * 模型
-    glm::mat4 meshMatrix = projection * view * model;
-
-    // 5. 定义 PushConstant 数据
-    MeshPushConstants constants;
-	constants.data = glm::vec4(1.0f, 0.5f, 0.25f, 1.0f); // RGBA 颜色
-    constants.render_matrix = meshMatrix;
-
-    // 6. 发送 Push Constants!
-    vkCmdPushConstants(_mainCommandBuffer, _trianglePipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(MeshPushConstants), &constants);
+    scissor.extent = _renderExtent;
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
 
     // =============================================================
-    // 4. 绘制！
-	//vkCmdDraw(_mainCommandBuffer, 3, 1, 0, 0);
-	// 绘制立方体，共 36 个顶点 (6 个面 * 2 个三角形 * 3 个顶点)
-    vkCmdDraw(_mainCommandBuffer, 36, 1, 0, 0);
-	
-	vkCmdEndRendering(_mainCommandBuffer);// 结束动态渲染
+    // 3. 绘制！(列表在 build_draws 里排好序) 管线 / 顶点缓冲区只在变化时绑定，push constant 每个绘制一次
+    _drawList.record(cmd, _trianglePipelineLayout, _layoutCache.push_constant_stages(), _pipelines, _meshes);
 
-	// --- [关键步骤] 图片布局转换 (变回去) ---
-	// 画完了，现在要把图片变成 "Present Src" (最佳呈现状态)，以便显示器读取
+    // 4. meshlet 网格：回退路径画剔除着色器写好的间接命令，mesh shader 路径每个绘制一次 task 分发
+    _meshlets.draw(cmd);
 	
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-	imgBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	imgBarrier.dstAccessMask = 0;
-
-	vkCmdPipelineBarrier(
-		_mainCommandBuffer,
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-		0,
-		0, nullptr,
-		0, nullptr,
-		1, &imgBarrier
-	);
-
-	// 结束记录
-	vkEndCommandBuffer(_mainCommandBuffer);
-
-	// =================================================================
-	// 4. 提交给 GPU (Execute)
-	// =================================================================
+	vkCmdEndRendering(cmd);// 结束动态渲染
+}
 
-	VkSubmitInfo submit = {};
-	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+void VulkanEngine::draw_particles(VkCommandBuffer cmd)// 把粒子叠加到 draw image 上
+{
+	if (!_particles.enabled()) {
+		return;
+	}
 
-	// 等待信号量：_presentSemaphore (等交换链把图给我们)
-	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	submit.pWaitDstStageMask = &waitStage;
-	submit.waitSemaphoreCount = 1;
-	submit.pWaitSemaphores = &_presentSemaphore;
+	// 接着 forward 的结果画：颜色 LOAD，深度只读 (只测试，不写入)
+	VkRenderingAttachmentInfo colorAttachment = {};
+	colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	colorAttachment.imageView = _renderGraph.image_view(_rgDraw);
+	colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 
-	// 提交命令缓冲区
-	submit.commandBufferCount = 1;
-	submit.pCommandBuffers = &_mainCommandBuffer;
+	VkRenderingAttachmentInfo depthAttachment = {};
+	depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	depthAttachment.imageView = _renderGraph.image_view(_rgDepth);
+	depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_NONE;
 
-	// 完成信号量：_renderSemaphore (画完了通知交换链)
-	submit.signalSemaphoreCount = 1;
-	submit.pSignalSemaphores = &_renderSemaphore;
+	VkRenderingInfo renderInfo = {};
+	renderInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	renderInfo.renderArea = { 0, 0, _renderExtent.width, _renderExtent.height };
+	renderInfo.layerCount = 1;
+	renderInfo.colorAttachmentCount = 1;
+	renderInfo.pColorAttachments = &colorAttachment;
+	renderInfo.pDepthAttachment = &depthAttachment;
+	vkCmdBeginRendering(cmd, &renderInfo);
 
-	// 提交！并把 _renderFence 传进去，这样 CPU 就能知道这帧什么时候算完
-	if (vkQueueSubmit(_graphicsQueue, 1, &submit, _renderFence) != VK_SUCCESS) {
-		std::cout << "[ERROR] Failed to submit draw command buffer!" << std::endl;
-	}
+	VkViewport viewport = { 0.0f, 0.0f, (float)_renderExtent.width, (float)_renderExtent.height, 0.0f, 1.0f };
+	vkCmdSetViewport(cmd, 0, 1, &viewport);
+	VkRect2D scissor = { { 0, 0 }, _renderExtent };
+	vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-	// =================================================================
-	// 5. 呈现 (Present)
-	// =================================================================
-	
-	VkPresentInfoKHR presentInfo = {};
-	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-	presentInfo.swapchainCount = 1;
-	presentInfo.pSwapchains = &_swapchain;
-	
-	// 等待信号量：_renderSemaphore (等显卡画完)
-	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pWaitSemaphores = &_renderSemaphore;
-	
-	presentInfo.pImageIndices = &swapchainImageIndex;
+	_particles.draw(cmd);
 
-	vkQueuePresentKHR(_graphicsQueue, &presentInfo);
+	vkCmdEndRendering(cmd);
+}
 
-	// 帧数加一
-	_frameNumber++;
+void VulkanEngine::draw_upscale(VkCommandBuffer cmd)// 把 draw image 缩放到交换链
+{
+	// 只取 draw image 里这一帧实际画了的部分，线性过滤拉伸到整个交换链图片
+	VkImageBlit region = {};
+	region.srcOffsets[1] = { (int32_t)_renderExtent.width, (int32_t)_renderExtent.height, 1 };
+	region.dstOffsets[1] = { (int32_t)_windowExtent.width, (int32_t)_windowExtent.height, 1 };
+	region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.srcSubresource.mipLevel = 0;
+	region.srcSubresource.baseArrayLayer = 0;
+	region.srcSubresource.layerCount = 1;
+	region.dstSubresource = region.srcSubresource;
+
+	vkCmdBlitImage(cmd,
+		_renderGraph.image(_rgDraw), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		_renderGraph.image(_rgSwapchain), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		1, &region, VK_FILTER_LINEAR);
 }
 
 void VulkanEngine::run()
@@ -651,6 +1082,10 @@ void VulkanEngine::run()
 	SDL_Event e;
 	bool bQuit = false;
 
+	// 渲染线程：从队列里取帧数据包，录制 + 提交；主线程只处理事件和模拟
+	// 第 N 帧在渲染线程录制的同时，主线程已经在模拟第 N+1 帧
+	_renderThread = std::thread([this]() { render_loop(); });
+
 	// 无限循环 (Game Loop)
 	while (!bQuit)
 	{
@@ -668,93 +1103,450 @@ void VulkanEngine::run()
 					bQuit = true;
 				}
 			}
+
+			// 左键拾取
+			if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT) {
+				pick(e.button.x, e.button.y);
+			}
 		}
 
-		// 只有在没最小化时才绘制
-		draw();
+		// 模拟这一帧，直接写进队列里的空槽位 (队列满时在这里等渲染线程，反压)
+		FramePacket* packet = _packets.begin_push();
+		simulate(*packet);
+		packet->quit = bQuit;
+		_packets.end_push();
 	}
+
+	// 最后一个包带着 quit，渲染线程画完它就退出
+	_renderThread.join();
 }
 
-bool VulkanEngine::load_shader_module(const char* filePath, VkShaderModule* outShaderModule)
+void VulkanEngine::simulate(FramePacket& packet)
 {
-	// 1. 以二进制模式打开文件，并将指针移到文件末尾 (ate)
-	std::ifstream file(filePath, std::ios::ate | std::ios::binary);
+	packet.simFrame = _simFrame;
+	packet.draws.clear(); // 槽位复用，vector 容量保留
+	packet.lights.clear();
+	packet.animations.clear();
+	packet.emitters.clear();
+
+	// 1. 相机：往后拉一点，这样能看到原点
+	packet.cameraPosition = { 0.f, 0.f, 10.f };
+	packet.view = glm::translate(glm::mat4(1.f), -packet.cameraPosition);
+	packet.fovY = 70.f;
+	packet.zNear = 0.1f;
+	packet.zFar = 200.0f;
+
+	// 太阳光：斜着照下来，方向固定
+	packet.lightDirection = glm::normalize(glm::vec3(-0.4f, -1.0f, -0.3f));
+
+	// 2. 计算一个闪烁的颜色 (根据模拟帧数)
+	float flash = std::abs(std::sin(_simFrame / 120.f));
+	packet.clearColor = { 0.0f, 0.0f, flash, 1.0f };
+
+	// 3. 场景：一个自转的立方体
+	PacketDraw cube = {};
+	cube.pipeline = PIPELINE_TRIANGLE;
+	cube.mesh = MESH_CUBE;
+	cube.material = _defaultMaterial;
+	cube.object = 0;
+	cube.model = glm::rotate(glm::mat4(1.f), glm::radians(_simFrame * 0.4f), glm::vec3(0, 1, 0));
+	cube.data = glm::vec4(1.0f, 0.5f, 0.25f, 1.0f); // RGBA 颜色
+	packet.draws.push_back(cube);
+
+	// 4. 地面：一片不动的方块，标记为静态 (渲染线程录一次命令，之后每帧直接执行)
+	constexpr int GROUND_TILES = 16;
+	for (int z = 0; z < GROUND_TILES; z++) {
+		for (int x = 0; x < GROUND_TILES; x++) {
+			PacketDraw tile = {};
+			tile.pipeline = PIPELINE_TRIANGLE;
+			tile.mesh = MESH_CUBE;
+			tile.material = _defaultMaterial;
+			tile.object = 1 + (uint32_t)(z * GROUND_TILES + x);
+			tile.flags = DRAW_STATIC;
+			const glm::vec3 position((x - GROUND_TILES / 2) * 2.0f + 1.0f, -3.0f, 8.0f - z * 2.0f);
+			tile.model = glm::scale(glm::translate(glm::mat4(1.f), position), glm::vec3(0.9f, 0.1f, 0.9f));
+			tile.data = glm::vec4(0.6f, 0.6f, 0.6f, 1.0f);
+			packet.draws.push_back(tile);
+		}
+	}
 
-	if (!file.is_open()) {
-		return false;
+	// 5. 点光源：一大群彩色小灯在地面上方绕着地面中心转 (分簇之后光源多了每个像素的代价几乎不变)
+	constexpr int LIGHT_COUNT = 1024;
+	const glm::vec3 groundCenter(0.0f, -2.4f, -7.0f);
+	for (int i = 0; i < LIGHT_COUNT; i++) {
+		// 黄金角螺旋铺满半径 14 的圆盘，内外圈反向转
+		const float ring = 14.0f * std::sqrt((i + 0.5f) / LIGHT_COUNT);
+		const float direction = (i & 1) ? 1.0f : -1.0f;
+		const float angle = i * 2.39996f + direction * _simFrame * 0.01f;
+		const float hue = (float)i / LIGHT_COUNT;
+		PacketLight light = {};
+		light.position = groundCenter + glm::vec3(std::cos(angle) * ring, 0.3f * std::sin(_simFrame * 0.05f + i), std::sin(angle) * ring);
+		light.radius = 2.5f;
+		light.color = glm::vec3(0.5f) + 0.5f * glm::cos(6.28318f * (glm::vec3(hue) + glm::vec3(0.0f, 0.33f, 0.67f)));
+		light.intensity = 0.15f;
+		packet.lights.push_back(light);
 	}
 
-	// 2. 因为指针在末尾，tellg() 可以告诉我们文件有多大
-	size_t fileSize = (size_t)file.tellg();
+	// 6. 蒙皮的触手：每块地面上一根，相位错开，在摆动和扭动两个片段之间慢慢过渡
+	if (_tentacleMesh != INVALID_SLOT) {
+		const float time = _simFrame / 60.0f;
+		for (int z = 0; z < GROUND_TILES; z++) {
+			for (int x = 0; x < GROUND_TILES; x++) {
+				PacketDraw tentacle = {};
+				tentacle.pipeline = PIPELINE_TRIANGLE;
+				tentacle.mesh = _tentacleMesh;
+				tentacle.material = _defaultMaterial;
+				tentacle.object = 1 + GROUND_TILES * GROUND_TILES + (uint32_t)(z * GROUND_TILES + x);
+				tentacle.flags = DRAW_SKINNED;
+				const glm::vec3 position((x - GROUND_TILES / 2) * 2.0f + 1.0f, -2.95f, 8.0f - z * 2.0f);
+				tentacle.model = glm::scale(glm::translate(glm::mat4(1.f), position), glm::vec3(0.5f));
+				tentacle.data = glm::vec4(1.0f);
+
+				PacketAnimation animation = {};
+				animation.draw = (uint32_t)packet.draws.size();
+				animation.clips[0] = _tentacleClips[0];
+				animation.clips[1] = _tentacleClips[1];
+				animation.times[0] = time + x * 0.13f + z * 0.29f;
+				animation.times[1] = time * 1.3f + x * 0.31f;
+				animation.blend = 0.5f + 0.5f * std::sin(time * 0.5f + x * 0.4f + z * 0.2f);
+				packet.draws.push_back(tentacle);
+				packet.animations.push_back(animation);
+			}
+		}
+	}
+
+	// 7. 粒子：地面上四个喷泉，每个每秒 60000 个 (一帧 1000 个)，落回地面时按深度图反弹
+	const glm::vec4 fountainColors[4] = {
+		{ 1.0f, 0.55f, 0.15f, 0.6f }, { 0.3f, 0.6f, 1.0f, 0.6f }, { 0.4f, 1.0f, 0.4f, 0.6f }, { 1.0f, 0.3f, 0.8f, 0.6f },
+	};
+	for (int i = 0; i < 4; i++) {
+		PacketEmitter fountain = {};
+		fountain.position = glm::vec3((i & 1) ? 6.0f : -6.0f, -2.8f, (i & 2) ? -12.0f : -4.0f);
+		fountain.radius = 0.1f;
+		// 喷口绕着竖直方向慢慢摆动
+		const float sway = _simFrame * 0.02f + i * 1.57f;
+		fountain.velocity = glm::vec3(std::cos(sway) * 1.5f, 9.0f, std::sin(sway) * 1.5f);
+		fountain.spread = 2.0f;
+		fountain.color = fountainColors[i];
+		fountain.lifetime = 4.0f;
+		fountain.size = 0.04f;
+		fountain.count = 1000;
+		packet.emitters.push_back(fountain);
+	}
 
-	// 3. 分配缓冲区 (uint32_t 是 SPIR-V 的对齐要求)
-	std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
+	// 8. 场景查询：物体的世界包围盒 (网格包围球经过变换，最大轴缩放放大半径)，没动的物体不算改动
+	for (const PacketDraw& draw : packet.draws) {
+		if (draw.mesh >= _meshAssets.size()) {
+			continue;
+		}
+		const MeshAsset& asset = _meshAssets[draw.mesh];
+		const float scale = std::sqrt(std::max({ glm::dot(glm::vec3(draw.model[0]), glm::vec3(draw.model[0])),
+			glm::dot(glm::vec3(draw.model[1]), glm::vec3(draw.model[1])), glm::dot(glm::vec3(draw.model[2]), glm::vec3(draw.model[2])) }));
+		const glm::vec3 center = glm::vec3(draw.model * glm::vec4(asset.center, 1.0f));
+		const glm::vec3 extent(asset.radius * scale);
+		_sceneBvh.set_bounds(draw.object, { center - extent, center + extent });
+	}
+	_sceneBvh.update();
+	glm::mat4 projection = glm::perspective(glm::radians(packet.fovY), (float)_windowExtent.width / (float)_windowExtent.height, packet.zNear, packet.zFar);
+	projection[1][1] *= -1;
+	_simViewProj = projection * packet.view;
 
-	// 4. 指针移回开头，开始读取
-	file.seekg(0);
-	file.read((char*)buffer.data(), fileSize);
+	_simFrame++;
+}
 
-	file.close();
+void VulkanEngine::pick(int x, int y)
+{
+	// 窗口坐标 -> NDC (投影已经翻转了 Y，窗口的 y 向下正好对上)，近平面 (z = 0) 到远平面 (z = 1) 的射线
+	const glm::mat4 inverse = glm::inverse(_simViewProj);
+	const glm::vec2 ndc((x + 0.5f) / _windowExtent.width * 2.0f - 1.0f, (y + 0.5f) / _windowExtent.height * 2.0f - 1.0f);
+	const glm::vec4 nearPoint = inverse * glm::vec4(ndc, 0.0f, 1.0f);
+	const glm::vec4 farPoint = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+
+	vkbvh::Ray ray;
+	ray.origin = glm::vec3(nearPoint) / nearPoint.w;
+	ray.direction = glm::vec3(farPoint) / farPoint.w - ray.origin;
+	ray.maxDistance = 1.0f; // direction 就是近平面到远平面
+
+	vkbvh::RayHit hit;
+	const auto snapshot = _sceneBvh.snapshot();
+	vkbvh::raycast(*snapshot, { &ray, 1 }, { &hit, 1 });
+	if (hit.object == vkbvh::INVALID_INDEX) {
+		vklog::info() << "Picked nothing";
+		return;
+	}
+	const BvhStats& stats = _sceneBvh.stats();
+	vklog::info() << "Picked object " << hit.object << " at " << hit.distance * glm::length(ray.direction) << " units ("
+		<< stats.objects << " objects, " << stats.nodes << " BVH nodes, quality " << stats.quality << ")";
+}
 
-	// 5. 创建 Vulkan Shader Module
-	VkShaderModuleCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.pNext = nullptr;
+void VulkanEngine::render_loop()
+{
+	// Vulkan 的录制和提交从这里开始全部在渲染线程上
+	for (;;) {
+		const FramePacket* packet = _packets.begin_pop();
+		const bool quit = packet->quit;
+		if (!quit) {
+			_capture.write_frame(*packet); // 没有在抓帧时什么都不做
+			const uint64_t allocationsBefore = vkarena::thread_heap_allocations();
+			draw(*packet);
+			check_frame_allocations(vkarena::thread_heap_allocations() - allocationsBefore);
+		}
+		_packets.end_pop();
+		if (quit) {
+			break;
+		}
+	}
+}
 
-	// codeSize 必须是字节数
-	createInfo.codeSize = buffer.size() * sizeof(uint32_t);
-	// pCode 指向 uint32_t 数组
-	createInfo.pCode = buffer.data();
+bool VulkanEngine::background_work_pending() const
+{
+	return _textures.pending_count() > 0 || _streamer.pending_count() > 0 ||
+		(_hasVirtualTexture && _virtualTexture.pending_count() > 0) || _memory.defragmenting();
+}
 
-	VkShaderModule shaderModule;
-	if (vkCreateShaderModule(_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+bool VulkanEngine::check_frame_allocations(uint64_t allocations)
+{
+	if (background_work_pending()) {
+		_quietFrames = 0;
 		return false;
 	}
-
-	*outShaderModule = shaderModule;
+	if (_quietFrames < ALLOC_WARMUP_FRAMES) {
+		_quietFrames++;
+		return false;
+	}
+	if (allocations > 0) {
+		vklog::warn() << "draw() made " << allocations << " heap allocations in steady state (frame " << _frameNumber << ")";
+	}
+	assert(!_assertNoFrameAllocations || allocations == 0);
 	return true;
 }
 
-void VulkanEngine::init_pipelines()// 初始化管线
+void VulkanEngine::replay()
 {
-  
-  VkShaderModule triangleVertexShader;
-    if (!load_shader_module("shaders/triangle_mesh.vert.spv", &triangleVertexShader)) {
-        std::cout << "[ERROR] Failed to load triangle_mesh.vert.spv" << std::endl;
-    }
-	else {
-		std::cout << "[INFO] Triangle mesh vertex shader successfully loaded" << std::endl;
+	if (!_isInitialized || !_headless) {
+		vklog::error() << "Replay needs a headless engine (set _replayPath before init)";
+		return;
 	}
 
-	 VkShaderModule triangleFragShader;
-    if (!load_shader_module("shaders/colored_triangle.frag.spv", &triangleFragShader)) {
-        std::cout << "[ERROR] Error when building the triangle fragment shader module" << std::endl;
-    }
-    else {
-        std::cout << "[INFO] Triangle vertex shader successfully loaded" << std::endl;
-    }
+	// 1. 读完整个抓帧：资源 chunk 立即执行，抓帧时的下标映射到这次运行的下标；帧解码后留在内存里
+	//    资源都在计时之前创建好 (材质取最后一次写入的值)，计时只包含录制 + 提交 + GPU
+	std::unordered_map<uint32_t, uint32_t> meshMap;
+	std::unordered_map<uint32_t, uint32_t> materialMap;
+	std::unordered_map<uint32_t, uint32_t> textureMap;
+	std::vector<FramePacket> frames;
+	frames.reserve(_replayReader.header().frameCount);
+
+	auto remap = [](const std::unordered_map<uint32_t, uint32_t>& map, uint32_t index, uint32_t fallback) {
+		const auto it = map.find(index);
+		return it != map.end() ? it->second : fallback;
+	};
+
+	vkcap::Chunk chunk;
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::string path;
+	while (_replayReader.next(chunk)) {
+		switch (chunk.type) {
+		case vkcap::ChunkType::Mesh: {
+			uint32_t mesh;
+			if (CaptureReader::read_mesh(chunk, mesh, vertices, indices)) {
+				meshMap[mesh] = upload_mesh(vertices, indices);
+			}
+			break;
+		}
+		case vkcap::ChunkType::Texture: {
+			uint32_t texture;
+			bool srgb;
+			if (CaptureReader::read_texture(chunk, texture, path, srgb)) {
+				textureMap[texture] = _textures.load(path, srgb);
+			}
+			break;
+		}
+		case vkcap::ChunkType::Material: {
+			uint32_t material;
+			GPUMaterial data;
+			if (CaptureReader::read_material(chunk, material, data)) {
+				// 纹理 / 采样器 / 虚拟纹理换成这次运行里的下标
+				data.textureIndex = remap(textureMap, data.textureIndex, INVALID_SLOT);
+				data.samplerIndex = _defaultSamplerIndex;
+				if (data.virtualTexture != INVALID_SLOT) {
+					data.virtualTexture = _hasVirtualTexture ? _virtualTexture.table_index() : INVALID_SLOT;
+				}
+				const auto existing = materialMap.find(material);
+				if (existing != materialMap.end()) {
+					update_material(existing->second, data);
+				}
+				else {
+					materialMap[material] = create_material(data);
+				}
+			}
+			break;
+		}
+		case vkcap::ChunkType::Frame: {
+			FramePacket& packet = frames.emplace_back();
+			if (!CaptureReader::read_frame(chunk, packet)) {
+				frames.pop_back();
+				break;
+			}
+			// 找不到的网格映射成无效下标 (绘制列表会跳过)，找不到的材质用默认材质
+			for (PacketDraw& draw : packet.draws) {
+				draw.mesh = remap(meshMap, draw.mesh, INVALID_SLOT);
+				draw.material = remap(materialMap, draw.material, _defaultMaterial);
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
 
-	// [新增] 1. 配置 Push Constant Range
-    VkPushConstantRange pushConstantRange = {};// 推送常量范围
-    pushConstantRange.offset = 0;
-    pushConstantRange.size = sizeof(MeshPushConstants);
+	if (frames.empty()) {
+		vklog::error() << "Capture has no frames: " << _replayPath;
+		return;
+	}
 
-	// 告诉 Vulkan 这个数据只在 Vertex Shader 里用
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;// 推送常量阶段标志
+	vklog::info() << "Replaying " << _replayPath << ": " << frames.size() << " frames x " << _replayIterations << " iterations ("
+		<< _windowExtent.width << "x" << _windowExtent.height << ", " << _meshAssets.size() << " meshes, " << materialMap.size() << " materials, "
+		<< textureMap.size() << " textures)";
 
-    // 1. 创建 Pipeline Layout (管线布局)
-    //  管线布局里告诉 Vulkan 我们会用到哪些资源 (Descriptor Sets) 和 Push Constants
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo = vkinit::pipeline_layout_create_info();// 管线布局创建信息
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.pNext = nullptr;
-    pipelineLayoutInfo.setLayoutCount = 0;
-    pipelineLayoutInfo.pSetLayouts = nullptr;
-    pipelineLayoutInfo.pushConstantRangeCount = 1;// 我们有 1 个 Push Constant Range
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;// 指向上面定义的 Push Constant Range
+	// 2. 预热：先完整跑一遍 (管线、虚拟纹理页缓存)，再等所有纹理上传完
+	for (const FramePacket& packet : frames) {
+		draw(packet);
+	}
+	for (uint32_t i = 0; i < 1000 && _textures.pending_count() > 0; i++) {
+		draw(frames.back());
+	}
+	if (_textures.pending_count() > 0) {
+		vklog::error() << "Textures still loading after warm-up, timings include uploads";
+	}
 
-    if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_trianglePipelineLayout) != VK_SUCCESS) {
-        std::cout << "[ERROR] Failed to create pipeline layout" << std::endl;
-    }
+	// 3. 计时：帧时间 = 一次 draw() 的墙钟时间 (包含等上一帧 fence，GPU 瓶颈时就是 GPU 时间)
+	//    GPU 时间来自时间戳查询，比 draw() 晚一帧读到
+	using Clock = std::chrono::high_resolution_clock;
+	std::vector<float> frameMs;
+	std::vector<float> gpuMs;
+	frameMs.reserve(frames.size() * _replayIterations);
+	gpuMs.reserve(frames.size() * _replayIterations);
+
+	// 稳定状态下 draw() 不应该在 (渲染线程的) 堆上分配：临时数据走帧 arena，容器都是复用的
+	uint64_t heapAllocations = 0;
+	uint32_t allocatingFrames = 0;
+	uint32_t steadyFrames = 0;
+	for (uint32_t iteration = 0; iteration < _replayIterations; iteration++) {
+		const auto iterationStart = Clock::now();
+		for (const FramePacket& packet : frames) {
+			const auto start = Clock::now();
+			const uint64_t allocationsBefore = vkarena::thread_heap_allocations();
+			draw(packet);
+			const uint64_t allocations = vkarena::thread_heap_allocations() - allocationsBefore;
+			frameMs.push_back(std::chrono::duration<float, std::milli>(Clock::now() - start).count());
+			gpuMs.push_back(_lastGpuMs);
+
+			heapAllocations += allocations;
+			allocatingFrames += allocations > 0 ? 1 : 0;
+			steadyFrames += check_frame_allocations(allocations) ? 1 : 0;
+		}
+		vkWaitForFences(_device, 1, &_renderFence, true, 1000000000);
+		const float iterationMs = std::chrono::duration<float, std::milli>(Clock::now() - iterationStart).count();
+		vklog::info() << "Replay iteration " << iteration << ": " << iterationMs << " ms ("
+			<< frames.size() * 1000.0f / iterationMs << " fps)";
+	}
+
+	// 4. 汇总
+	auto summarize = [](const char* label, std::vector<float>& samples) {
+		std::sort(samples.begin(), samples.end());
+		double sum = 0.0;
+		for (float sample : samples) {
+			sum += sample;
+		}
+		const auto percentile = [&](float p) { return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))]; };
+		vklog::info() << label << " ms: avg " << sum / samples.size() << " | min " << samples.front()
+			<< " | p50 " << percentile(0.5f) << " | p95 " << percentile(0.95f) << " | p99 " << percentile(0.99f)
+			<< " | max " << samples.back();
+	};
+	summarize("Replay frame", frameMs);
+	summarize("Replay GPU", gpuMs);
+
+	const FrameArenaStats arenaStats = _frameArenas.stats();
+	vklog::info() << "Replay heap allocations in draw(): " << heapAllocations << " in " << allocatingFrames << " / "
+		<< frameMs.size() << " frames (" << steadyFrames << " steady-state frames checked); frame arenas " << arenaStats.threads << " threads, "
+		<< arenaStats.peak / 1024 << " KB peak, " << arenaStats.overflows << " overflows";
+
+	const DrawListStats& drawStats = _drawList.stats();
+	vklog::info() << "Replay last frame: " << drawStats.draws << " draws, " << drawStats.pipelineBinds << " pipeline binds, "
+		<< drawStats.bindsSkipped << " binds skipped, " << drawStats.triangles << " triangles";
+	const StreamingStats& streamStats = _streamer.stats();
+	vklog::info() << "Replay streaming: " << streamStats.completed << " files, " << streamStats.bytesRead / 1024 << " KB read, "
+		<< streamStats.failed << " failed, " << streamStats.cancelled << " cancelled";
+	const MeshletStats& meshletStats = _meshlets.stats();
+	vklog::info() << "Replay meshlets: " << meshletStats.draws << " draws, " << meshletStats.visibleMeshlets << " / "
+		<< meshletStats.meshlets << " meshlets visible";
+	const StaticDrawStats& staticStats = _staticDraws.stats();
+	vklog::info() << "Replay static draws: " << staticStats.objects << " objects in " << staticStats.groups << " groups, "
+		<< staticStats.rebuilds << " re-recordings";
+	const LightClusterStats& lightStats = _clusteredLights.stats();
+	vklog::info() << "Replay lights: " << lightStats.lights << " in view, " << lightStats.culled << " culled on the CPU, "
+		<< lightStats.lightIndices << " cluster light indices";
+	const ShadowStats& shadowStats = _shadows.stats();
+	vklog::info() << "Replay shadows: " << shadowStats.totalStaticRedraws << " static cascade redraws in "
+		<< shadowStats.totalStaticPasses << " multiview passes, last frame "
+		<< shadowStats.composites << " composited / " << shadowStats.skipped << " skipped, " << shadowStats.casterDraws << " caster draws";
+	const SkinningStats& skinStats = _skinning.stats();
+	vklog::info() << "Replay skinning: " << skinStats.instances << " instances, " << skinStats.vertices << " vertices, "
+		<< skinStats.joints << " joints (" << skinStats.poseMs << " ms poses), " << skinStats.dropped << " dropped";
+	const ParticleStats& particleStats = _particles.stats();
+	vklog::info() << "Replay particles: " << particleStats.alive << " alive, " << particleStats.emitted << " emitted / "
+		<< particleStats.requested << " requested, " << particleStats.dropped << " dropped, "
+		<< particleStats.simulateMs << " ms GPU simulation";
+}
+
+bool VulkanEngine::load_shader_module(const char* name, VkShaderModule* outShaderModule)
+{
+	// shader 包在 init_pipelines() 里映射，这里只是查表 + 创建模块
+	// SPIR-V 直接从映射内存交给驱动，不再经过 ifstream 和临时 vector
+	const vkspirv::PackEntry* entry = _shaderPack.find(name);
+	if (!entry) {
+		return false;
+	}
+
+	return _shaderPack.create_module(_device, *entry, outShaderModule);
+}
+
+bool VulkanEngine::init_pipelines()// 初始化管线
+{
+	// shader 包已经在启动图的 shader_pack 阶段映射并预读好了
+	VkShaderModule triangleVertexShader;
+	if (!load_shader_module("triangle_mesh.vert", &triangleVertexShader)) {
+		vklog::error() << "Failed to load triangle_mesh.vert";
+		return false;
+	}
+	vklog::info() << "Triangle mesh vertex shader successfully loaded";
+
+	VkShaderModule triangleFragShader;
+	if (!load_shader_module("colored_triangle.frag", &triangleFragShader)) {
+		vklog::error() << "Error when building the triangle fragment shader module";
+		vkDestroyShaderModule(_device, triangleVertexShader, nullptr);
+		return false;
+	}
+	vklog::info() << "Triangle fragment shader successfully loaded";
+
+	// 1. 创建 Pipeline Layout (管线布局)
+	// descriptor set layout 和 push constant 范围都来自包里的反射信息，和 shader 永远一致
+	const vkspirv::PackEntry* triangleStages[] = {
+		_shaderPack.find("triangle_mesh.vert"),
+		_shaderPack.find("colored_triangle.frag"),
+	};
+	ReflectedLayout triangleLayout = _layoutCache.get_pipeline_layout(_shaderPack, triangleStages);
+	_trianglePipelineLayout = triangleLayout.layout;
+
+	// C++ 端的 MeshPushConstants 必须和 shader 里的 push_constant 块一样大
+	if (triangleLayout.pushConstantSize != sizeof(MeshPushConstants)) {
+		vklog::error() << "MeshPushConstants size mismatch: shader expects " << triangleLayout.pushConstantSize
+			<< " bytes, C++ has " << sizeof(MeshPushConstants);
+		vkDestroyShaderModule(_device, triangleFragShader, nullptr);
+		vkDestroyShaderModule(_device, triangleVertexShader, nullptr);
+		return false;
+	}
 
     // 2. 开始构建 Pipeline
     PipelineBuilder pipelineBuilder;
@@ -768,7 +1560,7 @@ void VulkanEngine::init_pipelines()// 初始化管线
     // -- B. Vertex Input (空) --
     // 我们目前把顶点硬编码在 Shader 里，所以这里不需要绑定任何 Buffer
 	VkVertexInputBindingDescription bindingDescription = Vertex::get_binding_description();
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions = Vertex::get_attribute_descriptions();
+    const std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions = Vertex::get_attribute_descriptions();
 
     // 连接到 Pipeline Builder
     pipelineBuilder._vertexInputInfo = vkinit::pipeline_vertex_input_state_create_info();
@@ -801,25 +1593,503 @@ void VulkanEngine::init_pipelines()// 初始化管线
     pipelineBuilder._renderInfo = {};
     pipelineBuilder._renderInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;// 动态渲染创建信息
     pipelineBuilder._renderInfo.colorAttachmentCount = 1;// 一个颜色附件
-    pipelineBuilder._renderInfo.pColorAttachmentFormats = &_swapchainImageFormat;// 颜色图格式
-    pipelineBuilder._renderInfo.depthAttachmentFormat = _depthImage._imageFormat; // 深度图格式
+    pipelineBuilder._renderInfo.pColorAttachmentFormats = &_drawFormat;// 颜色图格式 (离屏 draw image)
+    pipelineBuilder._renderInfo.depthAttachmentFormat = _depthFormat; // 深度图格式
 
     // -- I. 赋予 Layout --
     pipelineBuilder._pipelineLayout = _trianglePipelineLayout;
 
     // 3. 最终构建
     _trianglePipeline = pipelineBuilder.build_pipeline(_device);
+    if (_trianglePipeline == VK_NULL_HANDLE) {
+        vkDestroyShaderModule(_device, triangleFragShader, nullptr);
+        vkDestroyShaderModule(_device, triangleVertexShader, nullptr);
+        return false;
+    }
+
+    // 管线表：绘制列表按下标引用管线
+    _pipelines.resize(PIPELINE_TRIANGLE + 1);
+    _pipelines[PIPELINE_TRIANGLE] = _trianglePipeline;
+
+    // meshlet / 静态物体的管线沿用同一套状态 (顶点输入描述是上面的局部变量，必须在这个函数里构建)
+    init_meshlet_pipelines(pipelineBuilder);
+    init_static_pipelines(pipelineBuilder);
+    init_shadow_pipelines(pipelineBuilder);
+    init_light_pipelines();
+    init_skinning_pipelines();
+    init_particle_pipelines(pipelineBuilder);
     
     // 4. 清理 Shader Module
     // 管线创建好后，Shader Module 就可以丢掉了，因为代码已经被拷贝到管线里了
     vkDestroyShaderModule(_device, triangleFragShader, nullptr);
     vkDestroyShaderModule(_device, triangleVertexShader, nullptr);
 
-    std::cout << "[INFO] Triangle Pipeline Created Successfully!" << std::endl;
+    vklog::info() << "Triangle Pipeline Created Successfully!";
+    return true;
+}
+
+void VulkanEngine::init_meshlet_pipelines(const PipelineBuilder& base)// meshlet 剔除 + 绘制管线
+{
+	// 回退路径：计算着色器剔除 + meshlet.vert；mesh shader 路径：task + mesh，片段着色器和普通网格共用
+	const char* cullName = "meshlet_cull.comp";
+	const char* drawNames[] = { "meshlet.vert", "colored_triangle.frag" };
+	const char* meshNames[] = { "meshlet.task", "meshlet.mesh", "colored_triangle.frag" };
+	const std::span<const char*> names = _meshlets.uses_mesh_shaders() ? std::span<const char*>(meshNames) : std::span<const char*>(drawNames);
+
+	std::vector<const vkspirv::PackEntry*> entries;
+	PipelineBuilder builder = base;
+	builder._shaderStages.clear();
+	bool ok = true;
+	for (const char* name : names) {
+		const vkspirv::PackEntry* entry = _shaderPack.find(name);
+		VkShaderModule module;
+		if (!entry || !load_shader_module(name, &module)) {
+			vklog::error() << "Failed to load " << name;
+			ok = false;
+			continue;
+		}
+		entries.push_back(entry);
+		builder._shaderStages.push_back(vkinit::pipeline_shader_stage_create_info((VkShaderStageFlagBits)entry->stage, module));
+	}
+
+	if (ok) {
+		ReflectedLayout layout = _layoutCache.get_pipeline_layout(_shaderPack, entries);
+		builder._pipelineLayout = layout.layout;
+		// 网格是逆时针朝外，投影翻转了 Y，所以屏幕上是顺时针；meshlet 已经按法线锥剔除过，剩下的背面交给光栅化
+		builder._rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+		builder._rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+		_meshletPipeline = builder.build_pipeline(_device);
+
+		if (!_meshlets.uses_mesh_shaders()) {
+			VkShaderModule cullShader;
+			if (load_shader_module(cullName, &cullShader)) {
+				ComputePipelineBuilder computeBuilder;
+				computeBuilder._shaderStage = vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_COMPUTE_BIT, cullShader);
+				computeBuilder._pipelineLayout = layout.layout;
+				_meshletCullPipeline = computeBuilder.build_pipeline(_device);
+				vkDestroyShaderModule(_device, cullShader, nullptr);
+			}
+			else {
+				vklog::error() << "Failed to load " << cullName;
+			}
+		}
+		_meshlets.set_pipelines(layout.layout, _layoutCache.push_constant_stages(), _meshletCullPipeline, _meshletPipeline);
+	}
+
+	for (const VkPipelineShaderStageCreateInfo& stage : builder._shaderStages) {
+		vkDestroyShaderModule(_device, stage.module, nullptr);
+	}
+
+	vklog::info() << "Meshlet pipelines: " << (_meshlets.uses_mesh_shaders() ? "mesh shaders" : "compute cull + indirect draw")
+		<< (_meshletPipeline != VK_NULL_HANDLE ? "" : " (FAILED)");
+}
+
+void VulkanEngine::init_static_pipelines(const PipelineBuilder& base)// 静态物体的缓存绘制管线
+{
+	// 和 _pipelines 的状态完全一样，只是变换从实例表里取 (录好的命令缓冲区里没有每个物体的 push constant)
+	const char* names[] = { "static_mesh.vert", "colored_triangle.frag" };
+
+	std::vector<const vkspirv::PackEntry*> entries;
+	PipelineBuilder builder = base;
+	builder._shaderStages.clear();
+	bool ok = true;
+	for (const char* name : names) {
+		const vkspirv::PackEntry* entry = _shaderPack.find(name);
+		VkShaderModule module;
+		if (!entry || !load_shader_module(name, &module)) {
+			vklog::error() << "Failed to load " << name;
+			ok = false;
+			continue;
+		}
+		entries.push_back(entry);
+		builder._shaderStages.push_back(vkinit::pipeline_shader_stage_create_info((VkShaderStageFlagBits)entry->stage, module));
+	}
+
+	if (ok) {
+		ReflectedLayout layout = _layoutCache.get_pipeline_layout(_shaderPack, entries);
+		builder._pipelineLayout = layout.layout;
+		_staticPipelines.assign(_pipelines.size(), VK_NULL_HANDLE);
+		_staticPipelines[PIPELINE_TRIANGLE] = builder.build_pipeline(_device);
+		_staticDraws.set_pipelines(layout.layout, _layoutCache.push_constant_stages(), _staticPipelines, _drawFormat, _depthFormat);
+	}
+
+	for (const VkPipelineShaderStageCreateInfo& stage : builder._shaderStages) {
+		vkDestroyShaderModule(_device, stage.module, nullptr);
+	}
+
+	vklog::info() << "Static draw pipelines" << (ok && _staticPipelines[PIPELINE_TRIANGLE] != VK_NULL_HANDLE ? "" : " (FAILED)");
+}
+
+void VulkanEngine::init_shadow_pipelines(const PipelineBuilder& base)// 只有深度的阴影管线
+{
+	// 沿用顶点输入 / 深度测试，去掉片段着色器和颜色附件
+	// 不剔除背面 (薄片和没封口的网格也投影)，用深度偏移压住自阴影的条纹
+	PipelineBuilder builder = base;
+	builder._rasterizer.cullMode = VK_CULL_MODE_NONE;
+	builder._rasterizer.depthBiasEnable = VK_TRUE;
+	builder._rasterizer.depthBiasConstantFactor = 1.25f;
+	builder._rasterizer.depthBiasSlopeFactor = 1.75f;
+	builder._renderInfo.colorAttachmentCount = 0;
+	builder._renderInfo.pColorAttachmentFormats = nullptr;
+	builder._renderInfo.depthAttachmentFormat = ShadowCascades::FORMAT;
+
+	// 静态几何的管线每个 viewMask 一条 (多视角渲染时管线的 viewMask 要和渲染的一致)，只有深度，着色器也只有一个，建起来很便宜
+	auto build = [&](const char* name, std::span<VkPipeline> out, uint32_t firstMask, VkPipelineLayout& layout) {
+		const vkspirv::PackEntry* entry = _shaderPack.find(name);
+		VkShaderModule module;
+		if (!entry || !load_shader_module(name, &module)) {
+			vklog::error() << "Failed to load " << name;
+			return false;
+		}
+		const vkspirv::PackEntry* entries[] = { entry };
+		layout = _layoutCache.get_pipeline_layout(_shaderPack, entries).layout;
+		builder._pipelineLayout = layout;
+		builder._shaderStages.clear();
+		builder._shaderStages.push_back(vkinit::pipeline_shader_stage_create_info((VkShaderStageFlagBits)entry->stage, module));
+		bool built = true;
+		for (uint32_t mask = firstMask; mask < out.size(); mask++) {
+			builder._renderInfo.viewMask = mask;
+			out[mask] = builder.build_pipeline(_device);
+			built = built && out[mask] != VK_NULL_HANDLE;
+		}
+		builder._renderInfo.viewMask = 0;
+		vkDestroyShaderModule(_device, module, nullptr);
+		return built;
+	};
+
+	VkPipelineLayout dynamicLayout = VK_NULL_HANDLE;
+	VkPipelineLayout staticLayout = VK_NULL_HANDLE;
+	const bool ok = build("triangle_mesh.vert", std::span<VkPipeline>(&_shadowPipeline, 1), 0, dynamicLayout) &&
+		build("static_mesh.vert", _shadowStaticPipelines, 1, staticLayout);
+	if (ok) {
+		_shadows.set_pipelines(dynamicLayout, _layoutCache.push_constant_stages(), _shadowPipeline, _shadowStaticPipelines);
+	}
+
+	vklog::info() << "Shadow pipelines" << (ok ? "" : " (FAILED)");
+}
+
+void VulkanEngine::init_light_pipelines()// 光源分簇的计算管线
+{
+	const char* name = "light_cluster.comp";
+	const vkspirv::PackEntry* entry = _shaderPack.find(name);
+	VkShaderModule module;
+	if (!entry || !load_shader_module(name, &module)) {
+		vklog::error() << "Failed to load " << name;
+		return;
+	}
+
+	const vkspirv::PackEntry* entries[] = { entry };
+	ReflectedLayout layout = _layoutCache.get_pipeline_layout(_shaderPack, entries);
+	ComputePipelineBuilder builder;
+	builder._shaderStage = vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_COMPUTE_BIT, module);
+	builder._pipelineLayout = layout.layout;
+	_lightClusterPipeline = builder.build_pipeline(_device);
+	vkDestroyShaderModule(_device, module, nullptr);
+
+	_clusteredLights.set_pipeline(layout.layout, _lightClusterPipeline);
+	vklog::info() << "Light cluster pipeline" << (_lightClusterPipeline != VK_NULL_HANDLE ? "" : " (FAILED)");
+}
+
+void VulkanEngine::init_skinning_pipelines()// 计算蒙皮的管线
+{
+	const char* name = "skinning.comp";
+	const vkspirv::PackEntry* entry = _shaderPack.find(name);
+	VkShaderModule module;
+	if (!entry || !load_shader_module(name, &module)) {
+		vklog::error() << "Failed to load " << name;
+		return;
+	}
+
+	const vkspirv::PackEntry* entries[] = { entry };
+	ReflectedLayout layout = _layoutCache.get_pipeline_layout(_shaderPack, entries);
+	ComputePipelineBuilder builder;
+	builder._shaderStage = vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_COMPUTE_BIT, module);
+	builder._pipelineLayout = layout.layout;
+	_skinningPipeline = builder.build_pipeline(_device);
+	vkDestroyShaderModule(_device, module, nullptr);
+
+	_skinning.set_pipeline(layout.layout, _layoutCache.push_constant_stages(), _skinningPipeline);
+	vklog::info() << "Skinning pipeline" << (_skinningPipeline != VK_NULL_HANDLE ? "" : " (FAILED)");
+}
+
+void VulkanEngine::init_particle_pipelines(const PipelineBuilder& base)// 粒子的计算管线 + 公告板管线
+{
+	// 五个着色器共用一个 layout (set 0 + 同一个 push constant 块)
+	const char* names[] = { "particle.vert", "particle.frag", "particle_emit.comp", "particle_simulate.comp", "particle_args.comp" };
+	VkShaderModule modules[5] = {};
+	std::vector<const vkspirv::PackEntry*> entries;
+	bool ok = true;
+	for (size_t i = 0; i < std::size(names); i++) {
+		const vkspirv::PackEntry* entry = _shaderPack.find(names[i]);
+		if (!entry || !load_shader_module(names[i], &modules[i])) {
+			vklog::error() << "Failed to load " << names[i];
+			modules[i] = VK_NULL_HANDLE;
+			ok = false;
+			continue;
+		}
+		entries.push_back(entry);
+	}
+
+	if (ok) {
+		ReflectedLayout layout = _layoutCache.get_pipeline_layout(_shaderPack, entries);
+
+		// 公告板：没有顶点输入，加法混合 (颜色预先乘了不透明度，alpha 不变)，深度只测不写，正反面都画
+		PipelineBuilder builder = base;
+		builder._shaderStages.clear();
+		builder._shaderStages.push_back(vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_VERTEX_BIT, modules[0]));
+		builder._shaderStages.push_back(vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_FRAGMENT_BIT, modules[1]));
+		builder._vertexInputInfo = vkinit::pipeline_vertex_input_state_create_info();
+		builder._rasterizer.cullMode = VK_CULL_MODE_NONE;
+		builder._colorBlendAttachment.blendEnable = VK_TRUE;
+		builder._colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		builder._colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		builder._colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		builder._colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		builder._colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		builder._colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+		builder._depthStencil = vkinit::pipeline_depth_stencil_state_create_info(true, false, VK_COMPARE_OP_LESS_OR_EQUAL);
+		builder._pipelineLayout = layout.layout;
+		_particlePipeline = builder.build_pipeline(_device);
+
+		VkPipeline* computePipelines[] = { &_particleEmitPipeline, &_particleSimulatePipeline, &_particleArgsPipeline };
+		for (size_t i = 0; i < std::size(computePipelines); i++) {
+			ComputePipelineBuilder computeBuilder;
+			computeBuilder._shaderStage = vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_COMPUTE_BIT, modules[2 + i]);
+			computeBuilder._pipelineLayout = layout.layout;
+			*computePipelines[i] = computeBuilder.build_pipeline(_device);
+		}
+
+		_particles.set_pipelines(layout.layout, _layoutCache.push_constant_stages(),
+			_particleEmitPipeline, _particleSimulatePipeline, _particleArgsPipeline, _particlePipeline);
+	}
+
+	for (VkShaderModule module : modules) {
+		if (module != VK_NULL_HANDLE) {
+			vkDestroyShaderModule(_device, module, nullptr);
+		}
+	}
+
+	vklog::info() << "Particle pipelines" << (_particles.enabled() ? "" : " (FAILED)");
+}
+
+bool VulkanEngine::init_render_graph()// 构建并编译渲染图
+{
+	_renderGraph.init(_device, &_memory);
+
+	// 目标 GPU 帧时间：60Hz 的 16.6ms 留一点余量给 CPU 提交和呈现
+	// 回放要求每次的工作量一样，分辨率固定为 1 (计时器照常用来统计 GPU 时间)
+	if (_gpuTimer.init(_device, _chosenGPU) && !_headless) {
+		_dynamicResolution.init(14.0f);
+	}
+	else {
+		_dynamicResolution.init(14.0f, 1.0f, 1.0f);
+	}
+	_renderExtent = _windowExtent;
+
+	// 交换链图片每帧在 draw() 里更新；acquire 信号量在 TRANSFER 阶段等待 (见 draw())，第一次布局转换从这里开始
+	// headless 的离屏目标最后停在 TRANSFER_SRC，方便回读
+	_rgSwapchain = _renderGraph.import_image("swapchain", VK_NULL_HANDLE, VK_NULL_HANDLE, _swapchainImageFormat, _windowExtent,
+		VK_IMAGE_LAYOUT_UNDEFINED, _headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT);
+	// draw image 和深度图按最大尺寸 (窗口大小) 分配，动态分辨率只用其中一部分
+	_rgDraw = _renderGraph.create_image("draw", { _drawFormat, _windowExtent });
+	_rgDepth = _renderGraph.create_image("depth", { _depthFormat, _windowExtent });
+
+	// 虚拟纹理：处理上一帧的反馈并上传新页 (必须在渲染之前)，内部自己管理页缓存和反馈缓冲区的同步
+	if (_hasVirtualTexture) {
+		_renderGraph.add_pass("virtual_texture_update", [this](VkCommandBuffer cmd) {
+			_virtualTexture.begin_frame(cmd, _frameNumber, _frameArenas.local());
+		}).side_effect();
+	}
+
+	// meshlet 计数 (每帧开头 CPU 清零) 和回退路径的间接命令：剔除 pass 写，forward 当间接参数读
+	_rgMeshletCounts = _renderGraph.import_buffer("meshlet_counts", _meshlets.count_buffer(), _meshlets.count_buffer_size());
+	if (!_meshlets.uses_mesh_shaders()) {
+		_rgMeshletCommands = _renderGraph.import_buffer("meshlet_commands", _meshlets.command_buffer(), _meshlets.command_buffer_size());
+		_renderGraph.add_pass("meshlet_cull", [this](VkCommandBuffer cmd) { _meshlets.cull(cmd); })
+			.write(_rgMeshletCounts, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+			.write(_rgMeshletCommands, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+	}
+
+	// 光源分簇：计算着色器写每个 froxel 的光源列表，forward 的片段着色器读
+	_rgLightClusters = _renderGraph.import_buffer("light_clusters", _clusteredLights.cluster_buffer(), _clusteredLights.cluster_buffer_size());
+	_rgLightIndices = _renderGraph.import_buffer("light_indices", _clusteredLights.index_buffer(), _clusteredLights.index_buffer_size());
+	_renderGraph.add_pass("light_binning", [this](VkCommandBuffer cmd) { _clusteredLights.bin(cmd); })
+		.write(_rgLightClusters, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+		.write(_rgLightIndices, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+
+	// 级联阴影：静态缓存 / 阴影图的布局和同步在 ShadowCascades 内部管理，最后停在 SHADER_READ_ONLY 给 forward 采样
+	_renderGraph.add_pass("shadows", [this](VkCommandBuffer cmd) {
+		_shadows.record(cmd, _staticDraws);
+	}).side_effect();
+
+	auto forward = _renderGraph.add_pass("forward", [this](VkCommandBuffer cmd) { draw_forward(cmd); })
+		.write(_rgDraw, RGUsage::ColorAttachment)
+		.write(_rgDepth, RGUsage::DepthAttachment)
+		.read(_rgLightClusters, RGUsage::StorageRead, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT)
+		.read(_rgLightIndices, RGUsage::StorageRead, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT);
+	if (!_meshlets.uses_mesh_shaders()) {
+		forward.read(_rgMeshletCounts, RGUsage::IndirectBuffer)
+			.read(_rgMeshletCommands, RGUsage::IndirectBuffer);
+	}
+
+	// 粒子：发射 -> 模拟的分发参数 -> 模拟 (采样 forward 刚写的深度图做碰撞) -> 绘制参数，都是计算着色器
+	// 同一个计数 buffer 里的间接参数被下一个 pass 读，pass 之间的 barrier 由渲染图插入
+	// 最后间接绘制叠加到 draw image 上 (深度只读)，计数拷给 CPU 统计
+	_rgParticles = _renderGraph.import_buffer("particles", _particles.particle_buffer(), _particles.particle_buffer_size());
+	_rgParticleLists = _renderGraph.import_buffer("particle_lists", _particles.list_buffer(), _particles.list_buffer_size());
+	_rgParticleCounters = _renderGraph.import_buffer("particle_counters", _particles.counter_buffer(), _particles.counter_buffer_size());
+	_renderGraph.add_pass("particle_emit", [this](VkCommandBuffer cmd) { _particles.emit(cmd); })
+		.write(_rgParticles, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+		.write(_rgParticleLists, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+		.write(_rgParticleCounters, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+	_renderGraph.add_pass("particle_prepare", [this](VkCommandBuffer cmd) { _particles.prepare(cmd); })
+		.write(_rgParticleCounters, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+	_renderGraph.add_pass("particle_simulate", [this](VkCommandBuffer cmd) { _particles.simulate(cmd); })
+		.read(_rgParticleCounters, RGUsage::IndirectBuffer)
+		.write(_rgParticleCounters, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+		.write(_rgParticles, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+		.write(_rgParticleLists, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT)
+		.read(_rgDepth, RGUsage::Sampled, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+	_renderGraph.add_pass("particle_finalize", [this](VkCommandBuffer cmd) { _particles.finalize(cmd); })
+		.write(_rgParticleCounters, RGUsage::StorageWrite, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+	_renderGraph.add_pass("particles", [this](VkCommandBuffer cmd) { draw_particles(cmd); })
+		.read(_rgDraw, RGUsage::ColorAttachment)
+		.write(_rgDraw, RGUsage::ColorAttachment)
+		.read(_rgDepth, RGUsage::DepthRead)
+		.read(_rgParticleCounters, RGUsage::IndirectBuffer)
+		.read(_rgParticles, RGUsage::StorageRead, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT)
+		.read(_rgParticleLists, RGUsage::StorageRead, VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT);
+	_renderGraph.add_pass("particle_readback", [this](VkCommandBuffer cmd) { _particles.readback(cmd); })
+		.read(_rgParticleCounters, RGUsage::TransferSrc)
+		.side_effect();
+
+	_renderGraph.add_pass("upscale", [this](VkCommandBuffer cmd) { draw_upscale(cmd); })
+		.read(_rgDraw, RGUsage::TransferSrc)
+		.write(_rgSwapchain, RGUsage::TransferDst);
+
+	// 把这一帧的虚拟纹理反馈拷贝到回读缓冲区
+	if (_hasVirtualTexture) {
+		_renderGraph.add_pass("virtual_texture_readback", [this](VkCommandBuffer cmd) {
+			_virtualTexture.end_frame(cmd, _frameNumber);
+		}).side_effect();
+	}
+
+	if (!_renderGraph.compile()) {
+		vklog::error() << "Failed to compile render graph!";
+		return false;
+	}
+
+	// 深度图的视图在 compile 里创建 (之后不再重建)，登记进 bindless 给粒子碰撞采样
+	_depthTextureIndex = _bindless.add_texture(_renderGraph.image_view(_rgDepth));
+	_particles.set_depth(_depthTextureIndex, _defaultSamplerIndex);
+	return true;
+}
+
+bool VulkanEngine::init_descriptors()// 初始化 bindless 全局 set
+{
+	// 1. 全局 set：所有管线的 set 0 都是它
+	if (!_bindless.init(_device, _chosenGPU)) {
+		vklog::error() << "Failed to initialize bindless descriptors";
+		return false;
+	}
+
+	_layoutCache.init(_device);
+	_layoutCache.set_global_set(BindlessHeap::SET_INDEX, _bindless.layout(), _bindless.bindings());
+	// 128 字节是 Vulkan 保证的 push constant 下限
+	_layoutCache.set_shared_push_constants(VK_SHADER_STAGE_ALL, 128);
+
+	// 2. 材质表：常驻映射的 storage buffer，shader 按材质下标索引
+	_materialBuffer = create_buffer(MAX_MATERIALS * sizeof(GPUMaterial), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Other);
+	if (_materialBuffer._buffer == VK_NULL_HANDLE) {
+		return false;
+	}
+	vmaMapMemory(_allocator, _materialBuffer._allocation, (void**)&_materialData);
+	_materialSlots.init(MAX_MATERIALS);
+	_bindless.set_material_buffer(_materialBuffer._buffer, MAX_MATERIALS * sizeof(GPUMaterial));
+
+	// 场景数据：每帧在 build_draws 里整块写一次 (FRAMES_IN_FLIGHT = 1，写之前已经等过 fence)
+	_sceneBuffer = create_buffer(sizeof(GPUSceneData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Other);
+	if (_sceneBuffer._buffer == VK_NULL_HANDLE) {
+		return false;
+	}
+	vmaMapMemory(_allocator, _sceneBuffer._allocation, (void**)&_sceneData);
+	*_sceneData = {};
+	_bindless.set_scene_buffer(_sceneBuffer._buffer, sizeof(GPUSceneData));
+
+	// 3. 默认采样器 + 默认材质 (白色、无贴图)
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.pNext = nullptr;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	if (vkCreateSampler(_device, &samplerInfo, nullptr, &_defaultSampler) != VK_SUCCESS) {
+		vklog::error() << "Failed to create default sampler";
+		return false;
+	}
+	_defaultSamplerIndex = _bindless.add_sampler(_defaultSampler);
+
+	GPUMaterial defaultMaterial = {};
+	defaultMaterial.baseColor = glm::vec4(1.f);
+	defaultMaterial.textureIndex = INVALID_SLOT;
+	defaultMaterial.samplerIndex = _defaultSamplerIndex;
+	defaultMaterial.virtualTexture = INVALID_SLOT;
+
+	// 4. 纹理系统：纹理下标直接来自 bindless 表
+	if (!_textures.init(_device, _chosenGPU, &_memory, _graphicsQueue, _graphicsQueueFamily, &_bindless, &_jobs, &_streamer, _supportsBC)) {
+		return false;
+	}
+
+	// 5. 虚拟纹理 (可选：没有 .vtex 资源时跳过)
+	const char* virtualTexturePath = "assets/terrain.vtex";
+	if (std::filesystem::exists(virtualTexturePath)) {
+		_hasVirtualTexture = _virtualTexture.init(_device, &_memory, &_bindless, &_jobs, virtualTexturePath, 16, _windowExtent);
+		if (_hasVirtualTexture) {
+			defaultMaterial.virtualTexture = _virtualTexture.table_index();
+		}
+	}
+
+	_defaultMaterial = create_material(defaultMaterial);
+
+	vklog::info() << "Bindless Descriptors Initialized!";
+	return true;
+}
+
+uint32_t VulkanEngine::create_material(const GPUMaterial& material)
+{
+	uint32_t index = _materialSlots.allocate();
+	if (index == INVALID_SLOT) {
+		vklog::error() << "Material table is full";
+		return INVALID_SLOT;
+	}
+	_materialData[index] = material;
+	_materialTextures[index] = material.textureIndex;
+	_capture.write_material(index, material);
+	return index;
+}
+
+void VulkanEngine::update_material(uint32_t materialIndex, const GPUMaterial& material)
+{
+	if (materialIndex < MAX_MATERIALS) {
+		_materialData[materialIndex] = material;
+		_materialTextures[materialIndex] = material.textureIndex;
+		_capture.write_material(materialIndex, material);
+	}
+}
+
+void VulkanEngine::destroy_material(uint32_t materialIndex)
+{
+	// 和 bindless 槽位一样，退休两帧后才会被新材质复用
+	_materialSlots.release(materialIndex, _frameNumber);
 }
 
 // 1. Buffer 创建助手
-AllocatedBuffer VulkanEngine::create_buffer(size_t allocSize, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage)// 创建 Buffer 的辅助函数
+AllocatedBuffer VulkanEngine::create_buffer(size_t allocSize, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, MemoryCategory category)// 创建 Buffer 的辅助函数
 {
 	// 填写 Buffer 创建信息
 	VkBufferCreateInfo bufferInfo = {};
@@ -828,26 +2098,19 @@ AllocatedBuffer VulkanEngine::create_buffer(size_t allocSize, VkBufferUsageFlags
 	bufferInfo.size = allocSize;
 	bufferInfo.usage = usage;
 
-	// 填写 VMA 分配信息
-	VmaAllocationCreateInfo vmaallocInfo = {};
-	vmaallocInfo.usage = memoryUsage;
-
 	AllocatedBuffer newBuffer;
 
-	// 让 VMA 帮我们申请 Buffer 和显存，并绑定好
-	if (vmaCreateBuffer(_allocator, &bufferInfo, &vmaallocInfo,
-		&newBuffer._buffer,
-		&newBuffer._allocation,
-		nullptr) != VK_SUCCESS)
+	// 由 MemoryManager 申请 Buffer 和显存 (按类别选池、超预算时先驱逐)，并绑定好
+	if (!_memory.create_buffer(bufferInfo, memoryUsage, category, newBuffer))
 	{
-		std::cout << "[ERROR] Failed to allocate buffer!" << std::endl;
+		vklog::error() << "Failed to allocate buffer!";
 	}
 
 	return newBuffer;
 }
 
-// 2. 上传立方体数据
-void VulkanEngine::init_default_data()// 初始化默认数据
+// 2. 立方体顶点 (纯 CPU，启动时在工作线程上生成)
+std::vector<Vertex> VulkanEngine::build_cube_vertices()
 {
 	// 立方体的 8 个角点颜色
     glm::vec3 white = {1.f, 1.f, 1.f};
@@ -907,17 +2170,286 @@ void VulkanEngine::init_default_data()// 初始化默认数据
         {{ 0.5f, -0.5f,  0.5f}, 0.f, {1,0,0}, 0.f, blue},
     };
 
-    // 计算总大小
-    const size_t bufferSize = vertices.size() * sizeof(Vertex);
+    // 每个面的 6 个顶点按同样的顺序排列，UV 铺满整个面
+    const glm::vec2 faceUVs[6] = { {0.f, 1.f}, {1.f, 1.f}, {1.f, 0.f}, {1.f, 0.f}, {0.f, 0.f}, {0.f, 1.f} };
+    for (size_t i = 0; i < vertices.size(); i++) {
+        vertices[i].uv_x = faceUVs[i % 6].x;
+        vertices[i].uv_y = faceUVs[i % 6].y;
+    }
+    return vertices;
+}
+
+// 演示用的蒙皮网格：沿 +Y 的圆管，越往上越细，8 个关节一条链
+// 两个循环片段 (2 秒，首尾相同)：整条链绕 Z 轴波浪式摆动、绕 X 轴扭动，生成之后直接压缩
+VulkanEngine::SkinnedDemo VulkanEngine::build_tentacle()
+{
+    constexpr uint32_t JOINTS = 8;
+    constexpr float SEGMENT = 0.5f;     // 关节间距
+    constexpr uint32_t RINGS = 32;
+    constexpr uint32_t SIDES = 12;
+    constexpr float LENGTH = JOINTS * SEGMENT;
+    constexpr uint32_t FRAMES = 61;
+
+    SkinnedDemo demo;
+
+    // 1. 网格：每圈 SIDES + 1 个顶点 (接缝处 UV 不同)，权重在相邻两个关节之间线性过渡
+    for (uint32_t ring = 0; ring <= RINGS; ring++) {
+        const float v = (float)ring / RINGS;
+        const float y = v * LENGTH;
+        const float radius = glm::mix(0.3f, 0.05f, v);
+        const float joint = std::min(y / SEGMENT, (float)(JOINTS - 1));
+        const uint32_t j0 = std::min((uint32_t)joint, JOINTS - 1);
+        const float t = joint - (float)j0;
+        for (uint32_t side = 0; side <= SIDES; side++) {
+            const float u = (float)side / SIDES;
+            const float angle = u * 6.28318f;
+            const glm::vec3 normal(std::cos(angle), 0.0f, std::sin(angle));
+            Vertex vertex = {};
+            vertex.position = glm::vec3(normal.x * radius, y, normal.z * radius);
+            vertex.normal = normal;
+            vertex.uv_x = u;
+            vertex.uv_y = v;
+            vertex.color = glm::mix(glm::vec3(0.55f, 0.15f, 0.35f), glm::vec3(0.95f, 0.6f, 0.4f), v);
+            demo.vertices.push_back(vertex);
+
+            vkanim::SkinWeights weights = {};
+            weights.joints[0] = (uint8_t)j0;
+            weights.joints[1] = (uint8_t)std::min(j0 + 1, JOINTS - 1);
+            weights.weights = glm::vec4(1.0f - t, t, 0.0f, 0.0f);
+            demo.weights.push_back(weights);
+        }
+    }
+    for (uint32_t ring = 0; ring < RINGS; ring++) {
+        for (uint32_t side = 0; side < SIDES; side++) {
+            const uint32_t a = ring * (SIDES + 1) + side;
+            const uint32_t b = a + 1;
+            const uint32_t c = a + SIDES + 1;
+            const uint32_t d = c + 1;
+            demo.indices.insert(demo.indices.end(), { a, c, b, b, c, d });
+        }
+    }
+
+    // 2. 骨架：关节 j 在 (0, j * SEGMENT, 0)，父关节是 j - 1
+    for (uint32_t j = 0; j < JOINTS; j++) {
+        demo.skeleton.parents.push_back((int32_t)j - 1);
+        demo.skeleton.inverseBind.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -(float)j * SEGMENT, 0.0f)));
+    }
+
+    // 3. 片段：每个关节相对父关节转一点，相位沿链推迟，看起来像波往上走
+    for (uint32_t clip = 0; clip < 2; clip++) {
+        vkanim::RawClip raw;
+        raw.sampleRate = 30.0f;
+        raw.frameCount = FRAMES;
+        raw.jointCount = JOINTS;
+        raw.frames.resize((size_t)FRAMES * JOINTS);
+        const glm::vec3 axis = clip == 0 ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        for (uint32_t frame = 0; frame < FRAMES; frame++) {
+            const float phase = (float)frame / (FRAMES - 1) * 6.28318f;
+            for (uint32_t j = 0; j < JOINTS; j++) {
+                vkanim::JointTransform& transform = raw.frames[(size_t)frame * JOINTS + j];
+                const float angle = (clip == 0 ? 0.22f : 0.3f) * std::sin(phase - j * (clip == 0 ? 0.6f : 0.9f));
+                transform.rotation = glm::angleAxis(j == 0 ? angle * 0.3f : angle, axis);
+                transform.translation = glm::vec3(0.0f, j == 0 ? 0.0f : SEGMENT, 0.0f);
+            }
+        }
+        demo.clips[clip] = vkanim::compress(raw);
+    }
+    return demo;
+}
+
+// 3. 上传默认数据
+bool VulkanEngine::init_default_data(const vklod::MeshLodChain& cube, SkinnedDemo& tentacle)// 初始化默认数据
+{
+    // 网格表：立方体焊接后每个面 4 个顶点，是第一个网格 (面与面之间是法线接缝，所以只有 LOD 0)
+    if (upload_mesh(cube) != MESH_CUBE) {
+        vklog::error() << "Cube mesh must be the first mesh";
+        return false;
+    }
+
+    vklog::info() << "Cube Mesh Uploaded!";
+
+    // 蒙皮的触手：骨架 / 片段交给 SkinningSystem，网格按绑定姿势上传
+    const uint32_t skeleton = _skinning.add_skeleton(std::move(tentacle.skeleton));
+    if (skeleton != INVALID_SLOT) {
+        _tentacleMesh = upload_skinned_mesh(tentacle.vertices, tentacle.indices, tentacle.weights, skeleton);
+        for (uint32_t i = 0; i < 2; i++) {
+            vklog::info() << "Tentacle clip " << i << ": " << tentacle.clips[i].compressed_size() << " bytes compressed ("
+                << (size_t)tentacle.clips[i].frameCount * tentacle.clips[i].jointCount * sizeof(vkanim::JointTransform) << " raw)";
+            _tentacleClips[i] = _skinning.add_clip(std::move(tentacle.clips[i]));
+        }
+    }
+    // 触手只是演示，失败了 (_tentacleMesh 为 INVALID_SLOT) 不画就是了
+    return true;
+}
+
+uint32_t VulkanEngine::upload_mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+{
+    return upload_mesh(vklod::build_chain(vertices, indices));
+}
+
+uint32_t VulkanEngine::upload_mesh(const vklod::MeshLodChain& chain)
+{
+    return upload_mesh_lods(chain.vertices, chain.indices, chain.lods, chain.center, chain.radius);
+}
+
+uint32_t VulkanEngine::load_mesh(const std::string& path)
+{
+    // 只校验段表，不解析顶点；映射在上传之后就可以关掉
+    MeshAssetFile file;
+    if (!file.open(path.c_str())) {
+        return INVALID_SLOT;
+    }
+    return upload_mesh_lods(file.vertices(), file.indices(), file.lods(), file.info().center, file.info().radius);
+}
+
+uint32_t VulkanEngine::upload_skinned_mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+    std::span<const vkanim::SkinWeights> weights, uint32_t skeleton)
+{
+    // _meshes 里占两项：upload_mesh_lods 加的 LOD 0 (绑定姿势的顶点)，加上换成蒙皮输出 buffer 的那一项
+    if (_meshes.size() + 2 > drawkey::MAX_MESHES) {
+        vklog::error() << "Mesh table is full";
+        return INVALID_SLOT;
+    }
+    const uint32_t skin = _skinning.add_skin(vertices, weights, skeleton);
+    if (skin == INVALID_SLOT) {
+        return INVALID_SLOT;
+    }
+
+    // 包围球按绑定姿势算，再放大一些给动作留余量 (LOD 选择 / 阴影级联用)
+    // (add_skin 已经拒绝了空网格)
+    glm::vec3 lo = vertices[0].position;
+    glm::vec3 hi = vertices[0].position;
+    for (const Vertex& vertex : vertices) {
+        lo = glm::min(lo, vertex.position);
+        hi = glm::max(hi, vertex.position);
+    }
+    const glm::vec3 center = (lo + hi) * 0.5f;
+    float radius = 0.0f;
+    for (const Vertex& vertex : vertices) {
+        radius = std::max(radius, glm::length(vertex.position - center));
+    }
+
+    const vklod::Lod lod = { 0, (uint32_t)indices.size(), 0.0f };
+    const uint32_t meshIndex = upload_mesh_lods(vertices, indices, { &lod, 1 }, center, radius * 1.5f, false);
+    if (meshIndex == INVALID_SLOT) {
+        return INVALID_SLOT;
+    }
+
+    // 同一份索引，顶点换成蒙皮输出 buffer；每个实例画的时候再加上自己在里面的偏移
+    MeshAsset& asset = _meshAssets[meshIndex];
+    DrawMesh mesh = _meshes[asset.firstDrawMesh];
+    mesh.vertexBuffer = _skinning.output_buffer();
+    asset.skin = skin;
+    asset.skinnedDrawMesh = (uint32_t)_meshes.size();
+    _meshes.push_back(mesh);
+    return meshIndex;
+}
+
+uint32_t VulkanEngine::upload_mesh_lods(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+    std::span<const vklod::Lod> lods, const glm::vec3& center, float radius, bool meshlets)
+{
+    const uint32_t meshIndex = (uint32_t)_meshAssets.size();
+    const uint32_t firstDrawMesh = (uint32_t)_meshes.size();
+    const uint32_t lodCount = (uint32_t)lods.size();
+    if (firstDrawMesh + lodCount > drawkey::MAX_MESHES) {
+        vklog::error() << "Mesh table is full";
+        return INVALID_SLOT;
+    }
+    if (vertices.empty() || indices.empty()) {
+        vklog::error() << "Mesh has no triangles";
+        return INVALID_SLOT;
+    }
 
-    // 创建 Buffer (和之前一样)
-    _vertexBuffer = create_buffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    // 创建 Buffer 并拷贝数据 (带上 TRANSFER 用法，碎片整理时可以拷到新位置)
+    auto upload = [this](const void* src, size_t size, VkBufferUsageFlags usage) {
+        AllocatedBuffer buffer = create_buffer(size, usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Geometry);
+        void* data;
+        vmaMapMemory(_allocator, buffer._allocation, &data);
+        memcpy(data, src, size);
+        vmaUnmapMemory(_allocator, buffer._allocation);
+        return buffer;
+    };
 
-    // 拷贝数据 (和之前一样)
-    void* data;
-    vmaMapMemory(_allocator, _vertexBuffer._allocation, &data);
-    memcpy(data, vertices.data(), bufferSize);
-    vmaUnmapMemory(_allocator, _vertexBuffer._allocation);
+    MeshAsset asset = {};
+    // STORAGE：mesh shader 从 bindless 表里按 storage buffer 读顶点
+    asset.vertexBuffer = upload(vertices.data(), vertices.size() * sizeof(Vertex),
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    asset.indexBuffer = upload(indices.data(), indices.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    asset.firstDrawMesh = firstDrawMesh;
+    asset.lodCount = lodCount;
+    asset.center = center;
+    asset.radius = radius;
+    asset.skin = INVALID_SLOT;
+    asset.skinnedDrawMesh = INVALID_SLOT;
+
+    // 所有 LOD 共用两个 buffer，只是索引范围不同
+    for (uint32_t lod = 0; lod < lodCount; lod++) {
+        asset.lodErrors[lod] = lods[lod].error;
+
+        DrawMesh mesh = {};
+        mesh.vertexBuffer = asset.vertexBuffer._buffer;
+        mesh.indexBuffer = asset.indexBuffer._buffer;
+        mesh.vertexCount = (uint32_t)vertices.size();
+        mesh.firstIndex = lods[lod].firstIndex;
+        mesh.indexCount = lods[lod].indexCount;
+        _meshes.push_back(mesh);
+    }
 
-    std::cout << "[INFO] Cube Mesh Uploaded!" << std::endl;
+    // 足够大的网格每个 LOD 都切成 meshlet (放在同一个 meshlet 网格里)，小网格按簇剔除不划算
+    asset.meshletMesh = INVALID_SLOT;
+    if (meshlets && lods[0].indexCount / 3 >= _meshletMinTriangles) {
+        vkmeshlet::MeshletSet meshletSet;
+        for (uint32_t lod = 0; lod < lodCount; lod++) {
+            asset.firstMeshlet[lod] = (uint32_t)meshletSet.meshlets.size();
+            asset.meshletCount[lod] = vkmeshlet::build(vertices,
+                { indices.data() + lods[lod].firstIndex, lods[lod].indexCount }, meshletSet);
+        }
+        asset.meshletMesh = _meshlets.add_mesh(meshletSet, asset.vertexBuffer._buffer);
+    }
+    _meshAssets.push_back(asset);
+
+    // 之后不再映射，允许整理：搬走之后所有 LOD 改用新 buffer
+    // meshlet 网格的顶点缓冲区登记在 bindless 表和 MeshletRenderer 里，不参与整理
+    if (asset.meshletMesh == INVALID_SLOT) {
+        _memory.set_movable(asset.vertexBuffer._allocation, [this, meshIndex](VkBuffer newBuffer) {
+            MeshAsset& moved = _meshAssets[meshIndex];
+            moved.vertexBuffer._buffer = newBuffer;
+            for (uint32_t lod = 0; lod < moved.lodCount; lod++) {
+                _meshes[moved.firstDrawMesh + lod].vertexBuffer = newBuffer;
+            }
+        });
+    }
+    _memory.set_movable(asset.indexBuffer._allocation, [this, meshIndex](VkBuffer newBuffer) {
+        MeshAsset& moved = _meshAssets[meshIndex];
+        moved.indexBuffer._buffer = newBuffer;
+        for (uint32_t lod = 0; lod < moved.lodCount; lod++) {
+            _meshes[moved.firstDrawMesh + lod].indexBuffer = newBuffer;
+        }
+        if (moved.skinnedDrawMesh != INVALID_SLOT) {
+            _meshes[moved.skinnedDrawMesh].indexBuffer = newBuffer;
+        }
+    });
+
+    const vklod::Lod& base = lods[0];
+    _capture.write_mesh(meshIndex, vertices, { indices.data() + base.firstIndex, base.indexCount });
+
+    vklog::Line line = vklog::info();
+    line << "Mesh " << meshIndex << ": " << vertices.size() << " vertices, " << lodCount << " LODs (";
+    for (uint32_t lod = 0; lod < lodCount; lod++) {
+        line << lods[lod].indexCount / 3 << (lod + 1 < lodCount ? " / " : " triangles)");
+    }
+    if (asset.meshletMesh != INVALID_SLOT) {
+        line << ", " << asset.meshletCount[0] << " meshlets at LOD 0";
+    }
+    return meshIndex;
+}
+
+uint32_t VulkanEngine::load_texture(const std::string& path, bool srgb)
+{
+    const uint32_t textureIndex = _textures.load(path, srgb);
+    if (textureIndex != INVALID_SLOT) {
+        _capture.write_texture(textureIndex, path, srgb);
+    }
+    return textureIndex;
 }
@@ -1,9 +1,33 @@
 #pragma once
 
 #include "vk_types.h"
+#include "vk_arena.h"
+#include "vk_shaders.h"
+#include "vk_descriptors.h"
+#include "vk_textures.h"
+#include "vk_virtual_texture.h"
+#include "vk_render_graph.h"
+#include "vk_dynamic_resolution.h"
+#include "vk_memory.h"
+#include "vk_draw_list.h"
+#include "vk_frame_packet.h"
+#include "vk_capture.h"
+#include "vk_startup.h"
+#include "vk_compute.h"
+#include "vk_mesh_lod.h"
+#include "vk_meshlet.h"
+#include "vk_static_draws.h"
+#include "vk_shadows.h"
+#include "vk_clustered_lights.h"
+#include "vk_skinning.h"
+#include "vk_bvh.h"
+#include "vk_particles.h"
+
+#include <thread>
 
 struct SDL_Window;
 union SDL_Event;
+namespace vkb { struct Instance; }
 
 class PipelineBuilder {// 用于构建图形管线的辅助类
 public:
@@ -24,15 +48,33 @@ public:
 	VkPipeline build_pipeline(VkDevice device);
 };
 
+class ComputePipelineBuilder {// 用于构建计算管线的辅助类
+public:
+	VkPipelineShaderStageCreateInfo _shaderStage; // 计算着色器 (只有一个阶段)
+	VkPipelineLayout _pipelineLayout;             // 和图形管线一样来自 PipelineLayoutCache，set 0 是 bindless 全局 set
+
+	VkPipeline build_pipeline(VkDevice device);
+};
+
 class VulkanEngine {
 public:
 	bool _isInitialized{ false };
-	int _frameNumber {0};
+	int _frameNumber {0}; // 渲染线程的帧数
+	uint64_t _simFrame{ 0 }; // 模拟线程 (主线程) 的帧数
 	bool _stop_rendering{ false };
 	VkExtent2D _windowExtent{ 1700 , 900 };
 
 	struct SDL_Window* _window{ nullptr };
 
+	// 抓帧 / 回放 (main() 在 init() 之前根据命令行设置)
+	// 抓帧：初始化时打开 .vcap，之后创建的网格 / 材质 / 纹理和渲染的每一帧都写进去
+	// 回放：无窗口 (headless)，画到离屏目标上，不呈现；动态分辨率固定为 1，每次结果可重复
+	std::string _capturePath;
+	std::string _replayPath;
+	uint32_t _replayIterations{ 10 };
+	bool _assertNoFrameAllocations{ true }; // 稳定状态的 draw() 不允许有堆分配 (assert，只在调试版生效)
+	bool _headless{ false };
+
 	// ----- 新增：Vulkan 核心句柄 -----
 	VkInstance _instance;                      // Vulkan 实例
 	VkDebugUtilsMessengerEXT _debug_messenger; // 调试信使（用于接收报错）
@@ -52,6 +94,10 @@ public:
 	VkQueue _graphicsQueue;        // 图形队列 (提交命令的地方)
 	uint32_t _graphicsQueueFamily; // 队列家族索引 (显卡有很多种队列，我们要找能画图的那种)
 
+	VkQueue _computeQueue;         // 计算队列 (专用 / 独立的队列族，没有时就是图形队列)
+	uint32_t _computeQueueFamily;
+	AsyncCompute _compute;         // 异步计算：计算队列上的提交 + 和图形队列之间的时间线信号量
+
 	VkCommandPool _commandPool;    // 命令池 (分配器)
 	VkCommandBuffer _mainCommandBuffer; // 主命令缓冲区 (我们会把每一帧的指令录在这里)
 
@@ -59,36 +105,237 @@ public:
 	VkSemaphore _presentSemaphore; // 信号量: 图片准备好了吗？
 	VkSemaphore _renderSemaphore;  // 信号量: 画完了吗？
 
-	VmaAllocator _allocator; // VMA 分配器
+	MemoryManager _memory;   // 显存：预算、分类记账、池、碎片整理
+	VmaAllocator _allocator; // VMA 分配器 (属于 _memory，映射 / 解除映射用)
+	bool _supportsMemoryBudget{ false }; // VK_EXT_memory_budget
 
-	AllocatedImage _depthImage;// 深度图像
+	VkFormat _depthFormat{ VK_FORMAT_D32_SFLOAT };// 深度格式 (深度图是渲染图里的瞬态图像)
+
+	// 渲染图：pass 声明读写的资源，barrier / 布局转换 / 瞬态显存由它负责
+	RenderGraph _renderGraph;
+	RGResource _rgSwapchain{ RG_INVALID_RESOURCE };
+	RGResource _rgDepth{ RG_INVALID_RESOURCE };
+	RGResource _rgDraw{ RG_INVALID_RESOURCE };
+
+	// 动态分辨率：场景先画到离屏的 draw image (按窗口大小分配)，再缩放 blit 到交换链
+	// 每帧只改 viewport / scissor 的大小，附件不用重建
+	VkFormat _drawFormat{ VK_FORMAT_R16G16B16A16_SFLOAT };
+	VkExtent2D _renderExtent{ 1700 , 900 }; // 这一帧实际渲染的大小 (<= _windowExtent)
+	GpuFrameTimer _gpuTimer;
+	DynamicResolution _dynamicResolution;
 
 	// 初始化三部曲
 	void init();
 	void cleanup();
 	void run();
-	void draw();
+	void draw(const FramePacket& packet); // 渲染线程：录制并提交一帧
+	void replay(); // 代替 run()：把 _replayPath 重放 _replayIterations 遍并打印耗时
 
 	// 三角形相关
 	VkPipelineLayout _trianglePipelineLayout;// 三角形管线布局
     VkPipeline _trianglePipeline;// 三角形管线
 
-	AllocatedBuffer _vertexBuffer;
+	// 网格资源：所有 LOD 共用一个顶点缓冲区和一个索引缓冲区，每个 LOD 在 _meshes 里占一项
+	struct MeshAsset {
+		AllocatedBuffer vertexBuffer;
+		AllocatedBuffer indexBuffer;
+		uint32_t firstDrawMesh;       // LOD 0 在 _meshes 里的下标，LOD i 是 firstDrawMesh + i
+		uint32_t lodCount;
+		float lodErrors[vklod::MAX_LODS]; // 每级的物体空间误差
+		glm::vec3 center;             // 包围球 (物体空间)
+		float radius;
+		// meshlet 网格 (三角形够多的才有)：每个 LOD 在里面的簇范围
+		uint32_t meshletMesh;
+		uint32_t firstMeshlet[vklod::MAX_LODS];
+		uint32_t meshletCount[vklod::MAX_LODS];
+		// 蒙皮网格：SkinningSystem 里的 skin，和顶点换成蒙皮输出 buffer 的那一项 (只有 LOD 0，实例各自加顶点偏移)
+		uint32_t skin;
+		uint32_t skinnedDrawMesh;
+	};
+	std::vector<MeshAsset> _meshAssets; // 数据包里的网格下标指向这里
+
+	// LOD 选择：投影误差不超过这么多像素的最粗级别；变粗要低于阈值 * (1 - 滞回) 才切换
+	float _lodThresholdPx{ 1.0f };
+	float _lodHysteresis{ 0.25f };
+	std::vector<uint8_t> _objectLods; // 按 PacketDraw::object 记录上一帧的级别 (只在渲染线程上访问)
+
+	// meshlet：LOD 0 至少这么多三角形的网格切成簇，按簇剔除 (有 VK_EXT_mesh_shader 时走 task/mesh shader)
+	// meshlet 网格不走绘制列表，用自己的管线 (打开背面剔除)
+	uint32_t _meshletMinTriangles{ 512 };
+	bool _supportsMeshShaders{ false };
+	MeshletRenderer _meshlets;
+	VkPipeline _meshletCullPipeline{ VK_NULL_HANDLE };
+	VkPipeline _meshletPipeline{ VK_NULL_HANDLE };
+	RGResource _rgMeshletCommands{ RG_INVALID_RESOURCE };
+	RGResource _rgMeshletCounts{ RG_INVALID_RESOURCE };
+
+	// 绘制列表：每帧收集绘制、按排序键基数排序，录制时跳过重复的绑定
+	// 管线和网格按下标登记在表里，下标直接进排序键
+	static constexpr uint32_t PIPELINE_TRIANGLE = 0;
+	static constexpr uint32_t MESH_CUBE = 0;
+	DrawList _drawList;
+	std::vector<VkPipeline> _pipelines;
+	std::vector<DrawMesh> _meshes; // 每个网格资源的每个 LOD 一项
+
+	// 静态物体 (DRAW_STATIC)：录进缓存的二级命令缓冲区，只在物体集合 / 绑定 / 格式 / 分辨率变化时重新录制
+	// 管线表和 _pipelines 下标一一对应，顶点着色器换成从实例表取变换的 static_mesh.vert
+	StaticDrawCache _staticDraws;
+	std::vector<VkPipeline> _staticPipelines;
+
+	// 级联阴影：静态几何的深度缓存起来，只在光 / 级联范围变化时重画；动态物体每次更新时叠加上去
+	ShadowCascades _shadows;
+	VkPipeline _shadowPipeline{ VK_NULL_HANDLE };       // 动态物体 (triangle_mesh.vert)
+	VkPipeline _shadowStaticPipelines[ShadowCascades::VIEW_MASKS]{}; // 静态几何 (static_mesh.vert)，按多视角的 viewMask
+	float _shadowAmbient{ 0.35f }; // 阴影里剩下的亮度
+
+	// 分簇的点光源：计算着色器把光源分进 froxel，片段着色器只遍历自己那一格的
+	ClusteredLights _clusteredLights;
+	VkPipeline _lightClusterPipeline{ VK_NULL_HANDLE };
+	RGResource _rgLightClusters{ RG_INVALID_RESOURCE };
+	RGResource _rgLightIndices{ RG_INVALID_RESOURCE };
+
+	// 计算蒙皮 (DRAW_SKINNED)：工作线程算姿势，异步计算队列蒙皮到输出 buffer，之后 forward / 阴影都当普通网格画
+	SkinningSystem _skinning;
+	VkPipeline _skinningPipeline{ VK_NULL_HANDLE };
+	std::vector<uint32_t> _skinnedOffsets; // 按 PacketDraw 下标：这一帧蒙皮实例在输出 buffer 里的第一个顶点 (没有时 INVALID_SLOT)
+	// 演示用的触手：网格资源和两个片段 (摆动 / 扭转)
+	uint32_t _tentacleMesh{ INVALID_SLOT };
+	uint32_t _tentacleClips[2]{ INVALID_SLOT, INVALID_SLOT };
+
+	// GPU 粒子：发射 / 模拟 / 紧凑都在计算着色器里，按 forward 的深度图碰撞，实例数由 GPU 写进间接绘制参数
+	ParticleSystem _particles;
+	VkPipeline _particleEmitPipeline{ VK_NULL_HANDLE };
+	VkPipeline _particleSimulatePipeline{ VK_NULL_HANDLE };
+	VkPipeline _particleArgsPipeline{ VK_NULL_HANDLE };
+	VkPipeline _particlePipeline{ VK_NULL_HANDLE };
+	uint32_t _depthTextureIndex{ INVALID_SLOT }; // 深度图在 textures[] 里的下标 (渲染图编译之后登记)
+	RGResource _rgParticles{ RG_INVALID_RESOURCE };
+	RGResource _rgParticleLists{ RG_INVALID_RESOURCE };
+	RGResource _rgParticleCounters{ RG_INVALID_RESOURCE };
+
+	// 每帧的场景数据 (invViewProj、光、阴影级联、光源分簇)，常驻映射
+	AllocatedBuffer _sceneBuffer;
+	GPUSceneData* _sceneData{ nullptr };
+
+	// shader 包 (内存映射) 与反射生成的 layout 缓存
+	ShaderPack _shaderPack;
+	PipelineLayoutCache _layoutCache;
+
+	// bindless 全局资源 (set 0) 与材质表
+	static constexpr uint32_t MAX_MATERIALS = 4096;
+	BindlessHeap _bindless;
+	AllocatedBuffer _materialBuffer;
+	GPUMaterial* _materialData{ nullptr }; // 常驻映射
+	uint32_t _materialTextures[MAX_MATERIALS]{}; // CPU 端的副本 (映射内存是写合并的，不从那里读)：流式加载按材质给纹理排优先级
+	SlotAllocator _materialSlots;
+	VkSampler _defaultSampler;
+	uint32_t _defaultSamplerIndex{ INVALID_SLOT };
+	uint32_t _defaultMaterial{ INVALID_SLOT };
+
+	// 每帧的临时分配：帧槽位 × 线程一个线性 arena，等过这个槽位的 fence 后整体重置
+	FrameArenas _frameArenas;
+	// 堆分配检查：后台有活 (流式加载、纹理上传、VT 换页、碎片整理) 的帧允许分配，
+	// 连续安静 ALLOC_WARMUP_FRAMES 帧之后才算稳定状态，这时 draw() 在渲染线程上的堆分配必须是 0
+	static constexpr uint32_t ALLOC_WARMUP_FRAMES = 120;
+	uint32_t _quietFrames{ 0 };
+	bool background_work_pending() const;
+	// 返回这一帧是不是稳定状态 (是的话已经检查过 allocations)
+	bool check_frame_allocations(uint64_t allocations);
+
+	// 工作线程池 + 流式加载 + 异步纹理
+	JobSystem _jobs;
+	AssetStreamer _streamer;
+	TextureManager _textures;
+	bool _supportsBC{ false }; // 设备是否支持 BC 压缩纹理 (不支持时在工作线程上解码)
+
+	// 虚拟纹理 (大地形 / 图集)，物理页缓存大小固定
+	VirtualTexture _virtualTexture;
+	bool _hasVirtualTexture{ false };
+
+	// 材质下标是稳定的，shader 通过它索引材质表
+	uint32_t create_material(const GPUMaterial& material);
+	void update_material(uint32_t materialIndex, const GPUMaterial& material);
+	void destroy_material(uint32_t materialIndex);
+
+	// 生成 LOD 链并上传，返回网格资源下标 (抓帧时记录焊接后的顶点和 LOD 0 索引)
+	// indices 为空时 vertices 按三角形列表解释
+	uint32_t upload_mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices = {});
+	uint32_t upload_mesh(const vklod::MeshLodChain& chain); // LOD 链已经生成好 (比如在工作线程上)
+	// AssetBaker 烘焙好的网格 (.vasset)：内存映射，顶点 / 索引段直接拷进 buffer
+	uint32_t load_mesh(const std::string& path);
+	// 蒙皮网格：不焊接、不生成 LOD / meshlet (顶点顺序必须和 weights 对应)，返回网格资源下标
+	// 抓帧只记录绑定姿势，回放时按刚体画
+	uint32_t upload_skinned_mesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+		std::span<const vkanim::SkinWeights> weights, uint32_t skeleton);
+	// 异步加载纹理，返回 bindless 下标 (抓帧时记录路径)
+	uint32_t load_texture(const std::string& path, bool srgb = true);
 
     // [新增] 2. 创建 Buffer 的辅助函数
-    AllocatedBuffer create_buffer(size_t allocSize, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage);
+    AllocatedBuffer create_buffer(size_t allocSize, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, MemoryCategory category);
 	
 private:
 	// ----- 新增：初始化 Vulkan 的私有函数 -----
-	void init_vulkan(); 
+	// 启动图：各阶段的依赖见 init()，结束后打印每个阶段的耗时和关键路径
+	StartupGraph _startup;
+	bool init_window();
+	bool init_instance(vkb::Instance& vkbInstance);
+	bool init_device(const vkb::Instance& vkbInstance);
 	void init_swapchain(); //  初始化交换链函数
 	void init_commands(); //  初始化命令系统
 	void init_sync_structures(); // 初始化同步原语
 
-	bool load_shader_module(const char* filePath, VkShaderModule* outShaderModule);// 加载着色器模块
+	bool load_shader_module(const char* name, VkShaderModule* outShaderModule);// 从 shader 包加载着色器模块
+
+	bool init_descriptors();// 初始化 bindless 全局 set
+	bool init_pipelines();// 初始化管线
+	bool init_render_graph();// 构建并编译渲染图
+	void init_meshlet_pipelines(const PipelineBuilder& base);// meshlet 剔除 + 绘制管线 (两条路径之一)
+	void init_static_pipelines(const PipelineBuilder& base);// 静态物体的缓存绘制管线
+	void init_shadow_pipelines(const PipelineBuilder& base);// 只有深度的阴影管线
+	void init_light_pipelines();// 光源分簇的计算管线
+	void init_skinning_pipelines();// 计算蒙皮的管线
+	void init_particle_pipelines(const PipelineBuilder& base);// 粒子的计算管线 + 公告板管线
+
+	void build_draws(const FramePacket& packet);// 选 LOD，物体分到绘制列表 / meshlet
+
+	// 上传焊接好的顶点 + 首尾相接的 LOD 索引 (upload_mesh / load_mesh 共用)
+	// meshlets 为 false 时不切簇 (蒙皮网格的顶点每帧在别的 buffer 里)
+	uint32_t upload_mesh_lods(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+		std::span<const vklod::Lod> lods, const glm::vec3& center, float radius, bool meshlets = true);
+
+	void draw_forward(VkCommandBuffer cmd);// 主 pass：画场景
+	void draw_particles(VkCommandBuffer cmd);// 把粒子叠加到 draw image 上
+	void draw_upscale(VkCommandBuffer cmd);// 把 draw image 缩放到交换链
+
+	// 模拟 / 渲染分离：主线程处理事件并生成帧数据包，渲染线程消费
+	// 队列深度 = 在途帧数 + 1：一个包在渲染线程上录制 (GPU 同时在执行上一帧)，一个包在主线程上生成
+	// 再多的话模拟会领先画面太多，输入延迟变大
+	static constexpr uint32_t FRAMES_IN_FLIGHT = 1; // 只有一个 _renderFence
+	void simulate(FramePacket& packet);
+	// 场景查询：模拟线程每帧把物体的世界包围盒交给 BVH (没变的不算改动)，查询拿快照，工作线程上也可以查
+	SceneBvh _sceneBvh;
+	glm::mat4 _simViewProj{ 1.0f }; // 最近一次模拟的相机 (拾取用)
+	void pick(int x, int y);        // 窗口坐标下的拾取，打印打中的物体
+	void render_loop();
+	SpscQueue<FramePacket, FRAMES_IN_FLIGHT + 1> _packets;
+	std::thread _renderThread;
+	const FramePacket* _currentPacket{ nullptr }; // 渲染线程正在录制的包
 
-	void init_pipelines();// 初始化管线
+	CaptureWriter _capture;
+	CaptureReader _replayReader;
+	AllocatedImage _headlessTarget{}; // headless 时代替交换链图片
+	float _lastGpuMs{ 0.0f };         // 最近一次读到的 GPU 帧时间
 
 	// [新增] 3. 初始化网格数据的函数
-    void init_default_data();
+    static std::vector<Vertex> build_cube_vertices();
+    // 演示用的蒙皮网格：一根沿 +Y 的触手，骨骼链 + 两个压缩好的片段 (纯 CPU)
+    struct SkinnedDemo {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        std::vector<vkanim::SkinWeights> weights;
+        vkanim::Skeleton skeleton;
+        vkanim::Clip clips[2];
+    };
+    static SkinnedDemo build_tentacle();
+    bool init_default_data(const vklod::MeshLodChain& cube, SkinnedDemo& tentacle);
 };
\ No newline at end of file
@@ -0,0 +1,228 @@
+#include "vk_file.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = file;
+	_mapping = mapping;
+	_data = static_cast<const uint8_t*>(view);
+	_size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (_data) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mapping) {
+		CloseHandle((HANDLE)_mapping);
+	}
+	if (_file) {
+		CloseHandle((HANDLE)_file);
+	}
+	_data = nullptr;
+	_size = 0;
+	_mapping = nullptr;
+	_file = nullptr;
+}
+
+bool StreamFile::open(const char* path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = file;
+	_size = (uint64_t)fileSize.QuadPart;
+	return true;
+}
+
+void StreamFile::close()
+{
+	if (_file) {
+		CloseHandle((HANDLE)_file);
+	}
+	_file = nullptr;
+	_size = 0;
+}
+
+bool StreamFile::is_open() const
+{
+	return _file != nullptr;
+}
+
+bool StreamFile::read(uint64_t offset, size_t size, void* dst) const
+{
+	// 同步句柄 + OVERLAPPED 里的偏移：不用也不改共享的文件指针
+	uint8_t* out = static_cast<uint8_t*>(dst);
+	while (size > 0) {
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)(offset & 0xFFFFFFFFu);
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		const DWORD request = (DWORD)std::min<size_t>(size, 1u << 30);
+		DWORD bytesRead = 0;
+		if (!ReadFile((HANDLE)_file, out, request, &bytesRead, &overlapped) || bytesRead == 0) {
+			return false;
+		}
+		out += bytesRead;
+		offset += bytesRead;
+		size -= bytesRead;
+	}
+	return true;
+}
+
+#else
+
+bool MappedFile::open(const char* path)
+{
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED) {
+		::close(fd);
+		return false;
+	}
+
+	_fd = fd;
+	_data = static_cast<const uint8_t*>(view);
+	_size = (size_t)st.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (_data) {
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+	if (_fd >= 0) {
+		::close(_fd);
+	}
+	_data = nullptr;
+	_size = 0;
+	_fd = -1;
+}
+
+bool StreamFile::open(const char* path)
+{
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+
+	_fd = fd;
+	_size = (uint64_t)st.st_size;
+	return true;
+}
+
+void StreamFile::close()
+{
+	if (_fd >= 0) {
+		::close(_fd);
+	}
+	_fd = -1;
+	_size = 0;
+}
+
+bool StreamFile::is_open() const
+{
+	return _fd >= 0;
+}
+
+bool StreamFile::read(uint64_t offset, size_t size, void* dst) const
+{
+	uint8_t* out = static_cast<uint8_t*>(dst);
+	while (size > 0) {
+		const ssize_t bytesRead = pread(_fd, out, size, (off_t)offset);
+		if (bytesRead < 0 && errno == EINTR) {
+			continue;
+		}
+		if (bytesRead <= 0) {
+			return false;
+		}
+		out += bytesRead;
+		offset += (uint64_t)bytesRead;
+		size -= (size_t)bytesRead;
+	}
+	return true;
+}
+
+#endif
+
+void MappedFile::prefetch() const
+{
+	constexpr size_t PREFETCH_STRIDE = 4096;
+	volatile uint8_t sink = 0;
+	for (size_t offset = 0; offset < _size; offset += PREFETCH_STRIDE) {
+		sink = sink + _data[offset];
+	}
+}
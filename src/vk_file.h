@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 只读内存映射文件
+// Windows 下用 CreateFileMapping / MapViewOfFile，其他平台用 mmap
+// 映射期间 data() 指向的内存一直有效，不会有任何拷贝
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const char* path);
+	void close();
+
+	bool is_open() const { return _data != nullptr; }
+	const uint8_t* data() const { return _data; }
+	size_t size() const { return _size; }
+
+	// 把整个文件读进页缓存 (每页碰一个字节)，之后访问不会再因为缺页卡在磁盘上
+	// 启动时在工作线程上调用，和设备创建重叠
+	void prefetch() const;
+
+private:
+	const uint8_t* _data{ nullptr };
+	size_t _size{ 0 };
+
+#ifdef _WIN32
+	void* _file{ nullptr };    // HANDLE
+	void* _mapping{ nullptr }; // HANDLE
+#else
+	int _fd{ -1 };
+#endif
+};
+
+// 按偏移读的只读文件 (流式加载用)
+// read() 不移动文件指针 (pread / 带偏移的 ReadFile)，多个工作线程可以同时读同一个文件的不同区域
+class StreamFile {
+public:
+	StreamFile() = default;
+	~StreamFile() { close(); }
+
+	StreamFile(const StreamFile&) = delete;
+	StreamFile& operator=(const StreamFile&) = delete;
+
+	bool open(const char* path);
+	void close();
+
+	bool is_open() const;
+	uint64_t size() const { return _size; }
+
+	// 读满 size 字节才返回 true (中途被信号打断会继续读)
+	bool read(uint64_t offset, size_t size, void* dst) const;
+
+private:
+	uint64_t _size{ 0 };
+
+#ifdef _WIN32
+	void* _file{ nullptr }; // HANDLE
+#else
+	int _fd{ -1 };
+#endif
+};
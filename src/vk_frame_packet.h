@@ -0,0 +1,128 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <atomic>
+
+// 单生产者单消费者的有界环形队列 (无锁)
+// 槽位原地复用：生产者直接在槽位里填数据，里面的 vector 容量一直保留，稳态下不分配内存
+// 满 / 空时用 C++20 的 atomic wait 睡眠，不自旋
+template<typename T, size_t Capacity>
+class SpscQueue {
+public:
+	// 生产者：取一个空槽位，队列满时阻塞到消费者腾出位置
+	T* begin_push()
+	{
+		const uint64_t tail = _tail.load(std::memory_order_relaxed);
+		for (;;) {
+			const uint64_t head = _head.load(std::memory_order_acquire);
+			if (tail - head < Capacity) {
+				return &_slots[tail % Capacity];
+			}
+			_head.wait(head, std::memory_order_acquire);
+		}
+	}
+
+	// 生产者：槽位填好了，交给消费者
+	void end_push()
+	{
+		_tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		_tail.notify_one();
+	}
+
+	// 消费者：取最早的一项，队列空时阻塞
+	T* begin_pop()
+	{
+		const uint64_t head = _head.load(std::memory_order_relaxed);
+		for (;;) {
+			const uint64_t tail = _tail.load(std::memory_order_acquire);
+			if (tail != head) {
+				return &_slots[head % Capacity];
+			}
+			_tail.wait(tail, std::memory_order_acquire);
+		}
+	}
+
+	// 消费者：用完了，槽位还给生产者
+	void end_pop()
+	{
+		_head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		_head.notify_one();
+	}
+
+private:
+	T _slots[Capacity];
+	alignas(64) std::atomic<uint64_t> _head{ 0 }; // 只有消费者写
+	alignas(64) std::atomic<uint64_t> _tail{ 0 }; // 只有生产者写
+};
+
+// PacketDraw::flags
+// 静态物体 (不会每帧增删、换管线)：渲染线程把它们录进缓存的二级命令缓冲区，不再每帧重新录制
+// 变换偶尔变一下没关系，只是多写一次实例数据
+constexpr uint32_t DRAW_STATIC = 1u << 0;
+// 蒙皮物体：网格必须是 upload_skinned_mesh 上传的，姿势在 FramePacket::animations 里 (没有对应的动画时按绑定姿势画)
+// 每帧重新蒙皮，不进静态缓存
+constexpr uint32_t DRAW_SKINNED = 1u << 1;
+
+// 帧数据包里的一个可见物体
+struct PacketDraw {
+	uint32_t pipeline;   // 管线表下标
+	uint32_t mesh;       // 网格表下标
+	uint32_t material;   // 材质表下标
+	uint32_t object;     // 场景里的物体编号 (跨帧稳定，渲染线程按它记住每个物体上一帧的 LOD)
+	uint32_t flags;      // DRAW_STATIC 等
+	glm::mat4 model;
+	glm::vec4 data;      // 颜色倍增等
+};
+
+// 帧数据包里的一个点光源 (世界空间)
+struct PacketLight {
+	glm::vec3 position;
+	float radius;        // 影响半径，之外完全没有贡献
+	glm::vec3 color;
+	float intensity;
+};
+
+// 帧数据包里一个蒙皮物体这一帧的姿势：两个片段各自的时间，按 blend 混合 (0 只用 clips[0])
+struct PacketAnimation {
+	uint32_t draw;       // FramePacket::draws 下标
+	uint32_t clips[2];   // SkinningSystem 的片段下标，clips[1] 可以是 INVALID_SLOT
+	float times[2];      // 秒，超出片段长度时循环
+	float blend;
+};
+
+// 帧数据包里的一个粒子发射器：这一帧新发射 count 个粒子 (发射速率由模拟线程换算成每帧的个数)
+// 粒子发出去之后完全在 GPU 上模拟，和发射器再没有关系
+struct PacketEmitter {
+	glm::vec3 position;
+	float radius;        // 在这个球里随机出生
+	glm::vec3 velocity;
+	float spread;        // 随机速度的大小
+	glm::vec4 color;
+	float lifetime;      // 秒
+	float size;          // 公告板的半边长
+	uint32_t count;
+};
+
+// 模拟线程交给渲染线程的一帧：生成之后就不再修改
+// 渲染线程只读它，不会访问模拟线程的任何状态
+struct FramePacket {
+	uint64_t simFrame{ 0 };
+	bool quit{ false };            // 最后一个包：渲染线程收到后退出
+
+	// 相机 (投影矩阵由渲染线程按实际渲染分辨率生成)
+	glm::mat4 view{ 1.0f };
+	glm::vec3 cameraPosition{ 0.0f };
+	float fovY{ 70.0f };           // 度
+	float zNear{ 0.1f };
+	float zFar{ 200.0f };
+
+	// 方向光：光传播的方向 (渲染线程归一化)
+	glm::vec3 lightDirection{ 0.0f, -1.0f, 0.0f };
+
+	glm::vec4 clearColor{ 0.0f, 0.0f, 0.0f, 1.0f };
+	std::vector<PacketDraw> draws;
+	std::vector<PacketLight> lights;
+	std::vector<PacketAnimation> animations;
+	std::vector<PacketEmitter> emitters;
+};
@@ -0,0 +1,442 @@
+#include "vk_image_loader.h"
+#include "vk_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+	// 每个块的像素尺寸和字节数 (非压缩格式视为 1x1 的块)
+	struct FormatInfo {
+		uint32_t blockSize;
+		uint32_t blockBytes;
+	};
+
+	bool format_info(VkFormat format, FormatInfo& out)
+	{
+		switch (format) {
+		case VK_FORMAT_R8_UNORM:
+			out = { 1, 1 }; return true;
+		case VK_FORMAT_R8G8_UNORM:
+			out = { 1, 2 }; return true;
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			out = { 1, 4 }; return true;
+		case VK_FORMAT_R16G16B16A16_SFLOAT:
+			out = { 1, 8 }; return true;
+		case VK_FORMAT_R32G32B32A32_SFLOAT:
+			out = { 1, 16 }; return true;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC4_SNORM_BLOCK:
+			out = { 4, 8 }; return true;
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC5_SNORM_BLOCK:
+		case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+		case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			out = { 4, 16 }; return true;
+		default:
+			return false;
+		}
+	}
+
+	VkDeviceSize level_size(const FormatInfo& info, uint32_t width, uint32_t height)
+	{
+		const uint64_t blocksX = (width + info.blockSize - 1) / info.blockSize;
+		const uint64_t blocksY = (height + info.blockSize - 1) / info.blockSize;
+		return blocksX * blocksY * info.blockBytes;
+	}
+
+	template<typename T>
+	T read(const uint8_t* p)
+	{
+		T value;
+		memcpy(&value, p, sizeof(T));
+		return value;
+	}
+
+	// ---------------- BC 软件解码 ----------------
+
+	void decode_rgb565(uint16_t c, uint8_t out[4])
+	{
+		const uint32_t r = (c >> 11) & 0x1F;
+		const uint32_t g = (c >> 5) & 0x3F;
+		const uint32_t b = c & 0x1F;
+		out[0] = (uint8_t)((r << 3) | (r >> 2));
+		out[1] = (uint8_t)((g << 2) | (g >> 4));
+		out[2] = (uint8_t)((b << 3) | (b >> 2));
+		out[3] = 255;
+	}
+
+	// 颜色块 (8 字节)。BC1 按 c0 > c1 选 4 色 / 3 色 (中点 + 下标 3 是黑色)；BC2/BC3 里的颜色块总是 4 色模式
+	// punchThrough 只决定 3 色模式下下标 3 的 alpha (BC1 RGBA 是 0，BC1 RGB 是 255)
+	void decode_color_block(const uint8_t* block, bool forceFourColor, bool punchThrough, uint8_t out[16][4])
+	{
+		const uint16_t c0 = read<uint16_t>(block);
+		const uint16_t c1 = read<uint16_t>(block + 2);
+		const uint32_t indices = read<uint32_t>(block + 4);
+		const bool fourColor = c0 > c1 || forceFourColor;
+
+		uint8_t palette[4][4];
+		decode_rgb565(c0, palette[0]);
+		decode_rgb565(c1, palette[1]);
+		for (int ch = 0; ch < 3; ch++) {
+			if (fourColor) {
+				palette[2][ch] = (uint8_t)((2 * palette[0][ch] + palette[1][ch]) / 3);
+				palette[3][ch] = (uint8_t)((palette[0][ch] + 2 * palette[1][ch]) / 3);
+			}
+			else {
+				palette[2][ch] = (uint8_t)((palette[0][ch] + palette[1][ch]) / 2);
+				palette[3][ch] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = (fourColor || !punchThrough) ? 255 : 0;
+
+		for (int i = 0; i < 16; i++) {
+			memcpy(out[i], palette[(indices >> (2 * i)) & 0x3], 4);
+		}
+	}
+
+	// BC3 的插值 alpha 块 (8 字节)
+	void decode_alpha_block(const uint8_t* block, uint8_t out[16][4])
+	{
+		const uint32_t a0 = block[0];
+		const uint32_t a1 = block[1];
+		uint8_t palette[8] = { (uint8_t)a0, (uint8_t)a1 };
+		if (a0 > a1) {
+			for (uint32_t i = 1; i < 7; i++) {
+				palette[i + 1] = (uint8_t)(((7 - i) * a0 + i * a1) / 7);
+			}
+		}
+		else {
+			for (uint32_t i = 1; i < 5; i++) {
+				palette[i + 1] = (uint8_t)(((5 - i) * a0 + i * a1) / 5);
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		uint64_t indices = 0;
+		memcpy(&indices, block + 2, 6);
+		for (int i = 0; i < 16; i++) {
+			out[i][3] = palette[(indices >> (3 * i)) & 0x7];
+		}
+	}
+
+	// BC2 的显式 4bit alpha (8 字节)
+	void decode_explicit_alpha(const uint8_t* block, uint8_t out[16][4])
+	{
+		const uint64_t bits = read<uint64_t>(block);
+		for (int i = 0; i < 16; i++) {
+			out[i][3] = (uint8_t)(((bits >> (4 * i)) & 0xF) * 17);
+		}
+	}
+
+	// ---------------- KTX2 ----------------
+
+	const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	constexpr size_t KTX2_HEADER_SIZE = 80; // 标识符 + 头 + 索引
+	constexpr size_t KTX2_LEVEL_SIZE = 24;  // byteOffset + byteLength + uncompressedByteLength
+}
+
+namespace vkimage {
+
+	uint32_t mip_count(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		uint32_t size = std::max(width, height);
+		while (size > 1) {
+			size >>= 1;
+			levels++;
+		}
+		return levels;
+	}
+
+	bool is_block_compressed(VkFormat format)
+	{
+		FormatInfo info;
+		return format_info(format, info) && info.blockSize == 4;
+	}
+
+	bool load(const char* path, bool srgb, ImageData& out)
+	{
+		MappedFile file;
+		if (!file.open(path)) {
+			vklog::error() << "Could not open image: " << path;
+			return false;
+		}
+
+		return decode(path, file.data(), file.size(), srgb, out);
+	}
+
+	bool decode(const char* name, const uint8_t* data, size_t size, bool srgb, ImageData& out)
+	{
+		const std::string_view path(name);
+		if (size >= sizeof(KTX2_IDENTIFIER) && memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0) {
+			return load_ktx2(data, size, out);
+		}
+		if (path.ends_with(".tga") || path.ends_with(".TGA")) {
+			return load_tga(data, size, srgb, out);
+		}
+
+		vklog::error() << "Unsupported image format: " << name;
+		return false;
+	}
+
+	bool load_ktx2(const uint8_t* data, size_t size, ImageData& out)
+	{
+		if (size < KTX2_HEADER_SIZE || memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0) {
+			return false;
+		}
+
+		const VkFormat format = (VkFormat)read<uint32_t>(data + 12);
+		const uint32_t width = read<uint32_t>(data + 20);
+		const uint32_t height = read<uint32_t>(data + 24);
+		const uint32_t depth = read<uint32_t>(data + 28);
+		const uint32_t layers = read<uint32_t>(data + 32);
+		const uint32_t faces = read<uint32_t>(data + 36);
+		const uint32_t levelCount = read<uint32_t>(data + 40);
+		const uint32_t supercompression = read<uint32_t>(data + 44);
+
+		if (format == VK_FORMAT_UNDEFINED) {
+			vklog::error() << "KTX2: Basis Universal textures are not supported";
+			return false;
+		}
+		if (supercompression != 0) {
+			vklog::error() << "KTX2: supercompression scheme " << supercompression << " is not supported";
+			return false;
+		}
+		if (width == 0 || height == 0 || depth > 1 || layers > 1 || faces != 1) {
+			vklog::error() << "KTX2: only single 2D images are supported";
+			return false;
+		}
+
+		FormatInfo info;
+		if (!format_info(format, info)) {
+			vklog::error() << "KTX2: unsupported vkFormat " << (uint32_t)format;
+			return false;
+		}
+
+		// levelCount 为 0 表示只存了第 0 层，要求加载方生成 mip
+		const uint32_t storedLevels = std::max(levelCount, 1u);
+		if (storedLevels > mip_count(width, height) || KTX2_HEADER_SIZE + (size_t)storedLevels * KTX2_LEVEL_SIZE > size) {
+			return false;
+		}
+
+		out = {};
+		out.format = format;
+		out.width = width;
+		out.height = height;
+		out.generateMips = levelCount == 0 && info.blockSize == 1;
+
+		VkDeviceSize total = 0;
+		for (uint32_t level = 0; level < storedLevels; level++) {
+			ImageLevel l;
+			l.width = std::max(1u, width >> level);
+			l.height = std::max(1u, height >> level);
+			l.offset = total;
+			l.size = level_size(info, l.width, l.height);
+			total += l.size;
+			out.levels.push_back(l);
+		}
+
+		out.pixels.resize(total);
+		for (uint32_t level = 0; level < storedLevels; level++) {
+			const uint8_t* entry = data + KTX2_HEADER_SIZE + level * KTX2_LEVEL_SIZE;
+			const uint64_t byteOffset = read<uint64_t>(entry);
+			const uint64_t byteLength = read<uint64_t>(entry + 8);
+			if (byteLength != out.levels[level].size || byteOffset > size || byteLength > size - byteOffset) {
+				vklog::error() << "KTX2: level " << level << " is out of range";
+				return false;
+			}
+			memcpy(out.pixels.data() + out.levels[level].offset, data + byteOffset, byteLength);
+		}
+		return true;
+	}
+
+	bool load_tga(const uint8_t* data, size_t size, bool srgb, ImageData& out)
+	{
+		if (size < 18) {
+			return false;
+		}
+
+		const uint8_t idLength = data[0];
+		const uint8_t colorMapType = data[1];
+		const uint8_t imageType = data[2];
+		const uint32_t width = read<uint16_t>(data + 12);
+		const uint32_t height = read<uint16_t>(data + 14);
+		const uint32_t bpp = data[16];
+		const bool topDown = (data[17] & 0x20) != 0;
+
+		const bool rle = imageType == 10 || imageType == 11;
+		const bool gray = imageType == 3 || imageType == 11;
+		if (colorMapType != 0 || (imageType != 2 && imageType != 3 && imageType != 10 && imageType != 11)) {
+			vklog::error() << "TGA: color-mapped images are not supported";
+			return false;
+		}
+		if ((gray && bpp != 8) || (!gray && bpp != 24 && bpp != 32) || width == 0 || height == 0) {
+			vklog::error() << "TGA: unsupported pixel depth " << bpp;
+			return false;
+		}
+
+		const uint32_t pixelBytes = bpp / 8;
+		const uint8_t* src = data + 18 + idLength;
+		const uint8_t* end = data + size;
+		const size_t pixelCount = (size_t)width * height;
+
+		out = {};
+		out.format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+		out.width = width;
+		out.height = height;
+		out.generateMips = true;
+		out.pixels.resize(pixelCount * 4);
+		out.levels.push_back({ 0, (VkDeviceSize)out.pixels.size(), width, height });
+
+		// TGA 存的是 BGR(A)，默认从下往上
+		auto write_pixel = [&](size_t index, const uint8_t* p) {
+			const size_t x = index % width;
+			const size_t y = topDown ? index / width : height - 1 - index / width;
+			uint8_t* dst = out.pixels.data() + (y * width + x) * 4;
+			if (gray) {
+				dst[0] = dst[1] = dst[2] = p[0];
+				dst[3] = 255;
+			}
+			else {
+				dst[0] = p[2];
+				dst[1] = p[1];
+				dst[2] = p[0];
+				dst[3] = pixelBytes == 4 ? p[3] : 255;
+			}
+		};
+
+		size_t index = 0;
+		while (index < pixelCount) {
+			if (!rle) {
+				if (src + pixelBytes > end) {
+					return false;
+				}
+				write_pixel(index++, src);
+				src += pixelBytes;
+				continue;
+			}
+
+			// RLE 包：最高位为 1 表示重复同一个像素，否则是原样存放的像素串
+			if (src >= end) {
+				return false;
+			}
+			const uint8_t packet = *src++;
+			const size_t count = std::min<size_t>((packet & 0x7F) + 1, pixelCount - index);
+			if (packet & 0x80) {
+				if (src + pixelBytes > end) {
+					return false;
+				}
+				for (size_t i = 0; i < count; i++) {
+					write_pixel(index++, src);
+				}
+				src += pixelBytes;
+			}
+			else {
+				if (src + count * pixelBytes > end) {
+					return false;
+				}
+				for (size_t i = 0; i < count; i++) {
+					write_pixel(index++, src);
+					src += pixelBytes;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool decompress_bc(ImageData& image)
+	{
+		VkFormat target;
+		switch (image.format) {
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC2_UNORM_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+			target = VK_FORMAT_R8G8B8A8_UNORM;
+			break;
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC2_SRGB_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			target = VK_FORMAT_R8G8B8A8_SRGB;
+			break;
+		default:
+			vklog::error() << "No software decoder for format " << (uint32_t)image.format;
+			return false;
+		}
+
+		const bool bc2 = image.format == VK_FORMAT_BC2_UNORM_BLOCK || image.format == VK_FORMAT_BC2_SRGB_BLOCK;
+		const bool bc3 = image.format == VK_FORMAT_BC3_UNORM_BLOCK || image.format == VK_FORMAT_BC3_SRGB_BLOCK;
+		const bool bc1 = !bc2 && !bc3;
+		const bool punchThrough = image.format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK || image.format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+		const uint32_t blockBytes = bc1 ? 8 : 16;
+
+		std::vector<ImageLevel> levels;
+		VkDeviceSize total = 0;
+		for (const ImageLevel& level : image.levels) {
+			ImageLevel l = level;
+			l.offset = total;
+			l.size = (VkDeviceSize)level.width * level.height * 4;
+			total += l.size;
+			levels.push_back(l);
+		}
+
+		std::vector<uint8_t> pixels(total);
+		for (size_t li = 0; li < levels.size(); li++) {
+			const ImageLevel& src = image.levels[li];
+			const ImageLevel& dst = levels[li];
+			const uint32_t blocksX = (src.width + 3) / 4;
+			const uint32_t blocksY = (src.height + 3) / 4;
+
+			for (uint32_t by = 0; by < blocksY; by++) {
+				for (uint32_t bx = 0; bx < blocksX; bx++) {
+					const uint8_t* block = image.pixels.data() + src.offset + ((size_t)by * blocksX + bx) * blockBytes;
+
+					uint8_t texels[16][4];
+					if (bc1) {
+						decode_color_block(block, false, punchThrough, texels);
+					}
+					else {
+						decode_color_block(block + 8, true, false, texels);
+						if (bc2) {
+							decode_explicit_alpha(block, texels);
+						}
+						else {
+							decode_alpha_block(block, texels);
+						}
+					}
+
+					// 边缘块只写落在图像内的像素
+					for (uint32_t y = 0; y < 4 && by * 4 + y < dst.height; y++) {
+						for (uint32_t x = 0; x < 4 && bx * 4 + x < dst.width; x++) {
+							uint8_t* out = pixels.data() + dst.offset + (((size_t)by * 4 + y) * dst.width + bx * 4 + x) * 4;
+							memcpy(out, texels[y * 4 + x], 4);
+						}
+					}
+				}
+			}
+		}
+
+		image.format = target;
+		image.pixels = std::move(pixels);
+		image.levels = std::move(levels);
+		return true;
+	}
+}
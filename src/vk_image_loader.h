@@ -0,0 +1,43 @@
+#pragma once
+
+#include "vk_types.h"
+
+// 解码后的 CPU 端图像，由工作线程产出，交给 TextureManager 上传
+struct ImageLevel {
+	VkDeviceSize offset; // 在 pixels 里的偏移
+	VkDeviceSize size;
+	uint32_t width;
+	uint32_t height;
+};
+
+struct ImageData {
+	VkFormat format{ VK_FORMAT_UNDEFINED };
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+	std::vector<uint8_t> pixels;     // 所有 mip 依次紧密排列，第 0 层最大
+	std::vector<ImageLevel> levels;  // 文件里自带的 mip 层
+	bool generateMips{ false };      // 文件只有第 0 层，剩下的 mip 由 GPU 生成
+};
+
+// 图像文件解码，全部是纯 CPU 代码，可以在任意线程调用
+// 支持：
+//   .ktx2  未超压缩的 2D 纹理 (BCn / 常见的非压缩格式)，mip 链直接使用文件里的
+//   .tga   非压缩 / RLE 的真彩色和灰度图，解码成 RGBA8，mip 由 GPU 生成
+// Basis Universal (vkFormat = UNDEFINED) 和 zstd 超压缩的 KTX2 需要额外的转码库，目前不支持
+namespace vkimage {
+
+	bool load(const char* path, bool srgb, ImageData& out);
+	// 已经读进内存的文件 (流式加载)，name 只用来按扩展名判断格式
+	bool decode(const char* name, const uint8_t* data, size_t size, bool srgb, ImageData& out);
+
+	bool load_ktx2(const uint8_t* data, size_t size, ImageData& out);
+	bool load_tga(const uint8_t* data, size_t size, bool srgb, ImageData& out);
+
+	bool is_block_compressed(VkFormat format);
+
+	// BC1/BC2/BC3 -> RGBA8 (保留原有的 mip 链)
+	// 设备不支持 BC 纹理时，在工作线程上把它转成非压缩格式
+	bool decompress_bc(ImageData& image);
+
+	uint32_t mip_count(uint32_t width, uint32_t height);
+}
@@ -140,4 +140,26 @@ VkPipelineDepthStencilStateCreateInfo vkinit::pipeline_depth_stencil_state_creat
 	info.stencilTestEnable = VK_FALSE;
 
 	return info;
-}
\ No newline at end of file
+}
+
+VkSemaphoreSubmitInfo vkinit::semaphore_submit_info(VkPipelineStageFlags2 stageMask, VkSemaphore semaphore, uint64_t value)
+{
+	VkSemaphoreSubmitInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	info.pNext = nullptr;
+	info.semaphore = semaphore;
+	info.value = value;
+	info.stageMask = stageMask;
+	info.deviceIndex = 0;
+	return info;
+}
+
+VkCommandBufferSubmitInfo vkinit::command_buffer_submit_info(VkCommandBuffer cmd)
+{
+	VkCommandBufferSubmitInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+	info.pNext = nullptr;
+	info.commandBuffer = cmd;
+	info.deviceMask = 0;
+	return info;
+}
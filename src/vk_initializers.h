@@ -36,4 +36,10 @@ namespace vkinit {
 
 	// 11. 深度测试设置
 	VkPipelineDepthStencilStateCreateInfo pipeline_depth_stencil_state_create_info(bool bDepthTest, bool bDepthWrite, VkCompareOp compareOp);
+
+	// 12. 提交时等待 / 发出的信号量 (vkQueueSubmit2)，二值信号量的 value 被忽略
+	VkSemaphoreSubmitInfo semaphore_submit_info(VkPipelineStageFlags2 stageMask, VkSemaphore semaphore, uint64_t value = 0);
+
+	// 13. 提交的命令缓冲区 (vkQueueSubmit2)
+	VkCommandBufferSubmitInfo command_buffer_submit_info(VkCommandBuffer cmd);
 }
\ No newline at end of file
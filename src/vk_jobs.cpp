@@ -0,0 +1,160 @@
+#include "vk_jobs.h"
+
+#include <algorithm>
+
+void JobSystem::init(uint32_t threadCount)
+{
+	if (threadCount == 0) {
+		threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	_stop = false;
+	for (uint32_t i = 0; i < threadCount; i++) {
+		_threads.emplace_back([this]() { worker_loop(); });
+	}
+}
+
+void JobSystem::cleanup()
+{
+	if (_threads.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wake.notify_all();
+
+	for (std::thread& thread : _threads) {
+		thread.join();
+	}
+	_threads.clear();
+}
+
+void JobSystem::submit(std::function<void()> job)
+{
+	// 没有工作线程时 (未初始化) 直接在调用线程执行
+	if (_threads.empty()) {
+		job();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_queueCount == _queue.size()) {
+			// 满了：按顺序搬进两倍大的环形缓冲
+			std::vector<std::function<void()>> grown(std::max<size_t>(_queue.size() * 2, 64));
+			for (size_t i = 0; i < _queueCount; i++) {
+				grown[i] = std::move(_queue[(_queueHead + i) % _queue.size()]);
+			}
+			_queue = std::move(grown);
+			_queueHead = 0;
+		}
+		_queue[(_queueHead + _queueCount) % _queue.size()] = std::move(job);
+		_queueCount++;
+	}
+	_wake.notify_one();
+}
+
+void JobSystem::wait_idle()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	_idle.wait(lock, [this]() { return _queueCount == 0 && _running == 0; });
+}
+
+void JobSystem::parallel_for(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& fn)
+{
+	if (count == 0) {
+		return;
+	}
+	batchSize = std::max(batchSize, 1u);
+
+	const uint32_t batches = (count + batchSize - 1) / batchSize;
+
+	// 从池子里领一个没人用的状态 (引用数 0 -> 1)
+	ParallelState* state = nullptr;
+	for (ParallelState& candidate : _parallel) {
+		uint32_t expected = 0;
+		if (candidate.refs.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+			state = &candidate;
+			break;
+		}
+	}
+	if (!state) {
+		for (uint32_t begin = 0; begin < count; begin += batchSize) {
+			fn(begin, std::min(begin + batchSize, count));
+		}
+		return;
+	}
+	state->next.store(0, std::memory_order_relaxed);
+	state->done.store(0, std::memory_order_relaxed);
+	state->count = count;
+	state->batchSize = batchSize;
+	state->batches = batches;
+	state->fn = &fn;
+
+	const uint32_t helpers = std::min(thread_count(), batches - 1);
+	state->refs.fetch_add(helpers, std::memory_order_release);
+	for (uint32_t i = 0; i < helpers; i++) {
+		submit([state]() {
+			run_batches(*state);
+			release(*state);
+		});
+	}
+	run_batches(*state);
+
+	// 别的线程领走的批次还在做
+	for (uint32_t done = state->done.load(std::memory_order_acquire); done < batches;
+		done = state->done.load(std::memory_order_acquire)) {
+		state->done.wait(done, std::memory_order_acquire);
+	}
+	release(*state);
+}
+
+void JobSystem::run_batches(ParallelState& state)
+{
+	for (;;) {
+		const uint32_t batch = state.next.fetch_add(1, std::memory_order_relaxed);
+		if (batch >= state.batches) {
+			return;
+		}
+		const uint32_t begin = batch * state.batchSize;
+		(*state.fn)(begin, std::min(begin + state.batchSize, state.count));
+		if (state.done.fetch_add(1, std::memory_order_acq_rel) + 1 == state.batches) {
+			state.done.notify_all();
+		}
+	}
+}
+
+void JobSystem::release(ParallelState& state)
+{
+	state.refs.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void JobSystem::worker_loop()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_wake.wait(lock, [this]() { return _stop || _queueCount > 0; });
+		// 退出前先把队列里剩下的任务跑完
+		if (_queueCount == 0) {
+			return;
+		}
+
+		std::function<void()> job = std::move(_queue[_queueHead]);
+		_queue[_queueHead] = nullptr;
+		_queueHead = (_queueHead + 1) % _queue.size();
+		_queueCount--;
+		_running++;
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		_running--;
+		if (_queueCount == 0 && _running == 0) {
+			_idle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 简单的工作线程池
+// 任务是普通的 std::function，按提交顺序被空闲的工作线程取走
+// 工作线程绝不碰 Vulkan 命令：它们只做解码 / 转码这类纯 CPU 的活，结果交回主线程提交
+// 例外是启动图 (StartupGraph)：设备创建好之后，管线 / 资源的创建也会分到工作线程上，由依赖关系保证互不冲突
+// 稳定之后提交和 parallel_for 都不分配内存：队列是只增不减的环形缓冲，parallel_for 的状态来自固定的池子
+// (只捕获一两个指针的任务放得进 std::function 的内联存储)
+class JobSystem {
+public:
+	JobSystem() = default;
+	~JobSystem() { cleanup(); }
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// threadCount 为 0 时使用 (硬件线程数 - 1)，给主线程留一个核
+	void init(uint32_t threadCount = 0);
+	void cleanup(); // 等待剩余任务跑完，然后回收线程
+
+	void submit(std::function<void()> job);
+	void wait_idle(); // 阻塞到队列为空并且没有正在执行的任务
+
+	// 把 [0, count) 按 batchSize 切成几批，fn(begin, end) 在工作线程和调用线程上并行执行，返回时全部完成
+	// 调用线程自己也领批次做，工作线程都在忙别的任务时不会干等；只等批次做完，不等别的任务
+	void parallel_for(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& fn);
+
+	uint32_t thread_count() const { return (uint32_t)_threads.size(); }
+
+private:
+	// parallel_for 的共享状态：排队太晚的帮手开始时批次可能已经领完 (调用方都返回了)，它只看一眼计数就走，不碰 fn
+	// 调用方和每个帮手各持一个引用，最后一个放手的把它还回池子
+	struct ParallelState {
+		std::atomic<uint32_t> refs{ 0 };
+		std::atomic<uint32_t> next{ 0 };
+		std::atomic<uint32_t> done{ 0 };
+		uint32_t count{ 0 };
+		uint32_t batchSize{ 0 };
+		uint32_t batches{ 0 };
+		const std::function<void(uint32_t, uint32_t)>* fn{ nullptr };
+	};
+	static constexpr uint32_t MAX_PARALLEL = 16; // 同时进行的 parallel_for (池子用完时调用线程自己做完全部批次)
+
+	static void run_batches(ParallelState& state);
+	static void release(ParallelState& state);
+
+	void worker_loop();
+
+	std::vector<std::thread> _threads;
+	// 任务队列：环形缓冲，满了才扩容 (容量只增不减)
+	std::vector<std::function<void()>> _queue;
+	size_t _queueHead{ 0 };
+	size_t _queueCount{ 0 };
+	ParallelState _parallel[MAX_PARALLEL];
+	std::mutex _mutex;
+	std::condition_variable _wake; // 有新任务 / 要退出
+	std::condition_variable _idle; // 全部任务完成
+	uint32_t _running{ 0 };
+	bool _stop{ false };
+};
@@ -0,0 +1,417 @@
+#include "vk_log.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+	using vklog::Level;
+
+	struct Record {
+		uint64_t sequence;  // 全局提交顺序，后台线程按它合并各个线程的行
+		uint64_t timeUs;    // init 以来
+		uint32_t repeats;   // 上一个窗口里被限流吞掉的同样消息
+		uint32_t length;
+		Level level;
+		char text[vklog::LINE_CAPACITY];
+	};
+
+	struct RepeatEntry {
+		uint64_t hash{ 0 };
+		uint64_t windowStart{ 0 };
+		uint32_t count{ 0 };
+		uint32_t suppressed{ 0 };
+	};
+
+	// 一个线程的环形缓冲：head 只有所有者线程写，tail 只有后台线程写
+	struct Ring {
+		alignas(64) std::atomic<uint64_t> head{ 0 };
+		alignas(64) std::atomic<uint64_t> tail{ 0 };
+		alignas(64) std::atomic<uint32_t> dropped{ 0 };
+		// 限流表 (直接映射，按消息哈希)，只有所有者线程访问；条目被别的消息挤掉时，它吞掉的条数就不报了
+		RepeatEntry repeats[64];
+		Record records[vklog::RING_CAPACITY];
+	};
+	static_assert((vklog::RING_CAPACITY & (vklog::RING_CAPACITY - 1)) == 0);
+
+	struct Logger {
+		std::atomic<bool> running{ false };
+		std::atomic<uint64_t> sequence{ 0 };
+		std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+
+		// 只在线程登记和后台线程拿列表时加锁；线程退出后它的环形缓冲也留着 (线程数是有限的)
+		std::mutex ringMutex;
+		std::vector<std::unique_ptr<Ring>> rings;
+		std::atomic<uint32_t> ringCount{ 0 };
+
+		std::thread thread;
+		FILE* file{ nullptr };
+
+		// 后台线程空闲时等在这里 (带超时，写日志的线程不用保证唤醒)；flush 也等在这里
+		std::mutex wakeMutex;
+		std::condition_variable wake;
+		std::condition_variable drained;
+		uint64_t flushRequested{ 0 };
+		uint64_t flushServed{ 0 };
+
+		std::mutex syncMutex; // 同步写 (后台线程没有运行时)
+	};
+
+	Logger& logger()
+	{
+		static Logger instance;
+		return instance;
+	}
+
+	thread_local Ring* t_ring = nullptr;
+
+	Ring* thread_ring()
+	{
+		if (!t_ring) {
+			Logger& log = logger();
+			std::lock_guard<std::mutex> lock(log.ringMutex);
+			log.rings.push_back(std::make_unique<Ring>());
+			t_ring = log.rings.back().get();
+			log.ringCount.store((uint32_t)log.rings.size(), std::memory_order_release);
+		}
+		return t_ring;
+	}
+
+	uint64_t now_us()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - logger().start).count();
+	}
+
+	uint64_t hash_line(Level level, const char* text, uint32_t length)
+	{
+		// FNV-1a，级别也算进去
+		uint64_t hash = 14695981039346656037ull ^ (uint64_t)level;
+		for (uint32_t i = 0; i < length; i++) {
+			hash = (hash ^ (uint8_t)text[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	void write_line(FILE* out, Level level, const char* text, uint32_t length, uint32_t repeats)
+	{
+		fprintf(out, "[%s] %.*s", vklog::level_name(level), (int)length, text);
+		if (repeats > 0) {
+			fprintf(out, " (%u more repeats suppressed)", repeats);
+		}
+		fputc('\n', out);
+	}
+
+	void write_record(Logger& log, const Record& record)
+	{
+		write_line(stdout, record.level, record.text, record.length, record.repeats);
+		if (log.file) {
+			fprintf(log.file, "%10.3f ", record.timeUs / 1000000.0);
+			write_line(log.file, record.level, record.text, record.length, record.repeats);
+		}
+	}
+
+	void drain_loop()
+	{
+		Logger& log = logger();
+		std::vector<Ring*> rings;
+
+		for (;;) {
+			const bool stopping = !log.running.load(std::memory_order_acquire);
+			uint64_t serving;
+			{
+				std::lock_guard<std::mutex> lock(log.wakeMutex);
+				serving = log.flushRequested;
+			}
+			if (log.ringCount.load(std::memory_order_acquire) != rings.size()) {
+				std::lock_guard<std::mutex> lock(log.ringMutex);
+				rings.clear();
+				for (const std::unique_ptr<Ring>& ring : log.rings) {
+					rings.push_back(ring.get());
+				}
+			}
+
+			// 多路合并：每次写序号最小的那个线程的队首
+			// 序号在提交之前领，别的线程领了还没提交的行会晚一点出现，所以只是大致有序
+			uint32_t written = 0;
+			for (;;) {
+				Ring* next = nullptr;
+				uint64_t nextSequence = UINT64_MAX;
+				for (Ring* ring : rings) {
+					const uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+					if (tail == ring->head.load(std::memory_order_acquire)) {
+						continue;
+					}
+					const Record& record = ring->records[tail & (vklog::RING_CAPACITY - 1)];
+					if (record.sequence < nextSequence) {
+						nextSequence = record.sequence;
+						next = ring;
+					}
+				}
+				if (!next) {
+					break;
+				}
+				const uint64_t tail = next->tail.load(std::memory_order_relaxed);
+				write_record(log, next->records[tail & (vklog::RING_CAPACITY - 1)]);
+				next->tail.store(tail + 1, std::memory_order_release);
+				written++;
+			}
+
+			for (Ring* ring : rings) {
+				const uint32_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+				if (dropped > 0) {
+					Record note = {};
+					note.level = Level::Warn;
+					const int length = snprintf(note.text, sizeof(note.text), "Log ring buffer full, %u lines dropped", dropped);
+					note.length = (uint32_t)std::max(length, 0);
+					note.timeUs = now_us();
+					write_record(log, note);
+					written++;
+				}
+			}
+
+			if (written > 0) {
+				fflush(stdout);
+				if (log.file) {
+					fflush(log.file);
+				}
+			}
+
+			std::unique_lock<std::mutex> lock(log.wakeMutex);
+			if (serving > log.flushServed) {
+				log.flushServed = serving;
+				log.drained.notify_all();
+			}
+			if (stopping) {
+				break;
+			}
+			if (written == 0 && log.flushRequested == log.flushServed) {
+				log.wake.wait_for(lock, std::chrono::milliseconds(2));
+			}
+		}
+	}
+}
+
+namespace vklog {
+
+	namespace detail {
+		std::atomic<uint8_t> minLevel{ (uint8_t)Level::Info };
+	}
+
+	bool init(const char* path, Level minLevel)
+	{
+		Logger& log = logger();
+		if (log.running.load()) {
+			return true;
+		}
+		set_level(minLevel);
+
+		bool ok = true;
+		if (path && path[0]) {
+			log.file = fopen(path, "w");
+			if (!log.file) {
+				error() << "Failed to open log file " << path;
+				ok = false;
+			}
+		}
+
+		log.running.store(true, std::memory_order_release);
+		log.thread = std::thread(drain_loop);
+		return ok;
+	}
+
+	void shutdown()
+	{
+		Logger& log = logger();
+		if (!log.running.exchange(false)) {
+			return;
+		}
+		log.wake.notify_one();
+		log.thread.join();
+		if (log.file) {
+			fclose(log.file);
+			log.file = nullptr;
+		}
+	}
+
+	void flush()
+	{
+		Logger& log = logger();
+		if (!log.running.load(std::memory_order_acquire)) {
+			fflush(stdout);
+			return;
+		}
+		std::unique_lock<std::mutex> lock(log.wakeMutex);
+		const uint64_t ticket = ++log.flushRequested;
+		log.wake.notify_one();
+		log.drained.wait(lock, [&] { return log.flushServed >= ticket || !log.running.load(); });
+	}
+
+	void set_level(Level level)
+	{
+		detail::minLevel.store((uint8_t)level, std::memory_order_relaxed);
+	}
+
+	Level level()
+	{
+		return (Level)detail::minLevel.load(std::memory_order_relaxed);
+	}
+
+	const char* level_name(Level level)
+	{
+		switch (level) {
+		case Level::Debug: return "DEBUG";
+		case Level::Info: return "INFO";
+		case Level::Warn: return "WARN";
+		case Level::Error: return "ERROR";
+		}
+		return "?";
+	}
+
+	bool parse_level(std::string_view text, Level& out)
+	{
+		const Level levels[] = { Level::Debug, Level::Info, Level::Warn, Level::Error };
+		const char* names[] = { "debug", "info", "warn", "error" };
+		for (size_t i = 0; i < std::size(levels); i++) {
+			if (text == names[i]) {
+				out = levels[i];
+				return true;
+			}
+		}
+		return false;
+	}
+
+	Line::~Line()
+	{
+		if (!_enabled) {
+			return;
+		}
+
+		Logger& log = logger();
+		if (!log.running.load(std::memory_order_acquire)) {
+			std::lock_guard<std::mutex> lock(log.syncMutex);
+			write_line(stdout, _level, _text, _length, 0);
+			fflush(stdout);
+			return;
+		}
+
+		Ring* ring = thread_ring();
+
+		// 限流
+		const uint64_t hash = hash_line(_level, _text, _length);
+		const uint64_t now = now_us();
+		RepeatEntry& repeat = ring->repeats[hash & (std::size(ring->repeats) - 1)];
+		uint32_t suppressed = 0;
+		if (repeat.hash == hash && now - repeat.windowStart < REPEAT_WINDOW_US) {
+			if (++repeat.count > REPEAT_LIMIT) {
+				repeat.suppressed++;
+				return;
+			}
+		}
+		else if (repeat.hash == hash || repeat.count <= 1 || now - repeat.windowStart >= REPEAT_WINDOW_US) {
+			// 只挤掉只出现过一次的 / 过期的条目，正在刷屏的消息不会被一堆各不相同的行挤出去
+			suppressed = repeat.hash == hash ? repeat.suppressed : 0;
+			repeat = { hash, now, 1, 0 };
+		}
+
+		const uint64_t head = ring->head.load(std::memory_order_relaxed);
+		if (head - ring->tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+			ring->dropped.fetch_add(1 + suppressed, std::memory_order_relaxed);
+			return;
+		}
+		Record& record = ring->records[head & (RING_CAPACITY - 1)];
+		record.sequence = log.sequence.fetch_add(1, std::memory_order_relaxed);
+		record.timeUs = now;
+		record.repeats = suppressed;
+		record.length = _length;
+		record.level = _level;
+		memcpy(record.text, _text, _length);
+		ring->head.store(head + 1, std::memory_order_release);
+
+		// 错误尽快写出去；notify 不加锁，后台线程错过了也只是晚一个等待周期
+		if (_level == Level::Error) {
+			log.wake.notify_one();
+		}
+	}
+
+	Line& Line::operator<<(std::string_view text)
+	{
+		if (_enabled) {
+			const uint32_t count = std::min((uint32_t)text.size(), LINE_CAPACITY - _length);
+			memcpy(_text + _length, text.data(), count);
+			_length += count;
+		}
+		return *this;
+	}
+
+	Line& Line::operator<<(char c)
+	{
+		return *this << std::string_view(&c, 1);
+	}
+
+	Line& Line::operator<<(bool value)
+	{
+		return *this << (value ? std::string_view("1") : std::string_view("0"));
+	}
+
+	Line& Line::operator<<(const void* pointer)
+	{
+		char buffer[32];
+		const int count = snprintf(buffer, sizeof(buffer), "%p", pointer);
+		return *this << std::string_view(buffer, count > 0 ? (size_t)count : 0);
+	}
+
+	Line& Line::operator<<(double value)
+	{
+		// 和 std::cout 的默认格式一样 (6 位有效数字)
+		char buffer[32];
+		const int count = snprintf(buffer, sizeof(buffer), "%g", value);
+		return *this << std::string_view(buffer, count > 0 ? (size_t)count : 0);
+	}
+
+	Line& Line::append_signed(int64_t value)
+	{
+		char buffer[24];
+		const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		return *this << std::string_view(buffer, result.ptr - buffer);
+	}
+
+	Line& Line::append_unsigned(uint64_t value)
+	{
+		char buffer[24];
+		const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		return *this << std::string_view(buffer, result.ptr - buffer);
+	}
+
+	VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+		VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* data, void* /*userData*/)
+	{
+		Level level = Level::Debug;
+		if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) {
+			level = Level::Error;
+		}
+		else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) {
+			level = Level::Warn;
+		}
+		else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) {
+			level = Level::Info;
+		}
+
+		const char* kind = "General";
+		if (type & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT) {
+			kind = "Validation";
+		}
+		else if (type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) {
+			kind = "Performance";
+		}
+		Line(level) << "Vulkan " << kind << ": " << (data && data->pMessage ? data->pMessage : "");
+		return VK_FALSE; // 不中断触发它的 Vulkan 调用
+	}
+}
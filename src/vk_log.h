@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include <vulkan/vulkan.h>
+
+// 异步日志
+// - 每个线程第一次写日志时登记一个自己的环形缓冲 (单生产者 / 单消费者，无锁)；一行先格式化在调用线程的栈上，不分配内存、不加锁
+// - 一个后台线程把所有环形缓冲里的行 (大致按提交顺序) 取出来写到控制台和 (可选的) 文件，只有它会碰 stdout / 文件
+// - 环形缓冲满了就丢掉这一行并计数 (后台线程之后补一行提示)，写日志的线程永远不等
+// - 限流：同一个线程在一个窗口里重复写同一条消息，只放过前几条，吞掉的条数附在下一个窗口放过的第一条后面
+// - init 之前 / shutdown 之后 (解析命令行、离线工具) 直接同步写控制台
+// 用法：vklog::error() << "Failed to create " << name;  表达式结束时整行提交，不要写 std::endl
+//       一行分几次拼时先存成局部变量：vklog::Line line = vklog::info(); line << ...;  离开作用域时提交
+namespace vklog {
+
+	enum class Level : uint8_t { Debug, Info, Warn, Error };
+
+	constexpr uint32_t LINE_CAPACITY = 1024;     // 一行最多这么多字节，超出的截断 (验证层的消息可能很长)
+	constexpr uint32_t RING_CAPACITY = 512;      // 每个线程的环形缓冲能放这么多行 (2 的幂)
+	constexpr uint32_t REPEAT_LIMIT = 5;         // 同一条消息每个窗口放过这么多条
+	constexpr uint64_t REPEAT_WINDOW_US = 1000000;
+
+	// 启动后台线程；path 不为空时同时写到这个文件 (每行带上启动以来的秒数)
+	bool init(const char* path = nullptr, Level minLevel = Level::Info);
+	// 写完已经提交的行，回收后台线程；调用时其它线程不应该再写日志
+	void shutdown();
+	// 阻塞到后台线程把调用之前提交的行都写出去 (不要在帧循环里调用)
+	void flush();
+
+	void set_level(Level level);
+	Level level();
+	const char* level_name(Level level);
+	// "debug" / "info" / "warn" / "error"，认不出来返回 false
+	bool parse_level(std::string_view text, Level& out);
+
+	namespace detail {
+		extern std::atomic<uint8_t> minLevel;
+	}
+	// 过滤在格式化之前：被过滤的级别每次 << 只多一个分支
+	inline bool enabled(Level level) { return (uint8_t)level >= detail::minLevel.load(std::memory_order_relaxed); }
+
+	// 格式化在栈上的一行，析构时提交
+	class Line {
+	public:
+		explicit Line(Level level) : _level(level), _enabled(enabled(level)) {}
+		~Line();
+
+		Line(const Line&) = delete;
+		Line& operator=(const Line&) = delete;
+
+		Line& operator<<(std::string_view text);
+		Line& operator<<(const char* text) { return *this << std::string_view(text); } // 不然字符串字面量会匹配 const void*
+		Line& operator<<(char c);
+		Line& operator<<(bool value);
+		Line& operator<<(const void* pointer);
+		Line& operator<<(double value);
+		Line& operator<<(float value) { return *this << (double)value; }
+
+		template <std::integral T>
+		Line& operator<<(T value)
+		{
+			if constexpr (std::is_signed_v<T>) {
+				return append_signed((int64_t)value);
+			}
+			else {
+				return append_unsigned((uint64_t)value);
+			}
+		}
+
+		// VkResult 之类的枚举按数值写 (和 std::cout 一样)
+		template <typename T> requires std::is_enum_v<T>
+		Line& operator<<(T value) { return *this << (std::underlying_type_t<T>)value; }
+
+	private:
+		Line& append_signed(int64_t value);
+		Line& append_unsigned(uint64_t value);
+
+		char _text[LINE_CAPACITY];
+		uint32_t _length{ 0 };
+		Level _level;
+		bool _enabled;
+	};
+
+	inline Line debug() { return Line(Level::Debug); }
+	inline Line info() { return Line(Level::Info); }
+	inline Line warn() { return Line(Level::Warn); }
+	inline Line error() { return Line(Level::Error); }
+
+	// 给 vkb::InstanceBuilder::set_debug_callback 用：验证层的消息走日志 (按级别过滤、限流)，不在驱动调用里同步打印
+	VKAPI_ATTR VkBool32 VKAPI_CALL debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+		VkDebugUtilsMessageTypeFlagsEXT type, const VkDebugUtilsMessengerCallbackDataEXT* data, void* userData);
+}
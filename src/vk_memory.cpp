@@ -0,0 +1,733 @@
+#include "vk_memory.h"
+
+#include <algorithm>
+
+namespace {
+
+	// 自定义池的块大小，0 表示这个类别不建池 (走 VMA 默认池 / 独占分配，只记账)
+	VkDeviceSize pool_block_size(MemoryCategory category)
+	{
+		switch (category) {
+		case MemoryCategory::Geometry: return 32ull * 1024 * 1024;
+		case MemoryCategory::Textures: return 64ull * 1024 * 1024;
+		case MemoryCategory::Staging: return 32ull * 1024 * 1024;
+		default: return 0;
+		}
+	}
+
+	VkImageAspectFlags aspect_of(VkFormat format)
+	{
+		switch (format) {
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+
+	double to_mb(VkDeviceSize bytes) { return bytes / (1024.0 * 1024.0); }
+}
+
+const char* memory_category_name(MemoryCategory category)
+{
+	switch (category) {
+	case MemoryCategory::Geometry: return "geometry";
+	case MemoryCategory::Textures: return "textures";
+	case MemoryCategory::Attachments: return "attachments";
+	case MemoryCategory::Staging: return "staging";
+	case MemoryCategory::Other: return "other";
+	default: return "?";
+	}
+}
+
+bool MemoryManager::init(VkInstance instance, VkPhysicalDevice gpu, VkDevice device, bool memoryBudget)
+{
+	_device = device;
+	_memoryBudget = memoryBudget;
+
+	VmaAllocatorCreateInfo allocatorInfo = {};
+	allocatorInfo.physicalDevice = gpu;
+	allocatorInfo.device = device;
+	allocatorInfo.instance = instance;
+	allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+	allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+	if (memoryBudget) {
+		allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+	}
+	if (vmaCreateAllocator(&allocatorInfo, &_allocator) != VK_SUCCESS) {
+		vklog::error() << "Failed to create VMA allocator";
+		return false;
+	}
+
+	if (!memoryBudget) {
+		vklog::info() << "VK_EXT_memory_budget not available, budget is estimated from heap sizes";
+	}
+	return true;
+}
+
+void MemoryManager::cleanup()
+{
+	if (!_allocator) {
+		return;
+	}
+
+	// 正在进行的整理直接放弃：新位置上的句柄销毁，分配留在原处
+	if (_defragContext) {
+		if (_defragPassOpen) {
+			for (uint32_t i = 0; i < _defragPass.moveCount; i++) {
+				_defragPass.pMoves[i].operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+			}
+			for (PendingMove& move : _pendingMoves) {
+				if (move.newBuffer) vkDestroyBuffer(_device, move.newBuffer, nullptr);
+				if (move.newImage) vkDestroyImage(_device, move.newImage, nullptr);
+			}
+			_pendingMoves.clear();
+			vmaEndDefragmentationPass(_allocator, _defragContext, &_defragPass);
+			_defragPassOpen = false;
+		}
+		vmaEndDefragmentation(_allocator, _defragContext, nullptr);
+		_defragContext = nullptr;
+	}
+
+	if (!_records.empty()) {
+		vklog::error() << _records.size() << " allocations still alive at shutdown";
+		dump_stats();
+	}
+
+	for (auto& [key, pool] : _pools) {
+		vmaDestroyPool(_allocator, pool);
+	}
+	_pools.clear();
+	_records.clear();
+	_evictors.clear();
+
+	vmaDestroyAllocator(_allocator);
+	_allocator = nullptr;
+}
+
+// ============================================================
+// 分配
+// ============================================================
+
+VmaPool MemoryManager::pool_for(MemoryCategory category, uint32_t memoryTypeIndex)
+{
+	const uint32_t key = ((uint32_t)category << 8) | memoryTypeIndex;
+	auto it = _pools.find(key);
+	if (it != _pools.end()) {
+		return it->second;
+	}
+
+	VmaPoolCreateInfo poolInfo = {};
+	poolInfo.memoryTypeIndex = memoryTypeIndex;
+	poolInfo.blockSize = pool_block_size(category);
+
+	VmaPool pool = nullptr;
+	if (vmaCreatePool(_allocator, &poolInfo, &pool) != VK_SUCCESS) {
+		vklog::error() << "Failed to create " << memory_category_name(category) << " memory pool";
+		pool = nullptr;
+	}
+	_pools[key] = pool; // 失败也记下来，之后直接走默认池
+	return pool;
+}
+
+VkResult MemoryManager::allocate_with_budget(MemoryCategory category, VkDeviceSize size,
+	const std::function<VkResult(VmaAllocationCreateFlags)>& allocate)
+{
+	// 先要求不超预算；超了让可以流式重建的资源让位，再不行就越过预算 (驱动可能会换页，但不至于失败)
+	VkResult result = allocate(VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT);
+	if (result == VK_SUCCESS) {
+		return result;
+	}
+
+	const VkDeviceSize freed = evict(size);
+	result = allocate(0);
+	if (result != VK_SUCCESS) {
+		vklog::error() << "Out of memory allocating " << to_mb(size) << " MB of " << memory_category_name(category)
+			<< " (evicted " << to_mb(freed) << " MB)";
+		dump_stats();
+	}
+	return result;
+}
+
+bool MemoryManager::allocate(const VkMemoryRequirements& requirements, MemoryCategory category, VmaAllocation& out)
+{
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+	allocInfo.memoryTypeBits = requirements.memoryTypeBits;
+
+	// 超过半个块的分配放进池里只会浪费，交给默认池 (VMA 会自己决定是否独占)
+	const VkDeviceSize blockSize = pool_block_size(category);
+	if (blockSize != 0 && requirements.size <= blockSize / 2) {
+		uint32_t memoryTypeIndex = 0;
+		if (vmaFindMemoryTypeIndex(_allocator, requirements.memoryTypeBits, &allocInfo, &memoryTypeIndex) == VK_SUCCESS) {
+			allocInfo.pool = pool_for(category, memoryTypeIndex);
+		}
+	}
+
+	const VkResult result = allocate_with_budget(category, requirements.size, [&](VmaAllocationCreateFlags flags) {
+		VmaAllocationCreateInfo info = allocInfo;
+		info.flags |= flags;
+		return vmaAllocateMemory(_allocator, &requirements, &info, &out, nullptr);
+	});
+	if (result != VK_SUCCESS) {
+		out = nullptr;
+		return false;
+	}
+
+	Record record;
+	record.category = category;
+	record.size = requirements.size;
+	track(out, std::move(record));
+	return true;
+}
+
+bool MemoryManager::create_buffer(const VkBufferCreateInfo& info, VmaMemoryUsage usage, MemoryCategory category, AllocatedBuffer& out)
+{
+	out = {};
+	if (vkCreateBuffer(_device, &info, nullptr, &out._buffer) != VK_SUCCESS) {
+		vklog::error() << "Failed to create " << memory_category_name(category) << " buffer (" << info.size << " bytes)";
+		return false;
+	}
+
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(_device, out._buffer, &requirements);
+
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = usage;
+	allocInfo.memoryTypeBits = requirements.memoryTypeBits;
+
+	const VkDeviceSize blockSize = pool_block_size(category);
+	if (blockSize != 0 && requirements.size <= blockSize / 2) {
+		uint32_t memoryTypeIndex = 0;
+		if (vmaFindMemoryTypeIndex(_allocator, requirements.memoryTypeBits, &allocInfo, &memoryTypeIndex) == VK_SUCCESS) {
+			allocInfo.pool = pool_for(category, memoryTypeIndex);
+		}
+	}
+
+	const VkResult result = allocate_with_budget(category, requirements.size, [&](VmaAllocationCreateFlags flags) {
+		VmaAllocationCreateInfo createInfo = allocInfo;
+		createInfo.flags |= flags;
+		return vmaAllocateMemory(_allocator, &requirements, &createInfo, &out._allocation, nullptr);
+	});
+	if (result != VK_SUCCESS || vmaBindBufferMemory(_allocator, out._allocation, out._buffer) != VK_SUCCESS) {
+		if (out._allocation) vmaFreeMemory(_allocator, out._allocation);
+		vkDestroyBuffer(_device, out._buffer, nullptr);
+		out = {};
+		return false;
+	}
+
+	Record record;
+	record.category = category;
+	record.size = requirements.size;
+	record.bufferInfo = info;
+	record.bufferInfo.pNext = nullptr;
+	record.bufferInfo.queueFamilyIndexCount = 0;
+	record.bufferInfo.pQueueFamilyIndices = nullptr;
+	record.buffer = out._buffer;
+	track(out._allocation, std::move(record));
+	return true;
+}
+
+bool MemoryManager::create_image(const VkImageCreateInfo& info, MemoryCategory category, AllocatedImage& out)
+{
+	VkImage image = VK_NULL_HANDLE;
+	if (vkCreateImage(_device, &info, nullptr, &image) != VK_SUCCESS) {
+		vklog::error() << "Failed to create " << memory_category_name(category) << " image ("
+			<< info.extent.width << "x" << info.extent.height << ")";
+		return false;
+	}
+
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(_device, image, &requirements);
+
+	VmaAllocation allocation = nullptr;
+	if (!allocate(requirements, category, allocation)) {
+		vkDestroyImage(_device, image, nullptr);
+		return false;
+	}
+	if (vmaBindImageMemory(_allocator, allocation, image) != VK_SUCCESS) {
+		vklog::error() << "Failed to bind image memory";
+		free(allocation);
+		vkDestroyImage(_device, image, nullptr);
+		return false;
+	}
+
+	Record& record = _records[allocation];
+	record.isImage = true;
+	record.imageInfo = info;
+	record.imageInfo.pNext = nullptr;
+	record.imageInfo.queueFamilyIndexCount = 0;
+	record.imageInfo.pQueueFamilyIndices = nullptr;
+	record.imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	record.image = image;
+
+	out._image = image;
+	out._allocation = allocation;
+	out._imageExtent = info.extent;
+	out._imageFormat = info.format;
+	return true;
+}
+
+void MemoryManager::track(VmaAllocation allocation, Record record)
+{
+	const uint32_t c = (uint32_t)record.category;
+	_categoryBytes[c] += record.size;
+	_categoryCount[c]++;
+	_records[allocation] = std::move(record);
+}
+
+void MemoryManager::untrack(VmaAllocation allocation)
+{
+	auto it = _records.find(allocation);
+	if (it == _records.end()) {
+		return;
+	}
+	const uint32_t c = (uint32_t)it->second.category;
+	_categoryBytes[c] -= it->second.size;
+	_categoryCount[c]--;
+	_records.erase(it);
+}
+
+void MemoryManager::free(VmaAllocation allocation)
+{
+	if (!allocation) {
+		return;
+	}
+	untrack(allocation);
+
+	// 正在搬的分配：交给 VMA 在这一轮结束时连同新位置一起释放
+	if (cancel_move(allocation, VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY)) {
+		return;
+	}
+	vmaFreeMemory(_allocator, allocation);
+}
+
+bool MemoryManager::cancel_move(VmaAllocation allocation, VmaDefragmentationMoveOperation operation)
+{
+	for (PendingMove& move : _pendingMoves) {
+		if (move.allocation != allocation) {
+			continue;
+		}
+		// 拷贝可能还在 GPU 上执行，新句柄留到这一轮结束 (fence 之后) 再销毁
+		// 先放弃 (IGNORE) 后释放的分配要改成 DESTROY，由 VMA 在这一轮结束时释放
+		if (!move.cancelled || operation == VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY) {
+			for (uint32_t m = 0; m < _defragPass.moveCount; m++) {
+				if (_defragPass.pMoves[m].srcAllocation == allocation) {
+					_defragPass.pMoves[m].operation = operation;
+				}
+			}
+		}
+		move.cancelled = true;
+		return true;
+	}
+	return false;
+}
+
+void MemoryManager::destroy_buffer(AllocatedBuffer& buffer)
+{
+	if (buffer._buffer) {
+		vkDestroyBuffer(_device, buffer._buffer, nullptr);
+	}
+	free(buffer._allocation);
+	buffer = {};
+}
+
+void MemoryManager::destroy_image(AllocatedImage& image)
+{
+	if (image._image) {
+		vkDestroyImage(_device, image._image, nullptr);
+	}
+	free(image._allocation);
+	image._image = VK_NULL_HANDLE;
+	image._allocation = nullptr;
+}
+
+void MemoryManager::set_movable(VmaAllocation allocation, RelocateBuffer callback)
+{
+	auto it = _records.find(allocation);
+	if (it == _records.end() || it->second.isImage || !it->second.buffer) {
+		vklog::error() << "set_movable: not a buffer created by MemoryManager";
+		return;
+	}
+	const VkBufferUsageFlags copyUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	if ((it->second.bufferInfo.usage & copyUsage) != copyUsage) {
+		return; // 没法拷贝的 buffer 不参与整理
+	}
+	it->second.onBufferMoved = std::move(callback);
+}
+
+void MemoryManager::clear_movable(VmaAllocation allocation)
+{
+	auto it = _records.find(allocation);
+	if (it == _records.end()) {
+		return;
+	}
+	it->second.onBufferMoved = nullptr;
+	it->second.onImageMoved = nullptr;
+	cancel_move(allocation, VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE);
+}
+
+void MemoryManager::set_movable(VmaAllocation allocation, VkImageLayout restingLayout, RelocateImage callback)
+{
+	auto it = _records.find(allocation);
+	if (it == _records.end() || !it->second.isImage) {
+		vklog::error() << "set_movable: not an image created by MemoryManager";
+		return;
+	}
+	if (!(it->second.imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) || !(it->second.imageInfo.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+		return; // 没法拷贝的图像不参与整理
+	}
+	it->second.restingLayout = restingLayout;
+	it->second.onImageMoved = std::move(callback);
+}
+
+// ============================================================
+// 预算 / 驱逐
+// ============================================================
+
+void MemoryManager::add_evictor(EvictCallback callback)
+{
+	_evictors.push_back(std::move(callback));
+}
+
+VkDeviceSize MemoryManager::evict(VkDeviceSize bytesNeeded)
+{
+	VkDeviceSize freed = 0;
+	for (EvictCallback& evictor : _evictors) {
+		if (freed >= bytesNeeded) {
+			break;
+		}
+		freed += evictor(bytesNeeded - freed);
+	}
+	if (freed > 0) {
+		_evictions++;
+		vklog::info() << "Memory budget: evicted " << to_mb(freed) << " MB (needed " << to_mb(bytesNeeded) << " MB)";
+	}
+	return freed;
+}
+
+void MemoryManager::evict_over_budget()
+{
+	const VkPhysicalDeviceMemoryProperties* properties = nullptr;
+	vmaGetMemoryProperties(_allocator, &properties);
+
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetHeapBudgets(_allocator, budgets);
+
+	// 超过预算的 95% 就提前驱逐到 90%，别等到分配失败时才在关键路径上腾地方
+	for (uint32_t heap = 0; heap < properties->memoryHeapCount; heap++) {
+		if (!(properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) {
+			continue;
+		}
+		const VmaBudget& budget = budgets[heap];
+		if (budget.budget > 0 && budget.usage > budget.budget / 20 * 19) {
+			evict(budget.usage - budget.budget / 10 * 9);
+		}
+	}
+}
+
+// ============================================================
+// 碎片整理
+// ============================================================
+
+void MemoryManager::start_defragmentation()
+{
+	// 找空洞最多的池：空闲空间至少够整块释放一个块才值得搬
+	VmaPool best = nullptr;
+	VkDeviceSize bestFree = 0;
+	for (auto& [key, pool] : _pools) {
+		const MemoryCategory category = (MemoryCategory)(key >> 8);
+		if (!pool || category == MemoryCategory::Staging) {
+			continue;
+		}
+		VmaStatistics poolStats = {};
+		vmaGetPoolStatistics(_allocator, pool, &poolStats);
+		const VkDeviceSize freeBytes = poolStats.blockBytes - poolStats.allocationBytes;
+		if (poolStats.blockCount > 1 && freeBytes >= pool_block_size(category) && freeBytes > bestFree) {
+			best = pool;
+			bestFree = freeBytes;
+		}
+	}
+	if (!best) {
+		return;
+	}
+
+	VmaDefragmentationInfo defragInfo = {};
+	defragInfo.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_FAST_BIT;
+	defragInfo.pool = best;
+	defragInfo.maxAllocationsPerPass = DEFRAG_MOVES_PER_FRAME;
+	defragInfo.maxBytesPerPass = DEFRAG_BYTES_PER_FRAME;
+	if (vmaBeginDefragmentation(_allocator, &defragInfo, &_defragContext) != VK_SUCCESS) {
+		vklog::error() << "Failed to begin defragmentation";
+		_defragContext = nullptr;
+		return;
+	}
+	_defragPool = best;
+	vklog::info() << "Defragmenting pool with " << to_mb(bestFree) << " MB free";
+}
+
+void MemoryManager::end_defragmentation()
+{
+	VmaDefragmentationStats defragStats = {};
+	vmaEndDefragmentation(_allocator, _defragContext, &defragStats);
+	_defragContext = nullptr;
+	_defragPool = nullptr;
+
+	vklog::info() << "Defragmentation done: moved " << defragStats.allocationsMoved << " allocations ("
+		<< to_mb(defragStats.bytesMoved) << " MB), freed " << defragStats.deviceMemoryBlocksFreed << " blocks ("
+		<< to_mb(defragStats.bytesFreed) << " MB)";
+}
+
+void MemoryManager::record_moves(VkCommandBuffer cmd)
+{
+	if (!_defragContext || _defragPassOpen) {
+		return;
+	}
+
+	const VkResult result = vmaBeginDefragmentationPass(_allocator, _defragContext, &_defragPass);
+	if (result == VK_SUCCESS) {
+		end_defragmentation(); // 没有需要搬的了
+		return;
+	}
+	if (result != VK_INCOMPLETE) {
+		vklog::error() << "vmaBeginDefragmentationPass failed";
+		end_defragmentation();
+		return;
+	}
+	_defragPassOpen = true;
+
+	std::vector<VkImageMemoryBarrier2> toTransfer;
+	std::vector<VkImageMemoryBarrier2> toResting;
+
+	auto image_barrier = [](VkImage image, const VkImageCreateInfo& info, VkImageLayout oldLayout, VkImageLayout newLayout,
+		VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess, VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess) {
+		VkImageMemoryBarrier2 barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		barrier.srcStageMask = srcStage;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstStageMask = dstStage;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { aspect_of(info.format), 0, info.mipLevels, 0, info.arrayLayers };
+		return barrier;
+	};
+
+	// 先为每个移动在新位置上建好句柄
+	for (uint32_t i = 0; i < _defragPass.moveCount; i++) {
+		VmaDefragmentationMove& move = _defragPass.pMoves[i];
+		auto it = _records.find(move.srcAllocation);
+		const bool movable = it != _records.end() && (it->second.onBufferMoved || it->second.onImageMoved);
+		if (!movable) {
+			move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+			continue;
+		}
+
+		const Record& record = it->second;
+		PendingMove pending{ move.srcAllocation };
+		bool ok;
+		if (record.isImage) {
+			ok = vkCreateImage(_device, &record.imageInfo, nullptr, &pending.newImage) == VK_SUCCESS
+				&& vmaBindImageMemory(_allocator, move.dstTmpAllocation, pending.newImage) == VK_SUCCESS;
+		}
+		else {
+			ok = vkCreateBuffer(_device, &record.bufferInfo, nullptr, &pending.newBuffer) == VK_SUCCESS
+				&& vmaBindBufferMemory(_allocator, move.dstTmpAllocation, pending.newBuffer) == VK_SUCCESS;
+		}
+		if (!ok) {
+			if (pending.newImage) vkDestroyImage(_device, pending.newImage, nullptr);
+			if (pending.newBuffer) vkDestroyBuffer(_device, pending.newBuffer, nullptr);
+			move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+			continue;
+		}
+
+		if (record.isImage) {
+			toTransfer.push_back(image_barrier(record.image, record.imageInfo, record.restingLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, 0, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT));
+			toTransfer.push_back(image_barrier(pending.newImage, record.imageInfo, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				VK_PIPELINE_STAGE_2_NONE, 0, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT));
+			// 拷贝完两张图都回到平时的布局：旧图这一帧还在用，新图下一帧开始用
+			toResting.push_back(image_barrier(record.image, record.imageInfo, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, record.restingLayout,
+				VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, 0, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, 0));
+			toResting.push_back(image_barrier(pending.newImage, record.imageInfo, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, record.restingLayout,
+				VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_MEMORY_READ_BIT));
+		}
+		_pendingMoves.push_back(pending);
+	}
+
+	if (_pendingMoves.empty()) {
+		return; // 这一轮全部忽略，update 里照常结束
+	}
+
+	VkDependencyInfo dependency = {};
+	dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependency.imageMemoryBarrierCount = (uint32_t)toTransfer.size();
+	dependency.pImageMemoryBarriers = toTransfer.data();
+	vkCmdPipelineBarrier2(cmd, &dependency);
+
+	for (const PendingMove& pending : _pendingMoves) {
+		const Record& record = _records[pending.allocation];
+		if (record.isImage) {
+			std::vector<VkImageCopy> regions(record.imageInfo.mipLevels);
+			for (uint32_t mip = 0; mip < record.imageInfo.mipLevels; mip++) {
+				VkImageCopy& region = regions[mip];
+				region = {};
+				region.srcSubresource = { aspect_of(record.imageInfo.format), mip, 0, record.imageInfo.arrayLayers };
+				region.dstSubresource = region.srcSubresource;
+				region.extent = {
+					std::max(1u, record.imageInfo.extent.width >> mip),
+					std::max(1u, record.imageInfo.extent.height >> mip),
+					std::max(1u, record.imageInfo.extent.depth >> mip) };
+			}
+			vkCmdCopyImage(cmd, record.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, pending.newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				(uint32_t)regions.size(), regions.data());
+		}
+		else {
+			VkBufferCopy region = { 0, 0, record.bufferInfo.size };
+			vkCmdCopyBuffer(cmd, record.buffer, pending.newBuffer, 1, &region);
+		}
+	}
+
+	// buffer 的拷贝结果对之后所有命令可见 (下一帧开始 buffer 换成新的)
+	VkMemoryBarrier2 memoryBarrier = {};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+	memoryBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+	memoryBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+	memoryBarrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	memoryBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+
+	dependency = {};
+	dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependency.memoryBarrierCount = 1;
+	dependency.pMemoryBarriers = &memoryBarrier;
+	dependency.imageMemoryBarrierCount = (uint32_t)toResting.size();
+	dependency.pImageMemoryBarriers = toResting.data();
+	vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+void MemoryManager::finish_defrag_pass()
+{
+	if (!_defragPassOpen) {
+		return;
+	}
+
+	// 拷贝已经完成 (fence 之后)：让使用者切换到新句柄，旧句柄销毁，VMA 把分配换到新位置
+	const bool movedAny = !_pendingMoves.empty();
+	for (const PendingMove& pending : _pendingMoves) {
+		if (pending.cancelled) {
+			if (pending.newBuffer) vkDestroyBuffer(_device, pending.newBuffer, nullptr);
+			if (pending.newImage) vkDestroyImage(_device, pending.newImage, nullptr);
+			continue;
+		}
+		Record& record = _records[pending.allocation];
+		if (record.isImage) {
+			vkDestroyImage(_device, record.image, nullptr);
+			record.image = pending.newImage;
+			record.onImageMoved(pending.newImage);
+		}
+		else {
+			vkDestroyBuffer(_device, record.buffer, nullptr);
+			record.buffer = pending.newBuffer;
+			record.onBufferMoved(pending.newBuffer);
+		}
+		_defragMoves++;
+		_defragBytes += record.size;
+	}
+	_pendingMoves.clear();
+
+	const VkResult result = vmaEndDefragmentationPass(_allocator, _defragContext, &_defragPass);
+	_defragPassOpen = false;
+	// 这一轮挑中的全是不可移动的分配，再来一轮也一样
+	if (result == VK_SUCCESS || !movedAny) {
+		end_defragmentation();
+	}
+}
+
+// ============================================================
+// 每帧
+// ============================================================
+
+void MemoryManager::update(uint64_t frameNumber)
+{
+	_frameNumber = frameNumber;
+	vmaSetCurrentFrameIndex(_allocator, (uint32_t)frameNumber); // 预算缓存按帧刷新
+
+	finish_defrag_pass();
+
+	if (frameNumber % CHECK_INTERVAL == 0) {
+		evict_over_budget();
+		if (!_defragContext) {
+			start_defragmentation();
+		}
+	}
+
+	if (frameNumber > 0 && frameNumber % DUMP_INTERVAL == 0) {
+		dump_stats();
+	}
+}
+
+// ============================================================
+// 统计
+// ============================================================
+
+MemoryStats MemoryManager::stats() const
+{
+	MemoryStats out;
+	for (uint32_t c = 0; c < (uint32_t)MemoryCategory::Count; c++) {
+		out.categories[c].bytes = _categoryBytes[c];
+		out.categories[c].allocations = _categoryCount[c];
+	}
+	for (const auto& [key, pool] : _pools) {
+		if (!pool) {
+			continue;
+		}
+		VmaStatistics poolStats = {};
+		vmaGetPoolStatistics(_allocator, pool, &poolStats);
+		out.categories[key >> 8].poolBytes += poolStats.blockBytes;
+	}
+
+	const VkPhysicalDeviceMemoryProperties* properties = nullptr;
+	vmaGetMemoryProperties(_allocator, &properties);
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetHeapBudgets(_allocator, budgets);
+
+	out.heaps.resize(properties->memoryHeapCount);
+	for (uint32_t heap = 0; heap < properties->memoryHeapCount; heap++) {
+		out.heaps[heap].usage = budgets[heap].usage;
+		out.heaps[heap].budget = budgets[heap].budget;
+		out.heaps[heap].deviceLocal = (properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+	}
+
+	out.defragMoves = _defragMoves;
+	out.defragBytes = _defragBytes;
+	out.evictions = _evictions;
+	return out;
+}
+
+void MemoryManager::dump_stats() const
+{
+	const MemoryStats s = stats();
+
+	vklog::info() << "Memory (frame " << _frameNumber << ")";
+	for (uint32_t heap = 0; heap < s.heaps.size(); heap++) {
+		vklog::info() << "  heap " << heap << (s.heaps[heap].deviceLocal ? " (device)" : " (host)") << ": "
+			<< to_mb(s.heaps[heap].usage) << " / " << to_mb(s.heaps[heap].budget) << " MB";
+	}
+	for (uint32_t c = 0; c < (uint32_t)MemoryCategory::Count; c++) {
+		const MemoryStats::Category& category = s.categories[c];
+		vklog::Line line = vklog::info();
+		line << "  " << memory_category_name((MemoryCategory)c) << ": " << to_mb(category.bytes) << " MB in "
+			<< category.allocations << " allocations";
+		if (category.poolBytes > 0) {
+			line << ", pools " << to_mb(category.poolBytes) << " MB";
+		}
+	}
+	vklog::info() << "  defrag: " << s.defragMoves << " moves (" << to_mb(s.defragBytes) << " MB), evictions: " << s.evictions;
+}
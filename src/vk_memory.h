@@ -0,0 +1,142 @@
+#pragma once
+
+#include "vk_types.h"
+
+#include <functional>
+#include <unordered_map>
+
+// 显存分类：每类单独统计，几何 / 纹理 / staging 各自有 VMA 自定义池
+enum class MemoryCategory : uint32_t {
+	Geometry,     // 顶点 / 索引
+	Textures,     // 采样纹理 (可以被驱逐、整理)
+	Attachments,  // 渲染目标 (渲染图的瞬态显存)
+	Staging,      // 上传 / 回读
+	Other,        // 材质表、页表等小 buffer
+	Count,
+};
+
+const char* memory_category_name(MemoryCategory category);
+
+struct MemoryStats {
+	struct Category {
+		VkDeviceSize bytes{ 0 };       // 分配出去的字节
+		uint32_t allocations{ 0 };
+		VkDeviceSize poolBytes{ 0 };   // 自定义池占用的 VkDeviceMemory (含空洞)
+	};
+	struct Heap {
+		VkDeviceSize usage{ 0 };       // 整个进程在这个堆上的用量 (VK_EXT_memory_budget)
+		VkDeviceSize budget{ 0 };
+		bool deviceLocal{ false };
+	};
+
+	Category categories[(size_t)MemoryCategory::Count];
+	std::vector<Heap> heaps;
+	uint64_t defragMoves{ 0 };
+	VkDeviceSize defragBytes{ 0 };
+	uint32_t evictions{ 0 };        // 因为超预算触发驱逐的次数
+};
+
+// 显存管理
+// - VMA 开启 VK_EXT_memory_budget：每次分配先要求不超预算，超了就让注册的驱逐回调 (流式纹理等) 腾地方，
+//   腾完仍不够才越过预算分配 (被驱逐的资源要退休几帧才真正释放)
+// - 分配按类别记账；几何 / 纹理 / staging 走各自的自定义池，不会互相制造碎片
+// - 增量碎片整理：池里空洞太多时开始，每帧最多移动几个分配，拷贝录制在帧命令缓冲区开头，
+//   下一帧 fence 之后才切换到新位置；只有登记了重定位回调的资源会被移动
+class MemoryManager {
+public:
+	// 返回已经释放 (或已经排队等待释放) 的字节数
+	using EvictCallback = std::function<VkDeviceSize(VkDeviceSize bytesNeeded)>;
+	// 碎片整理把资源搬到了新的句柄上，调用方更新自己的引用 (image view、descriptor、绑定的 buffer)
+	using RelocateBuffer = std::function<void(VkBuffer newBuffer)>;
+	using RelocateImage = std::function<void(VkImage newImage)>;
+
+	static constexpr uint64_t CHECK_INTERVAL = 60;      // 每隔多少帧检查预算和碎片
+	static constexpr uint64_t DUMP_INTERVAL = 3600;     // 每隔多少帧打印一次统计
+	static constexpr uint32_t DEFRAG_MOVES_PER_FRAME = 4;
+	static constexpr VkDeviceSize DEFRAG_BYTES_PER_FRAME = 16ull * 1024 * 1024;
+
+	bool init(VkInstance instance, VkPhysicalDevice gpu, VkDevice device, bool memoryBudget);
+	void cleanup();
+
+	VmaAllocator allocator() const { return _allocator; }
+
+	bool create_buffer(const VkBufferCreateInfo& info, VmaMemoryUsage usage, MemoryCategory category, AllocatedBuffer& out);
+	bool create_image(const VkImageCreateInfo& info, MemoryCategory category, AllocatedImage& out);
+	bool allocate(const VkMemoryRequirements& requirements, MemoryCategory category, VmaAllocation& out);
+	void destroy_buffer(AllocatedBuffer& buffer);
+	void destroy_image(AllocatedImage& image); // image view 由调用方自己销毁
+	void free(VmaAllocation allocation);
+
+	// 登记为可移动：buffer 不能处于映射状态；图像平时必须停在 restingLayout
+	void set_movable(VmaAllocation allocation, RelocateBuffer callback);
+	void set_movable(VmaAllocation allocation, VkImageLayout restingLayout, RelocateImage callback);
+	// 资源要退休 / 不再接受重定位回调时调用，已经录制的移动会被放弃
+	void clear_movable(VmaAllocation allocation);
+
+	// 驱逐回调按注册顺序调用
+	void add_evictor(EvictCallback callback);
+
+	// 每帧等完 fence 之后调用：完成上一帧的碎片整理移动，定期检查预算 / 开始整理 / 打印统计
+	void update(uint64_t frameNumber);
+	// 帧命令缓冲区开头调用：录制这一帧的碎片整理拷贝
+	void record_moves(VkCommandBuffer cmd);
+	// 正在整理 (或者还有拷贝等着切换)
+	bool defragmenting() const { return _defragContext != nullptr || !_pendingMoves.empty(); }
+
+	MemoryStats stats() const;
+	void dump_stats() const;
+
+private:
+	struct Record {
+		MemoryCategory category{ MemoryCategory::Other };
+		VkDeviceSize size{ 0 };
+		bool isImage{ false };
+		VkBufferCreateInfo bufferInfo{};
+		VkImageCreateInfo imageInfo{};
+		VkBuffer buffer{ VK_NULL_HANDLE };
+		VkImage image{ VK_NULL_HANDLE };
+		VkImageLayout restingLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		RelocateBuffer onBufferMoved;
+		RelocateImage onImageMoved;
+	};
+
+	struct PendingMove {
+		VmaAllocation allocation;
+		VkBuffer newBuffer{ VK_NULL_HANDLE };
+		VkImage newImage{ VK_NULL_HANDLE };
+		bool cancelled{ false }; // 拷贝已经录制，等 fence 之后只销毁新句柄
+	};
+
+	VmaPool pool_for(MemoryCategory category, uint32_t memoryTypeIndex);
+	VkResult allocate_with_budget(MemoryCategory category, VkDeviceSize size, const std::function<VkResult(VmaAllocationCreateFlags)>& allocate);
+	void track(VmaAllocation allocation, Record record);
+	void untrack(VmaAllocation allocation);
+	bool cancel_move(VmaAllocation allocation, VmaDefragmentationMoveOperation operation);
+	VkDeviceSize evict(VkDeviceSize bytesNeeded);
+	void evict_over_budget();
+	void start_defragmentation();
+	void finish_defrag_pass();
+	void end_defragmentation();
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	VmaAllocator _allocator{ nullptr };
+	bool _memoryBudget{ false };
+	uint64_t _frameNumber{ 0 };
+
+	std::unordered_map<uint32_t, VmaPool> _pools; // (类别 << 8 | 内存类型) -> 池
+	std::unordered_map<VmaAllocation, Record> _records;
+	VkDeviceSize _categoryBytes[(size_t)MemoryCategory::Count]{};
+	uint32_t _categoryCount[(size_t)MemoryCategory::Count]{};
+
+	std::vector<EvictCallback> _evictors;
+	uint32_t _evictions{ 0 };
+
+	// 碎片整理：同一时间只整理一个池
+	VmaDefragmentationContext _defragContext{ nullptr };
+	VmaPool _defragPool{ nullptr };
+	VmaDefragmentationPassMoveInfo _defragPass{};
+	bool _defragPassOpen{ false };
+	std::vector<PendingMove> _pendingMoves;
+	uint64_t _defragMoves{ 0 };
+	VkDeviceSize _defragBytes{ 0 };
+};
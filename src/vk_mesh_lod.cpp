@@ -0,0 +1,466 @@
+#include "vk_mesh_lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+#include <glm/geometric.hpp>
+
+namespace {
+
+	// ---------------- 焊接 ----------------
+
+	struct VertexKey {
+		const Vertex* vertex;
+		bool operator==(const VertexKey& other) const { return memcmp(vertex, other.vertex, sizeof(Vertex)) == 0; }
+	};
+
+	struct VertexKeyHash {
+		size_t operator()(const VertexKey& key) const
+		{
+			// FNV-1a，Vertex 是 11 个 float，没有填充字节
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(key.vertex);
+			uint64_t hash = 14695981039346656037ull;
+			for (size_t i = 0; i < sizeof(Vertex); i++) {
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			}
+			return (size_t)hash;
+		}
+	};
+
+	struct PositionHash {
+		size_t operator()(const glm::vec3& p) const
+		{
+			// + 0.0f 把 -0 变成 +0，和 == 的语义一致
+			const glm::vec3 q = p + 0.0f;
+			uint32_t bits[3];
+			memcpy(bits, &q, sizeof(bits));
+			return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+		}
+	};
+
+	// ---------------- 二次误差 ----------------
+
+	// 对称 4x4 矩阵的 10 个分量，weight 是累计的面积 (误差按面积加权平均后开方，得到距离)
+	struct Quadric {
+		double a2{ 0 }, ab{ 0 }, ac{ 0 }, ad{ 0 };
+		double b2{ 0 }, bc{ 0 }, bd{ 0 };
+		double c2{ 0 }, cd{ 0 };
+		double d2{ 0 };
+		double weight{ 0 };
+
+		void add_plane(const glm::dvec3& n, double d, double w)
+		{
+			a2 += n.x * n.x * w; ab += n.x * n.y * w; ac += n.x * n.z * w; ad += n.x * d * w;
+			b2 += n.y * n.y * w; bc += n.y * n.z * w; bd += n.y * d * w;
+			c2 += n.z * n.z * w; cd += n.z * d * w;
+			d2 += d * d * w;
+			weight += w;
+		}
+
+		void add(const Quadric& o)
+		{
+			a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad;
+			b2 += o.b2; bc += o.bc; bd += o.bd;
+			c2 += o.c2; cd += o.cd;
+			d2 += o.d2;
+			weight += o.weight;
+		}
+
+		// 到所有平面的加权距离平方和
+		double evaluate(const glm::dvec3& p) const
+		{
+			const double e = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+				+ b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+				+ c2 * p.z * p.z + 2 * cd * p.z
+				+ d2;
+			return e > 0.0 ? e : 0.0;
+		}
+	};
+
+	// 边界边的约束平面 (垂直于三角形、经过这条边) 的权重，越大边界越不容易变形
+	constexpr double BORDER_WEIGHT = 10.0;
+
+	enum class VertexKind : uint8_t {
+		Interior, // 流形内部
+		Border,   // 开放边界上 (恰好两条边界边)，只能沿边界折叠
+		Locked,   // 接缝 / 非流形，不动
+	};
+
+	struct Collapse {
+		double cost;
+		uint32_t src;
+		uint32_t dst;
+		uint32_t srcVersion;
+		uint32_t dstVersion;
+		bool operator>(const Collapse& other) const { return cost > other.cost; }
+	};
+
+	uint64_t edge_key(uint32_t a, uint32_t b)
+	{
+		return a < b ? ((uint64_t)a << 32 | b) : ((uint64_t)b << 32 | a);
+	}
+
+	// 把 indices 简化到 targetTriangles 个三角形以内 (减不动时提前结束)，返回这一步的误差 (距离)
+	float simplify(const std::vector<glm::vec3>& positions, const std::vector<uint8_t>& seam,
+		const std::vector<uint32_t>& indices, uint32_t targetTriangles, std::vector<uint32_t>& out)
+	{
+		const uint32_t vertexCount = (uint32_t)positions.size();
+		const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+
+		std::vector<uint32_t> triangles = indices;
+		std::vector<uint8_t> alive(triangleCount, 1);
+		std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			for (uint32_t k = 0; k < 3; k++) {
+				vertexTriangles[triangles[t * 3 + k]].push_back(t);
+			}
+		}
+
+		// 1. 边的使用次数：只被一个三角形用到的是边界边
+		std::unordered_map<uint64_t, uint32_t> edges;
+		edges.reserve(indices.size());
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			for (uint32_t k = 0; k < 3; k++) {
+				edges[edge_key(triangles[t * 3 + k], triangles[t * 3 + (k + 1) % 3])]++;
+			}
+		}
+
+		// 2. 顶点分类 + 二次误差
+		std::vector<Quadric> quadrics(vertexCount);
+		std::vector<uint32_t> borderEdges(vertexCount, 0);
+		std::vector<VertexKind> kinds(vertexCount, VertexKind::Interior);
+
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			const uint32_t* tri = &triangles[t * 3];
+			const glm::dvec3 p0 = positions[tri[0]], p1 = positions[tri[1]], p2 = positions[tri[2]];
+			const glm::dvec3 cross = glm::cross(p1 - p0, p2 - p0);
+			const double length = glm::length(cross);
+			if (length <= 0.0) {
+				continue;
+			}
+			const glm::dvec3 normal = cross / length;
+			const double area = length * 0.5;
+			const double d = -glm::dot(normal, p0);
+			for (uint32_t k = 0; k < 3; k++) {
+				quadrics[tri[k]].add_plane(normal, d, area);
+			}
+
+			for (uint32_t k = 0; k < 3; k++) {
+				const uint32_t a = tri[k];
+				const uint32_t b = tri[(k + 1) % 3];
+				if (edges[edge_key(a, b)] != 1) {
+					continue;
+				}
+				borderEdges[a]++;
+				borderEdges[b]++;
+
+				const glm::dvec3 pa = positions[a];
+				const glm::dvec3 edge = glm::dvec3(positions[b]) - pa;
+				const double edgeLength = glm::length(edge);
+				if (edgeLength <= 0.0) {
+					continue;
+				}
+				const glm::dvec3 borderNormal = glm::normalize(glm::cross(edge, normal));
+				const double borderD = -glm::dot(borderNormal, pa);
+				Quadric border;
+				border.add_plane(borderNormal, borderD, edgeLength * edgeLength * BORDER_WEIGHT);
+				border.weight = 0.0; // 约束平面不参与平均
+				quadrics[a].add(border);
+				quadrics[b].add(border);
+			}
+		}
+
+		for (uint32_t v = 0; v < vertexCount; v++) {
+			if (seam[v] || (borderEdges[v] != 0 && borderEdges[v] != 2)) {
+				kinds[v] = VertexKind::Locked;
+			}
+			else if (borderEdges[v] == 2) {
+				kinds[v] = VertexKind::Border;
+			}
+		}
+
+		std::vector<uint8_t> removed(vertexCount, 0);
+		std::vector<uint32_t> versions(vertexCount, 0);
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+
+		auto collapse_cost = [&](uint32_t src, uint32_t dst) {
+			Quadric q = quadrics[src];
+			q.add(quadrics[dst]);
+			return q.evaluate(positions[dst]);
+		};
+
+		// 边 (a, b) 选代价小的那个方向入堆；边界顶点只能沿边界边移动
+		auto push_edge = [&](uint32_t a, uint32_t b, bool borderEdge) {
+			Collapse best = {};
+			best.cost = -1.0;
+			const uint32_t ends[2][2] = { { a, b }, { b, a } };
+			for (const auto& end : ends) {
+				const uint32_t src = end[0];
+				const uint32_t dst = end[1];
+				if (kinds[src] == VertexKind::Locked || (kinds[src] == VertexKind::Border && !borderEdge)) {
+					continue;
+				}
+				const double cost = collapse_cost(src, dst);
+				if (best.cost < 0.0 || cost < best.cost) {
+					best = { cost, src, dst, versions[src], versions[dst] };
+				}
+			}
+			if (best.cost >= 0.0) {
+				heap.push(best);
+			}
+		};
+
+		for (const auto& [key, count] : edges) {
+			push_edge((uint32_t)(key >> 32), (uint32_t)key, count == 1);
+		}
+
+		// 3. 依次折叠代价最小的边
+		uint32_t liveTriangles = triangleCount;
+		double maxError = 0.0;
+		std::vector<uint32_t> srcTriangles;
+		std::vector<uint32_t> srcNeighbors;
+		std::vector<uint32_t> dstNeighbors;
+
+		auto gather = [&](uint32_t v, std::vector<uint32_t>& tris, std::vector<uint32_t>* neighbors) {
+			tris.clear();
+			if (neighbors) {
+				neighbors->clear();
+			}
+			for (uint32_t t : vertexTriangles[v]) {
+				if (!alive[t]) {
+					continue;
+				}
+				const uint32_t* tri = &triangles[t * 3];
+				if (tri[0] != v && tri[1] != v && tri[2] != v) {
+					continue;
+				}
+				if (std::find(tris.begin(), tris.end(), t) != tris.end()) {
+					continue;
+				}
+				tris.push_back(t);
+				if (neighbors) {
+					for (uint32_t k = 0; k < 3; k++) {
+						if (tri[k] != v && std::find(neighbors->begin(), neighbors->end(), tri[k]) == neighbors->end()) {
+							neighbors->push_back(tri[k]);
+						}
+					}
+				}
+			}
+		};
+
+		std::vector<uint32_t> dstTriangles;
+		while (liveTriangles > targetTriangles && !heap.empty()) {
+			const Collapse collapse = heap.top();
+			heap.pop();
+			const uint32_t src = collapse.src;
+			const uint32_t dst = collapse.dst;
+			if (removed[src] || removed[dst] || versions[src] != collapse.srcVersion || versions[dst] != collapse.dstVersion) {
+				continue;
+			}
+
+			gather(src, srcTriangles, &srcNeighbors);
+			gather(dst, dstTriangles, &dstNeighbors);
+
+			// 这条边上的三角形 (折叠后退化，删掉)
+			uint32_t shared = 0;
+			for (uint32_t t : srcTriangles) {
+				const uint32_t* tri = &triangles[t * 3];
+				if (tri[0] == dst || tri[1] == dst || tri[2] == dst) {
+					shared++;
+				}
+			}
+			if (shared == 0) {
+				continue; // 边已经不存在了
+			}
+			if (kinds[src] == VertexKind::Border && shared != 1) {
+				continue;
+			}
+
+			// 连接条件：两端共同的邻居必须正好是这条边上三角形的第三个顶点，否则折叠会产生非流形
+			uint32_t common = 0;
+			for (uint32_t n : srcNeighbors) {
+				if (n != dst && std::find(dstNeighbors.begin(), dstNeighbors.end(), n) != dstNeighbors.end()) {
+					common++;
+				}
+			}
+			if (common != shared) {
+				continue;
+			}
+
+			// 折叠后剩下的三角形不能翻面或退化
+			bool flips = false;
+			for (uint32_t t : srcTriangles) {
+				const uint32_t* tri = &triangles[t * 3];
+				if (tri[0] == dst || tri[1] == dst || tri[2] == dst) {
+					continue;
+				}
+				glm::vec3 p[3] = { positions[tri[0]], positions[tri[1]], positions[tri[2]] };
+				const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				for (uint32_t k = 0; k < 3; k++) {
+					if (tri[k] == src) {
+						p[k] = positions[dst];
+					}
+				}
+				const glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+				const float lengths = glm::length(before) * glm::length(after);
+				if (lengths <= 0.0f || glm::dot(before, after) < 0.25f * lengths) {
+					flips = true;
+					break;
+				}
+			}
+			if (flips) {
+				continue;
+			}
+
+			// 执行折叠
+			for (uint32_t t : srcTriangles) {
+				uint32_t* tri = &triangles[t * 3];
+				if (tri[0] == dst || tri[1] == dst || tri[2] == dst) {
+					alive[t] = 0;
+					liveTriangles--;
+					continue;
+				}
+				for (uint32_t k = 0; k < 3; k++) {
+					if (tri[k] == src) {
+						tri[k] = dst;
+					}
+				}
+				vertexTriangles[dst].push_back(t);
+			}
+			removed[src] = 1;
+			quadrics[dst].add(quadrics[src]);
+			versions[dst]++;
+
+			const Quadric& q = quadrics[dst];
+			if (q.weight > 0.0) {
+				maxError = std::max(maxError, q.evaluate(positions[dst]) / q.weight);
+			}
+
+			// dst 周围的边代价都变了，重新入堆
+			gather(dst, dstTriangles, &dstNeighbors);
+			for (uint32_t n : dstNeighbors) {
+				uint32_t uses = 0;
+				for (uint32_t t : dstTriangles) {
+					const uint32_t* tri = &triangles[t * 3];
+					if (tri[0] == n || tri[1] == n || tri[2] == n) {
+						uses++;
+					}
+				}
+				push_edge(dst, n, uses == 1);
+			}
+		}
+
+		out.clear();
+		out.reserve((size_t)liveTriangles * 3);
+		for (uint32_t t = 0; t < triangleCount; t++) {
+			if (alive[t]) {
+				out.insert(out.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+			}
+		}
+		return (float)std::sqrt(maxError);
+	}
+}
+
+vklod::MeshLodChain vklod::build_chain(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const Settings& settings)
+{
+	MeshLodChain chain;
+
+	// 1. 焊接：属性完全相同的顶点合并
+	const size_t indexCount = indices.empty() ? vertices.size() : indices.size();
+	std::vector<uint32_t> lod0(indexCount);
+	std::unordered_map<VertexKey, uint32_t, VertexKeyHash> unique;
+	unique.reserve(vertices.size());
+	std::vector<uint32_t> sourceToWelded(vertices.size(), UINT32_MAX);
+	for (size_t i = 0; i < vertices.size(); i++) {
+		const auto [it, inserted] = unique.emplace(VertexKey{ &vertices[i] }, (uint32_t)chain.vertices.size());
+		if (inserted) {
+			chain.vertices.push_back(vertices[i]);
+		}
+		sourceToWelded[i] = it->second;
+	}
+	for (size_t i = 0; i < indexCount; i++) {
+		const uint32_t source = indices.empty() ? (uint32_t)i : indices[i];
+		lod0[i] = source < sourceToWelded.size() ? sourceToWelded[source] : 0;
+	}
+	lod0.resize(lod0.size() / 3 * 3);
+
+	// 2. 接缝：同一位置有多个 (属性不同的) 顶点，锁定
+	std::vector<glm::vec3> positions(chain.vertices.size());
+	std::vector<uint8_t> seam(chain.vertices.size(), 0);
+	std::unordered_map<glm::vec3, uint32_t, PositionHash> firstAtPosition;
+	for (uint32_t v = 0; v < chain.vertices.size(); v++) {
+		positions[v] = chain.vertices[v].position;
+		const auto [it, inserted] = firstAtPosition.emplace(positions[v], v);
+		if (!inserted) {
+			seam[v] = 1;
+			seam[it->second] = 1;
+		}
+	}
+
+	// 3. 包围球
+	if (!positions.empty()) {
+		glm::vec3 lo = positions[0];
+		glm::vec3 hi = positions[0];
+		for (const glm::vec3& p : positions) {
+			lo = glm::min(lo, p);
+			hi = glm::max(hi, p);
+		}
+		chain.center = (lo + hi) * 0.5f;
+		for (const glm::vec3& p : positions) {
+			chain.radius = std::max(chain.radius, glm::length(p - chain.center));
+		}
+	}
+
+	// 4. LOD 链：每级在上一级的结果上继续简化，误差累加 (保守估计)
+	chain.indices = lod0;
+	chain.lods.push_back({ 0, (uint32_t)lod0.size(), 0.0f });
+
+	std::vector<uint32_t> current = std::move(lod0);
+	std::vector<uint32_t> next;
+	float error = 0.0f;
+	const uint32_t maxLods = std::min(settings.maxLods, MAX_LODS);
+	while (chain.lods.size() < maxLods) {
+		const uint32_t triangles = (uint32_t)(current.size() / 3);
+		if (triangles <= settings.minTriangles) {
+			break;
+		}
+		const uint32_t target = std::max(settings.minTriangles, (uint32_t)(triangles * settings.reduction));
+		error += simplify(positions, seam, current, target, next);
+		if (next.size() / 3 > (size_t)(triangles * settings.minReduction)) {
+			break; // 减不动了
+		}
+
+		chain.lods.push_back({ (uint32_t)chain.indices.size(), (uint32_t)next.size(), error });
+		chain.indices.insert(chain.indices.end(), next.begin(), next.end());
+		std::swap(current, next);
+	}
+
+	return chain;
+}
+
+uint32_t vklod::select_lod(std::span<const float> errors, float scale, float distance, float projScale,
+	float thresholdPx, float hysteresis, uint32_t previous)
+{
+	if (errors.empty()) {
+		return 0;
+	}
+
+	// 误差随级别单调增加，找最后一个投影误差不超过 limit 的级别
+	const float toPixels = scale * projScale / std::max(distance, 1e-4f);
+	auto coarsest = [&](float limit) {
+		uint32_t lod = 0;
+		for (uint32_t i = 1; i < errors.size() && errors[i] * toPixels <= limit; i++) {
+			lod = i;
+		}
+		return lod;
+	};
+
+	uint32_t lod = coarsest(thresholdPx);
+	if (previous < errors.size() && lod > previous) {
+		lod = std::max(previous, coarsest(thresholdPx * (1.0f - hysteresis)));
+	}
+	return lod;
+}
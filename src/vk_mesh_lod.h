@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vk_types.h"
+
+// 网格 LOD 链 (导入时生成，纯 CPU，可以在工作线程上跑)
+// 1. 顶点按全部属性焊接成索引网格
+// 2. 二次误差度量 (QEM) 的边折叠：每次把代价最小的边的一端折叠到另一端，不产生新顶点，
+//    所以所有 LOD 共用同一个顶点缓冲区，只是索引不同 (所有 LOD 的索引首尾相接放在一个索引缓冲区里)
+// 3. 每级在上一级的基础上继续简化，三角形数按比例减少，直到减不动或者太少
+// 法线 / UV / 颜色接缝上的顶点 (同一位置有多个顶点) 和非流形顶点锁定不动，保证不开裂；开放边界只沿边界折叠
+// 运行时按投影后的像素误差选级别 (select_lod)，带滞回，距离在阈值附近抖动时不会来回切换
+namespace vklod {
+
+	constexpr uint32_t MAX_LODS = 8;
+
+	struct Settings {
+		uint32_t maxLods{ 6 };        // 含 LOD 0
+		float reduction{ 0.5f };      // 每级保留的三角形比例
+		uint32_t minTriangles{ 16 };  // 少于这个数就不再生成更粗的级别
+		float minReduction{ 0.8f };   // 这一级相比上一级至少减到这个比例，否则说明减不动了 (全是锁定顶点)
+	};
+
+	struct Lod {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float error;   // 物体空间的几何误差 (距离单位)，LOD 0 为 0
+	};
+
+	struct MeshLodChain {
+		std::vector<Vertex> vertices;  // 焊接后的顶点，所有 LOD 共用
+		std::vector<uint32_t> indices; // 所有 LOD 的索引首尾相接
+		std::vector<Lod> lods;         // lods[0] 是原始精度
+		glm::vec3 center{ 0.0f };      // 包围球 (物体空间)
+		float radius{ 0.0f };
+	};
+
+	// indices 为空时 vertices 按三角形列表解释
+	MeshLodChain build_chain(std::span<const Vertex> vertices, std::span<const uint32_t> indices, const Settings& settings = {});
+
+	// 按投影误差选 LOD
+	// errors：每级的物体空间误差；scale：模型矩阵的最大缩放；distance：相机到包围球表面的距离
+	// projScale = 渲染高度 / (2 * tan(fovY / 2))，把 1 个距离单位 / 距离 换算成像素
+	// previous：这个物体上一帧的级别 (没有时传 UINT32_MAX)；只有误差低于 thresholdPx * (1 - hysteresis) 时才换成更粗的级别，
+	// 变细则立即生效 (画质优先)
+	uint32_t select_lod(std::span<const float> errors, float scale, float distance, float projScale,
+		float thresholdPx, float hysteresis, uint32_t previous);
+}
@@ -0,0 +1,494 @@
+#include "vk_meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <glm/geometric.hpp>
+
+namespace {
+	constexpr uint8_t NOT_IN_MESHLET = 0xFF;
+
+	// 一个簇的包围球和法线锥
+	void compute_bounds(std::span<const Vertex> vertices, const vkmeshlet::MeshletSet& set, vkmeshlet::GPUMeshlet& meshlet)
+	{
+		const uint32_t* local = &set.vertices[meshlet.vertexOffset];
+
+		// 1. 包围球：AABB 中心 + 最远顶点
+		glm::vec3 lo = vertices[local[0]].position;
+		glm::vec3 hi = lo;
+		for (uint32_t i = 1; i < meshlet.vertexCount; i++) {
+			lo = glm::min(lo, vertices[local[i]].position);
+			hi = glm::max(hi, vertices[local[i]].position);
+		}
+		const glm::vec3 center = (lo + hi) * 0.5f;
+		float radius = 0.0f;
+		for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+			radius = std::max(radius, glm::length(vertices[local[i]].position - center));
+		}
+		meshlet.sphere = glm::vec4(center, radius);
+
+		// 2. 法线锥：轴是三角形法线的平均，半角由偏得最远的法线决定
+		//    整簇背对相机的条件 dot(center - camera, axis) >= cutoff * |center - camera| + radius，cutoff = sin(半角)
+		glm::vec3 normals[vkmeshlet::MAX_TRIANGLES];
+		uint32_t normalCount = 0;
+		glm::vec3 axis(0.0f);
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+			const uint32_t packed = set.triangles[meshlet.triangleOffset + t];
+			const glm::vec3 p0 = vertices[local[packed & 0xFF]].position;
+			const glm::vec3 p1 = vertices[local[(packed >> 8) & 0xFF]].position;
+			const glm::vec3 p2 = vertices[local[(packed >> 16) & 0xFF]].position;
+			const glm::vec3 cross = glm::cross(p1 - p0, p2 - p0);
+			const float length = glm::length(cross);
+			if (length <= 0.0f) {
+				continue;
+			}
+			normals[normalCount] = cross / length;
+			axis += normals[normalCount];
+			normalCount++;
+		}
+
+		meshlet.cone = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		const float axisLength = glm::length(axis);
+		if (normalCount == 0 || axisLength <= 1e-6f) {
+			return;
+		}
+		axis /= axisLength;
+		float minDot = 1.0f;
+		for (uint32_t i = 0; i < normalCount; i++) {
+			minDot = std::min(minDot, glm::dot(axis, normals[i]));
+		}
+		// 半角超过 90 度：总有三角形朝着相机，不剔除
+		if (minDot <= 0.0f) {
+			return;
+		}
+		meshlet.cone = glm::vec4(axis, std::sqrt(1.0f - minDot * minDot));
+	}
+}
+
+uint32_t vkmeshlet::build(std::span<const Vertex> vertices, std::span<const uint32_t> indices, MeshletSet& out)
+{
+	const uint32_t vertexCount = (uint32_t)vertices.size();
+	const uint32_t triangleCount = (uint32_t)(indices.size() / 3);
+	const size_t firstMeshlet = out.meshlets.size();
+	if (triangleCount == 0) {
+		return 0;
+	}
+
+	// 1. 顶点 -> 三角形邻接 (CSR)
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; i++) {
+		adjacencyOffsets[indices[i] + 1]++;
+	}
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	{
+		std::vector<uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (uint32_t i = 0; i < triangleCount * 3; i++) {
+			adjacency[cursor[indices[i]]++] = i / 3;
+		}
+	}
+
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	std::vector<uint8_t> local(vertexCount, NOT_IN_MESHLET); // 网格顶点 -> 当前簇里的下标
+	std::vector<uint32_t> meshletVertices;
+	std::vector<uint32_t> meshletTriangles;
+	meshletVertices.reserve(MAX_VERTICES);
+	meshletTriangles.reserve(MAX_TRIANGLES);
+	glm::vec3 positionSum(0.0f);
+	uint32_t seed = 0;
+
+	auto new_vertices = [&](uint32_t triangle) {
+		const uint32_t* tri = &indices[triangle * 3];
+		uint32_t count = 0;
+		for (uint32_t k = 0; k < 3; k++) {
+			const bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+			if (local[tri[k]] == NOT_IN_MESHLET && !repeated) {
+				count++;
+			}
+		}
+		return count;
+	};
+
+	auto flush = [&]() {
+		if (meshletTriangles.empty()) {
+			return;
+		}
+		GPUMeshlet meshlet = {};
+		meshlet.vertexOffset = (uint32_t)out.vertices.size();
+		meshlet.triangleOffset = (uint32_t)out.triangles.size();
+		meshlet.vertexCount = (uint32_t)meshletVertices.size();
+		meshlet.triangleCount = (uint32_t)meshletTriangles.size();
+		out.vertices.insert(out.vertices.end(), meshletVertices.begin(), meshletVertices.end());
+		out.triangles.insert(out.triangles.end(), meshletTriangles.begin(), meshletTriangles.end());
+		compute_bounds(vertices, out, meshlet);
+		out.meshlets.push_back(meshlet);
+
+		for (uint32_t v : meshletVertices) {
+			local[v] = NOT_IN_MESHLET;
+		}
+		meshletVertices.clear();
+		meshletTriangles.clear();
+		positionSum = glm::vec3(0.0f);
+	};
+
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+		// 2. 和当前簇共享顶点的三角形里，选新增顶点最少的，一样多时选离簇中心最近的
+		uint32_t best = UINT32_MAX;
+		uint32_t bestNew = 4;
+		float bestDistance = 0.0f;
+		const glm::vec3 centroid = meshletVertices.empty() ? glm::vec3(0.0f) : positionSum / (float)meshletVertices.size();
+		for (uint32_t v : meshletVertices) {
+			for (uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++) {
+				const uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) {
+					continue;
+				}
+				const uint32_t added = new_vertices(triangle);
+				if (added > bestNew) {
+					continue;
+				}
+				const uint32_t* tri = &indices[triangle * 3];
+				const glm::vec3 center = (vertices[tri[0]].position + vertices[tri[1]].position + vertices[tri[2]].position) / 3.0f;
+				const float distance = glm::dot(center - centroid, center - centroid);
+				if (added < bestNew || distance < bestDistance) {
+					best = triangle;
+					bestNew = added;
+					bestDistance = distance;
+				}
+			}
+		}
+
+		// 3. 没有相邻的 (新簇，或者这一片已经用完)：按原顺序取下一个
+		if (best == UINT32_MAX) {
+			while (emitted[seed]) {
+				seed++;
+			}
+			best = seed;
+			bestNew = new_vertices(best);
+		}
+
+		// 4. 放不下就先结束当前簇
+		if (meshletVertices.size() + bestNew > MAX_VERTICES || meshletTriangles.size() + 1 > MAX_TRIANGLES) {
+			flush();
+		}
+
+		const uint32_t* tri = &indices[best * 3];
+		uint32_t packed = 0;
+		for (uint32_t k = 0; k < 3; k++) {
+			if (local[tri[k]] == NOT_IN_MESHLET) {
+				local[tri[k]] = (uint8_t)meshletVertices.size();
+				meshletVertices.push_back(tri[k]);
+				positionSum += vertices[tri[k]].position;
+			}
+			packed |= (uint32_t)local[tri[k]] << (k * 8);
+		}
+		meshletTriangles.push_back(packed);
+		emitted[best] = 1;
+	}
+	flush();
+
+	return (uint32_t)(out.meshlets.size() - firstMeshlet);
+}
+
+bool MeshletRenderer::init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless, bool meshShaders)
+{
+	_device = device;
+	_memory = memory;
+	_bindless = bindless;
+	_meshShaders = meshShaders;
+
+	if (_meshShaders) {
+		_drawMeshTasks = (PFN_vkCmdDrawMeshTasksEXT)vkGetDeviceProcAddr(_device, "vkCmdDrawMeshTasksEXT");
+		if (!_drawMeshTasks) {
+			vklog::error() << "vkCmdDrawMeshTasksEXT not found, using the compute culling path";
+			_meshShaders = false;
+		}
+	}
+
+	auto create = [this](VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, AllocatedBuffer& out, void** mapped) {
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.pNext = nullptr;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		if (!_memory->create_buffer(bufferInfo, memoryUsage, MemoryCategory::Other, out)) {
+			vklog::error() << "Failed to allocate meshlet buffer (" << size << " bytes)";
+			return false;
+		}
+		if (mapped) {
+			vmaMapMemory(_memory->allocator(), out._allocation, mapped);
+		}
+		return true;
+	};
+
+	const VkDeviceSize frameSize = sizeof(GPUMeshletFrame) + (VkDeviceSize)MAX_DRAWS * sizeof(GPUMeshletDraw);
+	if (!create(frameSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, _frame, (void**)&_frameData) ||
+		!create(count_buffer_size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, _counts, (void**)&_countData)) {
+		return false;
+	}
+	memset(_countData, 0, count_buffer_size());
+	_frameSlot = _bindless->add_storage_buffer(_frame._buffer);
+	_countSlot = _bindless->add_storage_buffer(_counts._buffer);
+
+	if (!_meshShaders) {
+		if (!create(command_buffer_size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, _commands, nullptr)) {
+			return false;
+		}
+		_commandSlot = _bindless->add_storage_buffer(_commands._buffer);
+	}
+
+	vklog::info() << "Meshlets: " << (_meshShaders ? "task / mesh shaders" : "compute culling + indirect draws");
+	return true;
+}
+
+void MeshletRenderer::cleanup()
+{
+	// bindless 槽位随全局 set 一起释放
+	if (_device == VK_NULL_HANDLE) {
+		return;
+	}
+	for (Mesh& mesh : _meshes) {
+		_memory->destroy_buffer(mesh.data);
+		if (mesh.indices._buffer != VK_NULL_HANDLE) {
+			_memory->destroy_buffer(mesh.indices);
+		}
+	}
+	_meshes.clear();
+
+	if (_frameData) {
+		vmaUnmapMemory(_memory->allocator(), _frame._allocation);
+		_memory->destroy_buffer(_frame);
+	}
+	if (_countData) {
+		vmaUnmapMemory(_memory->allocator(), _counts._allocation);
+		_memory->destroy_buffer(_counts);
+	}
+	if (_commands._buffer != VK_NULL_HANDLE) {
+		_memory->destroy_buffer(_commands);
+	}
+	_frameData = nullptr;
+	_countData = nullptr;
+	_device = VK_NULL_HANDLE;
+}
+
+void MeshletRenderer::set_pipelines(VkPipelineLayout layout, VkShaderStageFlags pushStages, VkPipeline cull, VkPipeline draw)
+{
+	_layout = layout;
+	_pushStages = pushStages;
+	_cullPipeline = cull;
+	_drawPipeline = draw;
+}
+
+uint32_t MeshletRenderer::add_mesh(const vkmeshlet::MeshletSet& set, VkBuffer vertexBuffer)
+{
+	if (set.meshlets.empty()) {
+		return INVALID_SLOT;
+	}
+
+	auto upload = [this](const std::initializer_list<std::span<const uint8_t>> parts, VkBufferUsageFlags usage, AllocatedBuffer& out) {
+		size_t size = 0;
+		for (const auto& part : parts) {
+			size += part.size();
+		}
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.pNext = nullptr;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		if (!_memory->create_buffer(bufferInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Geometry, out)) {
+			vklog::error() << "Failed to allocate meshlet data (" << size << " bytes)";
+			return false;
+		}
+		uint8_t* data;
+		vmaMapMemory(_memory->allocator(), out._allocation, (void**)&data);
+		for (const auto& part : parts) {
+			memcpy(data, part.data(), part.size());
+			data += part.size();
+		}
+		vmaUnmapMemory(_memory->allocator(), out._allocation);
+		return true;
+	};
+	auto bytes = [](const auto& values) {
+		return std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(values.data()), values.size() * sizeof(values[0]));
+	};
+
+	Mesh mesh = {};
+	mesh.vertexBuffer = vertexBuffer;
+	mesh.vertexBase = (uint32_t)(set.meshlets.size() * sizeof(vkmeshlet::GPUMeshlet) / sizeof(uint32_t));
+	mesh.triangleBase = mesh.vertexBase + (uint32_t)set.vertices.size();
+	if (!upload({ bytes(set.meshlets), bytes(set.vertices), bytes(set.triangles) }, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, mesh.data)) {
+		return INVALID_SLOT;
+	}
+
+	// 回退路径：簇的三角形按顺序展开成网格顶点下标，第 i 个三角形就是索引缓冲区里的第 i 个
+	if (!_meshShaders) {
+		std::vector<uint32_t> indices(set.triangles.size() * 3);
+		for (const vkmeshlet::GPUMeshlet& meshlet : set.meshlets) {
+			for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+				const uint32_t packed = set.triangles[meshlet.triangleOffset + t];
+				for (uint32_t k = 0; k < 3; k++) {
+					indices[(meshlet.triangleOffset + t) * 3 + k] = set.vertices[meshlet.vertexOffset + ((packed >> (k * 8)) & 0xFF)];
+				}
+			}
+		}
+		if (!upload({ bytes(indices) }, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mesh.indices)) {
+			_memory->destroy_buffer(mesh.data);
+			return INVALID_SLOT;
+		}
+	}
+
+	mesh.dataSlot = _bindless->add_storage_buffer(mesh.data._buffer);
+	mesh.vertexSlot = _meshShaders ? _bindless->add_storage_buffer(vertexBuffer) : INVALID_SLOT;
+	_meshes.push_back(mesh);
+	return (uint32_t)_meshes.size() - 1;
+}
+
+void MeshletRenderer::begin_frame(const glm::mat4& viewProj, const glm::vec3& cameraPosition)
+{
+	// 上一帧 GPU 已经执行完：读统计，计数清零 (CPU 写在提交之前，对 GPU 可见)
+	_stats.visibleMeshlets = _countData[0];
+	memset(_countData, 0, count_buffer_size());
+
+	GPUMeshletFrame* frame = reinterpret_cast<GPUMeshletFrame*>(_frameData);
+	frame->viewProj = viewProj;
+	frame->cameraPosition = glm::vec4(cameraPosition, 1.0f);
+
+	// 从 viewProj 的行提取视锥平面 (深度 0..1：近平面就是第 3 行)
+	auto row = [&](int i) { return glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]); };
+	const glm::vec4 planes[6] = {
+		row(3) + row(0), row(3) - row(0),
+		row(3) + row(1), row(3) - row(1),
+		row(2), row(3) - row(2),
+	};
+	for (uint32_t i = 0; i < 6; i++) {
+		frame->frustum[i] = planes[i] / glm::length(glm::vec3(planes[i]));
+	}
+
+	_draws.clear();
+	_groups.clear();
+	_commandCount = 0;
+	_maxMeshlets = 0;
+	frame->drawCount = 0;
+	_stats.draws = 0;
+	_stats.meshlets = 0;
+}
+
+bool MeshletRenderer::add_draw(uint32_t mesh, uint32_t firstMeshlet, uint32_t meshletCount, const glm::mat4& model, const glm::vec4& data, uint32_t material)
+{
+	if (mesh >= _meshes.size() || _draws.size() >= MAX_DRAWS || _commandCount + meshletCount > MAX_COMMANDS) {
+		return false;
+	}
+	_draws.push_back({ mesh, firstMeshlet, meshletCount, material, model, data });
+	_commandCount += meshletCount;
+	return true;
+}
+
+void MeshletRenderer::flush_draws()
+{
+	// 按网格排序：回退路径每个网格组一次 vkCmdDrawIndexedIndirectCount
+	// 同一个网格按提交顺序 (比较下标，和 stable_sort 结果一样，但不用临时缓冲区)
+	_order.resize(_draws.size());
+	for (uint32_t i = 0; i < _order.size(); i++) {
+		_order[i] = i;
+	}
+	std::sort(_order.begin(), _order.end(), [this](uint32_t a, uint32_t b) {
+		return _draws[a].mesh != _draws[b].mesh ? _draws[a].mesh < _draws[b].mesh : a < b;
+	});
+
+	GPUMeshletFrame* frame = reinterpret_cast<GPUMeshletFrame*>(_frameData);
+	GPUMeshletDraw* gpuDraws = reinterpret_cast<GPUMeshletDraw*>(_frameData + sizeof(GPUMeshletFrame));
+
+	uint32_t drawCount = 0;
+	uint32_t commandOffset = 0;
+	for (uint32_t index : _order) {
+		const PendingDraw& draw = _draws[index];
+		if (_groups.empty() || _groups.back().mesh != draw.mesh) {
+			if (_groups.size() >= MAX_GROUPS) {
+				vklog::error() << "Too many meshlet meshes in one frame, dropping the rest";
+				break;
+			}
+			_groups.push_back({ draw.mesh, commandOffset, 0 });
+		}
+		Group& group = _groups.back();
+		const Mesh& mesh = _meshes[draw.mesh];
+
+		GPUMeshletDraw& gpu = gpuDraws[drawCount++];
+		gpu.model = draw.model;
+		gpu.data = draw.data;
+		gpu.dataBuffer = mesh.dataSlot;
+		gpu.vertexBuffer = mesh.vertexSlot;
+		gpu.firstMeshlet = draw.firstMeshlet;
+		gpu.meshletCount = draw.meshletCount;
+		gpu.material = draw.material;
+		gpu.commandOffset = group.commandOffset;
+		gpu.countIndex = 1 + (uint32_t)(_groups.size() - 1); // 0 号是可见簇总数
+		gpu.vertexBase = mesh.vertexBase;
+		gpu.triangleBase = mesh.triangleBase;
+
+		group.commandCount += draw.meshletCount;
+		commandOffset += draw.meshletCount;
+		_maxMeshlets = std::max(_maxMeshlets, draw.meshletCount);
+		_stats.meshlets += draw.meshletCount;
+	}
+	frame->drawCount = drawCount;
+	_stats.draws = drawCount;
+}
+
+void MeshletRenderer::cull(VkCommandBuffer cmd)
+{
+	if (_meshShaders) {
+		return; // task shader 自己剔除
+	}
+	flush_draws();
+	if (_stats.draws == 0 || _cullPipeline == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipeline);
+	_bindless->bind(cmd, _layout, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+	PushConstants constants = { _frameSlot, _countSlot, _commandSlot, 0 };
+	vkCmdPushConstants(cmd, _layout, _pushStages, 0, sizeof(constants), &constants);
+
+	// y 是绘制，x 是绘制里的簇 (按最多的那个绘制算，多出来的线程直接退出)
+	vkCmdDispatch(cmd, (_maxMeshlets + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, _stats.draws, 1);
+}
+
+void MeshletRenderer::draw(VkCommandBuffer cmd)
+{
+	if (_meshShaders) {
+		flush_draws();
+	}
+	if (_stats.draws == 0 || _drawPipeline == VK_NULL_HANDLE) {
+		return;
+	}
+
+	// bindless set 已经在 forward pass 开头绑定，所有 layout 对它兼容
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _drawPipeline);
+	PushConstants constants = { _frameSlot, _countSlot, _commandSlot, 0 };
+
+	if (_meshShaders) {
+		const GPUMeshletDraw* gpuDraws = reinterpret_cast<const GPUMeshletDraw*>(_frameData + sizeof(GPUMeshletFrame));
+		for (uint32_t i = 0; i < _stats.draws; i++) {
+			constants.drawIndex = i;
+			vkCmdPushConstants(cmd, _layout, _pushStages, 0, sizeof(constants), &constants);
+			_drawMeshTasks(cmd, (gpuDraws[i].meshletCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+		}
+		return;
+	}
+
+	// 回退路径：每个网格组绑定一次顶点 / 索引，剔除写好的命令条数由 GPU 决定
+	vkCmdPushConstants(cmd, _layout, _pushStages, 0, sizeof(constants), &constants);
+	for (uint32_t g = 0; g < _groups.size(); g++) {
+		const Group& group = _groups[g];
+		const Mesh& mesh = _meshes[group.mesh];
+		const VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(cmd, 0, 1, &mesh.vertexBuffer, &offset);
+		vkCmdBindIndexBuffer(cmd, mesh.indices._buffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdDrawIndexedIndirectCount(cmd, _commands._buffer, (VkDeviceSize)group.commandOffset * sizeof(VkDrawIndexedIndirectCommand),
+			_counts._buffer, (VkDeviceSize)(1 + g) * sizeof(uint32_t), group.commandCount, sizeof(VkDrawIndexedIndirectCommand));
+	}
+}
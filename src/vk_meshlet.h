@@ -0,0 +1,173 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_descriptors.h"
+#include "vk_memory.h"
+
+// meshlet：把网格切成小簇 (最多 64 个顶点 / 124 个三角形)，每簇带包围球和法线锥
+// 剔除按簇进行：视锥外的、整簇背对相机的直接丢掉，比整个物体一起剔除细得多
+// 布局和 VK_EXT_mesh_shader 的输出上限一致，同一份数据给两条路径用：
+// - mesh shader：task shader 每个线程剔除一簇，可见的交给 mesh shader 从 storage buffer 读顶点输出三角形
+// - 回退 (任何 Vulkan 1.3 设备，包括 lavapipe)：计算着色器剔除，每个可见簇写一条 vkCmdDrawIndexedIndirect 命令，
+//   按网格分组用 vkCmdDrawIndexedIndirectCount 绘制 (簇的三角形展开成普通索引缓冲区)
+namespace vkmeshlet {
+
+	constexpr uint32_t MAX_VERTICES = 64;
+	constexpr uint32_t MAX_TRIANGLES = 124;
+
+	// 和 shaders/meshlet.glsl 里的 Meshlet 一致 (std430)
+	struct GPUMeshlet {
+		glm::vec4 sphere;         // xyz 中心，w 半径 (物体空间)
+		glm::vec4 cone;           // xyz 法线锥的轴，w 是 cutoff (>= 1 表示法线太分散，不做背面剔除)
+		uint32_t vertexOffset;    // MeshletSet::vertices 里的起点
+		uint32_t triangleOffset;  // MeshletSet::triangles 里的起点 (也是展开后索引缓冲区里的第几个三角形)
+		uint32_t vertexCount;
+		uint32_t triangleCount;
+	};
+	static_assert(sizeof(GPUMeshlet) == 48);
+
+	struct MeshletSet {
+		std::vector<GPUMeshlet> meshlets;
+		std::vector<uint32_t> vertices;  // 簇内顶点 -> 网格顶点下标
+		std::vector<uint32_t> triangles; // 每个三角形 3 个 8 位的簇内下标
+	};
+
+	// 把一个索引列表切成 meshlet 追加到 out 里，返回追加的个数
+	// 贪心生长：优先加入新增顶点最少、离簇中心最近的相邻三角形，簇满了再开新簇
+	uint32_t build(std::span<const Vertex> vertices, std::span<const uint32_t> indices, MeshletSet& out);
+}
+
+// 和 shaders/meshlet.glsl 里的 MeshletFrame / MeshletDraw 一致 (std430)
+struct GPUMeshletFrame {
+	glm::mat4 viewProj;
+	glm::vec4 frustum[6];        // 世界空间平面，法线朝内
+	glm::vec4 cameraPosition;
+	uint32_t drawCount;
+	uint32_t pad0[3];
+};
+
+struct GPUMeshletDraw {
+	glm::mat4 model;
+	glm::vec4 data;
+	uint32_t dataBuffer;     // bindless 下标：这个网格的 meshlet + 簇内顶点 + 三角形
+	uint32_t vertexBuffer;   // bindless 下标：顶点 (只有 mesh shader 路径用)
+	uint32_t firstMeshlet;
+	uint32_t meshletCount;
+	uint32_t material;
+	uint32_t commandOffset;  // 回退路径：这个网格组的间接命令从哪里开始
+	uint32_t countIndex;     // 回退路径：这个网格组的计数
+	uint32_t vertexBase;     // 数据 buffer 里簇内顶点 / 三角形两段的起点 (uint 下标)
+	uint32_t triangleBase;
+	uint32_t pad0[3];
+};
+static_assert(sizeof(GPUMeshletDraw) == 128);
+
+struct MeshletStats {
+	uint32_t draws{ 0 };
+	uint32_t meshlets{ 0 };        // 这一帧提交剔除的簇
+	uint32_t visibleMeshlets{ 0 }; // 上一帧剔除之后剩下的簇 (GPU 写，帧开始时读回)
+};
+
+// meshlet 网格的注册、每帧的绘制收集、剔除和绘制录制
+// 管线由引擎创建 (和其他管线一样走 PipelineLayoutCache)，这里只负责数据和命令
+// 只在渲染线程上录制；add_mesh 在初始化 / 加载时调用
+class MeshletRenderer {
+public:
+	static constexpr uint32_t MAX_DRAWS = 4096;
+	static constexpr uint32_t MAX_COMMANDS = 1u << 18; // 回退路径一帧最多的簇
+	static constexpr uint32_t MAX_GROUPS = 1024;       // 回退路径一帧最多的网格组
+	static constexpr uint32_t CULL_GROUP_SIZE = 64;    // 和 meshlet_cull.comp / meshlet.task 的 local_size_x 一致
+
+	bool init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless, bool meshShaders);
+	void cleanup();
+
+	bool uses_mesh_shaders() const { return _meshShaders; }
+
+	// cull 只有回退路径用；draw 是 meshlet.vert (回退) 或 meshlet.mesh (mesh shader) 的管线
+	void set_pipelines(VkPipelineLayout layout, VkShaderStageFlags pushStages, VkPipeline cull, VkPipeline draw);
+
+	// 上传一个网格的 meshlet，返回 meshlet 网格下标
+	// vertexBuffer 是网格的顶点缓冲区 (mesh shader 路径当 storage buffer 读，需要 STORAGE 用法)
+	uint32_t add_mesh(const vkmeshlet::MeshletSet& set, VkBuffer vertexBuffer);
+
+	// 每帧：begin_frame -> add_draw... -> (render graph) cull -> draw
+	// 调用方已经等过这一帧的 fence
+	void begin_frame(const glm::mat4& viewProj, const glm::vec3& cameraPosition);
+	// 画 mesh 的 [firstMeshlet, firstMeshlet + meshletCount)；装不下时返回 false (调用方改走普通绘制)
+	bool add_draw(uint32_t mesh, uint32_t firstMeshlet, uint32_t meshletCount, const glm::mat4& model, const glm::vec4& data, uint32_t material);
+	void cull(VkCommandBuffer cmd);
+	void draw(VkCommandBuffer cmd);
+
+	bool empty() const { return _draws.empty(); }
+	VkBuffer command_buffer() const { return _commands._buffer; }
+	VkBuffer count_buffer() const { return _counts._buffer; }
+	VkDeviceSize command_buffer_size() const { return (VkDeviceSize)MAX_COMMANDS * sizeof(VkDrawIndexedIndirectCommand); }
+	VkDeviceSize count_buffer_size() const { return (VkDeviceSize)(MAX_GROUPS + 1) * sizeof(uint32_t); }
+	const MeshletStats& stats() const { return _stats; }
+
+private:
+	struct Mesh {
+		AllocatedBuffer data;    // GPUMeshlet[] + 簇内顶点 + 三角形
+		AllocatedBuffer indices; // 回退路径：展开后的三角形 (网格顶点下标)
+		VkBuffer vertexBuffer;
+		uint32_t dataSlot;
+		uint32_t vertexSlot;
+		uint32_t vertexBase;
+		uint32_t triangleBase;
+	};
+
+	struct PendingDraw {
+		uint32_t mesh;
+		uint32_t firstMeshlet;
+		uint32_t meshletCount;
+		uint32_t material;
+		glm::mat4 model;
+		glm::vec4 data;
+	};
+
+	// 和 meshlet.glsl 里的 push constant 一致
+	struct PushConstants {
+		uint32_t frameBuffer;
+		uint32_t countBuffer;
+		uint32_t commandBuffer;
+		uint32_t drawIndex;   // mesh shader 路径：这次 vkCmdDrawMeshTasksEXT 画哪个绘制
+	};
+
+	// 同一网格的绘制排在一起，分好组写进 GPU
+	void flush_draws();
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	MemoryManager* _memory{ nullptr };
+	BindlessHeap* _bindless{ nullptr };
+	bool _meshShaders{ false };
+	PFN_vkCmdDrawMeshTasksEXT _drawMeshTasks{ nullptr };
+
+	VkPipelineLayout _layout{ VK_NULL_HANDLE };
+	VkShaderStageFlags _pushStages{ 0 };
+	VkPipeline _cullPipeline{ VK_NULL_HANDLE };
+	VkPipeline _drawPipeline{ VK_NULL_HANDLE };
+
+	std::vector<Mesh> _meshes;
+
+	// 常驻映射：帧头 + 绘制表 (CPU 写)，计数 (GPU 写，CPU 帧开始时读统计、清零)
+	AllocatedBuffer _frame{};
+	uint8_t* _frameData{ nullptr };
+	AllocatedBuffer _counts{};
+	uint32_t* _countData{ nullptr };
+	AllocatedBuffer _commands{}; // 回退路径的间接命令 (GPU 写)
+	uint32_t _frameSlot{ INVALID_SLOT };
+	uint32_t _countSlot{ INVALID_SLOT };
+	uint32_t _commandSlot{ INVALID_SLOT };
+
+	std::vector<PendingDraw> _draws;
+	std::vector<uint32_t> _order;
+	struct Group {
+		uint32_t mesh;
+		uint32_t commandOffset;
+		uint32_t commandCount;
+	};
+	std::vector<Group> _groups;
+	uint32_t _commandCount{ 0 };
+	uint32_t _maxMeshlets{ 0 }; // 这一帧单个绘制最多的簇数 (决定剔除的 dispatch 宽度)
+	MeshletStats _stats{};
+};
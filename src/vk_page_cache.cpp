@@ -0,0 +1,165 @@
+#include "vk_page_cache.h"
+
+#include <unordered_set>
+
+void VirtualPageCache::init(uint32_t sizeInPages, uint32_t mipCount, uint32_t tilesPerRow)
+{
+	_sizeInPages = sizeInPages;
+	_mipCount = std::min(mipCount, vkvt::MAX_MIPS);
+	_tilesPerRow = tilesPerRow;
+
+	const uint32_t pageCount = vkvt::mip_offsets(_sizeInPages, _mipCount, _mipOffsets);
+	_entries.assign(pageCount, vkvt::INVALID_PAGE);
+
+	_slots.assign(tilesPerRow * tilesPerRow, Slot{});
+	_freeSlots.clear();
+	for (uint32_t i = (uint32_t)_slots.size(); i > 0; i--) {
+		_freeSlots.push_back(i - 1);
+	}
+	_lru.clear();
+	_resident.clear();
+	clear_dirty();
+}
+
+uint32_t& VirtualPageCache::entry(uint32_t mip, uint32_t x, uint32_t y)
+{
+	const uint32_t index = _mipOffsets[mip] + y * vkvt::pages_per_side(_sizeInPages, mip) + x;
+	_dirtyBegin = std::min(_dirtyBegin, index);
+	_dirtyEnd = std::max(_dirtyEnd, index + 1);
+	return _entries[index];
+}
+
+void VirtualPageCache::process_feedback(const uint32_t* ids, size_t count, uint64_t frameNumber, std::pmr::vector<uint32_t>& requests)
+{
+	std::pmr::memory_resource* resource = requests.get_allocator().resource();
+	std::pmr::unordered_set<uint32_t> seen(resource);
+	std::pmr::unordered_set<uint32_t> requested(resource);
+
+	for (size_t i = 0; i < count; i++) {
+		uint32_t page = ids[i];
+		if (page == vkvt::INVALID_PAGE || !seen.insert(page).second) {
+			continue;
+		}
+
+		uint32_t mip = vkvt::page_mip(page);
+		if (mip >= _mipCount ||
+			vkvt::page_x(page) >= vkvt::pages_per_side(_sizeInPages, mip) ||
+			vkvt::page_y(page) >= vkvt::pages_per_side(_sizeInPages, mip)) {
+			continue;
+		}
+
+		// 往上找到第一个驻留的祖先 (当前实际采样的页)，沿途缺的页都要请求
+		while (mip < _mipCount) {
+			auto it = _resident.find(page);
+			if (it != _resident.end()) {
+				touch(it->second, frameNumber);
+				break;
+			}
+			if (requested.insert(page).second) {
+				requests.push_back(page);
+			}
+			mip++;
+			page = vkvt::page_id(mip, vkvt::page_x(page) >> 1, vkvt::page_y(page) >> 1);
+		}
+	}
+
+	// 粗的 mip 先加载：它覆盖的范围大，能最快消除模糊
+	std::sort(requests.begin(), requests.end(), [](uint32_t a, uint32_t b) {
+		return vkvt::page_mip(a) > vkvt::page_mip(b);
+	});
+}
+
+bool VirtualPageCache::allocate_slot(uint64_t frameNumber, uint32_t& slot, uint32_t& evictedPage)
+{
+	evictedPage = vkvt::INVALID_PAGE;
+	if (!_freeSlots.empty()) {
+		slot = _freeSlots.back();
+		_freeSlots.pop_back();
+		return true;
+	}
+
+	if (_lru.empty()) {
+		return false;
+	}
+	const uint32_t victim = _lru.back();
+	if (_slots[victim].lastUsed >= frameNumber) {
+		return false; // 最旧的页这一帧还在用，缓存已经装不下工作集
+	}
+
+	evictedPage = _slots[victim].page;
+	evict(victim);
+	slot = victim;
+	return true;
+}
+
+void VirtualPageCache::make_resident(uint32_t page, uint32_t slot, uint64_t frameNumber, bool pinned)
+{
+	Slot& s = _slots[slot];
+	s.page = page;
+	s.lastUsed = frameNumber;
+	s.pinned = pinned;
+	if (!pinned) {
+		_lru.push_front(slot);
+		s.lru = _lru.begin();
+	}
+	_resident[page] = slot;
+
+	remap_subtree(page, 0, 0, pack_entry(slot_x(slot), slot_y(slot), vkvt::page_mip(page)), true);
+}
+
+void VirtualPageCache::evict(uint32_t slot)
+{
+	Slot& s = _slots[slot];
+	const uint32_t page = s.page;
+	const uint32_t mip = vkvt::page_mip(page);
+
+	// 原来映射到它的条目退回到父页的映射
+	uint32_t fallback = vkvt::INVALID_PAGE;
+	if (mip + 1 < _mipCount) {
+		fallback = entry(mip + 1, vkvt::page_x(page) >> 1, vkvt::page_y(page) >> 1);
+	}
+	remap_subtree(page, mip, slot, fallback, false);
+
+	_resident.erase(page);
+	if (!s.pinned) {
+		_lru.erase(s.lru);
+	}
+	s = Slot{};
+}
+
+void VirtualPageCache::touch(uint32_t slot, uint64_t frameNumber)
+{
+	Slot& s = _slots[slot];
+	s.lastUsed = frameNumber;
+	if (!s.pinned) {
+		_lru.splice(_lru.begin(), _lru, s.lru);
+	}
+}
+
+void VirtualPageCache::remap_subtree(uint32_t page, uint32_t fromMip, uint32_t fromSlot, uint32_t to, bool onlyCoarser)
+{
+	const uint32_t mip = vkvt::page_mip(page);
+	const uint32_t from = pack_entry(slot_x(fromSlot), slot_y(fromSlot), fromMip);
+
+	for (int32_t level = (int32_t)mip; level >= 0; level--) {
+		const uint32_t scale = 1u << (mip - level);
+		const uint32_t side = vkvt::pages_per_side(_sizeInPages, level);
+		const uint32_t x0 = vkvt::page_x(page) * scale;
+		const uint32_t y0 = vkvt::page_y(page) * scale;
+
+		for (uint32_t y = y0; y < std::min(y0 + scale, side); y++) {
+			for (uint32_t x = x0; x < std::min(x0 + scale, side); x++) {
+				uint32_t& e = entry(level, x, y);
+				if (onlyCoarser) {
+					// 还没有映射，或者映射的页比新页粗
+					if (e == vkvt::INVALID_PAGE || (e >> 16) > mip) {
+						e = to;
+					}
+				}
+				else if (e == from) {
+					e = to;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+// 虚拟纹理 (.vtex) 文件格式，由 VTBuilder 生成
+// 纹理切成固定大小的页，每页四周带 border 个像素的边 (双线性过滤不会采到隔壁页)
+// 页按 mip 从细到粗、每个 mip 内按行存放，可以 mmap 后按下标随机读取
+namespace vkvt {
+
+	constexpr uint32_t VTEX_MAGIC = 0x58455456; // "VTEX"
+	constexpr uint32_t VTEX_VERSION = 1;
+	constexpr uint32_t MAX_MIPS = 16;
+
+	struct VtexHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t size;       // 第 0 层边长 (正方形，2 的幂)
+		uint32_t pageSize;   // 每页有效像素
+		uint32_t border;
+		uint32_t mipCount;   // 最粗的一层只有 1 页
+		uint32_t format;     // VkFormat，目前固定 RGBA8
+		uint32_t tileBytes;  // (pageSize + 2 * border)^2 * 4
+		uint32_t pageCount;
+		uint32_t reserved;
+		uint64_t pagesOffset;
+	};
+
+	// 页 ID：和 shader 写进反馈缓冲区的值是同一个编码
+	constexpr uint32_t INVALID_PAGE = 0xFFFFFFFF;
+	inline uint32_t page_id(uint32_t mip, uint32_t x, uint32_t y) { return (mip << 24) | (y << 12) | x; }
+	inline uint32_t page_mip(uint32_t id) { return id >> 24; }
+	inline uint32_t page_x(uint32_t id) { return id & 0xFFF; }
+	inline uint32_t page_y(uint32_t id) { return (id >> 12) & 0xFFF; }
+
+	inline uint32_t pages_per_side(uint32_t sizeInPages, uint32_t mip) { return std::max(1u, sizeInPages >> mip); }
+
+	// 每个 mip 的第一页在全部页里的下标 (文件里的 tile 顺序和页表里的条目顺序相同)，返回总页数
+	inline uint32_t mip_offsets(uint32_t sizeInPages, uint32_t mipCount, uint32_t* offsets)
+	{
+		uint32_t total = 0;
+		for (uint32_t mip = 0; mip < mipCount; mip++) {
+			offsets[mip] = total;
+			const uint32_t side = pages_per_side(sizeInPages, mip);
+			total += side * side;
+		}
+		return total;
+	}
+}
+
+// 页缓存的 CPU 部分：驻留表、LRU、页表条目、请求排序
+// 不碰任何 Vulkan 对象，可以脱离 GPU 单独驱动 (无头测试)
+class VirtualPageCache {
+public:
+	// 页表条目：物理页坐标 + 实际映射的 mip，没有任何祖先驻留时为 INVALID_PAGE
+	static uint32_t pack_entry(uint32_t slotX, uint32_t slotY, uint32_t mip) { return (mip << 16) | (slotY << 8) | slotX; }
+
+	void init(uint32_t sizeInPages, uint32_t mipCount, uint32_t tilesPerRow);
+
+	// 解析一帧的反馈：命中的页刷新 LRU，缺失的页 (连同缺失的祖先) 加入请求列表，粗的 mip 优先
+	// 去重用的临时集合和 requests 用同一个内存资源 (引擎里是帧 arena)
+	void process_feedback(const uint32_t* ids, size_t count, uint64_t frameNumber, std::pmr::vector<uint32_t>& requests);
+
+	// 为新页找一个物理槽位：先用空闲的，再淘汰最久没用的；最近一帧还在用的页不会被淘汰
+	// 返回 false 表示缓存装不下当前的工作集
+	bool allocate_slot(uint64_t frameNumber, uint32_t& slot, uint32_t& evictedPage);
+
+	// 页已经拷贝进 slot：更新驻留表和页表 (子树里比它粗的映射全部替换成它)
+	void make_resident(uint32_t page, uint32_t slot, uint64_t frameNumber, bool pinned);
+
+	bool is_resident(uint32_t page) const { return _resident.count(page) != 0; }
+	uint32_t resident_count() const { return (uint32_t)_resident.size(); }
+	uint32_t slot_count() const { return (uint32_t)_slots.size(); }
+	uint32_t slot_x(uint32_t slot) const { return slot % _tilesPerRow; }
+	uint32_t slot_y(uint32_t slot) const { return slot / _tilesPerRow; }
+
+	const std::vector<uint32_t>& entries() const { return _entries; }
+	const uint32_t* mip_offsets() const { return _mipOffsets; }
+
+	// 上一次 make_resident / 淘汰修改过的页表范围 [begin, end)，用于只刷新改动的部分
+	uint32_t dirty_begin() const { return _dirtyBegin; }
+	uint32_t dirty_end() const { return _dirtyEnd; }
+	void clear_dirty() { _dirtyBegin = UINT32_MAX; _dirtyEnd = 0; }
+
+private:
+	struct Slot {
+		uint32_t page{ vkvt::INVALID_PAGE };
+		uint64_t lastUsed{ 0 };
+		bool pinned{ false };
+		std::list<uint32_t>::iterator lru;
+	};
+
+	void evict(uint32_t slot);
+	void touch(uint32_t slot, uint64_t frameNumber);
+	uint32_t& entry(uint32_t mip, uint32_t x, uint32_t y);
+	// 把 page 的子树里 "映射到 from" 的条目改成 to (from 为 INVALID_PAGE 时改的是比 page 粗的映射)
+	void remap_subtree(uint32_t page, uint32_t fromMip, uint32_t fromSlot, uint32_t to, bool onlyCoarser);
+
+	uint32_t _sizeInPages{ 0 };
+	uint32_t _mipCount{ 0 };
+	uint32_t _tilesPerRow{ 1 };
+	uint32_t _mipOffsets[vkvt::MAX_MIPS]{};
+
+	std::vector<uint32_t> _entries;
+	std::vector<Slot> _slots;
+	std::vector<uint32_t> _freeSlots;
+	std::list<uint32_t> _lru; // 前面是最近用过的，不包含固定页
+	std::unordered_map<uint32_t, uint32_t> _resident; // 页 ID -> 槽位
+
+	uint32_t _dirtyBegin{ UINT32_MAX };
+	uint32_t _dirtyEnd{ 0 };
+};
@@ -0,0 +1,312 @@
+#include "vk_particles.h"
+
+#include <algorithm>
+
+bool ParticleSystem::init(VkDevice device, VkPhysicalDevice gpu, MemoryManager* memory, BindlessHeap* bindless)
+{
+	_device = device;
+	_memory = memory;
+	_bindless = bindless;
+
+	auto create = [this](VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, MemoryCategory category,
+		AllocatedBuffer& out, void** mapped) {
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.pNext = nullptr;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		if (!_memory->create_buffer(bufferInfo, memoryUsage, category, out)) {
+			vklog::error() << "Failed to allocate particle buffer (" << size << " bytes)";
+			return false;
+		}
+		if (mapped) {
+			vmaMapMemory(_memory->allocator(), out._allocation, mapped);
+		}
+		return true;
+	};
+
+	// 计数 buffer 同时是间接参数和回读的拷贝源
+	if (!create(particle_buffer_size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::Other, _particles, nullptr) ||
+		!create(list_buffer_size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::Other, _lists, nullptr) ||
+		!create(counter_buffer_size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::Other, _counters, nullptr) ||
+		!create(sizeof(GPUParticleFrame), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Other,
+			_frame, (void**)&_frameData) ||
+		!create((VkDeviceSize)MAX_EMITTERS * sizeof(GPUParticleEmitter), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+			MemoryCategory::Other, _emitters, (void**)&_emitterData) ||
+		!create(counter_buffer_size(), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU, MemoryCategory::Staging,
+			_readback, (void**)&_readbackData)) {
+		return false;
+	}
+	*_frameData = {};
+	_particleSlot = _bindless->add_storage_buffer(_particles._buffer);
+	_listSlot = _bindless->add_storage_buffer(_lists._buffer);
+	_counterSlot = _bindless->add_storage_buffer(_counters._buffer);
+	_frameSlot = _bindless->add_storage_buffer(_frame._buffer);
+	_emitterSlot = _bindless->add_storage_buffer(_emitters._buffer);
+
+	// 模拟耗时的时间戳 (不支持时只是没有耗时统计)
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(gpu, &properties);
+	if (properties.limits.timestampComputeAndGraphics && properties.limits.timestampPeriod > 0.0f) {
+		VkQueryPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.pNext = nullptr;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = 2;
+		if (vkCreateQueryPool(_device, &poolInfo, nullptr, &_queryPool) != VK_SUCCESS) {
+			vklog::error() << "Failed to create particle timestamp query pool";
+			_queryPool = VK_NULL_HANDLE;
+		}
+		_timestampPeriodNs = properties.limits.timestampPeriod;
+	}
+	return true;
+}
+
+void ParticleSystem::cleanup()
+{
+	// bindless 槽位随全局 set 一起释放
+	if (_device == VK_NULL_HANDLE) {
+		return;
+	}
+	if (_queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(_device, _queryPool, nullptr);
+		_queryPool = VK_NULL_HANDLE;
+	}
+	if (_frameData) {
+		vmaUnmapMemory(_memory->allocator(), _frame._allocation);
+		_memory->destroy_buffer(_frame);
+	}
+	if (_emitterData) {
+		vmaUnmapMemory(_memory->allocator(), _emitters._allocation);
+		_memory->destroy_buffer(_emitters);
+	}
+	if (_readbackData) {
+		vmaUnmapMemory(_memory->allocator(), _readback._allocation);
+		_memory->destroy_buffer(_readback);
+	}
+	for (AllocatedBuffer* buffer : { &_particles, &_lists, &_counters }) {
+		if (buffer->_buffer != VK_NULL_HANDLE) {
+			_memory->destroy_buffer(*buffer);
+		}
+		*buffer = {};
+	}
+	_frameData = nullptr;
+	_emitterData = nullptr;
+	_readbackData = nullptr;
+	_device = VK_NULL_HANDLE;
+}
+
+void ParticleSystem::set_pipelines(VkPipelineLayout layout, VkShaderStageFlags pushStages,
+	VkPipeline emit, VkPipeline simulate, VkPipeline args, VkPipeline draw)
+{
+	_layout = layout;
+	_pushStages = pushStages;
+	_emitPipeline = emit;
+	_simulatePipeline = simulate;
+	_argsPipeline = args;
+	_drawPipeline = emit != VK_NULL_HANDLE && simulate != VK_NULL_HANDLE && args != VK_NULL_HANDLE ? draw : VK_NULL_HANDLE;
+}
+
+void ParticleSystem::set_depth(uint32_t depthTexture, uint32_t sampler)
+{
+	_depthTexture = depthTexture;
+	_depthSampler = sampler;
+}
+
+void ParticleSystem::begin_frame(const glm::mat4& view, const glm::mat4& viewProj)
+{
+	// 上一帧的计数和时间戳已经完成 (等过 fence)
+	if (_readbackPending) {
+		_readbackPending = false;
+		const uint32_t emitted = _readbackData[COUNTER_EMITTED];
+		const uint32_t dropped = _readbackData[COUNTER_DROPPED];
+		_stats.alive = _readbackData[COUNTER_DRAW + 1];
+		_stats.emitted = emitted - _lastEmitted;
+		_stats.dropped = dropped - _lastDropped;
+		_lastEmitted = emitted;
+		_lastDropped = dropped;
+	}
+	if (_queryPending) {
+		_queryPending = false;
+		uint64_t timestamps[2] = {};
+		if (vkGetQueryPoolResults(_device, _queryPool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS &&
+			timestamps[1] > timestamps[0]) {
+			_stats.simulateMs = (float)((double)(timestamps[1] - timestamps[0]) * _timestampPeriodNs / 1000000.0);
+		}
+	}
+
+	// 相机的右 / 上方向是 view 矩阵前两行
+	GPUParticleFrame frame = {};
+	frame.viewProj = viewProj;
+	frame.cameraRight = glm::vec4(view[0][0], view[1][0], view[2][0], TIME_STEP);
+	frame.cameraUp = glm::vec4(view[0][1], view[1][1], view[2][1], _settings.restitution);
+	frame.gravityDrag = glm::vec4(_settings.gravity, _settings.drag);
+	frame.parity = _parity;
+	frame.depthTexture = _settings.depthCollision ? _depthTexture : INVALID_SLOT;
+	frame.depthSampler = _depthSampler;
+	frame.collisionThickness = _settings.collisionThickness;
+	*_frameData = frame; // emitterCount 在 emit 里补上
+
+	_emitterCount = 0;
+	_maxEmitCount = 0;
+	_stats.requested = 0;
+}
+
+bool ParticleSystem::add_emitter(const glm::vec3& position, float radius, const glm::vec3& velocity, float spread,
+	const glm::vec4& color, float lifetime, float size, uint32_t count)
+{
+	if (_emitterCount >= MAX_EMITTERS) {
+		return false;
+	}
+	if (count == 0) {
+		return true;
+	}
+	// 一帧最多把整个粒子池发射一遍
+	count = std::min(count, MAX_PARTICLES);
+
+	GPUParticleEmitter& emitter = _emitterData[_emitterCount++];
+	emitter.position = position;
+	emitter.radius = radius;
+	emitter.velocity = velocity;
+	emitter.spread = spread;
+	emitter.color = color;
+	emitter.lifetime = lifetime;
+	emitter.size = size;
+	emitter.count = count;
+	emitter.seed = _seed++ * 0x9E3779B9u;
+	_maxEmitCount = std::max(_maxEmitCount, count);
+	_stats.requested += count;
+	return true;
+}
+
+void ParticleSystem::push(VkCommandBuffer cmd, VkPipeline pipeline, VkPipelineBindPoint bindPoint, uint32_t mode)
+{
+	PushConstants constants = {};
+	constants.particleBuffer = _particleSlot;
+	constants.listBuffer = _listSlot;
+	constants.counterBuffer = _counterSlot;
+	constants.frameBuffer = _frameSlot;
+	constants.emitterBuffer = _emitterSlot;
+	constants.mode = mode;
+
+	vkCmdBindPipeline(cmd, bindPoint, pipeline);
+	_bindless->bind(cmd, _layout, bindPoint);
+	vkCmdPushConstants(cmd, _layout, _pushStages, 0, sizeof(constants), &constants);
+}
+
+void ParticleSystem::compute_barrier(VkCommandBuffer cmd)
+{
+	VkMemoryBarrier2 barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+	barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+	barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+	barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+	barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+	VkDependencyInfo dependency = {};
+	dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependency.memoryBarrierCount = 1;
+	dependency.pMemoryBarriers = &barrier;
+	vkCmdPipelineBarrier2(cmd, &dependency);
+}
+
+void ParticleSystem::emit(VkCommandBuffer cmd)
+{
+	if (!enabled()) {
+		return;
+	}
+
+	// 开始时间戳等前面所有的命令做完，只量粒子自己的几次分发
+	if (_queryPool != VK_NULL_HANDLE) {
+		vkCmdResetQueryPool(cmd, _queryPool, 0, 2);
+		vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, _queryPool, 0);
+	}
+
+	// 第一帧：所有粒子都进空闲表 (显存的初始内容是未定义的)
+	if (!_initialized) {
+		push(cmd, _argsPipeline, VK_PIPELINE_BIND_POINT_COMPUTE, 0);
+		vkCmdDispatch(cmd, (MAX_PARTICLES + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+		compute_barrier(cmd);
+		_initialized = true;
+	}
+
+	_frameData->emitterCount = _emitterCount;
+	if (_emitterCount == 0) {
+		return;
+	}
+	push(cmd, _emitPipeline, VK_PIPELINE_BIND_POINT_COMPUTE, 0);
+	vkCmdDispatch(cmd, (_maxEmitCount + GROUP_SIZE - 1) / GROUP_SIZE, _emitterCount, 1);
+}
+
+void ParticleSystem::prepare(VkCommandBuffer cmd)
+{
+	if (!enabled()) {
+		return;
+	}
+	push(cmd, _argsPipeline, VK_PIPELINE_BIND_POINT_COMPUTE, 1);
+	vkCmdDispatch(cmd, 1, 1, 1);
+}
+
+void ParticleSystem::simulate(VkCommandBuffer cmd)
+{
+	if (!enabled()) {
+		return;
+	}
+	push(cmd, _simulatePipeline, VK_PIPELINE_BIND_POINT_COMPUTE, 0);
+	vkCmdDispatchIndirect(cmd, _counters._buffer, COUNTER_DISPATCH * sizeof(uint32_t));
+}
+
+void ParticleSystem::finalize(VkCommandBuffer cmd)
+{
+	if (!enabled()) {
+		return;
+	}
+	push(cmd, _argsPipeline, VK_PIPELINE_BIND_POINT_COMPUTE, 2);
+	vkCmdDispatch(cmd, 1, 1, 1);
+
+	if (_queryPool != VK_NULL_HANDLE) {
+		vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, _queryPool, 1);
+		_queryPending = true;
+	}
+	// 这一帧模拟写的存活表是下一帧发射 / 模拟读的
+	_parity ^= 1;
+}
+
+void ParticleSystem::draw(VkCommandBuffer cmd)
+{
+	if (!enabled()) {
+		return;
+	}
+	// 6 个顶点 (两个三角形) x 存活数个实例，实例数是 finalize 写的
+	push(cmd, _drawPipeline, VK_PIPELINE_BIND_POINT_GRAPHICS, 0);
+	vkCmdDrawIndirect(cmd, _counters._buffer, COUNTER_DRAW * sizeof(uint32_t), 1, sizeof(VkDrawIndirectCommand));
+}
+
+void ParticleSystem::readback(VkCommandBuffer cmd)
+{
+	if (!enabled()) {
+		return;
+	}
+	VkBufferCopy region = {};
+	region.size = counter_buffer_size();
+	vkCmdCopyBuffer(cmd, _counters._buffer, _readback._buffer, 1, &region);
+
+	// 拷贝结果对 CPU 可见 (下一帧 fence 之后读)
+	VkBufferMemoryBarrier2 barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+	barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+	barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+	barrier.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+	barrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = _readback._buffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+	VkDependencyInfo dependency = {};
+	dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependency.bufferMemoryBarrierCount = 1;
+	dependency.pBufferMemoryBarriers = &barrier;
+	vkCmdPipelineBarrier2(cmd, &dependency);
+	_readbackPending = true;
+}
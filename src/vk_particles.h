@@ -0,0 +1,193 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_descriptors.h"
+#include "vk_memory.h"
+
+// GPU 粒子
+// 粒子的状态只在 GPU 上，CPU 每帧只写发射器表和一小块帧参数，粒子再多 CPU 的开销也不变
+// 每帧 (渲染图里 forward 之后的几个 pass)：
+// 1. emit：每个发射器一行工作组，新粒子从空闲表 (dead list) 里弹出下标、初始化，追加进当前的存活表
+// 2. prepare：一个线程按存活数写模拟的间接分发参数，清空另一张存活表
+// 3. simulate：间接分发，每个线程一个存活粒子：速度 / 重力 / 阻力 / 寿命，可选按这一帧的深度图碰撞反弹
+//    活着的紧凑地追加进另一张存活表，死了的下标压回空闲表
+// 4. finalize：一个线程把存活数写进绘制的间接参数
+// 5. draw：vkCmdDrawIndirect，实例数来自 GPU，每个实例一个面向相机的四边形 (加法混合，深度只测不写)
+// 两张存活表每帧交换；计数 (CPU 看的累计发射 / 丢弃、存活数) 拷进回读 buffer，下一帧 fence 之后读
+// 模拟耗时来自 emit 开头和 finalize 结尾的时间戳
+// 只在渲染线程上使用；FRAMES_IN_FLIGHT = 1，写帧参数 / 发射器表之前已经等过 fence
+
+// 和 shaders/particles.glsl 里的 Particle 一致 (std430)
+struct GPUParticle {
+	glm::vec3 position;
+	float age;          // 秒，超过 lifetime 就死
+	glm::vec3 velocity;
+	float lifetime;
+	uint32_t color;     // unorm8 x 4
+	float size;         // 四边形的半边长
+	uint32_t pad0;
+	uint32_t pad1;
+};
+static_assert(sizeof(GPUParticle) == 48);
+
+// 和 shaders/particles.glsl 里的 Emitter 一致 (std430)
+struct GPUParticleEmitter {
+	glm::vec3 position;
+	float radius;       // 在这个球里随机出生
+	glm::vec3 velocity;
+	float spread;       // 叠加在 velocity 上的随机速度 (球内均匀) 的大小
+	glm::vec4 color;
+	float lifetime;     // 每个粒子在 [0.5, 1] * lifetime 之间随机
+	float size;
+	uint32_t count;     // 这一帧发射多少个
+	uint32_t seed;
+};
+static_assert(sizeof(GPUParticleEmitter) == 64);
+
+// 和 shaders/particles.glsl 里的 ParticleFrame 一致 (std430)
+struct GPUParticleFrame {
+	glm::mat4 viewProj;
+	glm::vec4 cameraRight;   // xyz 世界空间的相机右方向，w 时间步长 (秒)
+	glm::vec4 cameraUp;      // xyz 世界空间的相机上方向，w 碰撞的反弹系数
+	glm::vec4 gravityDrag;   // xyz 重力加速度，w 阻力 (每秒损失的速度比例)
+	uint32_t emitterCount;
+	uint32_t parity;         // 这一帧发射 / 模拟读的存活表 (模拟写另一张)
+	uint32_t depthTexture;   // textures[] 下标，INVALID_SLOT 时不碰撞
+	uint32_t depthSampler;
+	float collisionThickness; // 粒子在表面后面这么远 (相机空间深度) 以内才算撞上，再往后是被挡住了
+	uint32_t pad0;
+	uint32_t pad1;
+	uint32_t pad2;
+};
+static_assert(sizeof(GPUParticleFrame) == 144);
+
+struct ParticleStats {
+	uint32_t alive{ 0 };      // 上一帧模拟之后活着的
+	uint32_t emitted{ 0 };    // 上一帧真正发射的
+	uint32_t dropped{ 0 };    // 上一帧没有空闲粒子、没发出去的
+	uint32_t requested{ 0 };  // 这一帧交给 GPU 的发射数
+	float simulateMs{ 0.0f }; // 上一帧 emit -> finalize 的 GPU 时间 (不支持时间戳时为 0)
+};
+
+// 所有粒子共用的力和碰撞参数 (每帧写进帧参数，随时可以改)
+struct ParticleSettings {
+	glm::vec3 gravity{ 0.0f, -9.8f, 0.0f };
+	float drag{ 0.3f };                 // 每秒损失的速度比例
+	float restitution{ 0.4f };          // 碰撞后法线方向保留的速度比例
+	float collisionThickness{ 0.5f };   // 见 GPUParticleFrame
+	bool depthCollision{ true };
+};
+
+class ParticleSystem {
+public:
+	static constexpr uint32_t MAX_PARTICLES = 1u << 20; // 和 particles.glsl 的 MAX_PARTICLES 一致
+	static constexpr uint32_t MAX_EMITTERS = 1024;
+	static constexpr uint32_t GROUP_SIZE = 64;          // 和几个计算着色器的 local_size_x 一致
+	static constexpr float TIME_STEP = 1.0f / 60.0f;    // 和模拟线程一样按帧步进 (回放可重复)
+
+	// 计数 buffer 的布局 (uint 下标)，和 particles.glsl 一致
+	static constexpr uint32_t COUNTER_DRAW = 0;      // VkDrawIndirectCommand
+	static constexpr uint32_t COUNTER_DISPATCH = 4;  // VkDispatchIndirectCommand
+	static constexpr uint32_t COUNTER_DEAD = 8;      // 空闲表里的个数
+	static constexpr uint32_t COUNTER_ALIVE = 9;     // 两张存活表的个数
+	static constexpr uint32_t COUNTER_EMITTED = 11;  // 累计发射 (不清零，CPU 取差)
+	static constexpr uint32_t COUNTER_DROPPED = 12;  // 累计丢弃
+	static constexpr uint32_t COUNTER_COUNT = 16;
+
+	bool init(VkDevice device, VkPhysicalDevice gpu, MemoryManager* memory, BindlessHeap* bindless);
+	void cleanup();
+
+	// 四个计算管线 + 公告板管线 (同一个 layout)；任何一个没有时整个系统不工作
+	void set_pipelines(VkPipelineLayout layout, VkShaderStageFlags pushStages,
+		VkPipeline emit, VkPipeline simulate, VkPipeline args, VkPipeline draw);
+	// 深度碰撞用的深度图 (textures[] 下标，采样时是 SHADER_READ_ONLY)；INVALID_SLOT 时不碰撞
+	void set_depth(uint32_t depthTexture, uint32_t sampler);
+
+	// 每帧：begin_frame -> add_emitter... -> (渲染图) emit / prepare / simulate / finalize / draw / readback
+	void begin_frame(const glm::mat4& view, const glm::mat4& viewProj);
+	// 表满了返回 false
+	bool add_emitter(const glm::vec3& position, float radius, const glm::vec3& velocity, float spread,
+		const glm::vec4& color, float lifetime, float size, uint32_t count);
+
+	void emit(VkCommandBuffer cmd);
+	void prepare(VkCommandBuffer cmd);
+	void simulate(VkCommandBuffer cmd);
+	void finalize(VkCommandBuffer cmd);
+	// 在已经开始的动态渲染里画 (颜色 LOAD，深度只读)
+	void draw(VkCommandBuffer cmd);
+	void readback(VkCommandBuffer cmd);
+
+	VkBuffer particle_buffer() const { return _particles._buffer; }
+	VkDeviceSize particle_buffer_size() const { return (VkDeviceSize)MAX_PARTICLES * sizeof(GPUParticle); }
+	VkBuffer list_buffer() const { return _lists._buffer; }
+	VkDeviceSize list_buffer_size() const { return (VkDeviceSize)MAX_PARTICLES * 3 * sizeof(uint32_t); }
+	VkBuffer counter_buffer() const { return _counters._buffer; }
+	VkDeviceSize counter_buffer_size() const { return (VkDeviceSize)COUNTER_COUNT * sizeof(uint32_t); }
+
+	bool enabled() const { return _drawPipeline != VK_NULL_HANDLE; }
+	const ParticleStats& stats() const { return _stats; }
+	ParticleSettings& settings() { return _settings; }
+
+private:
+	// 和 particles.glsl 里的 push constant 一致
+	struct PushConstants {
+		uint32_t particleBuffer;
+		uint32_t listBuffer;
+		uint32_t counterBuffer;
+		uint32_t frameBuffer;
+		uint32_t emitterBuffer;
+		uint32_t mode;      // particle_args.comp：0 初始化空闲表，1 模拟的分发参数，2 绘制参数
+		uint32_t pad0;
+		uint32_t pad1;
+	};
+
+	void push(VkCommandBuffer cmd, VkPipeline pipeline, VkPipelineBindPoint bindPoint, uint32_t mode);
+	// 计算写 -> 计算读写 (同一个 pass 里的两次分发之间)
+	static void compute_barrier(VkCommandBuffer cmd);
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	MemoryManager* _memory{ nullptr };
+	BindlessHeap* _bindless{ nullptr };
+
+	VkPipelineLayout _layout{ VK_NULL_HANDLE };
+	VkShaderStageFlags _pushStages{ 0 };
+	VkPipeline _emitPipeline{ VK_NULL_HANDLE };
+	VkPipeline _simulatePipeline{ VK_NULL_HANDLE };
+	VkPipeline _argsPipeline{ VK_NULL_HANDLE };
+	VkPipeline _drawPipeline{ VK_NULL_HANDLE };
+
+	// 粒子 / 下标表 (空闲表 + 两张存活表) / 计数只在 GPU 上；帧参数和发射器表 CPU 每帧写，回读 buffer GPU 每帧拷，都常驻映射
+	AllocatedBuffer _particles{};
+	AllocatedBuffer _lists{};
+	AllocatedBuffer _counters{};
+	AllocatedBuffer _frame{};
+	GPUParticleFrame* _frameData{ nullptr };
+	AllocatedBuffer _emitters{};
+	GPUParticleEmitter* _emitterData{ nullptr };
+	AllocatedBuffer _readback{};
+	uint32_t* _readbackData{ nullptr };
+	uint32_t _particleSlot{ INVALID_SLOT };
+	uint32_t _listSlot{ INVALID_SLOT };
+	uint32_t _counterSlot{ INVALID_SLOT };
+	uint32_t _frameSlot{ INVALID_SLOT };
+	uint32_t _emitterSlot{ INVALID_SLOT };
+	uint32_t _depthTexture{ INVALID_SLOT };
+	uint32_t _depthSampler{ INVALID_SLOT };
+
+	// emit 开头、finalize 结尾两个时间戳
+	VkQueryPool _queryPool{ VK_NULL_HANDLE };
+	float _timestampPeriodNs{ 0.0f };
+	bool _queryPending{ false };
+
+	bool _initialized{ false }; // 空闲表在第一帧的 emit pass 里填好
+	bool _readbackPending{ false };
+	uint32_t _lastEmitted{ 0 };
+	uint32_t _lastDropped{ 0 };
+	uint32_t _parity{ 0 };
+	uint32_t _emitterCount{ 0 };
+	uint32_t _maxEmitCount{ 0 };  // 最大的发射数，决定 emit 分发的 x
+	uint32_t _seed{ 0 };
+
+	ParticleSettings _settings{};
+	ParticleStats _stats{};
+};
@@ -0,0 +1,583 @@
+#include "vk_render_graph.h"
+
+#include <algorithm>
+
+namespace {
+
+	struct UsageInfo {
+		VkPipelineStageFlags2 stages;
+		VkAccessFlags2 readAccess;
+		VkAccessFlags2 writeAccess;
+		VkImageLayout layout;
+		VkImageUsageFlags imageUsage;
+	};
+
+	UsageInfo usage_info(RGUsage usage)
+	{
+		const VkPipelineStageFlags2 shaderStages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+		const VkPipelineStageFlags2 depthStages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+
+		switch (usage) {
+		case RGUsage::ColorAttachment:
+			return { VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+		case RGUsage::DepthAttachment:
+			return { depthStages, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+		case RGUsage::DepthRead:
+			return { depthStages, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, 0,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+		case RGUsage::Sampled:
+			return { shaderStages, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, 0,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT };
+		case RGUsage::StorageRead:
+			return { shaderStages, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, 0,
+				VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT };
+		case RGUsage::StorageWrite:
+			return { shaderStages, VK_ACCESS_2_SHADER_STORAGE_READ_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+				VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT };
+		case RGUsage::TransferSrc:
+			return { VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT, 0,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+		case RGUsage::TransferDst:
+			return { VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, 0, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+		case RGUsage::IndirectBuffer:
+			return { VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+		case RGUsage::VertexBuffer:
+			return { VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT, VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+		case RGUsage::IndexBuffer:
+			return { VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+		}
+		return {};
+	}
+
+	VkImageAspectFlags aspect_of(VkFormat format)
+	{
+		switch (format) {
+		case VK_FORMAT_D16_UNORM:
+		case VK_FORMAT_D32_SFLOAT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT;
+		case VK_FORMAT_D24_UNORM_S8_UINT:
+		case VK_FORMAT_D32_SFLOAT_S8_UINT:
+			return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		default:
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+	}
+}
+
+// ============================================================
+// PassBuilder
+// ============================================================
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(RGResource resource, RGUsage usage, VkPipelineStageFlags2 stages)
+{
+	_graph->add_access(_pass, resource, usage, stages, false);
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(RGResource resource, RGUsage usage, VkPipelineStageFlags2 stages)
+{
+	_graph->add_access(_pass, resource, usage, stages, true);
+	return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::side_effect()
+{
+	_graph->_passes[_pass].sideEffect = true;
+	return *this;
+}
+
+// ============================================================
+// RenderGraph
+// ============================================================
+
+void RenderGraph::init(VkDevice device, MemoryManager* memory)
+{
+	_device = device;
+	_memory = memory;
+}
+
+void RenderGraph::cleanup()
+{
+	reset();
+}
+
+void RenderGraph::reset()
+{
+	release_transients();
+	_resources.clear();
+	_passes.clear();
+	_compiled = false;
+}
+
+RGResource RenderGraph::import_image(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+	VkImageLayout initialLayout, VkImageLayout finalLayout, VkPipelineStageFlags2 initialStages)
+{
+	Resource resource;
+	resource.name = name;
+	resource.imported = true;
+	resource.desc = { format, extent };
+	resource.aspect = aspect_of(format);
+	resource.image = image;
+	resource.view = view;
+	resource.initialLayout = initialLayout;
+	resource.finalLayout = finalLayout;
+	resource.initialStages = initialStages;
+	_resources.push_back(resource);
+	_compiled = false;
+	return (RGResource)(_resources.size() - 1);
+}
+
+RGResource RenderGraph::import_buffer(const char* name, VkBuffer buffer, VkDeviceSize size)
+{
+	Resource resource;
+	resource.name = name;
+	resource.isImage = false;
+	resource.imported = true;
+	resource.buffer = buffer;
+	resource.size = size;
+	_resources.push_back(resource);
+	_compiled = false;
+	return (RGResource)(_resources.size() - 1);
+}
+
+void RenderGraph::set_imported_image(RGResource resource, VkImage image, VkImageView view)
+{
+	_resources[resource].image = image;
+	_resources[resource].view = view;
+}
+
+RGResource RenderGraph::create_image(const char* name, const RGImageDesc& desc)
+{
+	Resource resource;
+	resource.name = name;
+	resource.desc = desc;
+	resource.aspect = aspect_of(desc.format);
+	_resources.push_back(resource);
+	_compiled = false;
+	return (RGResource)(_resources.size() - 1);
+}
+
+RenderGraph::PassBuilder RenderGraph::add_pass(const char* name, std::function<void(VkCommandBuffer)> execute)
+{
+	Pass pass;
+	pass.name = name;
+	pass.execute = std::move(execute);
+	_passes.push_back(std::move(pass));
+	_compiled = false;
+	return PassBuilder(this, (uint32_t)(_passes.size() - 1));
+}
+
+void RenderGraph::add_access(uint32_t pass, RGResource resource, RGUsage usage, VkPipelineStageFlags2 stages, bool write)
+{
+	const UsageInfo info = usage_info(usage);
+
+	Access access;
+	access.resource = resource;
+	access.stages = stages ? stages : info.stages;
+	access.access = info.readAccess | (write ? info.writeAccess : 0);
+	access.layout = _resources[resource].isImage ? info.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+	access.read = !write;
+	access.write = write;
+
+	_resources[resource].usage |= info.imageUsage;
+
+	// 同一个 pass 多次声明同一个资源 (比如先读后写) 合并成一次访问
+	for (Access& existing : _passes[pass].accesses) {
+		if (existing.resource == resource) {
+			if (existing.layout != access.layout) {
+				vklog::error() << "Render graph pass '" << _passes[pass].name << "' uses '"
+					<< _resources[resource].name << "' in two different layouts";
+			}
+			existing.stages |= access.stages;
+			existing.access |= access.access;
+			existing.read = existing.read || access.read;
+			existing.write = existing.write || access.write;
+			return;
+		}
+	}
+	_passes[pass].accesses.push_back(access);
+}
+
+void RenderGraph::cull_passes()
+{
+	// 倒着走：一个 pass 有副作用、写了外部资源、或者写了后面的 pass 要读的资源，才需要保留
+	std::vector<bool> needed(_resources.size(), false);
+
+	for (size_t i = _passes.size(); i > 0; i--) {
+		Pass& pass = _passes[i - 1];
+
+		bool keep = pass.sideEffect;
+		for (const Access& access : pass.accesses) {
+			if (access.write && (_resources[access.resource].imported || needed[access.resource])) {
+				keep = true;
+			}
+		}
+
+		pass.culled = !keep;
+		if (!keep) {
+			continue;
+		}
+		// 只写不读的资源：更早的写入会被这次覆盖，不再需要
+		for (const Access& access : pass.accesses) {
+			if (access.write && !access.read) {
+				needed[access.resource] = false;
+			}
+		}
+		for (const Access& access : pass.accesses) {
+			if (access.read) {
+				needed[access.resource] = true;
+			}
+		}
+	}
+}
+
+bool RenderGraph::compile()
+{
+	release_transients();
+	cull_passes();
+
+	// 1. 瞬态图像的生命周期 (只算保留下来的 pass)
+	for (Resource& resource : _resources) {
+		resource.firstPass = UINT32_MAX;
+		resource.lastPass = 0;
+		resource.block = -1;
+		resource.aliasPrev = RG_INVALID_RESOURCE;
+		resource.touched = false;
+	}
+	uint32_t culled = 0;
+	for (uint32_t i = 0; i < (uint32_t)_passes.size(); i++) {
+		if (_passes[i].culled) {
+			culled++;
+			continue;
+		}
+		for (const Access& access : _passes[i].accesses) {
+			Resource& resource = _resources[access.resource];
+			resource.firstPass = std::min(resource.firstPass, i);
+			resource.lastPass = std::max(resource.lastPass, i);
+		}
+	}
+
+	// 2. 创建图像并分配显存 (生命周期不重叠的共享一块)
+	if (!allocate_transients()) {
+		release_transients();
+		return false;
+	}
+
+	_compiled = true;
+	vklog::info() << "Render graph: " << _passes.size() - culled << " passes (" << culled << " culled), "
+		<< _blocks.size() << " transient blocks, " << _transientBytes / 1024 << " KB ("
+		<< _unaliasedBytes / 1024 << " KB without aliasing)";
+	return true;
+}
+
+bool RenderGraph::allocate_transients()
+{
+	std::vector<RGResource> transients;
+	std::vector<VkMemoryRequirements> requirements(_resources.size());
+
+	for (RGResource r = 0; r < (RGResource)_resources.size(); r++) {
+		Resource& resource = _resources[r];
+		if (resource.imported || !resource.isImage || resource.firstPass == UINT32_MAX) {
+			continue; // 外部资源，或者只被剔除掉的 pass 用到
+		}
+
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.pNext = nullptr;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = resource.desc.format;
+		imageInfo.extent = { resource.desc.extent.width, resource.desc.extent.height, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = resource.usage;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+		if (vkCreateImage(_device, &imageInfo, nullptr, &resource.image) != VK_SUCCESS) {
+			vklog::error() << "Failed to create render graph image '" << resource.name << "'";
+			return false;
+		}
+		vkGetImageMemoryRequirements(_device, resource.image, &requirements[r]);
+		transients.push_back(r);
+	}
+
+	// 大的先放；每张图找第一块 "内存类型兼容、且里面所有图像的生命周期都和它不重叠" 的显存块
+	std::sort(transients.begin(), transients.end(), [&](RGResource a, RGResource b) {
+		return requirements[a].size > requirements[b].size;
+	});
+
+	_unaliasedBytes = 0;
+	for (RGResource r : transients) {
+		const Resource& resource = _resources[r];
+		const VkMemoryRequirements& req = requirements[r];
+		_unaliasedBytes += req.size;
+
+		int32_t chosen = -1;
+		for (int32_t b = 0; b < (int32_t)_blocks.size() && chosen < 0; b++) {
+			MemoryBlock& block = _blocks[b];
+			if ((block.requirements.memoryTypeBits & req.memoryTypeBits) == 0) {
+				continue;
+			}
+			bool overlaps = false;
+			for (RGResource other : block.residents) {
+				const Resource& o = _resources[other];
+				if (!(resource.lastPass < o.firstPass || o.lastPass < resource.firstPass)) {
+					overlaps = true;
+					break;
+				}
+			}
+			if (!overlaps) {
+				chosen = b;
+			}
+		}
+
+		if (chosen < 0) {
+			_blocks.push_back(MemoryBlock{});
+			_blocks.back().requirements = req;
+			chosen = (int32_t)_blocks.size() - 1;
+		}
+
+		MemoryBlock& block = _blocks[chosen];
+		block.requirements.size = std::max(block.requirements.size, req.size);
+		block.requirements.alignment = std::max(block.requirements.alignment, req.alignment);
+		block.requirements.memoryTypeBits &= req.memoryTypeBits;
+		block.residents.push_back(r);
+		_resources[r].block = chosen;
+	}
+
+	_transientBytes = 0;
+	for (MemoryBlock& block : _blocks) {
+		if (!_memory->allocate(block.requirements, MemoryCategory::Attachments, block.allocation)) {
+			vklog::error() << "Failed to allocate render graph memory (" << block.requirements.size << " bytes)";
+			return false;
+		}
+		_transientBytes += block.requirements.size;
+
+		// 同一块上的使用者按时间排好，每个使用者第一次使用前要等前一个用完
+		std::sort(block.residents.begin(), block.residents.end(), [&](RGResource a, RGResource b) {
+			return _resources[a].firstPass < _resources[b].firstPass;
+		});
+		for (size_t i = 0; i < block.residents.size(); i++) {
+			const size_t prev = (i + block.residents.size() - 1) % block.residents.size();
+			_resources[block.residents[i]].aliasPrev = block.residents[prev];
+		}
+	}
+
+	for (RGResource r : transients) {
+		Resource& resource = _resources[r];
+		if (vmaBindImageMemory(_memory->allocator(), _blocks[resource.block].allocation, resource.image) != VK_SUCCESS) {
+			vklog::error() << "Failed to bind render graph image '" << resource.name << "'";
+			return false;
+		}
+
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.pNext = nullptr;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.image = resource.image;
+		viewInfo.format = resource.desc.format;
+		viewInfo.subresourceRange.aspectMask = resource.aspect;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(_device, &viewInfo, nullptr, &resource.view) != VK_SUCCESS) {
+			vklog::error() << "Failed to create render graph image view '" << resource.name << "'";
+			return false;
+		}
+	}
+	return true;
+}
+
+void RenderGraph::release_transients()
+{
+	for (Resource& resource : _resources) {
+		if (resource.imported) {
+			continue;
+		}
+		if (resource.view != VK_NULL_HANDLE) {
+			vkDestroyImageView(_device, resource.view, nullptr);
+			resource.view = VK_NULL_HANDLE;
+		}
+		if (resource.image != VK_NULL_HANDLE) {
+			vkDestroyImage(_device, resource.image, nullptr);
+			resource.image = VK_NULL_HANDLE;
+		}
+		resource.block = -1;
+	}
+	for (MemoryBlock& block : _blocks) {
+		if (block.allocation) {
+			_memory->free(block.allocation);
+		}
+	}
+	_blocks.clear();
+	_transientBytes = 0;
+	_unaliasedBytes = 0;
+	_compiled = false;
+}
+
+void RenderGraph::execute(VkCommandBuffer cmd)
+{
+	if (!_compiled) {
+		vklog::error() << "Render graph executed before compile()";
+		return;
+	}
+
+	_barrierCount = 0;
+	for (Resource& resource : _resources) {
+		resource.touched = false;
+	}
+
+	auto image_barrier = [&](const Resource& resource, const SyncState& from, VkImageLayout oldLayout,
+		VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess, VkImageLayout newLayout) {
+		VkImageMemoryBarrier2 barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+		barrier.pNext = nullptr;
+		barrier.srcStageMask = from.writeStages | from.readStages;
+		barrier.srcAccessMask = from.writeAccess;
+		barrier.dstStageMask = dstStages;
+		barrier.dstAccessMask = dstAccess;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = resource.image;
+		barrier.subresourceRange.aspectMask = resource.aspect;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		_imageBarriers.push_back(barrier);
+	};
+
+	auto flush = [&]() {
+		if (_imageBarriers.empty() && _bufferBarriers.empty()) {
+			return;
+		}
+		VkDependencyInfo dependency = {};
+		dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		dependency.pNext = nullptr;
+		dependency.bufferMemoryBarrierCount = (uint32_t)_bufferBarriers.size();
+		dependency.pBufferMemoryBarriers = _bufferBarriers.data();
+		dependency.imageMemoryBarrierCount = (uint32_t)_imageBarriers.size();
+		dependency.pImageMemoryBarriers = _imageBarriers.data();
+		vkCmdPipelineBarrier2(cmd, &dependency);
+
+		_barrierCount += (uint32_t)(_imageBarriers.size() + _bufferBarriers.size());
+		_imageBarriers.clear();
+		_bufferBarriers.clear();
+	};
+
+	for (const Pass& pass : _passes) {
+		if (pass.culled) {
+			continue;
+		}
+
+		for (const Access& access : pass.accesses) {
+			Resource& resource = _resources[access.resource];
+			SyncState& state = resource.state;
+
+			// 一帧里第一次用到：外部资源从声明的初始状态开始；
+			// 瞬态图像的内容没有意义 (从 UNDEFINED 开始)，但要等同一块显存上的前一个使用者用完
+			// 前一个使用者如果还没轮到 (环绕到上一帧)，它的 state 还是上一帧结束时的状态
+			if (!resource.touched) {
+				resource.touched = true;
+				if (resource.imported) {
+					state = SyncState{};
+					state.layout = resource.initialLayout;
+					state.writeStages = resource.initialStages;
+				}
+				else {
+					const Resource& prev = _resources[resource.aliasPrev];
+					const SyncState prevState = prev.state;
+					state = SyncState{};
+					image_barrier(resource, prevState, VK_IMAGE_LAYOUT_UNDEFINED, access.stages, access.access, access.layout);
+					state.layout = access.layout;
+					state.writeStages = access.stages;
+					state.writeAccess = access.write ? access.access : 0;
+					state.readStages = access.write ? 0 : access.stages;
+					state.readAccess = access.write ? 0 : access.access;
+					continue;
+				}
+			}
+
+			const bool layoutChange = resource.isImage && state.layout != access.layout;
+
+			if (access.write || layoutChange) {
+				// 写 (或布局转换) 要等之前所有的读写都结束；只有之前的写需要 flush
+				if (layoutChange || state.writeStages || state.readStages) {
+					if (resource.isImage) {
+						image_barrier(resource, state, state.layout, access.stages, access.access, access.layout);
+					}
+					else {
+						VkBufferMemoryBarrier2 barrier = {};
+						barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+						barrier.pNext = nullptr;
+						barrier.srcStageMask = state.writeStages | state.readStages;
+						barrier.srcAccessMask = state.writeAccess;
+						barrier.dstStageMask = access.stages;
+						barrier.dstAccessMask = access.access;
+						barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+						barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+						barrier.buffer = resource.buffer;
+						barrier.offset = 0;
+						barrier.size = VK_WHOLE_SIZE;
+						_bufferBarriers.push_back(barrier);
+					}
+				}
+				state.layout = access.layout;
+				state.writeStages = access.stages;
+				state.writeAccess = access.write ? access.access : 0;
+				state.readStages = access.write ? 0 : access.stages;
+				state.readAccess = access.write ? 0 : access.access;
+			}
+			else {
+				// 读后读不需要 barrier；只有还没对这些阶段可见的写才需要
+				const bool covered = (access.stages & ~state.readStages) == 0 && (access.access & ~state.readAccess) == 0;
+				if (!covered && state.writeStages) {
+					if (resource.isImage) {
+						SyncState from = state;
+						from.readStages = 0;
+						image_barrier(resource, from, state.layout, access.stages, access.access, access.layout);
+					}
+					else {
+						VkBufferMemoryBarrier2 barrier = {};
+						barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+						barrier.pNext = nullptr;
+						barrier.srcStageMask = state.writeStages;
+						barrier.srcAccessMask = state.writeAccess;
+						barrier.dstStageMask = access.stages;
+						barrier.dstAccessMask = access.access;
+						barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+						barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+						barrier.buffer = resource.buffer;
+						barrier.offset = 0;
+						barrier.size = VK_WHOLE_SIZE;
+						_bufferBarriers.push_back(barrier);
+					}
+				}
+				state.readStages |= access.stages;
+				state.readAccess |= access.access;
+			}
+		}
+
+		flush();
+		pass.execute(cmd);
+	}
+
+	// 外部图像转换到声明的最终布局 (交换链 -> PRESENT_SRC)
+	for (Resource& resource : _resources) {
+		if (!resource.imported || !resource.isImage || !resource.touched ||
+			resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || resource.finalLayout == resource.state.layout) {
+			continue;
+		}
+		image_barrier(resource, resource.state, resource.state.layout, VK_PIPELINE_STAGE_2_NONE, 0, resource.finalLayout);
+		resource.state.layout = resource.finalLayout;
+	}
+	flush();
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_memory.h"
+
+#include <functional>
+#include <string>
+
+// 渲染图中的资源句柄 (图像或 buffer)，只在同一次 compile 的图里有效
+using RGResource = uint32_t;
+constexpr RGResource RG_INVALID_RESOURCE = 0xFFFFFFFF;
+
+// pass 对资源的用法，决定 barrier 的 stage / access 和图像布局
+enum class RGUsage {
+	ColorAttachment,  // 颜色附件 (写)
+	DepthAttachment,  // 深度附件 (深度测试 + 写入)
+	DepthRead,        // 只读深度 (深度测试，不写入)
+	Sampled,          // 着色器采样
+	StorageRead,      // 着色器读 storage image / buffer
+	StorageWrite,     // 着色器写 storage image / buffer
+	TransferSrc,
+	TransferDst,
+	IndirectBuffer,   // vkCmdDraw*Indirect / vkCmdDispatchIndirect 的参数
+	VertexBuffer,
+	IndexBuffer,
+};
+
+// 瞬态图像：只在一帧之内有意义，由渲染图分配，生命周期不重叠的图像共享同一块显存
+struct RGImageDesc {
+	VkFormat format{ VK_FORMAT_UNDEFINED };
+	VkExtent2D extent{ 0, 0 };
+};
+
+// 渲染图
+// 1. 每个 pass 声明它读写哪些图像 / buffer，执行函数只录制绘制命令，不写 barrier
+// 2. compile() 剔除结果没人用的 pass，计算瞬态图像的生命周期，把不重叠的图像放进同一块显存
+// 3. execute() 按声明顺序录制，pass 之间只插入真正需要的 synchronization2 barrier 和布局转换
+//    同一个 pass 的所有 barrier 合并成一次 vkCmdPipelineBarrier2
+// 图通常在初始化时构建一次，之后每帧只更新外部资源 (比如交换链图片) 再 execute
+class RenderGraph {
+public:
+	class PassBuilder {
+	public:
+		// stages 为 0 时使用 usage 的默认阶段 (着色器访问默认是片段 + 计算)
+		PassBuilder& read(RGResource resource, RGUsage usage, VkPipelineStageFlags2 stages = 0);
+		PassBuilder& write(RGResource resource, RGUsage usage, VkPipelineStageFlags2 stages = 0);
+		// 有图外可见的副作用 (回读、上传等)，永远不会被剔除
+		PassBuilder& side_effect();
+
+	private:
+		friend class RenderGraph;
+		PassBuilder(RenderGraph* graph, uint32_t pass) : _graph(graph), _pass(pass) {}
+
+		RenderGraph* _graph;
+		uint32_t _pass;
+	};
+
+	void init(VkDevice device, MemoryManager* memory);
+	void cleanup();
+
+	// 清空所有 pass 和资源并释放瞬态显存；调用前 GPU 必须已经不再使用它们
+	void reset();
+
+	// 外部图像：帧开始时处于 initialLayout，帧结束时转换到 finalLayout (UNDEFINED 表示保持最后的用法)
+	// initialStages 是外部同步已经覆盖的阶段 (比如交换链 acquire 信号量等待的阶段)，第一次布局转换从这里开始
+	// 写外部资源的 pass 视为有输出，不会被剔除
+	RGResource import_image(const char* name, VkImage image, VkImageView view, VkFormat format, VkExtent2D extent,
+		VkImageLayout initialLayout, VkImageLayout finalLayout, VkPipelineStageFlags2 initialStages = VK_PIPELINE_STAGE_2_NONE);
+	RGResource import_buffer(const char* name, VkBuffer buffer, VkDeviceSize size);
+	// 每帧更换外部图像 (交换链图片)，格式和大小不能变
+	void set_imported_image(RGResource resource, VkImage image, VkImageView view);
+
+	RGResource create_image(const char* name, const RGImageDesc& desc);
+
+	PassBuilder add_pass(const char* name, std::function<void(VkCommandBuffer)> execute);
+
+	bool compile();
+	void execute(VkCommandBuffer cmd);
+
+	// 供 pass 的执行函数取实际的 Vulkan 对象
+	VkImage image(RGResource resource) const { return _resources[resource].image; }
+	VkImageView image_view(RGResource resource) const { return _resources[resource].view; }
+	VkExtent2D image_extent(RGResource resource) const { return _resources[resource].desc.extent; }
+	VkFormat image_format(RGResource resource) const { return _resources[resource].desc.format; }
+	VkBuffer buffer(RGResource resource) const { return _resources[resource].buffer; }
+
+	// 统计：瞬态显存 (别名之后 / 不做别名时)，上一次 execute 插入的 barrier 数量
+	VkDeviceSize transient_bytes() const { return _transientBytes; }
+	VkDeviceSize unaliased_bytes() const { return _unaliasedBytes; }
+	uint32_t barrier_count() const { return _barrierCount; }
+
+private:
+	struct Access {
+		RGResource resource;
+		VkPipelineStageFlags2 stages;
+		VkAccessFlags2 access;
+		VkImageLayout layout;
+		bool read;  // 需要之前的内容 (决定剔除)
+		bool write;
+	};
+
+	struct Pass {
+		std::string name;
+		std::function<void(VkCommandBuffer)> execute;
+		std::vector<Access> accesses;
+		bool sideEffect{ false };
+		bool culled{ false };
+	};
+
+	// 资源在一帧之内的同步状态
+	struct SyncState {
+		VkImageLayout layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		VkPipelineStageFlags2 writeStages{ 0 }; // 最后一次写 (或布局转换) 的阶段
+		VkAccessFlags2 writeAccess{ 0 };
+		VkPipelineStageFlags2 readStages{ 0 };  // 上次写之后已经可见的读阶段
+		VkAccessFlags2 readAccess{ 0 };
+	};
+
+	struct Resource {
+		std::string name;
+		bool isImage{ true };
+		bool imported{ false };
+
+		RGImageDesc desc{};
+		VkImageAspectFlags aspect{ 0 };
+		VkImageUsageFlags usage{ 0 };
+		VkImage image{ VK_NULL_HANDLE };
+		VkImageView view{ VK_NULL_HANDLE };
+		VkImageLayout initialLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		VkImageLayout finalLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		VkPipelineStageFlags2 initialStages{ 0 };
+
+		VkBuffer buffer{ VK_NULL_HANDLE };
+		VkDeviceSize size{ 0 };
+
+		// compile 结果
+		uint32_t firstPass{ UINT32_MAX };
+		uint32_t lastPass{ 0 };
+		int32_t block{ -1 };                          // 瞬态图像所在的显存块
+		RGResource aliasPrev{ RG_INVALID_RESOURCE };  // 同一块显存上的前一个使用者 (第一个使用者的前一个是上一帧的最后一个)
+
+		// execute 状态
+		SyncState state{};
+		bool touched{ false };
+	};
+
+	struct MemoryBlock {
+		VmaAllocation allocation{ nullptr };
+		VkMemoryRequirements requirements{};
+		std::vector<RGResource> residents; // 按 firstPass 排序
+	};
+
+	void add_access(uint32_t pass, RGResource resource, RGUsage usage, VkPipelineStageFlags2 stages, bool write);
+	void cull_passes();
+	bool allocate_transients();
+	void release_transients();
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	MemoryManager* _memory{ nullptr };
+
+	std::vector<Resource> _resources;
+	std::vector<Pass> _passes;
+	std::vector<MemoryBlock> _blocks;
+	bool _compiled{ false };
+
+	VkDeviceSize _transientBytes{ 0 };
+	VkDeviceSize _unaliasedBytes{ 0 };
+	uint32_t _barrierCount{ 0 };
+
+	// execute 时复用，避免每个 pass 分配
+	std::vector<VkImageMemoryBarrier2> _imageBarriers;
+	std::vector<VkBufferMemoryBarrier2> _bufferBarriers;
+};
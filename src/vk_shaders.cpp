@@ -0,0 +1,274 @@
+#include "vk_shaders.h"
+
+#include <algorithm>
+#include <map>
+
+bool ShaderPack::open(const char* path)
+{
+	close();
+
+	if (!_file.open(path)) {
+		vklog::error() << "Could not map shader pack: " << path;
+		return false;
+	}
+
+	const uint8_t* base = _file.data();
+	const size_t size = _file.size();
+	const vkspirv::PackHeader* header = reinterpret_cast<const vkspirv::PackHeader*>(base);
+
+	// 校验头部和各个段是否都落在文件范围内
+	if (size < sizeof(vkspirv::PackHeader) ||
+		header->magic != vkspirv::PACK_MAGIC ||
+		header->version != vkspirv::PACK_VERSION ||
+		header->fileSize != size ||
+		header->entriesOffset + (uint64_t)header->entryCount * sizeof(vkspirv::PackEntry) > size ||
+		header->bindingsOffset + (uint64_t)header->bindingCount * sizeof(vkspirv::ReflectedBinding) > size ||
+		header->stringsOffset > size) {
+		vklog::error() << "Invalid or outdated shader pack: " << path;
+		_file.close();
+		return false;
+	}
+
+	_header = header;
+	_entries = reinterpret_cast<const vkspirv::PackEntry*>(base + header->entriesOffset);
+	_bindings = reinterpret_cast<const vkspirv::ReflectedBinding*>(base + header->bindingsOffset);
+	_strings = reinterpret_cast<const char*>(base + header->stringsOffset);
+
+	for (uint32_t i = 0; i < header->entryCount; i++) {
+		const vkspirv::PackEntry& entry = _entries[i];
+		if (entry.codeOffset + entry.codeSize > size ||
+			entry.codeOffset % vkspirv::PACK_ALIGNMENT != 0 ||
+			header->stringsOffset + entry.nameOffset + entry.nameLength > size ||
+			entry.firstBinding + entry.bindingCount > header->bindingCount) {
+			vklog::error() << "Corrupted shader pack entry #" << i << " in " << path;
+			close();
+			return false;
+		}
+	}
+
+	vklog::info() << "Shader pack mapped: " << path << " (" << header->entryCount << " shaders, " << size << " bytes)";
+	return true;
+}
+
+void ShaderPack::close()
+{
+	_file.close();
+	_header = nullptr;
+	_entries = nullptr;
+	_bindings = nullptr;
+	_strings = nullptr;
+}
+
+const vkspirv::PackEntry* ShaderPack::find(std::string_view name) const
+{
+	if (!_header) {
+		return nullptr;
+	}
+
+	// 条目按名字哈希排序，二分查找后再比较名字防止哈希冲突
+	const uint64_t hash = vkspirv::hash_name(name);
+	const vkspirv::PackEntry* end = _entries + _header->entryCount;
+	const vkspirv::PackEntry* it = std::lower_bound(_entries, end, hash, [](const vkspirv::PackEntry& e, uint64_t h) {
+		return e.nameHash < h;
+	});
+	for (; it != end && it->nameHash == hash; ++it) {
+		if (this->name(*it) == name) {
+			return it;
+		}
+	}
+	return nullptr;
+}
+
+std::string_view ShaderPack::name(const vkspirv::PackEntry& entry) const
+{
+	return std::string_view(_strings + entry.nameOffset, entry.nameLength);
+}
+
+std::span<const vkspirv::ReflectedBinding> ShaderPack::bindings(const vkspirv::PackEntry& entry) const
+{
+	return std::span<const vkspirv::ReflectedBinding>(_bindings + entry.firstBinding, entry.bindingCount);
+}
+
+const uint32_t* ShaderPack::code(const vkspirv::PackEntry& entry) const
+{
+	return reinterpret_cast<const uint32_t*>(_file.data() + entry.codeOffset);
+}
+
+bool ShaderPack::create_module(VkDevice device, const vkspirv::PackEntry& entry, VkShaderModule* outShaderModule) const
+{
+	VkShaderModuleCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.codeSize = entry.codeSize;
+	createInfo.pCode = code(entry); // 直接指向映射内存
+
+	return vkCreateShaderModule(device, &createInfo, nullptr, outShaderModule) == VK_SUCCESS;
+}
+
+void PipelineLayoutCache::init(VkDevice device)
+{
+	_device = device;
+}
+
+void PipelineLayoutCache::cleanup()
+{
+	for (auto& [key, layout] : _pipelineLayouts) {
+		vkDestroyPipelineLayout(_device, layout, nullptr);
+	}
+	for (auto& [key, layout] : _setLayouts) {
+		vkDestroyDescriptorSetLayout(_device, layout, nullptr);
+	}
+	_pipelineLayouts.clear();
+	_setLayouts.clear();
+}
+
+void PipelineLayoutCache::set_global_set(uint32_t set, VkDescriptorSetLayout layout, std::span<const VkDescriptorSetLayoutBinding> bindings)
+{
+	_globalSetIndex = set;
+	_globalSetLayout = layout;
+	_globalBindings.assign(bindings.begin(), bindings.end());
+}
+
+void PipelineLayoutCache::set_shared_push_constants(VkShaderStageFlags stages, uint32_t size)
+{
+	_sharedPushStages = stages;
+	_sharedPushSize = size;
+}
+
+VkDescriptorSetLayout PipelineLayoutCache::get_set_layout(std::span<const VkDescriptorSetLayoutBinding> bindings)
+{
+	std::string key;
+	for (const VkDescriptorSetLayoutBinding& b : bindings) {
+		const uint32_t fields[4] = { b.binding, (uint32_t)b.descriptorType, b.descriptorCount, b.stageFlags };
+		key.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+	}
+
+	auto it = _setLayouts.find(key);
+	if (it != _setLayouts.end()) {
+		return it->second;
+	}
+
+	VkDescriptorSetLayoutCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	info.pNext = nullptr;
+	info.bindingCount = (uint32_t)bindings.size();
+	info.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+	if (vkCreateDescriptorSetLayout(_device, &info, nullptr, &layout) != VK_SUCCESS) {
+		vklog::error() << "Failed to create descriptor set layout";
+		return VK_NULL_HANDLE;
+	}
+
+	_setLayouts.emplace(std::move(key), layout);
+	return layout;
+}
+
+ReflectedLayout PipelineLayoutCache::get_pipeline_layout(const ShaderPack& pack, std::span<const vkspirv::PackEntry* const> stages)
+{
+	// 1. 合并所有 stage 的绑定：set -> (binding -> 描述)
+	std::map<uint32_t, std::map<uint32_t, VkDescriptorSetLayoutBinding>> sets;
+	ReflectedLayout result;
+	uint32_t pushBegin = UINT32_MAX;
+	uint32_t pushEnd = 0;
+
+	for (const vkspirv::PackEntry* stage : stages) {
+		if (!stage) {
+			continue;
+		}
+		for (const vkspirv::ReflectedBinding& rb : pack.bindings(*stage)) {
+			VkDescriptorSetLayoutBinding& b = sets[rb.set][rb.binding];
+			b.binding = rb.binding;
+			b.descriptorType = (VkDescriptorType)rb.descriptorType;
+			b.descriptorCount = std::max(b.descriptorCount, std::max(rb.descriptorCount, 1u));
+			b.stageFlags |= stage->stage;
+			b.pImmutableSamplers = nullptr;
+		}
+		if (stage->pushConstantSize > 0) {
+			pushBegin = std::min(pushBegin, stage->pushConstantOffset);
+			pushEnd = std::max(pushEnd, stage->pushConstantOffset + stage->pushConstantSize);
+			result.pushConstantStages |= stage->stage;
+		}
+	}
+
+	// 2. 生成 set layout (中间没用到的 set 也要填一个空 layout)
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	uint32_t setCount = sets.empty() ? 0 : sets.rbegin()->first + 1;
+	if (_globalSetLayout != VK_NULL_HANDLE) {
+		setCount = std::max(setCount, _globalSetIndex + 1);
+	}
+	for (uint32_t set = 0; set < setCount; set++) {
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		auto it = sets.find(set);
+
+		if (set == _globalSetIndex && _globalSetLayout != VK_NULL_HANDLE) {
+			// 全局 set：shader 声明的每个 binding 都必须存在且类型一致
+			if (it != sets.end()) {
+				for (auto& [index, binding] : it->second) {
+					auto match = std::find_if(_globalBindings.begin(), _globalBindings.end(), [&](const VkDescriptorSetLayoutBinding& g) {
+						return g.binding == index && g.descriptorType == binding.descriptorType;
+					});
+					if (match == _globalBindings.end()) {
+						vklog::error() << "Shader binding (set " << set << ", binding " << index
+							<< ") does not match the global descriptor set";
+					}
+				}
+			}
+			setLayouts.push_back(_globalSetLayout);
+			continue;
+		}
+
+		if (it != sets.end()) {
+			for (auto& [index, binding] : it->second) {
+				bindings.push_back(binding);
+			}
+		}
+		setLayouts.push_back(get_set_layout(bindings));
+	}
+
+	VkPushConstantRange pushConstantRange = {};
+	if (result.pushConstantStages != 0) {
+		result.pushConstantOffset = pushBegin;
+		result.pushConstantSize = pushEnd - pushBegin;
+		pushConstantRange.stageFlags = result.pushConstantStages;
+		pushConstantRange.offset = result.pushConstantOffset;
+		pushConstantRange.size = result.pushConstantSize;
+	}
+	if (_sharedPushStages != 0) {
+		if (pushEnd > _sharedPushSize && result.pushConstantStages != 0) {
+			vklog::error() << "Shader push constants (" << pushEnd << " bytes) exceed the shared range ("
+				<< _sharedPushSize << " bytes)";
+		}
+		result.pushConstantStages = _sharedPushStages;
+		pushConstantRange.stageFlags = _sharedPushStages;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = _sharedPushSize;
+	}
+
+	// 3. 去重：相同的 set layout 组合 + push constant 范围 共享同一个 pipeline layout
+	//    只缓存句柄：共享 push constant 范围时不同 shader 的 key 一样，offset/size 必须是这一次反射出来的
+	std::string key(reinterpret_cast<const char*>(setLayouts.data()), setLayouts.size() * sizeof(VkDescriptorSetLayout));
+	key.append(reinterpret_cast<const char*>(&pushConstantRange), sizeof(pushConstantRange));
+
+	auto cached = _pipelineLayouts.find(key);
+	if (cached != _pipelineLayouts.end()) {
+		result.layout = cached->second;
+		return result;
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.pNext = nullptr;
+	pipelineLayoutInfo.setLayoutCount = (uint32_t)setLayouts.size();
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = pushConstantRange.stageFlags != 0 ? 1 : 0;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &result.layout) != VK_SUCCESS) {
+		vklog::error() << "Failed to create reflected pipeline layout";
+		return ReflectedLayout{};
+	}
+
+	_pipelineLayouts.emplace(std::move(key), result.layout);
+	return result;
+}
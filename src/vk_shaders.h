@@ -0,0 +1,81 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_file.h"
+#include "vk_spirv.h"
+
+#include <string_view>
+#include <unordered_map>
+
+// 内存映射的 shader 包 (由构建步骤 ShaderPacker 生成)
+// SPIR-V 直接从映射内存交给驱动，不经过任何拷贝
+class ShaderPack {
+public:
+	bool open(const char* path);
+	void close();
+
+	bool is_open() const { return _header != nullptr; }
+	void prefetch() const { _file.prefetch(); } // 预读整个包，后面创建 shader module 时不再缺页
+	uint32_t entry_count() const { return _header ? _header->entryCount : 0; }
+
+	// 按名字查找，名字就是 shaders/ 下的文件名去掉 .spv，比如 "triangle_mesh.vert"
+	const vkspirv::PackEntry* find(std::string_view name) const;
+
+	std::string_view name(const vkspirv::PackEntry& entry) const;
+	std::span<const vkspirv::ReflectedBinding> bindings(const vkspirv::PackEntry& entry) const;
+	const uint32_t* code(const vkspirv::PackEntry& entry) const;
+
+	bool create_module(VkDevice device, const vkspirv::PackEntry& entry, VkShaderModule* outShaderModule) const;
+
+private:
+	MappedFile _file;
+	const vkspirv::PackHeader* _header{ nullptr };
+	const vkspirv::PackEntry* _entries{ nullptr };
+	const vkspirv::ReflectedBinding* _bindings{ nullptr };
+	const char* _strings{ nullptr };
+};
+
+// 反射生成的管线布局，push constant 的范围也一起返回，方便 vkCmdPushConstants 使用
+// pushConstantStages 是调用 vkCmdPushConstants 时必须传的 stage；offset/size 是 shader 实际用到的范围
+struct ReflectedLayout {
+	VkPipelineLayout layout{ VK_NULL_HANDLE };
+	VkShaderStageFlags pushConstantStages{ 0 };
+	uint32_t pushConstantOffset{ 0 };
+	uint32_t pushConstantSize{ 0 };
+};
+
+// 根据 shader 反射信息自动生成 descriptor set layout / pipeline layout
+// 所有 layout 按内容去重，多条管线共享同一个句柄；缓存负责销毁它们
+class PipelineLayoutCache {
+public:
+	void init(VkDevice device);
+	void cleanup();
+
+	// 固定某个 set 的 layout (比如 bindless 全局 set)，所有 pipeline layout 都会带上它
+	// shader 里对这个 set 的声明只做校验，不再参与生成
+	void set_global_set(uint32_t set, VkDescriptorSetLayout layout, std::span<const VkDescriptorSetLayoutBinding> bindings);
+
+	// 所有 pipeline layout 使用同一个 push constant 范围，这样它们对全局 set 是"兼容"的：
+	// 切换管线后已经绑定的全局 set 仍然有效，一帧只需要绑定一次
+	void set_shared_push_constants(VkShaderStageFlags stages, uint32_t size);
+	VkShaderStageFlags push_constant_stages() const { return _sharedPushStages; }
+
+	VkDescriptorSetLayout get_set_layout(std::span<const VkDescriptorSetLayoutBinding> bindings);
+
+	// 合并多个 stage 的反射信息：同一 binding 的 stageFlags 取并集，push constant 取覆盖范围
+	ReflectedLayout get_pipeline_layout(const ShaderPack& pack, std::span<const vkspirv::PackEntry* const> stages);
+
+private:
+	VkDevice _device{ VK_NULL_HANDLE };
+
+	uint32_t _globalSetIndex{ UINT32_MAX };
+	VkDescriptorSetLayout _globalSetLayout{ VK_NULL_HANDLE };
+	std::vector<VkDescriptorSetLayoutBinding> _globalBindings;
+
+	VkShaderStageFlags _sharedPushStages{ 0 };
+	uint32_t _sharedPushSize{ 0 };
+
+	// key 是 binding 描述 / layout 描述的原始字节，完全相同才会命中
+	std::unordered_map<std::string, VkDescriptorSetLayout> _setLayouts;
+	std::unordered_map<std::string, VkPipelineLayout> _pipelineLayouts;
+};
@@ -0,0 +1,447 @@
+#include "vk_shadows.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+bool ShadowCascades::init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless)
+{
+	_device = device;
+	_memory = memory;
+	_bindless = bindless;
+
+	// 1. 静态缓存和阴影图：每个级联一层，层之间用 vkCmdCopyImage 拷贝
+	auto create = [this](VkImageUsageFlags usage, AllocatedImage& out) {
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.pNext = nullptr;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = FORMAT;
+		imageInfo.extent = { RESOLUTION, RESOLUTION, 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = MAX_SHADOW_CASCADES;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = usage;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (!_memory->create_image(imageInfo, MemoryCategory::Attachments, out)) {
+			vklog::error() << "Failed to allocate shadow cascade image";
+			return false;
+		}
+		return true;
+	};
+	if (!create(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, _cache) ||
+		!create(VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, _map)) {
+		return false;
+	}
+
+	// 2. 阴影图每层一个 2D 视图：叠加动态物体时渲染用，同时登记进 bindless (着色器按级联取 textures[])
+	//    静态缓存只有一个覆盖所有层的数组视图，多视角渲染一次画好几层
+	auto create_view = [this](VkImage image, uint32_t layer, uint32_t layerCount, VkImageView& out) {
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.pNext = nullptr;
+		viewInfo.viewType = layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.image = image;
+		viewInfo.format = FORMAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = layer;
+		viewInfo.subresourceRange.layerCount = layerCount;
+		if (vkCreateImageView(_device, &viewInfo, nullptr, &out) != VK_SUCCESS) {
+			vklog::error() << "Failed to create shadow cascade view";
+			return false;
+		}
+		return true;
+	};
+	for (uint32_t i = 0; i < MAX_SHADOW_CASCADES; i++) {
+		Cascade& cascade = _cascades[i];
+		if (!create_view(_map._image, i, 1, cascade.mapView)) {
+			return false;
+		}
+		cascade.textureSlot = _bindless->add_texture(cascade.mapView);
+	}
+	if (!create_view(_cache._image, 0, MAX_SHADOW_CASCADES, _cacheArrayView)) {
+		return false;
+	}
+
+	// 3. 比较采样器：硬件做深度比较，线性过滤在 2x2 上得到比较结果的插值
+	//    范围外的坐标采到白色边框 (深度 1，不在阴影里)
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.pNext = nullptr;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	if (vkCreateSampler(_device, &samplerInfo, nullptr, &_sampler) != VK_SUCCESS) {
+		vklog::error() << "Failed to create shadow sampler";
+		return false;
+	}
+	_samplerSlot = _bindless->add_sampler(_sampler);
+
+	_casters.reserve(256);
+	return true;
+}
+
+void ShadowCascades::cleanup()
+{
+	// bindless 槽位随全局 set 一起释放
+	if (_device == VK_NULL_HANDLE) {
+		return;
+	}
+	for (Cascade& cascade : _cascades) {
+		if (cascade.mapView != VK_NULL_HANDLE) {
+			vkDestroyImageView(_device, cascade.mapView, nullptr);
+		}
+		cascade = Cascade{};
+	}
+	if (_cacheArrayView != VK_NULL_HANDLE) {
+		vkDestroyImageView(_device, _cacheArrayView, nullptr);
+	}
+	if (_cache._image != VK_NULL_HANDLE) {
+		_memory->destroy_image(_cache);
+	}
+	if (_map._image != VK_NULL_HANDLE) {
+		_memory->destroy_image(_map);
+	}
+	if (_sampler != VK_NULL_HANDLE) {
+		vkDestroySampler(_device, _sampler, nullptr);
+	}
+	_cache = {};
+	_map = {};
+	_cacheArrayView = VK_NULL_HANDLE;
+	_sampler = VK_NULL_HANDLE;
+	_device = VK_NULL_HANDLE;
+}
+
+void ShadowCascades::set_pipelines(VkPipelineLayout layout, VkShaderStageFlags pushStages, VkPipeline dynamicPipeline, std::span<const VkPipeline> staticPipelines)
+{
+	_layout = layout;
+	_pushStages = pushStages;
+	_dynamicPipeline = dynamicPipeline;
+	// 少任何一个 viewMask 都画不了任意组合的级联，当作没有静态管线
+	_hasStaticPipelines = staticPipelines.size() == VIEW_MASKS;
+	for (uint32_t mask = 0; mask < VIEW_MASKS; mask++) {
+		_staticPipelines[mask] = mask < staticPipelines.size() ? staticPipelines[mask] : VK_NULL_HANDLE;
+		_hasStaticPipelines = _hasStaticPipelines && (mask == 0 || _staticPipelines[mask] != VK_NULL_HANDLE);
+	}
+	// 管线换了 (深度偏移等可能不同)：全部重画
+	for (Cascade& cascade : _cascades) {
+		cascade.valid = false;
+	}
+}
+
+void ShadowCascades::begin_frame(const glm::mat4& view, float fovY, float aspect, float zNear, float zFar, const glm::vec3& lightDirection)
+{
+	_frameNumber++;
+	_cameraToWorld = glm::inverse(view);
+	_tanHalfY = std::tan(glm::radians(fovY) * 0.5f);
+	_tanHalfX = _tanHalfY * aspect;
+	_zNear = zNear;
+	_zFar = zFar;
+	const float length = glm::length(lightDirection);
+	if (length > 0.0f) {
+		_light = lightDirection / length;
+	}
+
+	_casters.clear();
+	_stats.staticRedraws = 0;
+	_stats.staticPasses = 0;
+	_stats.composites = 0;
+	_stats.skipped = 0;
+	_stats.casters = 0;
+	_stats.casterDraws = 0;
+}
+
+void ShadowCascades::add_caster(const DrawMesh& mesh, const glm::mat4& model, const glm::vec3& center, float radius)
+{
+	if (mesh.indexCount == 0) {
+		return;
+	}
+	_casters.push_back({ mesh, model, center, radius });
+	_stats.casters++;
+}
+
+void ShadowCascades::end_frame(uint64_t staticVersion)
+{
+	// 切分：对数切分和均匀切分按 SPLIT_LAMBDA 混合
+	const float shadowFar = std::min(_zFar, SHADOW_DISTANCE);
+	float sliceNear = _zNear;
+	for (uint32_t i = 0; i < MAX_SHADOW_CASCADES; i++) {
+		Cascade& cascade = _cascades[i];
+		const float t = (float)(i + 1) / (float)MAX_SHADOW_CASCADES;
+		const float logSplit = _zNear * std::pow(shadowFar / _zNear, t);
+		const float uniformSplit = _zNear + (shadowFar - _zNear) * t;
+		const float sliceFar = SPLIT_LAMBDA * logSplit + (1.0f - SPLIT_LAMBDA) * uniformSplit;
+
+		glm::vec3 center;
+		float radius;
+		slice_sphere(sliceNear, sliceFar, center, radius);
+		sliceNear = sliceFar;
+
+		// 错开的周期：0、1 每帧，2 每 2 帧，3 每 4 帧 (加上 i 让不同级联落在不同的帧)
+		// 还没画过的级联马上更新
+		const uint64_t period = 1ull << (i > 0 ? i - 1 : 0);
+		cascade.update = !cascade.valid || (_frameNumber + i) % period == 0;
+		cascade.staticDirty = false;
+		if (!cascade.update || !_hasStaticPipelines) {
+			cascade.update = false;
+			continue;
+		}
+		if (is_stale(cascade, center, radius, staticVersion)) {
+			fit(cascade, center, radius);
+			cascade.staticVersion = staticVersion;
+			cascade.staticDirty = true;
+		}
+	}
+}
+
+void ShadowCascades::slice_sphere(float sliceNear, float sliceFar, glm::vec3& center, float& radius) const
+{
+	// 视锥切片的最小包围球 (只和切片的远近和视角有关，相机转动时半径不变)
+	// k = tan²(x) + tan²(y)：距离 z 处切面角点到轴的距离平方是 z²k
+	const float k = _tanHalfX * _tanHalfX + _tanHalfY * _tanHalfY;
+	const float d = std::min(0.5f * (sliceFar + sliceNear) * (1.0f + k), sliceFar);
+	const float nearSq = (d - sliceNear) * (d - sliceNear) + sliceNear * sliceNear * k;
+	const float farSq = (sliceFar - d) * (sliceFar - d) + sliceFar * sliceFar * k;
+	// 向上取整到 1/16，浮点误差不会让半径来回跳
+	radius = std::ceil(std::sqrt(std::max(nearSq, farSq)) * 16.0f) / 16.0f;
+	center = glm::vec3(_cameraToWorld * glm::vec4(0.0f, 0.0f, -d, 1.0f));
+}
+
+bool ShadowCascades::is_stale(const Cascade& cascade, const glm::vec3& center, float radius, uint64_t staticVersion) const
+{
+	if (!cascade.valid || cascade.staticVersion != staticVersion) {
+		return true;
+	}
+	// 光转过阈值
+	if (glm::dot(cascade.light, _light) < std::cos(glm::radians(LIGHT_THRESHOLD_DEGREES))) {
+		return true;
+	}
+	// 视角 / 远近变了：切片变大装不下，或者小很多 (分辨率浪费)
+	if (radius > cascade.radius || radius < cascade.radius * 0.75f) {
+		return true;
+	}
+	// 切片包围球走出了拟合时的覆盖范围
+	const glm::vec3 p = glm::vec3(cascade.lightView * glm::vec4(center, 1.0f)) - cascade.centerLS;
+	return std::abs(p.x) + radius > cascade.extent || std::abs(p.y) + radius > cascade.extent || std::abs(p.z) + radius > cascade.extent;
+}
+
+void ShadowCascades::fit(Cascade& cascade, const glm::vec3& center, float radius)
+{
+	const glm::vec3 up = std::abs(_light.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	cascade.lightView = glm::lookAt(glm::vec3(0.0f), _light, up);
+	cascade.light = _light;
+	cascade.radius = radius;
+	cascade.extent = radius * (1.0f + MARGIN);
+
+	// 中心对齐到纹素：重新拟合前后静态几何落在同样的纹素格子上，不会闪
+	const float texel = 2.0f * cascade.extent / (float)RESOLUTION;
+	glm::vec3 p = glm::vec3(cascade.lightView * glm::vec4(center, 1.0f));
+	p.x = std::floor(p.x / texel) * texel;
+	p.y = std::floor(p.y / texel) * texel;
+	cascade.centerLS = p;
+
+	// 光空间沿 -z 看，近平面再朝光源推出 CASTER_DISTANCE
+	const float e = cascade.extent;
+	const glm::mat4 projection = glm::ortho(p.x - e, p.x + e, p.y - e, p.y + e, -p.z - e - CASTER_DISTANCE, -p.z + e);
+	cascade.viewProj = projection * cascade.lightView;
+}
+
+bool ShadowCascades::overlaps(const Cascade& cascade, const Caster& caster) const
+{
+	const glm::vec3 p = glm::vec3(cascade.lightView * glm::vec4(caster.center, 1.0f)) - cascade.centerLS;
+	const float e = cascade.extent + caster.radius;
+	return std::abs(p.x) < e && std::abs(p.y) < e && p.z > -e && p.z < e + CASTER_DISTANCE;
+}
+
+void ShadowCascades::fill_scene(GPUSceneData& scene) const
+{
+	// 只交出前面已经画好的级联 (着色器按顺序找第一个覆盖的)
+	scene.cascadeCount = 0;
+	scene.shadowSampler = _samplerSlot;
+	for (uint32_t i = 0; i < MAX_SHADOW_CASCADES; i++) {
+		const Cascade& cascade = _cascades[i];
+		scene.cascadeViewProj[i] = cascade.viewProj;
+		scene.shadowTextures[i] = cascade.textureSlot;
+		if (scene.cascadeCount == i && cascade.mapLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+			scene.cascadeCount = i + 1;
+		}
+	}
+	scene.shadowParams = glm::vec4(1.0f / (float)RESOLUTION, 0.0f, 0.0f, 0.0f);
+}
+
+void ShadowCascades::record(VkCommandBuffer cmd, const StaticDrawCache& statics)
+{
+	if (!_hasStaticPipelines || _dynamicPipeline == VK_NULL_HANDLE) {
+		return;
+	}
+
+	// 1. 静态缓存：要重画的级联放进同一个 viewMask，清空后从各自的级联视角 (StaticDrawCache 的视角 1 + n) 一次画完
+	//    附件是覆盖所有层的数组视图，不在 viewMask 里的层不会被读写，但布局也要和附件一致 (从拷贝源转过来内容不变)
+	uint32_t staticMask = 0;
+	for (uint32_t i = 0; i < MAX_SHADOW_CASCADES; i++) {
+		if (_cascades[i].update && _cascades[i].staticDirty) {
+			staticMask |= 1u << i;
+		}
+	}
+	if (staticMask != 0) {
+		for (uint32_t i = 0; i < MAX_SHADOW_CASCADES; i++) {
+			transition(cmd, _cache._image, i, _cascades[i].cacheLayout, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+		}
+		begin_depth(cmd, _cacheArrayView, VK_ATTACHMENT_LOAD_OP_CLEAR, staticMask);
+		_bindless->bind(cmd, _layout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+		statics.draw_view(cmd, _staticPipelines[staticMask], 1);
+		vkCmdEndRendering(cmd);
+		for (uint32_t i = 0; i < MAX_SHADOW_CASCADES; i++) {
+			transition(cmd, _cache._image, i, _cascades[i].cacheLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+			if (staticMask & (1u << i)) {
+				_cascades[i].valid = true;
+				_stats.staticRedraws++;
+				_stats.totalStaticRedraws++;
+			}
+		}
+		_stats.staticPasses++;
+		_stats.totalStaticPasses++;
+	}
+
+	for (uint32_t i = 0; i < MAX_SHADOW_CASCADES; i++) {
+		Cascade& cascade = _cascades[i];
+		if (!cascade.update) {
+			continue;
+		}
+
+		uint32_t casterCount = 0;
+		for (const Caster& caster : _casters) {
+			casterCount += overlaps(cascade, caster) ? 1 : 0;
+		}
+		// 静态缓存没变、现在和上次都没有动态物体：阴影图和缓存一样，什么都不用做
+		if (!cascade.staticDirty && casterCount == 0 && !cascade.hadCasters) {
+			_stats.skipped++;
+			continue;
+		}
+
+		// 2. 缓存拷到阴影图
+		transition(cmd, _map._image, i, cascade.mapLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		VkImageCopy region = {};
+		region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+		region.srcSubresource.baseArrayLayer = i;
+		region.srcSubresource.layerCount = 1;
+		region.dstSubresource = region.srcSubresource;
+		region.extent = { RESOLUTION, RESOLUTION, 1 };
+		vkCmdCopyImage(cmd, _cache._image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, _map._image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		// 3. 动态物体叠加在上面 (深度测试照常，和静态几何互相遮挡)
+		if (casterCount > 0) {
+			transition(cmd, _map._image, i, cascade.mapLayout, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+			begin_depth(cmd, cascade.mapView, VK_ATTACHMENT_LOAD_OP_LOAD, 0);
+			_bindless->bind(cmd, _layout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+			vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, _dynamicPipeline);
+			for (const Caster& caster : _casters) {
+				if (!overlaps(cascade, caster)) {
+					continue;
+				}
+				MeshPushConstants constants = {};
+				constants.render_matrix = cascade.viewProj * caster.model;
+				vkCmdPushConstants(cmd, _layout, _pushStages, 0, sizeof(MeshPushConstants), &constants);
+				const VkDeviceSize offset = 0;
+				vkCmdBindVertexBuffers(cmd, 0, 1, &caster.mesh.vertexBuffer, &offset);
+				vkCmdBindIndexBuffer(cmd, caster.mesh.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+				vkCmdDrawIndexed(cmd, caster.mesh.indexCount, 1, caster.mesh.firstIndex, (int32_t)caster.mesh.firstVertex, 0);
+				_stats.casterDraws++;
+			}
+			vkCmdEndRendering(cmd);
+		}
+		cascade.hadCasters = casterCount > 0;
+
+		// 4. 给 forward pass 采样
+		transition(cmd, _map._image, i, cascade.mapLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		_stats.composites++;
+	}
+}
+
+void ShadowCascades::transition(VkCommandBuffer cmd, VkImage image, uint32_t layer, VkImageLayout& layout, VkImageLayout newLayout) const
+{
+	// 按旧 / 新布局推出同步范围：深度附件、拷贝、片段着色器采样三种用法
+	auto scope = [](VkImageLayout l, VkPipelineStageFlags2& stage, VkAccessFlags2& access) {
+		switch (l) {
+		case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL:
+			stage = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+			access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+			stage = VK_PIPELINE_STAGE_2_COPY_BIT;
+			access = VK_ACCESS_2_TRANSFER_READ_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+			stage = VK_PIPELINE_STAGE_2_COPY_BIT;
+			access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+			break;
+		case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+			stage = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+			access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+			break;
+		default:
+			stage = VK_PIPELINE_STAGE_2_NONE;
+			access = VK_ACCESS_2_NONE;
+			break;
+		}
+	};
+
+	VkImageMemoryBarrier2 barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+	scope(layout, barrier.srcStageMask, barrier.srcAccessMask);
+	scope(newLayout, barrier.dstStageMask, barrier.dstAccessMask);
+	barrier.oldLayout = layout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = layer;
+	barrier.subresourceRange.layerCount = 1;
+
+	VkDependencyInfo dependency = {};
+	dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	dependency.imageMemoryBarrierCount = 1;
+	dependency.pImageMemoryBarriers = &barrier;
+	vkCmdPipelineBarrier2(cmd, &dependency);
+	layout = newLayout;
+}
+
+void ShadowCascades::begin_depth(VkCommandBuffer cmd, VkImageView view, VkAttachmentLoadOp loadOp, uint32_t viewMask) const
+{
+	VkRenderingAttachmentInfo depthAttachment = {};
+	depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	depthAttachment.imageView = view;
+	depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL;
+	depthAttachment.loadOp = loadOp;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.clearValue.depthStencil = { 1.0f, 0 };
+
+	VkRenderingInfo renderInfo = {};
+	renderInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	renderInfo.renderArea = { 0, 0, RESOLUTION, RESOLUTION };
+	renderInfo.layerCount = 1; // viewMask 不是 0 时忽略
+	renderInfo.viewMask = viewMask;
+	renderInfo.pDepthAttachment = &depthAttachment;
+	vkCmdBeginRendering(cmd, &renderInfo);
+
+	VkViewport viewport = {};
+	viewport.width = (float)RESOLUTION;
+	viewport.height = (float)RESOLUTION;
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(cmd, 0, 1, &viewport);
+	VkRect2D scissor = {};
+	scissor.extent = { RESOLUTION, RESOLUTION };
+	vkCmdSetScissor(cmd, 0, 1, &scissor);
+}
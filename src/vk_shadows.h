@@ -0,0 +1,131 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_descriptors.h"
+#include "vk_draw_list.h"
+#include "vk_memory.h"
+#include "vk_static_draws.h"
+
+// 缓存的级联阴影 (方向光)
+// 每个级联两层深度：
+// - 静态缓存：StaticDrawCache 里的静态几何，只有光的方向转过阈值、相机走出级联覆盖的范围、
+//   或者静态物体本身变了 (version) 才重画；级联的矩阵只在这时更新，平时固定不动 (没有抖动)
+// - 阴影图：先把静态缓存拷过来，再叠加这一帧的动态物体，着色器采样的是这一层
+// 远处的级联按错开的周期更新 (0、1 每帧，2 隔一帧，3 隔三帧)，同一帧里最多只有一两个远级联在重画
+// 这一帧要重画的静态缓存用多视角 (viewMask = 要重画的级联) 一次画完：静态几何只提交一次，广播到缓存的各层
+// 自己管理图像布局和 barrier (像 VirtualTexture 一样)，渲染图里只是一个 side_effect pass
+// 只在渲染线程上使用
+
+struct ShadowStats {
+	uint32_t staticRedraws{ 0 };   // 这一帧重画静态缓存的级联
+	uint32_t staticPasses{ 0 };    // 这一帧画静态缓存的 pass (多视角，0 或 1)
+	uint32_t composites{ 0 };      // 这一帧拷贝 + 叠加动态物体的级联
+	uint32_t skipped{ 0 };         // 轮到了但内容不会变、直接跳过的级联
+	uint32_t casters{ 0 };         // 这一帧的动态投影物体
+	uint32_t casterDraws{ 0 };     // 动态物体在各级联里的绘制次数
+	uint64_t totalStaticRedraws{ 0 };
+	uint64_t totalStaticPasses{ 0 };
+};
+
+class ShadowCascades {
+public:
+	static constexpr uint32_t RESOLUTION = 2048;
+	static constexpr VkFormat FORMAT = VK_FORMAT_D32_SFLOAT;
+	static constexpr float SHADOW_DISTANCE = 80.0f;  // 相机前方多远以内有阴影
+	static constexpr float SPLIT_LAMBDA = 0.75f;     // 对数 / 均匀切分的混合
+	static constexpr float MARGIN = 0.25f;           // 级联覆盖范围比切片包围球大多少 (相机可以走多远不用重画)
+	static constexpr float CASTER_DISTANCE = 50.0f;  // 覆盖范围朝光源方向再延伸多远 (范围外的物体也能投影进来)
+	static constexpr float LIGHT_THRESHOLD_DEGREES = 0.25f;
+	// 静态缓存的多视角管线按 viewMask 下标 (1..VIEW_MASKS-1)，渲染时的 viewMask 必须和管线的一致
+	static constexpr uint32_t VIEW_MASKS = 1u << MAX_SHADOW_CASCADES;
+
+	bool init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless);
+	void cleanup();
+
+	// 只有深度的管线：动态物体用 triangle_mesh.vert (push constant 里是 viewProj * model)，
+	// 静态几何用 static_mesh.vert，staticPipelines[mask] 是 viewMask = mask 的多视角管线 (VIEW_MASKS 个，下标 0 不用)
+	void set_pipelines(VkPipelineLayout layout, VkShaderStageFlags pushStages, VkPipeline dynamicPipeline, std::span<const VkPipeline> staticPipelines);
+
+	// 每帧：begin_frame -> add_caster... -> end_frame -> (shadow pass) record
+	// lightDirection 是光传播的方向 (不用归一化)
+	void begin_frame(const glm::mat4& view, float fovY, float aspect, float zNear, float zFar, const glm::vec3& lightDirection);
+	// 动态物体：center / radius 是世界空间的包围球，只画进和它相交的级联
+	void add_caster(const DrawMesh& mesh, const glm::mat4& model, const glm::vec3& center, float radius);
+	// 决定这一帧哪些级联要更新、哪些要重新拟合并重画静态缓存
+	void end_frame(uint64_t staticVersion);
+
+	// 级联 cascade 当前的矩阵 (StaticDrawCache 的第 1 + cascade 个视角)
+	const glm::mat4& view_proj(uint32_t cascade) const { return _cascades[cascade].viewProj; }
+	// 阴影相关的字段：级联矩阵、阴影图下标、采样器
+	void fill_scene(GPUSceneData& scene) const;
+
+	void record(VkCommandBuffer cmd, const StaticDrawCache& statics);
+
+	const ShadowStats& stats() const { return _stats; }
+
+private:
+	struct Cascade {
+		glm::mat4 lightView{ 1.0f };
+		glm::mat4 viewProj{ 1.0f };
+		glm::vec3 light{ 0.0f };    // 拟合时的光方向
+		glm::vec3 centerLS{ 0.0f }; // 覆盖范围中心 (光空间，xy 对齐到纹素)
+		float extent{ 0.0f };       // 覆盖范围的半边长
+		float radius{ 0.0f };       // 拟合时切片包围球的半径
+		uint64_t staticVersion{ 0 };
+		bool valid{ false };        // 静态缓存画过
+		bool update{ false };       // 这一帧轮到更新
+		bool staticDirty{ false };  // 这一帧要重画静态缓存
+		bool hadCasters{ false };   // 阴影图里叠加过动态物体
+		VkImageLayout cacheLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		VkImageLayout mapLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+		VkImageView mapView{ VK_NULL_HANDLE };
+		uint32_t textureSlot{ INVALID_SLOT };
+	};
+
+	struct Caster {
+		DrawMesh mesh;
+		glm::mat4 model;
+		glm::vec3 center;
+		float radius;
+	};
+
+	// 切片 [sliceNear, sliceFar] 的包围球 (世界空间)
+	void slice_sphere(float sliceNear, float sliceFar, glm::vec3& center, float& radius) const;
+	bool is_stale(const Cascade& cascade, const glm::vec3& center, float radius, uint64_t staticVersion) const;
+	void fit(Cascade& cascade, const glm::vec3& center, float radius);
+	bool overlaps(const Cascade& cascade, const Caster& caster) const;
+
+	void transition(VkCommandBuffer cmd, VkImage image, uint32_t layer, VkImageLayout& layout, VkImageLayout newLayout) const;
+	// viewMask 不是 0 时 view 是数组视图，第 n 位画到第 n 层
+	void begin_depth(VkCommandBuffer cmd, VkImageView view, VkAttachmentLoadOp loadOp, uint32_t viewMask) const;
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	MemoryManager* _memory{ nullptr };
+	BindlessHeap* _bindless{ nullptr };
+
+	AllocatedImage _cache{};
+	AllocatedImage _map{};
+	VkImageView _cacheArrayView{ VK_NULL_HANDLE }; // 静态缓存所有层 (多视角渲染的附件)
+	VkSampler _sampler{ VK_NULL_HANDLE };
+	uint32_t _samplerSlot{ INVALID_SLOT };
+
+	VkPipelineLayout _layout{ VK_NULL_HANDLE };
+	VkShaderStageFlags _pushStages{ 0 };
+	VkPipeline _dynamicPipeline{ VK_NULL_HANDLE };
+	VkPipeline _staticPipelines[VIEW_MASKS]{};
+	bool _hasStaticPipelines{ false };
+
+	Cascade _cascades[MAX_SHADOW_CASCADES];
+	std::vector<Caster> _casters;
+
+	// 这一帧的相机
+	glm::mat4 _cameraToWorld{ 1.0f };
+	float _tanHalfY{ 0.0f };
+	float _tanHalfX{ 0.0f };
+	float _zNear{ 0.1f };
+	float _zFar{ 1.0f };
+	glm::vec3 _light{ 0.0f, -1.0f, 0.0f };
+
+	uint64_t _frameNumber{ 0 };
+	ShadowStats _stats{};
+};
@@ -0,0 +1,287 @@
+#include "vk_skinning.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+bool SkinningSystem::init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless, AsyncCompute* compute, JobSystem* jobs, FrameArenas* arenas)
+{
+	_device = device;
+	_memory = memory;
+	_bindless = bindless;
+	_compute = compute;
+	_jobs = jobs;
+	_arenas = arenas;
+
+	auto create = [this](VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, MemoryCategory category,
+		bool shared, AllocatedBuffer& out, void** mapped) {
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.pNext = nullptr;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		if (shared) {
+			_compute->share(bufferInfo);
+		}
+		if (!_memory->create_buffer(bufferInfo, memoryUsage, category, out)) {
+			vklog::error() << "Failed to allocate skinning buffer (" << size << " bytes)";
+			return false;
+		}
+		if (mapped) {
+			vmaMapMemory(_memory->allocator(), out._allocation, mapped);
+		}
+		return true;
+	};
+
+	// 输出：计算队列写 (storage)，图形队列当顶点缓冲区读
+	if (!create((VkDeviceSize)MAX_OUTPUT_VERTICES * sizeof(Vertex), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+			VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::Geometry, true, _output, nullptr) ||
+		!create((VkDeviceSize)MAX_PALETTE_JOINTS * 3 * sizeof(glm::vec4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Other, false, _palette, (void**)&_paletteData) ||
+		!create((VkDeviceSize)MAX_INSTANCES * sizeof(GPUSkinJob), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Other, false, _jobTable, (void**)&_jobData)) {
+		return false;
+	}
+	_outputSlot = _bindless->add_storage_buffer(_output._buffer);
+	_paletteSlot = _bindless->add_storage_buffer(_palette._buffer);
+	_jobSlot = _bindless->add_storage_buffer(_jobTable._buffer);
+
+	_instances.reserve(MAX_INSTANCES);
+	return true;
+}
+
+void SkinningSystem::cleanup()
+{
+	// bindless 槽位随全局 set 一起释放
+	if (_device == VK_NULL_HANDLE) {
+		return;
+	}
+	for (Skin& skin : _skins) {
+		_memory->destroy_buffer(skin.vertices);
+		_memory->destroy_buffer(skin.weights);
+	}
+	_skins.clear();
+	if (_paletteData) {
+		vmaUnmapMemory(_memory->allocator(), _palette._allocation);
+		_memory->destroy_buffer(_palette);
+	}
+	if (_jobData) {
+		vmaUnmapMemory(_memory->allocator(), _jobTable._allocation);
+		_memory->destroy_buffer(_jobTable);
+	}
+	if (_output._buffer != VK_NULL_HANDLE) {
+		_memory->destroy_buffer(_output);
+	}
+	_paletteData = nullptr;
+	_jobData = nullptr;
+	_output = {};
+	_device = VK_NULL_HANDLE;
+}
+
+void SkinningSystem::set_pipeline(VkPipelineLayout layout, VkShaderStageFlags pushStages, VkPipeline pipeline)
+{
+	_layout = layout;
+	_pushStages = pushStages;
+	_pipeline = pipeline;
+}
+
+uint32_t SkinningSystem::add_skeleton(vkanim::Skeleton skeleton)
+{
+	const uint32_t jointCount = skeleton.joint_count();
+	if (jointCount == 0 || jointCount > vkanim::MAX_JOINTS || skeleton.inverseBind.size() != jointCount) {
+		vklog::error() << "Invalid skeleton (" << jointCount << " joints)";
+		return INVALID_SLOT;
+	}
+	for (uint32_t joint = 0; joint < jointCount; joint++) {
+		if (skeleton.parents[joint] >= (int32_t)joint) {
+			vklog::error() << "Skeleton joint " << joint << " comes before its parent";
+			return INVALID_SLOT;
+		}
+	}
+	_skeletons.push_back(std::move(skeleton));
+	return (uint32_t)_skeletons.size() - 1;
+}
+
+uint32_t SkinningSystem::add_clip(vkanim::Clip clip)
+{
+	if (clip.frameCount == 0) {
+		return INVALID_SLOT;
+	}
+	_clips.push_back(std::move(clip));
+	return (uint32_t)_clips.size() - 1;
+}
+
+uint32_t SkinningSystem::add_skin(std::span<const Vertex> vertices, std::span<const vkanim::SkinWeights> weights, uint32_t skeleton)
+{
+	if (skeleton >= _skeletons.size() || vertices.empty() || vertices.size() != weights.size() || vertices.size() > MAX_OUTPUT_VERTICES) {
+		vklog::error() << "Invalid skin (" << vertices.size() << " vertices, " << weights.size() << " weights)";
+		return INVALID_SLOT;
+	}
+
+	// 权重量化成 8 位：先按比例取整，差的那一点补到最大的权重上，保证总和正好是 255
+	const uint32_t jointCount = _skeletons[skeleton].joint_count();
+	std::vector<uint32_t> packed(vertices.size() * 2);
+	for (size_t i = 0; i < weights.size(); i++) {
+		const vkanim::SkinWeights& w = weights[i];
+		const float sum = std::max(w.weights.x + w.weights.y + w.weights.z + w.weights.w, 1e-6f);
+		uint32_t quantized[4];
+		uint32_t total = 0;
+		uint32_t largest = 0;
+		for (uint32_t k = 0; k < 4; k++) {
+			quantized[k] = (uint32_t)std::lround(std::clamp(w.weights[k] / sum, 0.0f, 1.0f) * 255.0f);
+			total += quantized[k];
+			largest = w.weights[k] > w.weights[largest] ? k : largest;
+		}
+		quantized[largest] = (uint32_t)std::clamp((int32_t)quantized[largest] + 255 - (int32_t)total, 0, 255);
+
+		uint32_t joints = 0;
+		uint32_t packedWeights = 0;
+		for (uint32_t k = 0; k < 4; k++) {
+			const uint32_t joint = w.joints[k] < jointCount ? w.joints[k] : 0;
+			joints |= joint << (k * 8);
+			packedWeights |= quantized[k] << (k * 8);
+		}
+		packed[i * 2 + 0] = joints;
+		packed[i * 2 + 1] = packedWeights;
+	}
+
+	auto upload = [this](const void* src, size_t size, AllocatedBuffer& out) {
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.pNext = nullptr;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		if (!_memory->create_buffer(bufferInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Geometry, out)) {
+			vklog::error() << "Failed to allocate skin buffer (" << size << " bytes)";
+			return false;
+		}
+		void* data;
+		vmaMapMemory(_memory->allocator(), out._allocation, &data);
+		memcpy(data, src, size);
+		vmaUnmapMemory(_memory->allocator(), out._allocation);
+		return true;
+	};
+
+	Skin skin = {};
+	if (!upload(vertices.data(), vertices.size_bytes(), skin.vertices)) {
+		return INVALID_SLOT;
+	}
+	if (!upload(packed.data(), packed.size() * sizeof(uint32_t), skin.weights)) {
+		_memory->destroy_buffer(skin.vertices);
+		return INVALID_SLOT;
+	}
+	skin.vertexSlot = _bindless->add_storage_buffer(skin.vertices._buffer);
+	skin.weightSlot = _bindless->add_storage_buffer(skin.weights._buffer);
+	skin.vertexCount = (uint32_t)vertices.size();
+	skin.skeleton = skeleton;
+	_skins.push_back(skin);
+	return (uint32_t)_skins.size() - 1;
+}
+
+void SkinningSystem::begin_frame()
+{
+	_instances.clear();
+	_outputVertices = 0;
+	_paletteJoints = 0;
+	_maxVertices = 0;
+	_stats.instances = 0;
+	_stats.vertices = 0;
+	_stats.joints = 0;
+	_stats.dropped = 0;
+}
+
+uint32_t SkinningSystem::add_instance(uint32_t skin, uint32_t clip0, float time0, uint32_t clip1, float time1, float blend)
+{
+	if (_pipeline == VK_NULL_HANDLE || skin >= _skins.size()) {
+		return INVALID_SLOT;
+	}
+	const Skin& data = _skins[skin];
+	const uint32_t jointCount = _skeletons[data.skeleton].joint_count();
+	if (_instances.size() >= MAX_INSTANCES || _outputVertices + data.vertexCount > MAX_OUTPUT_VERTICES ||
+		_paletteJoints + jointCount > MAX_PALETTE_JOINTS) {
+		_stats.dropped++;
+		return INVALID_SLOT;
+	}
+
+	Instance instance = {};
+	instance.skin = skin;
+	instance.clips[0] = clip0;
+	instance.clips[1] = clip1;
+	instance.times[0] = time0;
+	instance.times[1] = time1;
+	instance.blend = blend;
+	instance.firstJoint = _paletteJoints;
+
+	// 实例表按加入的顺序直接写进映射内存 (dispatch 的 y 就是这里的下标)
+	GPUSkinJob job = {};
+	job.sourceBuffer = data.vertexSlot;
+	job.weightBuffer = data.weightSlot;
+	job.vertexCount = data.vertexCount;
+	job.outputOffset = _outputVertices;
+	job.firstJoint = _paletteJoints;
+	_jobData[_instances.size()] = job;
+	_instances.push_back(instance);
+
+	const uint32_t offset = _outputVertices;
+	_outputVertices += data.vertexCount;
+	_paletteJoints += jointCount;
+	_maxVertices = std::max(_maxVertices, data.vertexCount);
+	_stats.instances++;
+	_stats.vertices += data.vertexCount;
+	_stats.joints += jointCount;
+	return offset;
+}
+
+void SkinningSystem::evaluate(const Instance& instance, vkanim::Pose& pose, vkanim::Pose& other, vkanim::PoseScratch& scratch)
+{
+	const vkanim::Skeleton& skeleton = _skeletons[_skins[instance.skin].skeleton];
+	const uint32_t jointCount = skeleton.joint_count();
+
+	// 关节数和骨架不一样的片段当作没有 (绑定姿势)
+	auto usable = [&](uint32_t clip) {
+		return clip < _clips.size() && _clips[clip].jointCount == jointCount;
+	};
+	if (usable(instance.clips[0])) {
+		vkanim::sample(_clips[instance.clips[0]], instance.times[0], pose, scratch);
+		if (usable(instance.clips[1]) && instance.blend > 0.0f) {
+			vkanim::sample(_clips[instance.clips[1]], instance.times[1], other, scratch);
+			vkanim::blend(pose, other, std::min(instance.blend, 1.0f), pose);
+		}
+	}
+	else {
+		pose.resize(0);
+	}
+	vkanim::skinning_matrices(skeleton, pose, _paletteData + (size_t)instance.firstJoint * 3, scratch);
+}
+
+void SkinningSystem::end_frame()
+{
+	if (_instances.empty()) {
+		_stats.poseMs = 0.0f;
+		return;
+	}
+
+	// 1. 姿势：实例之间互不相关，分批交给工作线程 (渲染线程自己也领)，各自写矩阵表里自己的那一段
+	//    姿势和解码用的临时数据每批只建一份 (在领到这一批的线程自己这一帧的 arena 上)，批内的实例反复使用
+	const auto start = std::chrono::high_resolution_clock::now();
+	_jobs->parallel_for((uint32_t)_instances.size(), POSE_BATCH, [this](uint32_t begin, uint32_t end) {
+		LinearArena& scratch = _arenas->local();
+		vkanim::Pose pose(&scratch);
+		vkanim::Pose other(&scratch);
+		vkanim::PoseScratch poseScratch(&scratch);
+		for (uint32_t i = begin; i < end; i++) {
+			evaluate(_instances[i], pose, other, poseScratch);
+		}
+	});
+	_stats.poseMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// 2. 蒙皮：x 是顶点，y 是实例；矩阵表和实例表是提交之前写好的主机内存，提交本身保证可见
+	VkCommandBuffer cmd = _compute->begin();
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+	_bindless->bind(cmd, _layout, VK_PIPELINE_BIND_POINT_COMPUTE);
+	const PushConstants push = { _jobSlot, _paletteSlot, _outputSlot, 0 };
+	vkCmdPushConstants(cmd, _layout, _pushStages, 0, sizeof(push), &push);
+	vkCmdDispatch(cmd, (_maxVertices + GROUP_SIZE - 1) / GROUP_SIZE, (uint32_t)_instances.size(), 1);
+	_compute->submit(cmd, VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_animation.h"
+#include "vk_arena.h"
+#include "vk_compute.h"
+#include "vk_descriptors.h"
+#include "vk_jobs.h"
+#include "vk_memory.h"
+
+// 计算蒙皮
+// 每帧：工作线程并行采样 / 混合每个实例的姿势、算蒙皮矩阵，直接写进映射的矩阵表
+// -> 异步计算队列上一次 dispatch 把所有实例的顶点蒙皮到输出 mega-buffer (格式还是 Vertex)
+// -> 图形队列在顶点输入阶段等这批计算；之后蒙皮好的顶点和普通网格一样画，forward 和阴影用同一份结果，不再每个 pass 各蒙一次
+// 实例在输出 buffer 里按加入的顺序紧挨着放，每帧重新分配
+// 只在渲染线程上使用 (add_skeleton / add_clip / add_skin 在初始化时调用)；FRAMES_IN_FLIGHT = 1，begin_frame 之前已经等过 fence，
+// 上一帧的图形工作 (读输出 buffer) 已经完成，这一帧的计算可以直接覆盖
+
+// 和 skinning.comp 里的 SkinJob 一致 (std430)
+struct GPUSkinJob {
+	uint32_t sourceBuffer;  // bindless 下标：绑定姿势的顶点 (Vertex)
+	uint32_t weightBuffer;  // bindless 下标：每个顶点 4 个关节下标 (各 8 位) + 4 个权重 (unorm8)
+	uint32_t vertexCount;
+	uint32_t outputOffset;  // 输出 buffer 里的第一个顶点
+	uint32_t firstJoint;    // 矩阵表里的第一个关节 (每个关节 3 个 vec4)
+	uint32_t pad0;
+	uint32_t pad1;
+	uint32_t pad2;
+};
+static_assert(sizeof(GPUSkinJob) == 32);
+
+struct SkinningStats {
+	uint32_t instances{ 0 };  // 这一帧蒙皮的实例
+	uint32_t vertices{ 0 };   // 这一帧蒙皮的顶点
+	uint32_t joints{ 0 };     // 这一帧算的蒙皮矩阵
+	uint32_t dropped{ 0 };    // 输出 buffer / 矩阵表 / 实例表装不下的实例 (调用方按绑定姿势画)
+	float poseMs{ 0.0f };     // 采样 + 混合 + 蒙皮矩阵 (多线程) 的墙钟时间
+};
+
+class SkinningSystem {
+public:
+	static constexpr uint32_t MAX_INSTANCES = 4096;
+	static constexpr uint32_t MAX_OUTPUT_VERTICES = 1u << 19;
+	static constexpr uint32_t MAX_PALETTE_JOINTS = 1u << 16;
+	static constexpr uint32_t GROUP_SIZE = 64;  // 和 skinning.comp 的 local_size_x 一致
+	static constexpr uint32_t POSE_BATCH = 32;  // 工作线程每次领多少个实例
+
+	// 姿势的临时数据放在各个线程这一帧的 arena 上 (arenas 由引擎在等过 fence 之后重置)
+	bool init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless, AsyncCompute* compute, JobSystem* jobs, FrameArenas* arenas);
+	void cleanup();
+
+	// skinning.comp 的管线；没有管线时不蒙皮，add_instance 全部返回 INVALID_SLOT
+	void set_pipeline(VkPipelineLayout layout, VkShaderStageFlags pushStages, VkPipeline pipeline);
+
+	uint32_t add_skeleton(vkanim::Skeleton skeleton);
+	uint32_t add_clip(vkanim::Clip clip);
+	// vertices / weights 一一对应，顺序和网格上传的顶点相同 (蒙皮网格不焊接)；返回 skin 下标
+	uint32_t add_skin(std::span<const Vertex> vertices, std::span<const vkanim::SkinWeights> weights, uint32_t skeleton);
+
+	// 每帧：begin_frame -> add_instance... -> end_frame
+	void begin_frame();
+	// clip1 为 INVALID_SLOT 时只用 clip0；clip0 也是 INVALID_SLOT 时是绑定姿势
+	// 返回这个实例在输出 buffer 里的第一个顶点，装不下时返回 INVALID_SLOT
+	uint32_t add_instance(uint32_t skin, uint32_t clip0, float time0, uint32_t clip1, float time1, float blend);
+	// 并行算姿势，然后把蒙皮提交到异步计算队列 (图形队列下一次帧提交会等它)
+	void end_frame();
+
+	VkBuffer output_buffer() const { return _output._buffer; }
+	const SkinningStats& stats() const { return _stats; }
+
+private:
+	struct Skin {
+		AllocatedBuffer vertices;
+		AllocatedBuffer weights;
+		uint32_t vertexSlot;
+		uint32_t weightSlot;
+		uint32_t vertexCount;
+		uint32_t skeleton;
+	};
+
+	struct Instance {
+		uint32_t skin;
+		uint32_t clips[2];
+		float times[2];
+		float blend;
+		uint32_t firstJoint;
+	};
+
+	// 和 skinning.comp 里的 push constant 一致
+	struct PushConstants {
+		uint32_t jobBuffer;
+		uint32_t paletteBuffer;
+		uint32_t outputBuffer;
+		uint32_t pad0;
+	};
+
+	// 一个实例的姿势 -> 矩阵表 (工作线程上)
+	void evaluate(const Instance& instance, vkanim::Pose& pose, vkanim::Pose& other, vkanim::PoseScratch& scratch);
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	MemoryManager* _memory{ nullptr };
+	BindlessHeap* _bindless{ nullptr };
+	AsyncCompute* _compute{ nullptr };
+	JobSystem* _jobs{ nullptr };
+	FrameArenas* _arenas{ nullptr };
+
+	VkPipelineLayout _layout{ VK_NULL_HANDLE };
+	VkShaderStageFlags _pushStages{ 0 };
+	VkPipeline _pipeline{ VK_NULL_HANDLE };
+
+	std::vector<vkanim::Skeleton> _skeletons;
+	std::vector<vkanim::Clip> _clips;
+	std::vector<Skin> _skins;
+
+	// 输出 buffer 两个队列都访问 (队列族不同时 CONCURRENT)；矩阵表和实例表 CPU 每帧写，常驻映射
+	AllocatedBuffer _output{};
+	AllocatedBuffer _palette{};
+	glm::vec4* _paletteData{ nullptr };
+	AllocatedBuffer _jobTable{};
+	GPUSkinJob* _jobData{ nullptr };
+	uint32_t _outputSlot{ INVALID_SLOT };
+	uint32_t _paletteSlot{ INVALID_SLOT };
+	uint32_t _jobSlot{ INVALID_SLOT };
+
+	// 这一帧
+	std::vector<Instance> _instances;
+	uint32_t _outputVertices{ 0 };
+	uint32_t _paletteJoints{ 0 };
+	uint32_t _maxVertices{ 0 }; // 最大的实例，决定 dispatch 的 x
+
+	SkinningStats _stats{};
+};
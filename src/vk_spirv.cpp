@@ -0,0 +1,332 @@
+#include "vk_spirv.h"
+
+#include <algorithm>
+
+namespace {
+
+	// 反射只需要用到的一小部分 SPIR-V 操作码 / 枚举
+	constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+	enum Op : uint32_t {
+		OpEntryPoint = 15,
+		OpTypeInt = 21,
+		OpTypeFloat = 22,
+		OpTypeVector = 23,
+		OpTypeMatrix = 24,
+		OpTypeImage = 25,
+		OpTypeSampler = 26,
+		OpTypeSampledImage = 27,
+		OpTypeArray = 28,
+		OpTypeRuntimeArray = 29,
+		OpTypeStruct = 30,
+		OpTypePointer = 32,
+		OpConstant = 43,
+		OpVariable = 59,
+		OpDecorate = 71,
+		OpMemberDecorate = 72,
+		OpTypeAccelerationStructureKHR = 5341,
+	};
+
+	enum Decoration : uint32_t {
+		DecorationBlock = 2,
+		DecorationBufferBlock = 3,
+		DecorationArrayStride = 6,
+		DecorationMatrixStride = 7,
+		DecorationBinding = 33,
+		DecorationDescriptorSet = 34,
+		DecorationOffset = 35,
+	};
+
+	enum StorageClass : uint32_t {
+		StorageClassUniformConstant = 0,
+		StorageClassUniform = 2,
+		StorageClassPushConstant = 9,
+		StorageClassStorageBuffer = 12,
+	};
+
+	constexpr uint32_t DimBuffer = 5;
+	constexpr uint32_t DimSubpassData = 6;
+	constexpr uint32_t UNSET = ~0u;
+
+	struct MemberInfo {
+		uint32_t offset{ 0 };
+		uint32_t matrixStride{ 0 };
+	};
+
+	struct IdInfo {
+		const uint32_t* inst{ nullptr }; // 定义这个 id 的类型/常量指令
+		uint32_t set{ UNSET };
+		uint32_t binding{ UNSET };
+		uint32_t arrayStride{ 0 };
+		bool block{ false };
+		bool bufferBlock{ false };
+		std::vector<MemberInfo> members;
+	};
+
+	struct Variable {
+		uint32_t id;
+		uint32_t pointerType;
+		uint32_t storageClass;
+	};
+
+	VkShaderStageFlagBits stage_from_execution_model(uint32_t model)
+	{
+		switch (model) {
+		case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+		case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+		case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+		case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+		case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+		case 5364: return VK_SHADER_STAGE_TASK_BIT_EXT;
+		case 5365: return VK_SHADER_STAGE_MESH_BIT_EXT;
+		default: return VK_SHADER_STAGE_ALL;
+		}
+	}
+
+	class Reflector {
+	public:
+		std::vector<IdInfo> ids;
+
+		IdInfo* get(uint32_t id) { return id < ids.size() ? &ids[id] : nullptr; }
+
+		uint32_t op_of(uint32_t id)
+		{
+			IdInfo* info = get(id);
+			return (info && info->inst) ? (info->inst[0] & 0xFFFF) : 0;
+		}
+
+		uint32_t constant_value(uint32_t id)
+		{
+			IdInfo* info = get(id);
+			if (!info || !info->inst || (info->inst[0] & 0xFFFF) != OpConstant) {
+				return 1;
+			}
+			return info->inst[3];
+		}
+
+		// 计算类型在 buffer 布局 (std140/std430/push constant) 下占用的字节数
+		uint32_t type_size(uint32_t id, uint32_t matrixStride = 0)
+		{
+			IdInfo* info = get(id);
+			if (!info || !info->inst) {
+				return 0;
+			}
+			const uint32_t* inst = info->inst;
+			switch (inst[0] & 0xFFFF) {
+			case OpTypeInt:
+			case OpTypeFloat:
+				return inst[2] / 8;
+			case OpTypeVector:
+				return inst[3] * type_size(inst[2]);
+			case OpTypeMatrix:
+				return inst[3] * (matrixStride ? matrixStride : type_size(inst[2]));
+			case OpTypeArray: {
+				uint32_t stride = info->arrayStride ? info->arrayStride : type_size(inst[2]);
+				return constant_value(inst[3]) * stride;
+			}
+			case OpTypeRuntimeArray:
+				return 0;
+			case OpTypePointer:
+				return 8; // buffer device address
+			case OpTypeStruct: {
+				uint32_t size = 0;
+				uint32_t memberCount = (inst[0] >> 16) - 2;
+				for (uint32_t m = 0; m < memberCount; m++) {
+					MemberInfo member = m < info->members.size() ? info->members[m] : MemberInfo{};
+					size = std::max(size, member.offset + type_size(inst[2 + m], member.matrixStride));
+				}
+				return size;
+			}
+			default:
+				return 0;
+			}
+		}
+
+		uint32_t descriptor_type(uint32_t typeId, uint32_t storageClass)
+		{
+			switch (storageClass) {
+			case StorageClassStorageBuffer:
+				return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			case StorageClassUniform: {
+				IdInfo* info = get(typeId);
+				return (info && info->bufferBlock) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			}
+			default:
+				break;
+			}
+
+			IdInfo* info = get(typeId);
+			if (!info || !info->inst) {
+				return UNSET;
+			}
+			const uint32_t* inst = info->inst;
+			switch (inst[0] & 0xFFFF) {
+			case OpTypeSampler:
+				return VK_DESCRIPTOR_TYPE_SAMPLER;
+			case OpTypeSampledImage: {
+				IdInfo* image = get(inst[2]);
+				if (image && image->inst && image->inst[3] == DimBuffer) {
+					return VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				}
+				return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			}
+			case OpTypeImage: {
+				uint32_t dim = inst[3];
+				uint32_t sampled = inst[7];
+				if (dim == DimSubpassData) {
+					return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+				}
+				if (dim == DimBuffer) {
+					return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				}
+				return sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			}
+			case OpTypeAccelerationStructureKHR:
+				return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+			default:
+				return UNSET;
+			}
+		}
+	};
+}
+
+bool vkspirv::reflect(const uint32_t* code, size_t wordCount, ShaderReflection& out)
+{
+	out = ShaderReflection{};
+	if (wordCount < 5 || code[0] != SPIRV_MAGIC) {
+		return false;
+	}
+
+	Reflector r;
+	r.ids.resize(code[3]); // header 第 4 个字是 id 上界
+	std::vector<Variable> variables;
+
+	// 1. 扫一遍指令流，收集类型/常量定义、装饰和变量
+	size_t cursor = 5;
+	while (cursor < wordCount) {
+		const uint32_t* inst = code + cursor;
+		uint32_t count = inst[0] >> 16;
+		uint32_t opcode = inst[0] & 0xFFFF;
+		if (count == 0 || cursor + count > wordCount) {
+			return false; // 字节码损坏
+		}
+
+		switch (opcode) {
+		case OpEntryPoint:
+			if (out.stage == VK_SHADER_STAGE_ALL) {
+				out.stage = stage_from_execution_model(inst[1]);
+			}
+			break;
+		case OpTypeInt:
+		case OpTypeFloat:
+		case OpTypeVector:
+		case OpTypeMatrix:
+		case OpTypeImage:
+		case OpTypeSampler:
+		case OpTypeSampledImage:
+		case OpTypeArray:
+		case OpTypeRuntimeArray:
+		case OpTypeStruct:
+		case OpTypePointer:
+		case OpTypeAccelerationStructureKHR:
+			if (IdInfo* info = r.get(inst[1])) info->inst = inst;
+			break;
+		case OpConstant:
+			if (IdInfo* info = r.get(inst[2])) info->inst = inst;
+			break;
+		case OpVariable:
+			variables.push_back({ inst[2], inst[1], inst[3] });
+			break;
+		case OpDecorate:
+			if (IdInfo* info = r.get(inst[1])) {
+				switch (inst[2]) {
+				case DecorationBlock: info->block = true; break;
+				case DecorationBufferBlock: info->bufferBlock = true; break;
+				case DecorationArrayStride: info->arrayStride = inst[3]; break;
+				case DecorationBinding: info->binding = inst[3]; break;
+				case DecorationDescriptorSet: info->set = inst[3]; break;
+				default: break;
+				}
+			}
+			break;
+		case OpMemberDecorate:
+			if (IdInfo* info = r.get(inst[1])) {
+				uint32_t member = inst[2];
+				if (info->members.size() <= member) {
+					info->members.resize(member + 1);
+				}
+				if (inst[3] == DecorationOffset) info->members[member].offset = inst[4];
+				if (inst[3] == DecorationMatrixStride) info->members[member].matrixStride = inst[4];
+			}
+			break;
+		default:
+			break;
+		}
+		cursor += count;
+	}
+
+	// 2. 把变量翻译成 descriptor 绑定 / push constant 范围
+	for (const Variable& var : variables) {
+		IdInfo* pointer = r.get(var.pointerType);
+		if (!pointer || !pointer->inst || (pointer->inst[0] & 0xFFFF) != OpTypePointer) {
+			continue;
+		}
+		uint32_t typeId = pointer->inst[3];
+
+		if (var.storageClass == StorageClassPushConstant) {
+			IdInfo* block = r.get(typeId);
+			if (!block || !block->inst) {
+				continue;
+			}
+			uint32_t begin = UNSET;
+			for (const MemberInfo& member : block->members) {
+				begin = std::min(begin, member.offset);
+			}
+			out.pushConstantOffset = begin == UNSET ? 0 : begin;
+			out.pushConstantSize = r.type_size(typeId) - out.pushConstantOffset;
+			continue;
+		}
+
+		if (var.storageClass != StorageClassUniformConstant &&
+			var.storageClass != StorageClassUniform &&
+			var.storageClass != StorageClassStorageBuffer) {
+			continue;
+		}
+
+		IdInfo* info = r.get(var.id);
+		if (!info || info->set == UNSET || info->binding == UNSET) {
+			continue;
+		}
+
+		// 展开数组：sampler2D textures[16] / 运行时数组 textures[]
+		uint32_t count = 1;
+		for (uint32_t op = r.op_of(typeId); op == OpTypeArray || op == OpTypeRuntimeArray; op = r.op_of(typeId)) {
+			const uint32_t* arrayInst = r.get(typeId)->inst;
+			count = (op == OpTypeRuntimeArray) ? 0 : count * r.constant_value(arrayInst[3]);
+			typeId = arrayInst[2];
+		}
+
+		uint32_t type = r.descriptor_type(typeId, var.storageClass);
+		if (type == UNSET) {
+			continue;
+		}
+		out.bindings.push_back({ info->set, info->binding, type, count });
+	}
+
+	std::sort(out.bindings.begin(), out.bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b) {
+		return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+	});
+	return out.stage != VK_SHADER_STAGE_ALL;
+}
+
+uint64_t vkspirv::hash_fnv1a(const void* data, size_t size, uint64_t seed)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+// SPIR-V 反射 + shader 包 (shaders.pak) 文件格式
+// 这个文件只依赖 Vulkan 头文件，打包工具 (tools/shader_packer.cpp) 和引擎共用同一份代码
+namespace vkspirv {
+
+	// ---------------- 反射结果 ----------------
+
+	struct ReflectedBinding {
+		uint32_t set;
+		uint32_t binding;
+		uint32_t descriptorType;  // VkDescriptorType
+		uint32_t descriptorCount; // 0 表示运行时数组 (无界数组，比如 bindless)
+	};
+
+	struct ShaderReflection {
+		VkShaderStageFlagBits stage{ VK_SHADER_STAGE_ALL };
+		std::vector<ReflectedBinding> bindings;
+		uint32_t pushConstantOffset{ 0 };
+		uint32_t pushConstantSize{ 0 }; // 0 表示没有 push constant
+	};
+
+	// 解析 SPIR-V 字节码，提取 stage / descriptor 绑定 / push constant 范围
+	bool reflect(const uint32_t* code, size_t wordCount, ShaderReflection& out);
+
+	// FNV-1a 64 位哈希 (内容哈希 & 名字哈希)
+	uint64_t hash_fnv1a(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+	inline uint64_t hash_name(std::string_view name) { return hash_fnv1a(name.data(), name.size()); }
+
+	// ---------------- 包文件格式 ----------------
+	// [PackHeader][PackEntry * entryCount][ReflectedBinding * bindingCount][名字字符串][SPIR-V 代码...]
+	// 所有代码段都按 PACK_ALIGNMENT 对齐，内存映射后可以直接把指针交给 vkCreateShaderModule
+
+	constexpr uint32_t PACK_MAGIC = 0x4B505356; // "VSPK"
+	constexpr uint32_t PACK_VERSION = 1;
+	constexpr uint32_t PACK_ALIGNMENT = 16;
+
+	struct PackHeader {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t bindingCount;
+		uint64_t entriesOffset;
+		uint64_t bindingsOffset;
+		uint64_t stringsOffset;
+		uint64_t fileSize;
+	};
+
+	struct PackEntry {
+		uint64_t nameHash;          // 按名字哈希排序，运行时二分查找
+		uint64_t contentHash;       // SPIR-V 内容哈希，内容相同的 shader 共享同一段代码
+		uint64_t codeOffset;
+		uint32_t codeSize;          // 字节数
+		uint32_t nameOffset;        // 相对 stringsOffset
+		uint32_t nameLength;
+		uint32_t stage;             // VkShaderStageFlagBits
+		uint32_t firstBinding;      // 在 ReflectedBinding 数组里的起始下标
+		uint32_t bindingCount;
+		uint32_t pushConstantOffset;
+		uint32_t pushConstantSize;
+	};
+
+	static_assert(sizeof(PackHeader) % 8 == 0, "PackHeader must stay 8-byte aligned");
+	static_assert(sizeof(PackEntry) % 8 == 0, "PackEntry must stay 8-byte aligned");
+}
@@ -0,0 +1,186 @@
+#include "vk_startup.h"
+#include "vk_log.h"
+
+#include <algorithm>
+#include <cstdio>
+
+StartupGraph::StageId StartupGraph::add_stage(const char* name, StageThread thread, std::initializer_list<StageId> dependencies, std::function<bool()> run)
+{
+	const StageId id = (StageId)_stages.size();
+
+	Stage stage;
+	stage.name = name;
+	stage.thread = thread;
+	stage.dependencies.assign(dependencies.begin(), dependencies.end());
+	stage.run = std::move(run);
+	_stages.push_back(std::move(stage));
+
+	// 依赖只能指向已经添加的阶段，所以图天然无环
+	for (StageId dependency : dependencies) {
+		_stages[dependency].dependents.push_back(id);
+	}
+	return id;
+}
+
+bool StartupGraph::run(JobSystem& jobs)
+{
+	_jobs = &jobs;
+	_start = Clock::now();
+	_mainThread = std::this_thread::get_id();
+	_failed = false;
+	_remaining = (uint32_t)_stages.size();
+
+	std::vector<StageId> readyWorkers;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (StageId id = 0; id < _stages.size(); id++) {
+			Stage& stage = _stages[id];
+			stage.pending = (uint32_t)stage.dependencies.size();
+			if (stage.pending == 0) {
+				if (stage.thread == StageThread::Main) {
+					_mainReady.push_back(id);
+				}
+				else {
+					readyWorkers.push_back(id);
+				}
+			}
+		}
+	}
+	// 在锁外提交：JobSystem 没有工作线程时会在当前线程直接执行
+	for (StageId id : readyWorkers) {
+		_jobs->submit([this, id]() { execute(id); });
+	}
+
+	// 主线程：执行轮到它的阶段，其余时间等工作线程
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (_remaining > 0) {
+		if (!_mainReady.empty()) {
+			const StageId id = _mainReady.front();
+			_mainReady.erase(_mainReady.begin());
+			lock.unlock();
+			execute(id);
+			lock.lock();
+			continue;
+		}
+		_changed.wait(lock);
+	}
+	return !_failed;
+}
+
+void StartupGraph::execute(StageId id)
+{
+	Stage& stage = _stages[id];
+
+	StageState state = StageState::Skipped;
+	if (!stage.skip) {
+		stage.ranOnMain = std::this_thread::get_id() == _mainThread;
+		stage.startMs = elapsed_ms();
+		state = stage.run() ? StageState::Done : StageState::Failed;
+		stage.endMs = elapsed_ms();
+		if (state == StageState::Failed) {
+			vklog::error() << "Startup stage '" << stage.name << "' failed";
+		}
+	}
+
+	std::vector<StageId> readyWorkers;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		complete(id, state, readyWorkers);
+	}
+	_changed.notify_all();
+
+	for (StageId ready : readyWorkers) {
+		_jobs->submit([this, ready]() { execute(ready); });
+	}
+}
+
+void StartupGraph::complete(StageId id, StageState state, std::vector<StageId>& readyWorkers)
+{
+	// 调用方已经加锁
+	Stage& stage = _stages[id];
+	stage.state = state;
+	_remaining--;
+	if (state != StageState::Done) {
+		_failed = true;
+	}
+
+	for (StageId dependentId : stage.dependents) {
+		Stage& dependent = _stages[dependentId];
+		if (state != StageState::Done) {
+			dependent.skip = true;
+		}
+		if (--dependent.pending == 0) {
+			if (dependent.thread == StageThread::Main) {
+				_mainReady.push_back(dependentId);
+			}
+			else {
+				readyWorkers.push_back(dependentId);
+			}
+		}
+	}
+}
+
+float StartupGraph::elapsed_ms() const
+{
+	return std::chrono::duration<float, std::milli>(Clock::now() - _start).count();
+}
+
+void StartupGraph::report() const
+{
+	if (_stages.empty()) {
+		return;
+	}
+
+	// 1. 时间线 (按开始时间)
+	std::vector<StageId> order(_stages.size());
+	for (StageId id = 0; id < order.size(); id++) {
+		order[id] = id;
+	}
+	std::sort(order.begin(), order.end(), [this](StageId a, StageId b) { return _stages[a].startMs < _stages[b].startMs; });
+
+	float wallMs = 0.0f;
+	float workMs = 0.0f;
+	StageId last = order.front();
+	vklog::info() << "Startup stages (ms):";
+	for (StageId id : order) {
+		const Stage& stage = _stages[id];
+		char line[160];
+		if (stage.state == StageState::Skipped) {
+			snprintf(line, sizeof(line), "  %-20s skipped", stage.name);
+		}
+		else {
+			snprintf(line, sizeof(line), "  %-20s %8.1f -> %8.1f  %8.1f  %s%s", stage.name, stage.startMs, stage.endMs,
+				stage.endMs - stage.startMs, stage.ranOnMain ? "main" : "worker", stage.state == StageState::Failed ? "  FAILED" : "");
+			workMs += stage.endMs - stage.startMs;
+			if (stage.endMs >= wallMs) {
+				wallMs = stage.endMs;
+				last = id;
+			}
+		}
+		vklog::info() << line;
+	}
+
+	// 2. 关键路径：从最后结束的阶段开始，每次回到最晚结束的那个依赖
+	//    想缩短启动时间就得缩短这条链上的阶段
+	std::vector<StageId> path = { last };
+	for (;;) {
+		const Stage& stage = _stages[path.back()];
+		if (stage.dependencies.empty()) {
+			break;
+		}
+		StageId latest = stage.dependencies.front();
+		for (StageId dependency : stage.dependencies) {
+			if (_stages[dependency].endMs > _stages[latest].endMs) {
+				latest = dependency;
+			}
+		}
+		path.push_back(latest);
+	}
+
+	vklog::Line line = vklog::info();
+	line << "Startup: " << wallMs << " ms wall, " << workMs << " ms of stage work (" << (wallMs > 0.0f ? workMs / wallMs : 1.0f)
+		<< "x overlap), critical path: ";
+	for (size_t i = path.size(); i-- > 0;) {
+		line << _stages[path[i]].name << (i > 0 ? " -> " : "");
+	}
+}
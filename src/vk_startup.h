@@ -0,0 +1,63 @@
+#pragma once
+
+#include "vk_jobs.h"
+
+#include <chrono>
+#include <initializer_list>
+
+// 启动依赖图
+// 每个阶段声明依赖哪些阶段，依赖全部完成后立刻开始：
+// - Worker 阶段交给 JobSystem (读文件、解析资源、创建管线这类不需要在主线程上的活)
+// - Main 阶段在 run() 的调用线程上执行 (SDL 窗口 / surface 必须在主线程)
+// 阶段返回 false 表示失败，直接或间接依赖它的阶段全部跳过，run() 返回 false
+// 共享同一个非线程安全对象 (比如 MemoryManager) 的阶段必须用依赖串起来，图不会替它们加锁
+class StartupGraph {
+public:
+	using StageId = uint32_t;
+	enum class StageThread { Worker, Main };
+
+	StageId add_stage(const char* name, StageThread thread, std::initializer_list<StageId> dependencies, std::function<bool()> run);
+
+	// 阻塞到所有阶段完成 (或被跳过)
+	bool run(JobSystem& jobs);
+
+	// 从 run() 开始到现在的毫秒数 (用来算首帧时间)
+	float elapsed_ms() const;
+
+	// 打印每个阶段的时间线、总耗时和关键路径
+	void report() const;
+
+private:
+	using Clock = std::chrono::high_resolution_clock;
+
+	enum class StageState { Waiting, Done, Failed, Skipped };
+
+	struct Stage {
+		const char* name;
+		StageThread thread;
+		std::vector<StageId> dependencies;
+		std::vector<StageId> dependents;
+		std::function<bool()> run;
+
+		uint32_t pending{ 0 };  // 还没完成的依赖数
+		bool skip{ false };     // 有依赖失败了
+		StageState state{ StageState::Waiting };
+		bool ranOnMain{ false };
+		float startMs{ 0.0f };
+		float endMs{ 0.0f };
+	};
+
+	void execute(StageId id);
+	void complete(StageId id, StageState state, std::vector<StageId>& readyWorkers);
+
+	std::vector<Stage> _stages;
+	JobSystem* _jobs{ nullptr };
+	Clock::time_point _start;
+	std::thread::id _mainThread;
+
+	std::mutex _mutex;
+	std::condition_variable _changed; // 有主线程阶段就绪 / 有阶段完成
+	std::vector<StageId> _mainReady;
+	uint32_t _remaining{ 0 };
+	bool _failed{ false };
+};
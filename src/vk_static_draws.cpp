@@ -0,0 +1,336 @@
+#include "vk_static_draws.h"
+#include "vk_initializers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+bool StaticDrawCache::init(VkDevice device, uint32_t queueFamily, MemoryManager* memory, BindlessHeap* bindless)
+{
+	_device = device;
+	_memory = memory;
+	_bindless = bindless;
+
+	// 自己的命令池：二级命令缓冲区要单独重置，和主命令缓冲区的生命周期无关
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = queueFamily;
+	if (vkCreateCommandPool(_device, &poolInfo, nullptr, &_pool) != VK_SUCCESS) {
+		vklog::error() << "Failed to create static draw command pool";
+		return false;
+	}
+	VkCommandBufferAllocateInfo allocInfo = vkinit::command_buffer_allocate_info(_pool, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+	if (vkAllocateCommandBuffers(_device, &allocInfo, &_commandBuffer) != VK_SUCCESS) {
+		vklog::error() << "Failed to allocate static draw command buffer";
+		return false;
+	}
+
+	auto create = [this](VkDeviceSize size, VkBufferUsageFlags usage, AllocatedBuffer& out, void** mapped) {
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.pNext = nullptr;
+		bufferInfo.size = size;
+		bufferInfo.usage = usage;
+		if (!_memory->create_buffer(bufferInfo, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Other, out)) {
+			vklog::error() << "Failed to allocate static draw buffer (" << size << " bytes)";
+			return false;
+		}
+		vmaMapMemory(_memory->allocator(), out._allocation, mapped);
+		return true;
+	};
+
+	const VkDeviceSize frameSize = sizeof(GPUStaticFrame) + (VkDeviceSize)MAX_OBJECTS * sizeof(GPUStaticInstance);
+	const VkDeviceSize commandSize = (VkDeviceSize)MAX_OBJECTS * sizeof(VkDrawIndexedIndirectCommand);
+	if (!create(frameSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, _frame, (void**)&_frameData) ||
+		!create(commandSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, _commands, (void**)&_commandData)) {
+		return false;
+	}
+	_frameSlot = _bindless->add_storage_buffer(_frame._buffer);
+	return true;
+}
+
+void StaticDrawCache::cleanup()
+{
+	// bindless 槽位随全局 set 一起释放
+	if (_device == VK_NULL_HANDLE) {
+		return;
+	}
+	if (_frameData) {
+		vmaUnmapMemory(_memory->allocator(), _frame._allocation);
+		_memory->destroy_buffer(_frame);
+	}
+	if (_commandData) {
+		vmaUnmapMemory(_memory->allocator(), _commands._allocation);
+		_memory->destroy_buffer(_commands);
+	}
+	if (_pool != VK_NULL_HANDLE) {
+		vkDestroyCommandPool(_device, _pool, nullptr);
+	}
+	_frameData = nullptr;
+	_commandData = nullptr;
+	_pool = VK_NULL_HANDLE;
+	_commandBuffer = VK_NULL_HANDLE;
+	_objects.clear();
+	_recordedCount = 0;
+	_device = VK_NULL_HANDLE;
+}
+
+void StaticDrawCache::set_pipelines(VkPipelineLayout layout, VkShaderStageFlags pushStages, std::span<const VkPipeline> pipelines,
+	VkFormat colorFormat, VkFormat depthFormat)
+{
+	_layout = layout;
+	_pushStages = pushStages;
+	_pipelines.assign(pipelines.begin(), pipelines.end());
+	_colorFormat = colorFormat;
+	_depthFormat = depthFormat;
+	_dirty = true;
+}
+
+void StaticDrawCache::begin_frame(const glm::mat4& viewProj)
+{
+	_frameNumber++;
+	reinterpret_cast<GPUStaticFrame*>(_frameData)->viewProj[0] = viewProj;
+
+	_seenCount = 0;
+	_liveCount = 0;
+	_stats.instanceWrites = 0;
+	_stats.commandWrites = 0;
+	_stats.rebuilt = false;
+	_stats.recordMs = 0.0f;
+}
+
+void StaticDrawCache::set_view(uint32_t view, const glm::mat4& viewProj)
+{
+	if (view < MAX_VIEWS) {
+		reinterpret_cast<GPUStaticFrame*>(_frameData)->viewProj[view] = viewProj;
+	}
+}
+
+bool StaticDrawCache::add(uint32_t object, uint32_t pipeline, const DrawMesh& mesh, uint32_t material, const glm::mat4& model, const glm::vec4& data)
+{
+	if (mesh.indexCount == 0 || pipeline >= _pipelines.size() || _pipelines[pipeline] == VK_NULL_HANDLE || _liveCount >= MAX_OBJECTS) {
+		return false;
+	}
+	if (object >= _objects.size()) {
+		Object empty = {};
+		empty.slot = INVALID_SLOT;
+		_objects.resize((size_t)object + 1, empty);
+	}
+	Object& entry = _objects[object];
+	// 同一个编号一帧里出现两次：第二次走绘制列表
+	if (entry.lastFrame == _frameNumber) {
+		return false;
+	}
+	entry.lastFrame = _frameNumber;
+	_liveCount++;
+
+	VkDrawIndexedIndirectCommand command = {};
+	command.indexCount = mesh.indexCount;
+	command.instanceCount = 1;
+	command.firstIndex = mesh.firstIndex;
+	command.vertexOffset = (int32_t)mesh.firstVertex;
+	command.firstInstance = entry.slot;
+
+	GPUStaticInstance instance = {};
+	instance.model = model;
+	instance.data = data;
+	instance.material = material;
+
+	if (entry.slot == INVALID_SLOT || entry.pipeline != pipeline || entry.vertexBuffer != mesh.vertexBuffer || entry.indexBuffer != mesh.indexBuffer) {
+		// 新物体或者绑定变了：这一帧重新录制，重新录制时整张表都会重写
+		_dirty = true;
+	}
+	else if (!_dirty) {
+		_seenCount++;
+		if (memcmp(&command, &entry.command, sizeof(command)) != 0) {
+			// 重新出现的物体会改变深度，只换 LOD 的不算
+			if (command.instanceCount != entry.command.instanceCount) {
+				_version++;
+			}
+			write_command(entry.slot, command);
+		}
+		if (memcmp(&instance, &entry.instance, sizeof(instance)) != 0) {
+			write_instance(entry.slot, instance);
+		}
+	}
+
+	entry.pipeline = pipeline;
+	entry.vertexBuffer = mesh.vertexBuffer;
+	entry.indexBuffer = mesh.indexBuffer;
+	entry.command = command;
+	entry.instance = instance;
+	return true;
+}
+
+void StaticDrawCache::end_frame(VkExtent2D extent)
+{
+	if (_dirty || extent.width != _extent.width || extent.height != _extent.height) {
+		// 只是分辨率变了时物体集合不变，阴影缓存不用重画
+		if (_dirty) {
+			_version++;
+		}
+		rebuild(extent);
+	}
+	else if (_seenCount < _recordedCount) {
+		// 有录进去的物体这一帧没出现：只是不画它，不重新录制 (下次重新录制时才从表里去掉)
+		for (Object& entry : _objects) {
+			if (entry.slot != INVALID_SLOT && entry.lastFrame != _frameNumber && entry.command.instanceCount != 0) {
+				entry.command.instanceCount = 0;
+				write_command(entry.slot, entry.command);
+				_version++;
+			}
+		}
+	}
+	_stats.objects = _recordedCount;
+}
+
+void StaticDrawCache::execute(VkCommandBuffer cmd) const
+{
+	if (_recordedCount > 0) {
+		vkCmdExecuteCommands(cmd, 1, &_commandBuffer);
+	}
+}
+
+void StaticDrawCache::draw_view(VkCommandBuffer cmd, VkPipeline pipeline, uint32_t view) const
+{
+	if (_recordedCount == 0 || view >= MAX_VIEWS) {
+		return;
+	}
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	const PushConstants push = { _frameSlot, view };
+	vkCmdPushConstants(cmd, _layout, _pushStages, 0, sizeof(push), &push);
+	for (const Group& group : _groups) {
+		const VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(cmd, 0, 1, &group.vertexBuffer, &offset);
+		vkCmdBindIndexBuffer(cmd, group.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdDrawIndexedIndirect(cmd, _commands._buffer, (VkDeviceSize)group.first * sizeof(VkDrawIndexedIndirectCommand),
+			group.count, sizeof(VkDrawIndexedIndirectCommand));
+	}
+}
+
+void StaticDrawCache::write_command(uint32_t slot, const VkDrawIndexedIndirectCommand& command)
+{
+	_commandData[slot] = command;
+	_stats.commandWrites++;
+}
+
+void StaticDrawCache::write_instance(uint32_t slot, const GPUStaticInstance& instance)
+{
+	reinterpret_cast<GPUStaticInstance*>(_frameData + sizeof(GPUStaticFrame))[slot] = instance;
+	_stats.instanceWrites++;
+	_version++;
+}
+
+void StaticDrawCache::rebuild(VkExtent2D extent)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	// 1. 这一帧出现的物体按 管线 | 顶点缓冲区 | 索引缓冲区 排好，相同的连成一组，组内一次多重间接绘制
+	//    没出现的物体从表里去掉
+	_order.clear();
+	for (uint32_t object = 0; object < _objects.size(); object++) {
+		Object& entry = _objects[object];
+		entry.slot = INVALID_SLOT;
+		if (entry.lastFrame == _frameNumber) {
+			_order.push_back(object);
+		}
+	}
+	std::sort(_order.begin(), _order.end(), [this](uint32_t a, uint32_t b) {
+		const Object& x = _objects[a];
+		const Object& y = _objects[b];
+		if (x.pipeline != y.pipeline) {
+			return x.pipeline < y.pipeline;
+		}
+		if (x.vertexBuffer != y.vertexBuffer) {
+			return x.vertexBuffer < y.vertexBuffer;
+		}
+		if (x.indexBuffer != y.indexBuffer) {
+			return x.indexBuffer < y.indexBuffer;
+		}
+		return a < b;
+	});
+
+	// 2. 间接命令和实例表按新的顺序整张重写 (firstInstance 就是实例下标)
+	for (uint32_t slot = 0; slot < _order.size(); slot++) {
+		Object& entry = _objects[_order[slot]];
+		entry.slot = slot;
+		entry.command.firstInstance = slot;
+		write_command(slot, entry.command);
+		write_instance(slot, entry.instance);
+	}
+	_recordedCount = (uint32_t)_order.size();
+	_extent = extent;
+	_dirty = false;
+
+	_groups.clear();
+	for (uint32_t slot = 0; slot < _recordedCount; slot++) {
+		const Object& entry = _objects[_order[slot]];
+		if (!_groups.empty()) {
+			Group& last = _groups.back();
+			if (last.pipeline == entry.pipeline && last.vertexBuffer == entry.vertexBuffer && last.indexBuffer == entry.indexBuffer) {
+				last.count++;
+				continue;
+			}
+		}
+		_groups.push_back({ entry.pipeline, entry.vertexBuffer, entry.indexBuffer, slot, 1 });
+	}
+
+	// 3. 录制：二级命令缓冲区不继承主命令缓冲区的任何状态，set、视口、push constant 都要自己设置
+	vkResetCommandBuffer(_commandBuffer, 0);
+	_stats.groups = (uint32_t)_groups.size();
+	if (_recordedCount > 0) {
+		VkCommandBufferInheritanceRenderingInfo renderingInfo = {};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+		renderingInfo.colorAttachmentCount = 1;
+		renderingInfo.pColorAttachmentFormats = &_colorFormat;
+		renderingInfo.depthAttachmentFormat = _depthFormat;
+		renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.pNext = &renderingInfo;
+
+		// 会被提交很多次，不能带 ONE_TIME_SUBMIT；同时只有一帧在途，不需要 SIMULTANEOUS_USE
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+		vkBeginCommandBuffer(_commandBuffer, &beginInfo);
+
+		_bindless->bind(_commandBuffer, _layout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+		VkViewport viewport = {};
+		viewport.width = (float)extent.width;
+		viewport.height = (float)extent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(_commandBuffer, 0, 1, &viewport);
+		VkRect2D scissor = {};
+		scissor.extent = extent;
+		vkCmdSetScissor(_commandBuffer, 0, 1, &scissor);
+
+		// 相机是 view 0
+		const PushConstants push = { _frameSlot, 0 };
+		vkCmdPushConstants(_commandBuffer, _layout, _pushStages, 0, sizeof(push), &push);
+
+		for (size_t i = 0; i < _groups.size(); i++) {
+			const Group& group = _groups[i];
+			if (i == 0 || group.pipeline != _groups[i - 1].pipeline) {
+				vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelines[group.pipeline]);
+			}
+			const VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(_commandBuffer, 0, 1, &group.vertexBuffer, &offset);
+			vkCmdBindIndexBuffer(_commandBuffer, group.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			vkCmdDrawIndexedIndirect(_commandBuffer, _commands._buffer, (VkDeviceSize)group.first * sizeof(VkDrawIndexedIndirectCommand),
+				group.count, sizeof(VkDrawIndexedIndirectCommand));
+		}
+
+		vkEndCommandBuffer(_commandBuffer);
+	}
+
+	_stats.rebuilds++;
+	_stats.rebuilt = true;
+	_stats.recordMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_descriptors.h"
+#include "vk_draw_list.h"
+#include "vk_memory.h"
+
+// 静态几何的缓存录制：标记为 DRAW_STATIC 的物体录进一个可以重复执行的二级命令缓冲区
+// 命令缓冲区里只有绑定 + vkCmdDrawIndexedIndirect，每帧变化的东西都放在 buffer 里：
+// - viewProj 在帧头里，每帧写一次
+// - 物体的模型矩阵 / 颜色 / 材质在实例表里，按 firstInstance (gl_InstanceIndex) 取，变了才写
+// - LOD 切换只改间接命令的索引范围；这一帧没出现的物体把 instanceCount 写成 0
+// 只有物体集合、管线 / 顶点 / 索引缓冲区 (碎片整理会换 buffer)、附件格式或渲染分辨率变化时才重新录制
+// 所以每帧的 CPU 录制开销和变化的多少成正比，不和场景大小成正比
+// 同一份间接命令还能从别的视角画 (阴影级联)：帧头里有 MAX_VIEWS 个 viewProj，view 0 是相机
+// version() 在影响深度的内容 (物体集合 / 变换 / 显隐) 变化时增加，阴影缓存据此判断是否要重画；只有 LOD 切换不算
+// 只在渲染线程上使用；调用方已经等过这一帧的 fence (FRAMES_IN_FLIGHT = 1，命令缓冲区和 buffer 不用多份)
+
+// 和 shaders/static_mesh.vert 里的 StaticFrame / StaticInstance 一致 (std430)
+struct GPUStaticFrame {
+	glm::mat4 viewProj[1 + MAX_SHADOW_CASCADES];
+};
+
+struct GPUStaticInstance {
+	glm::mat4 model;
+	glm::vec4 data;
+	uint32_t material;
+	uint32_t pad0[3];
+};
+static_assert(sizeof(GPUStaticInstance) == 96);
+
+struct StaticDrawStats {
+	uint32_t objects{ 0 };        // 录在命令缓冲区里的物体
+	uint32_t groups{ 0 };         // 管线 + 顶点 / 索引缓冲区相同的一组，一次间接绘制
+	uint32_t instanceWrites{ 0 }; // 这一帧改写的实例
+	uint32_t commandWrites{ 0 };  // 这一帧改写的间接命令 (LOD 切换 / 隐藏 / 重新出现)
+	uint32_t rebuilds{ 0 };       // 累计重新录制的次数
+	bool rebuilt{ false };        // 这一帧重新录制了
+	float recordMs{ 0.0f };       // 这一帧花在重新录制上的时间
+};
+
+class StaticDrawCache {
+public:
+	static constexpr uint32_t MAX_OBJECTS = 16384;
+	static constexpr uint32_t MAX_VIEWS = 1 + MAX_SHADOW_CASCADES;
+
+	bool init(VkDevice device, uint32_t queueFamily, MemoryManager* memory, BindlessHeap* bindless);
+	void cleanup();
+
+	// pipelines 和绘制列表的管线表下标一一对应 (顶点着色器换成 static_mesh.vert)
+	// 管线是按附件格式创建的，格式一起给；有任何变化都会在下一帧重新录制
+	void set_pipelines(VkPipelineLayout layout, VkShaderStageFlags pushStages, std::span<const VkPipeline> pipelines,
+		VkFormat colorFormat, VkFormat depthFormat);
+
+	// 每帧：begin_frame -> add... -> end_frame -> (forward pass) execute
+	void begin_frame(const glm::mat4& viewProj);
+	// 额外视角 (1..MAX_VIEWS-1) 的 viewProj，这一帧用 draw_view 画之前设置
+	void set_view(uint32_t view, const glm::mat4& viewProj);
+	// object 是跨帧稳定的物体编号；mesh 是选好的 LOD。没有索引的网格或者表满了返回 false (调用方改走绘制列表)
+	bool add(uint32_t object, uint32_t pipeline, const DrawMesh& mesh, uint32_t material, const glm::mat4& model, const glm::vec4& data);
+	// 隐藏这一帧没出现的物体；需要时重新录制 (viewport / scissor 录在里面，分辨率变了也要重录)
+	void end_frame(VkExtent2D extent);
+
+	// 必须在用 VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT 开始的动态渲染里调用
+	void execute(VkCommandBuffer cmd) const;
+	// 在主命令缓冲区里从 view 视角画全部静态物体 (pipeline 用 static_mesh.vert，layout 和 set_pipelines 的兼容)
+	// 调用方已经开始渲染、绑定了 bindless set、设置了视口
+	// 多视角渲染时一次画完 viewMask 里的每一位 (第 n 位用 view + n)，pipeline 的 viewMask 要和渲染的一致
+	void draw_view(VkCommandBuffer cmd, VkPipeline pipeline, uint32_t view) const;
+
+	bool empty() const { return _recordedCount == 0; }
+	const StaticDrawStats& stats() const { return _stats; }
+	uint64_t version() const { return _version; }
+
+private:
+	struct Object {
+		// 决定录制内容的部分
+		uint32_t pipeline;
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		uint32_t slot;      // 间接命令 / 实例表下标，INVALID_SLOT 表示还没录进去
+		uint64_t lastFrame; // 最后一次出现在哪一帧
+		// 映射内存是写合并的，不从那里读：比较用 CPU 端的副本
+		VkDrawIndexedIndirectCommand command;
+		GPUStaticInstance instance;
+	};
+
+	// 和 static_mesh.vert 里的 push constant 一致 (只有 bindless 下标，录制之后不变)
+	struct PushConstants {
+		uint32_t frameBuffer;
+		uint32_t view;
+	};
+
+	// 管线 + 顶点 / 索引缓冲区相同的一段连续命令
+	struct Group {
+		uint32_t pipeline;
+		VkBuffer vertexBuffer;
+		VkBuffer indexBuffer;
+		uint32_t first;
+		uint32_t count;
+	};
+
+	void write_command(uint32_t slot, const VkDrawIndexedIndirectCommand& command);
+	void write_instance(uint32_t slot, const GPUStaticInstance& instance);
+	void rebuild(VkExtent2D extent);
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	MemoryManager* _memory{ nullptr };
+	BindlessHeap* _bindless{ nullptr };
+
+	VkCommandPool _pool{ VK_NULL_HANDLE };
+	VkCommandBuffer _commandBuffer{ VK_NULL_HANDLE }; // 二级命令缓冲区
+
+	VkPipelineLayout _layout{ VK_NULL_HANDLE };
+	VkShaderStageFlags _pushStages{ 0 };
+	std::vector<VkPipeline> _pipelines;
+	VkFormat _colorFormat{ VK_FORMAT_UNDEFINED };
+	VkFormat _depthFormat{ VK_FORMAT_UNDEFINED };
+
+	// 常驻映射：帧头 + 实例表，间接命令
+	AllocatedBuffer _frame{};
+	uint8_t* _frameData{ nullptr };
+	AllocatedBuffer _commands{};
+	VkDrawIndexedIndirectCommand* _commandData{ nullptr };
+	uint32_t _frameSlot{ INVALID_SLOT };
+
+	std::vector<Object> _objects; // 按物体编号
+	std::vector<uint32_t> _order; // 重新录制时的排序
+	std::vector<Group> _groups;   // 重新录制时分好的组，draw_view 也用
+	uint64_t _frameNumber{ 0 };
+	uint32_t _recordedCount{ 0 }; // 录在命令缓冲区里的物体
+	uint32_t _seenCount{ 0 };     // 这一帧出现过的、已经录进去的物体
+	uint32_t _liveCount{ 0 };     // 这一帧出现过的物体 (包括新的)
+	VkExtent2D _extent{ 0, 0 };
+	bool _dirty{ true };
+	uint64_t _version{ 0 };
+	StaticDrawStats _stats{};
+};
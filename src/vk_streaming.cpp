@@ -0,0 +1,221 @@
+#include "vk_streaming.h"
+#include "vk_types.h"
+
+#include <algorithm>
+
+void AssetStreamer::init(JobSystem* jobs, uint64_t readBudget)
+{
+	_jobs = jobs;
+	_readBudget = std::max<uint64_t>(readBudget, CHUNK_BYTES);
+}
+
+void AssetStreamer::cleanup()
+{
+	while (!_requests.empty()) {
+		cancel(_requests.back().handle);
+	}
+	for (auto& [handle, transfer] : _reading) {
+		uint32_t expected = Transfer::Reading;
+		transfer->state.compare_exchange_strong(expected, Transfer::Cancelled);
+	}
+
+	// 已经发出去的块会访问 Transfer (它们各自持有引用)，回调可能访问调用方，等它们结束
+	if (_jobs) {
+		_jobs->wait_idle();
+	}
+	_reading.clear();
+}
+
+StreamHandle AssetStreamer::request(const std::string& path, float priority, Callback callback)
+{
+	Request request;
+	request.handle = ++_nextHandle;
+	request.path = path;
+	request.priority = priority;
+	request.callback = std::move(callback);
+	_requests.push_back(std::move(request));
+	return _nextHandle;
+}
+
+void AssetStreamer::set_priority(StreamHandle handle, float priority)
+{
+	// 已经全部发出去的请求改优先级没有意义
+	for (Request& request : _requests) {
+		if (request.handle == handle) {
+			request.priority = priority;
+			return;
+		}
+	}
+}
+
+bool AssetStreamer::cancel(StreamHandle handle)
+{
+	auto it = std::find_if(_requests.begin(), _requests.end(), [handle](const Request& request) { return request.handle == handle; });
+	if (it != _requests.end()) {
+		if (it->transfer) {
+			// 发出去一部分了：没发的块算作已经完成，正在读的块读完后由最后一个丢弃结果
+			Transfer& transfer = *it->transfer;
+			transfer.state = Transfer::Cancelled;
+			const uint32_t unissued = (uint32_t)((transfer.size - it->nextOffset + CHUNK_BYTES - 1) / CHUNK_BYTES);
+			if (transfer.remaining.fetch_sub(unissued) == unissued) {
+				transfer.file.close();
+			}
+		}
+		_requests.erase(it);
+		_stats.cancelled++;
+		return true;
+	}
+
+	auto reading = _reading.find(handle);
+	if (reading == _reading.end()) {
+		return false;
+	}
+	// 和工作线程抢：谁先把状态从 Reading 改掉谁说了算
+	uint32_t expected = Transfer::Reading;
+	if (!reading->second->state.compare_exchange_strong(expected, Transfer::Cancelled)) {
+		return false;
+	}
+	_reading.erase(reading);
+	_stats.cancelled++;
+	return true;
+}
+
+void AssetStreamer::update()
+{
+	// 1. 回收读完的请求
+	for (auto it = _reading.begin(); it != _reading.end();) {
+		if (it->second->done) {
+			it = _reading.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	// 2. 已经打开的文件优先读完 (占着文件句柄和内存)，其余按优先级，同优先级先来先读
+	std::stable_sort(_requests.begin(), _requests.end(), [](const Request& a, const Request& b) {
+		if ((a.transfer != nullptr) != (b.transfer != nullptr)) {
+			return a.transfer != nullptr;
+		}
+		return a.priority < b.priority;
+	});
+
+	// 3. 在预算内发起读：大文件切块，小文件的块拼进同一个任务
+	uint64_t budget = _readBudget;
+	uint32_t openFiles = (uint32_t)_reading.size();
+	for (const Request& request : _requests) {
+		openFiles += request.transfer ? 1 : 0;
+	}
+
+	std::vector<Chunk> batch;
+	uint64_t batchBytes = 0;
+	uint64_t issued = 0;
+	for (auto it = _requests.begin(); it != _requests.end() && budget > 0;) {
+		Request& request = *it;
+		if (!request.transfer) {
+			if (openFiles >= MAX_OPEN_FILES) {
+				++it;
+				continue;
+			}
+			auto transfer = std::make_shared<Transfer>();
+			if (!transfer->file.open(request.path.c_str())) {
+				vklog::error() << "Could not open streamed file: " << request.path;
+				fail(std::move(request.callback));
+				it = _requests.erase(it);
+				continue;
+			}
+			const uint64_t size = transfer->file.size();
+			transfer->size = size;
+			// 不清零：每个字节都会被读覆盖
+			transfer->data = std::make_unique_for_overwrite<uint8_t[]>((size_t)std::max<uint64_t>(size, 1));
+			transfer->callback = std::move(request.callback);
+			transfer->remaining = (uint32_t)std::max<uint64_t>((size + CHUNK_BYTES - 1) / CHUNK_BYTES, 1);
+			request.transfer = std::move(transfer);
+			openFiles++;
+		}
+
+		const uint64_t size = request.transfer->size;
+		if (size == 0) {
+			// 空文件也走一遍工作线程，回调的线程保持一致
+			batch.push_back({ request.transfer, 0, 0 });
+		}
+		while (request.nextOffset < size && budget > 0) {
+			const uint64_t chunk = std::min(CHUNK_BYTES, size - request.nextOffset);
+			batch.push_back({ request.transfer, request.nextOffset, chunk });
+			request.nextOffset += chunk;
+			budget -= std::min(budget, chunk);
+			batchBytes += chunk;
+			issued += chunk;
+			if (batchBytes >= CHUNK_BYTES) {
+				submit(std::move(batch));
+				batch.clear();
+				batchBytes = 0;
+			}
+		}
+
+		if (request.nextOffset >= size) {
+			_reading.emplace(request.handle, std::move(request.transfer));
+			it = _requests.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	if (!batch.empty()) {
+		submit(std::move(batch));
+	}
+
+	_stats.queued = (uint32_t)_requests.size();
+	_stats.reading = (uint32_t)_reading.size();
+	_stats.bytesIssued = issued;
+	_stats.bytesRead = _bytesRead.load();
+	_stats.completed = _completed.load();
+	_stats.failed = _failed.load();
+}
+
+void AssetStreamer::submit(std::vector<Chunk>&& batch)
+{
+	_jobs->submit([this, batch = std::move(batch)]() {
+		for (const Chunk& chunk : batch) {
+			Transfer& transfer = *chunk.transfer;
+			// 取消之后剩下的块不用真的读
+			if (chunk.size > 0 && transfer.state.load() == Transfer::Reading && !transfer.failed) {
+				if (transfer.file.read(chunk.offset, (size_t)chunk.size, transfer.data.get() + chunk.offset)) {
+					_bytesRead += chunk.size;
+				}
+				else {
+					transfer.failed = true;
+				}
+			}
+			if (transfer.remaining.fetch_sub(1) == 1) {
+				finish(transfer);
+			}
+		}
+	});
+}
+
+void AssetStreamer::finish(Transfer& transfer)
+{
+	transfer.file.close();
+
+	uint32_t expected = Transfer::Reading;
+	if (transfer.state.compare_exchange_strong(expected, Transfer::Delivering)) {
+		const bool ok = !transfer.failed;
+		if (ok) {
+			_completed++;
+		}
+		else {
+			_failed++;
+		}
+		transfer.callback(ok, ok ? std::span<const uint8_t>(transfer.data.get(), (size_t)transfer.size) : std::span<const uint8_t>());
+	}
+	transfer.data.reset();
+	transfer.callback = nullptr;
+	transfer.done = true;
+}
+
+void AssetStreamer::fail(Callback callback)
+{
+	_failed++;
+	_jobs->submit([callback = std::move(callback)]() { callback(false, {}); });
+}
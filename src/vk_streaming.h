@@ -0,0 +1,102 @@
+#pragma once
+
+#include "vk_file.h"
+#include "vk_jobs.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 流式加载：按优先级排队的异步文件读取
+// 1. request() 只是排队，不碰磁盘；priority 越小越先读 (引擎用到相机的距离，不可见的再加一个很大的偏移)
+// 2. 每帧 update() 按优先级挑请求，把文件切成 CHUNK_BYTES 的块发给工作线程 (pread)，
+//    发起的字节数不超过每帧的读预算；小文件的块拼成一个任务，减少任务数
+// 3. 最后一块读完的工作线程直接调用回调 (可以在里面解码)，结果再由各自的系统交回主线程上传
+// 4. cancel()：还没读完的请求不再调用回调，排队中的直接丢掉，已经发出去的块读完后丢弃
+// request / set_priority / cancel / update 必须在同一个线程上调用 (渲染线程)
+using StreamHandle = uint64_t;
+constexpr StreamHandle INVALID_STREAM = 0;
+
+struct StreamingStats {
+	uint32_t queued{ 0 };        // 还有块没发出去的请求
+	uint32_t reading{ 0 };       // 块都发出去了、还没读完的请求
+	uint64_t bytesIssued{ 0 };   // 上一次 update 发起的读
+	uint64_t bytesRead{ 0 };     // 累计
+	uint32_t completed{ 0 };
+	uint32_t cancelled{ 0 };
+	uint32_t failed{ 0 };
+};
+
+class AssetStreamer {
+public:
+	static constexpr uint64_t CHUNK_BYTES = 1ull << 20;          // 一个读任务最多这么多字节
+	static constexpr uint64_t DEFAULT_READ_BUDGET = 32ull << 20; // 每帧最多发起的读 (60 帧约 2 GB/s)
+	static constexpr uint32_t MAX_OPEN_FILES = 64;               // 同时在读的文件数
+
+	// ok 为 false 时 data 为空；data 只在回调期间有效
+	// 在工作线程上调用 (打开失败时也是)，不能碰 Vulkan 命令
+	using Callback = std::function<void(bool ok, std::span<const uint8_t> data)>;
+
+	void init(JobSystem* jobs, uint64_t readBudget = DEFAULT_READ_BUDGET);
+	void cleanup(); // 取消所有请求，等已经发出去的读结束
+
+	StreamHandle request(const std::string& path, float priority, Callback callback);
+	void set_priority(StreamHandle handle, float priority);
+	// 返回 true 表示回调保证不会被调用；false 表示请求已经结束 (或回调正在执行)
+	bool cancel(StreamHandle handle);
+
+	// 每帧调用一次：回收读完的请求，按优先级发起新的读
+	void update();
+
+	uint32_t pending_count() const { return (uint32_t)(_requests.size() + _reading.size()); }
+	const StreamingStats& stats() const { return _stats; }
+
+private:
+	// 和工作线程共享
+	struct Transfer {
+		enum State : uint32_t { Reading, Delivering, Cancelled };
+
+		StreamFile file;
+		uint64_t size{ 0 };
+		std::unique_ptr<uint8_t[]> data;
+		Callback callback;
+		std::atomic<uint32_t> remaining{ 0 }; // 还没读完 (包括还没发出去) 的块
+		std::atomic<uint32_t> state{ Reading };
+		std::atomic<bool> failed{ false };
+		std::atomic<bool> done{ false };
+	};
+
+	struct Request {
+		StreamHandle handle;
+		std::string path;
+		float priority;
+		Callback callback;
+		std::shared_ptr<Transfer> transfer; // 第一次发起读时才打开文件
+		uint64_t nextOffset{ 0 };
+	};
+
+	struct Chunk {
+		std::shared_ptr<Transfer> transfer;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	void submit(std::vector<Chunk>&& batch);
+	void finish(Transfer& transfer); // 最后一块读完 (工作线程)
+	void fail(Callback callback);    // 打开失败：回调也在工作线程上调用
+
+	JobSystem* _jobs{ nullptr };
+	uint64_t _readBudget{ DEFAULT_READ_BUDGET };
+	StreamHandle _nextHandle{ INVALID_STREAM };
+
+	std::vector<Request> _requests;
+	std::unordered_map<StreamHandle, std::shared_ptr<Transfer>> _reading;
+	StreamingStats _stats{};
+	std::atomic<uint64_t> _bytesRead{ 0 };
+	std::atomic<uint32_t> _completed{ 0 };
+	std::atomic<uint32_t> _failed{ 0 };
+};
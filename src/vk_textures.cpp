@@ -0,0 +1,633 @@
+#include "vk_textures.h"
+#include "vk_asset.h"
+#include "vk_initializers.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+	VkDeviceSize align_up(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	void transition_mips(VkCommandBuffer cmd, VkImage image, uint32_t baseMip, uint32_t mipCount,
+		VkImageLayout oldLayout, VkImageLayout newLayout,
+		VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+		VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage)
+	{
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = baseMip;
+		barrier.subresourceRange.levelCount = mipCount;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+
+		vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+}
+
+bool TextureManager::init(VkDevice device, VkPhysicalDevice gpu, MemoryManager* memory, VkQueue queue, uint32_t queueFamily,
+	BindlessHeap* bindless, JobSystem* jobs, AssetStreamer* streamer, bool supportsBC)
+{
+	_device = device;
+	_gpu = gpu;
+	_memory = memory;
+	_allocator = memory->allocator();
+	_queue = queue;
+	_bindless = bindless;
+	_jobs = jobs;
+	_streamer = streamer;
+	_supportsBC = supportsBC;
+
+	// 上传专用的命令池，每个批次单独分配、完成后释放
+	VkCommandPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = queueFamily;
+
+	if (vkCreateCommandPool(_device, &poolInfo, nullptr, &_pool) != VK_SUCCESS) {
+		vklog::error() << "Failed to create texture upload command pool";
+		return false;
+	}
+
+	// 占位纹理：1x1 白色，同步上传，之后所有还没加载完的纹理都指向它
+	ImageData white;
+	white.format = VK_FORMAT_R8G8B8A8_UNORM;
+	white.width = 1;
+	white.height = 1;
+	white.pixels = { 255, 255, 255, 255 };
+	white.levels.push_back({ 0, 4, 1, 1 });
+
+	uint32_t mipLevels;
+	UploadBatch batch;
+	uint8_t* mapped;
+	if (!create_image(white, _placeholder, mipLevels) || !begin_batch(batch, 16, &mapped)) {
+		return false;
+	}
+	memcpy(mapped, white.pixels.data(), white.pixels.size());
+	record_upload(batch.cmd, _placeholder, mipLevels, white, batch.staging._buffer, 0);
+	if (!end_batch(batch)) {
+		return false;
+	}
+	vkWaitForFences(_device, 1, &batch.fence, true, UINT64_MAX);
+	finish_batch(batch);
+
+	// 超预算时先驱逐纹理 (可以从文件重新加载)
+	_memory->add_evictor([this](VkDeviceSize bytesNeeded) { return evict(bytesNeeded); });
+
+	vklog::info() << "Texture Manager Initialized! (BC textures " << (_supportsBC ? "native" : "decoded on CPU") << ")";
+	return true;
+}
+
+void TextureManager::cleanup()
+{
+	// 工作线程的回调会访问 this，必须先等它们全部结束
+	if (_jobs) {
+		_jobs->wait_idle();
+	}
+
+	for (UploadBatch& batch : _batches) {
+		vkWaitForFences(_device, 1, &batch.fence, true, UINT64_MAX);
+		finish_batch(batch);
+	}
+	_batches.clear();
+
+	for (auto& [index, texture] : _textures) {
+		destroy_image(texture.image);
+	}
+	_textures.clear();
+
+	for (auto& [frame, image] : _retired) {
+		destroy_image(image);
+	}
+	_retired.clear();
+	_decoded.clear();
+	_pendingUploads.clear();
+	_streaming.clear();
+
+	destroy_image(_placeholder);
+	vkDestroyCommandPool(_device, _pool, nullptr);
+	_pool = VK_NULL_HANDLE;
+}
+
+uint32_t TextureManager::load(const std::string& path, bool srgb, float priority)
+{
+	uint32_t index = _bindless->add_texture(_placeholder._imageView);
+	if (index == INVALID_SLOT) {
+		return INVALID_SLOT;
+	}
+
+	Texture& texture = _textures[index];
+	texture = {};
+	texture.path = path;
+	texture.srgb = srgb;
+	texture.priority = priority;
+	texture.lastUsed = _frameNumber;
+	start_load(index);
+	return index;
+}
+
+void TextureManager::start_load(uint32_t index)
+{
+	Texture& texture = _textures[index];
+	const uint64_t ticket = ++_nextTicket;
+	texture.ticket = ticket;
+	texture.state = TextureState::Loading;
+
+	// 读文件交给流式加载排队，解码 (以及必要时的 BC 转码) 在读完的那个工作线程上接着做
+	const std::string path = texture.path;
+	const bool srgb = texture.srgb;
+	const bool decodeBC = !_supportsBC;
+	_loading++;
+	_streaming.push_back(index);
+	texture.stream = _streamer->request(path, texture.priority, [this, index, ticket, path, srgb, decodeBC](bool ok, std::span<const uint8_t> data) {
+		DecodedImage result;
+		result.index = index;
+		result.ticket = ticket;
+		// 烘焙过的纹理 (.vasset) 只是整段拷贝，源格式才需要解码
+		if (ok && vkasset::is_asset(data.data(), data.size())) {
+			vkasset::AssetView asset;
+			result.ok = asset.open(data.data(), data.size(), path.c_str()) && vkasset::load_texture(asset, result.image);
+		}
+		else {
+			result.ok = ok && vkimage::decode(path.c_str(), data.data(), data.size(), srgb, result.image);
+		}
+		if (result.ok && decodeBC && vkimage::is_block_compressed(result.image.format)) {
+			result.ok = vkimage::decompress_bc(result.image);
+		}
+		if (!result.ok) {
+			vklog::error() << "Failed to load texture: " << path;
+		}
+
+		std::lock_guard<std::mutex> lock(_decodedMutex);
+		_decoded.push_back(std::move(result));
+		_loading--;
+	});
+}
+
+void TextureManager::destroy(uint32_t textureIndex)
+{
+	auto it = _textures.find(textureIndex);
+	if (it == _textures.end()) {
+		return;
+	}
+
+	Texture& texture = it->second;
+	if (texture.state == TextureState::Uploading) {
+		// GPU 还在往里拷贝，交给批次在 fence 之后释放
+		for (UploadBatch& batch : _batches) {
+			auto pos = std::find(batch.textures.begin(), batch.textures.end(), textureIndex);
+			if (pos != batch.textures.end()) {
+				batch.textures.erase(pos);
+				batch.orphans.push_back(texture.image);
+				break;
+			}
+		}
+	}
+	else if (texture.state == TextureState::Resident) {
+		// 已提交的帧可能还在采样它；退休期间不能再被整理搬走
+		_memory->clear_movable(texture.image._allocation);
+		_retired.emplace_back(_frameNumber, texture.image);
+	}
+	else if (texture.state == TextureState::Loading && _streamer->cancel(texture.stream)) {
+		_loading--; // 还没读完，回调不会再来
+	}
+	// 其余 Loading 状态的解码结果到达时 ticket 对不上，会被直接丢弃
+
+	_textures.erase(it);
+	_bindless->remove_texture(textureIndex);
+}
+
+void TextureManager::touch(uint32_t textureIndex, float priority)
+{
+	auto it = _textures.find(textureIndex);
+	if (it == _textures.end()) {
+		return;
+	}
+	Texture& texture = it->second;
+	texture.priority = texture.lastUsed == _frameNumber ? std::min(texture.priority, priority) : priority;
+	texture.lastUsed = _frameNumber;
+	if (texture.state == TextureState::Evicted) {
+		start_load(textureIndex);
+	}
+	else if (texture.state == TextureState::Loading) {
+		_streamer->set_priority(texture.stream, texture.priority);
+	}
+}
+
+VkDeviceSize TextureManager::evict(VkDeviceSize bytesNeeded)
+{
+	// 最久没用过的先走；最近 RETIRE_FRAMES 帧里用过的可能还在提交的帧里，不动
+	std::vector<std::pair<uint64_t, uint32_t>> candidates;
+	for (auto& [index, texture] : _textures) {
+		if (texture.state == TextureState::Resident && texture.lastUsed + RETIRE_FRAMES <= _frameNumber) {
+			candidates.emplace_back(texture.lastUsed, index);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	VkDeviceSize freed = 0;
+	for (auto& [lastUsed, index] : candidates) {
+		if (freed >= bytesNeeded) {
+			break;
+		}
+		Texture& texture = _textures[index];
+		_bindless->update_texture(index, _placeholder._imageView);
+		_memory->clear_movable(texture.image._allocation);
+		_retired.emplace_back(_frameNumber, texture.image);
+		texture.image = {};
+		texture.state = TextureState::Evicted;
+		freed += texture.bytes;
+	}
+	return freed;
+}
+
+void TextureManager::relocate(uint32_t index, VkImage newImage)
+{
+	// 碎片整理把图像搬到了新位置：旧的 view 已经没有命令在用 (fence 之后)，换一个新的
+	auto it = _textures.find(index);
+	if (it == _textures.end()) {
+		return;
+	}
+	AllocatedImage& image = it->second.image;
+	vkDestroyImageView(_device, image._imageView, nullptr);
+	image._image = newImage;
+
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.pNext = nullptr;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.image = newImage;
+	viewInfo.format = image._imageFormat;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = it->second.mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	if (vkCreateImageView(_device, &viewInfo, nullptr, &image._imageView) != VK_SUCCESS) {
+		vklog::error() << "Failed to recreate texture image view after defragmentation";
+		image._imageView = _placeholder._imageView;
+	}
+	if (it->second.state == TextureState::Resident) {
+		_bindless->update_texture(index, image._imageView);
+	}
+}
+
+bool TextureManager::is_resident(uint32_t textureIndex) const
+{
+	auto it = _textures.find(textureIndex);
+	return it != _textures.end() && it->second.state == TextureState::Resident;
+}
+
+void TextureManager::update(uint64_t frameNumber, LinearArena& scratch)
+{
+	_frameNumber = frameNumber;
+
+	// 1. 完成的批次：把下标切到真正的纹理
+	for (auto it = _batches.begin(); it != _batches.end();) {
+		if (vkGetFenceStatus(_device, it->fence) == VK_SUCCESS) {
+			finish_batch(*it);
+			it = _batches.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	// 2. 释放退休期满的图像
+	while (!_retired.empty() && _retired.front().first + RETIRE_FRAMES <= frameNumber) {
+		destroy_image(_retired.front().second);
+		_retired.pop_front();
+	}
+
+	// 3. 上一帧没被用到、还在排队的纹理让给可见的 (只降一次，再被 touch 时恢复)
+	for (auto it = _streaming.begin(); it != _streaming.end();) {
+		auto texture = _textures.find(*it);
+		if (texture == _textures.end() || texture->second.state != TextureState::Loading) {
+			it = _streaming.erase(it);
+			continue;
+		}
+		if (texture->second.lastUsed + 1 < frameNumber && texture->second.priority < HIDDEN_PRIORITY) {
+			texture->second.priority += HIDDEN_PRIORITY;
+			_streamer->set_priority(texture->second.stream, texture->second.priority);
+		}
+		++it;
+	}
+
+	// 4. 收取工作线程的解码结果
+	{
+		std::lock_guard<std::mutex> lock(_decodedMutex);
+		for (DecodedImage& decoded : _decoded) {
+			_pendingUploads.push_back(std::move(decoded));
+		}
+		_decoded.clear();
+	}
+	if (_pendingUploads.empty()) {
+		return;
+	}
+
+	// 5. 按预算挑出这一帧要上传的图像 (至少一张，哪怕它比预算还大)
+	// 超出预算的就地压到 _pendingUploads 前面，留到下一帧
+	std::pmr::vector<DecodedImage> uploads(&scratch);
+	size_t deferred = 0;
+	VkDeviceSize stagingSize = 0;
+	for (DecodedImage& decoded : _pendingUploads) {
+		auto it = _textures.find(decoded.index);
+		if (it == _textures.end() || it->second.ticket != decoded.ticket) {
+			continue; // 加载途中被 destroy 了
+		}
+		if (!decoded.ok) {
+			it->second.state = TextureState::Failed;
+			continue;
+		}
+
+		const VkDeviceSize bytes = align_up(decoded.image.pixels.size(), 16);
+		if (!uploads.empty() && stagingSize + bytes > UPLOAD_BUDGET) {
+			if (&_pendingUploads[deferred] != &decoded) {
+				_pendingUploads[deferred] = std::move(decoded);
+			}
+			deferred++;
+			continue;
+		}
+		stagingSize += bytes;
+		uploads.push_back(std::move(decoded));
+	}
+	_pendingUploads.erase(_pendingUploads.begin() + deferred, _pendingUploads.end());
+
+	if (uploads.empty()) {
+		return;
+	}
+
+	// 6. 一个批次：一块 staging buffer + 一个命令缓冲区 + 一个 fence
+	UploadBatch batch;
+	uint8_t* mapped;
+	if (!begin_batch(batch, stagingSize, &mapped)) {
+		for (DecodedImage& upload : uploads) {
+			_textures[upload.index].state = TextureState::Failed;
+		}
+		return;
+	}
+
+	VkDeviceSize offset = 0;
+	for (DecodedImage& upload : uploads) {
+		Texture& texture = _textures[upload.index];
+		if (!create_image(upload.image, texture.image, texture.mipLevels)) {
+			texture.state = TextureState::Failed;
+			continue;
+		}
+		texture.bytes = upload.image.pixels.size();
+
+		memcpy(mapped + offset, upload.image.pixels.data(), upload.image.pixels.size());
+		record_upload(batch.cmd, texture.image, texture.mipLevels, upload.image, batch.staging._buffer, offset);
+		offset += align_up(upload.image.pixels.size(), 16);
+
+		texture.state = TextureState::Uploading;
+		batch.textures.push_back(upload.index);
+	}
+
+	if (end_batch(batch)) {
+		_batches.push_back(std::move(batch));
+	}
+}
+
+bool TextureManager::create_image(const ImageData& data, AllocatedImage& out, uint32_t& mipLevels)
+{
+	// 文件没带 mip 并且格式支持线性 blit 时，才在 GPU 上生成完整的 mip 链
+	const bool generate = data.generateMips && supports_blit(data.format);
+	mipLevels = generate ? vkimage::mip_count(data.width, data.height) : (uint32_t)data.levels.size();
+
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.pNext = nullptr;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = data.format;
+	imageInfo.extent = { data.width, data.height, 1 };
+	imageInfo.mipLevels = mipLevels;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	// TRANSFER_SRC 同时用于生成 mip 和碎片整理时拷贝到新位置
+	imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	out = {};
+	if (!_memory->create_image(imageInfo, MemoryCategory::Textures, out)) {
+		vklog::error() << "Failed to allocate texture image (" << data.width << "x" << data.height << ")";
+		return false;
+	}
+
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.pNext = nullptr;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.image = out._image;
+	viewInfo.format = data.format;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	if (vkCreateImageView(_device, &viewInfo, nullptr, &out._imageView) != VK_SUCCESS) {
+		vklog::error() << "Failed to create texture image view";
+		_memory->destroy_image(out);
+		out = {};
+		return false;
+	}
+	return true;
+}
+
+void TextureManager::record_upload(VkCommandBuffer cmd, const AllocatedImage& image, uint32_t mipLevels, const ImageData& data, VkBuffer staging, VkDeviceSize stagingOffset)
+{
+	const uint32_t copiedLevels = std::min(mipLevels, (uint32_t)data.levels.size());
+
+	// 1. 整张图转成 TRANSFER_DST，然后把文件里带的各层拷进去
+	transition_mips(cmd, image._image, 0, mipLevels,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		0, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	std::vector<VkBufferImageCopy> regions(copiedLevels);
+	for (uint32_t level = 0; level < copiedLevels; level++) {
+		VkBufferImageCopy& region = regions[level];
+		region = {};
+		region.bufferOffset = stagingOffset + data.levels[level].offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { data.levels[level].width, data.levels[level].height, 1 };
+	}
+	vkCmdCopyBufferToImage(cmd, staging, image._image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copiedLevels, regions.data());
+
+	// 2. 没有 mip 要生成：直接全部转成只读
+	if (copiedLevels == mipLevels) {
+		transition_mips(cmd, image._image, 0, mipLevels,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		return;
+	}
+
+	// 3. 逐层 blit 生成剩下的 mip：上一层转成 TRANSFER_SRC，缩小一半写入下一层
+	if (copiedLevels > 1) {
+		transition_mips(cmd, image._image, 0, copiedLevels - 1,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	}
+
+	for (uint32_t level = copiedLevels; level < mipLevels; level++) {
+		const int32_t srcWidth = (int32_t)std::max(1u, data.width >> (level - 1));
+		const int32_t srcHeight = (int32_t)std::max(1u, data.height >> (level - 1));
+		const int32_t dstWidth = (int32_t)std::max(1u, data.width >> level);
+		const int32_t dstHeight = (int32_t)std::max(1u, data.height >> level);
+
+		transition_mips(cmd, image._image, level - 1, 1,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+		VkImageBlit blit = {};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+		blit.srcOffsets[1] = { srcWidth, srcHeight, 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+		blit.dstOffsets[1] = { dstWidth, dstHeight, 1 };
+		vkCmdBlitImage(cmd,
+			image._image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			image._image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit, VK_FILTER_LINEAR);
+
+		transition_mips(cmd, image._image, level - 1, 1,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	}
+
+	// 最后一层只被写过
+	transition_mips(cmd, image._image, mipLevels - 1, 1,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+}
+
+bool TextureManager::begin_batch(UploadBatch& batch, VkDeviceSize stagingSize, uint8_t** mapped)
+{
+	batch = {};
+
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.pNext = nullptr;
+	bufferInfo.size = stagingSize;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	if (!_memory->create_buffer(bufferInfo, VMA_MEMORY_USAGE_CPU_ONLY, MemoryCategory::Staging, batch.staging)) {
+		vklog::error() << "Failed to allocate texture staging buffer (" << stagingSize << " bytes)";
+		return false;
+	}
+	vmaMapMemory(_allocator, batch.staging._allocation, (void**)mapped);
+
+	VkCommandBufferAllocateInfo cmdAllocInfo = vkinit::command_buffer_allocate_info(_pool);
+	VkFenceCreateInfo fenceInfo = vkinit::fence_create_info();
+	if (vkAllocateCommandBuffers(_device, &cmdAllocInfo, &batch.cmd) != VK_SUCCESS ||
+		vkCreateFence(_device, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS) {
+		vklog::error() << "Failed to create texture upload batch";
+		vmaUnmapMemory(_allocator, batch.staging._allocation);
+		_memory->destroy_buffer(batch.staging);
+		return false;
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.pNext = nullptr;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(batch.cmd, &beginInfo);
+	return true;
+}
+
+bool TextureManager::end_batch(UploadBatch& batch)
+{
+	vmaUnmapMemory(_allocator, batch.staging._allocation);
+	vkEndCommandBuffer(batch.cmd);
+
+	VkSubmitInfo submit = {};
+	submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit.pNext = nullptr;
+	submit.commandBufferCount = 1;
+	submit.pCommandBuffers = &batch.cmd;
+
+	if (vkQueueSubmit(_queue, 1, &submit, batch.fence) != VK_SUCCESS) {
+		vklog::error() << "Failed to submit texture upload batch";
+		for (uint32_t index : batch.textures) {
+			Texture& texture = _textures[index];
+			destroy_image(texture.image);
+			texture.state = TextureState::Failed;
+		}
+		batch.textures.clear();
+		vkFreeCommandBuffers(_device, _pool, 1, &batch.cmd);
+		vkDestroyFence(_device, batch.fence, nullptr);
+		_memory->destroy_buffer(batch.staging);
+		return false;
+	}
+	return true;
+}
+
+void TextureManager::finish_batch(UploadBatch& batch)
+{
+	for (uint32_t index : batch.textures) {
+		auto it = _textures.find(index);
+		if (it != _textures.end() && it->second.state == TextureState::Uploading) {
+			_bindless->update_texture(index, it->second.image._imageView);
+			it->second.state = TextureState::Resident;
+			// 常驻之后只会被采样，可以被碎片整理搬走
+			_memory->set_movable(it->second.image._allocation, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				[this, index](VkImage newImage) { relocate(index, newImage); });
+		}
+	}
+	for (AllocatedImage& image : batch.orphans) {
+		destroy_image(image);
+	}
+
+	_memory->destroy_buffer(batch.staging);
+	vkFreeCommandBuffers(_device, _pool, 1, &batch.cmd);
+	vkDestroyFence(_device, batch.fence, nullptr);
+	batch = {};
+}
+
+void TextureManager::destroy_image(AllocatedImage& image)
+{
+	if (image._image == VK_NULL_HANDLE) {
+		return;
+	}
+	vkDestroyImageView(_device, image._imageView, nullptr);
+	_memory->destroy_image(image);
+	image = {};
+}
+
+bool TextureManager::supports_blit(VkFormat format)
+{
+	auto it = _blitSupport.find(format);
+	if (it != _blitSupport.end()) {
+		return it->second;
+	}
+
+	VkFormatProperties props;
+	vkGetPhysicalDeviceFormatProperties(_gpu, format, &props);
+	const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+		VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	const bool supported = (props.optimalTilingFeatures & required) == required;
+	_blitSupport.emplace(format, supported);
+	return supported;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_arena.h"
+#include "vk_descriptors.h"
+#include "vk_image_loader.h"
+#include "vk_jobs.h"
+#include "vk_memory.h"
+#include "vk_streaming.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+// 异步纹理系统
+// 1. load() 立即返回一个 bindless 纹理下标，此时它指向 1x1 的白色占位纹理
+// 2. 文件交给 AssetStreamer 按优先级排队读 (每帧有读预算)，读完的工作线程接着解码 (设备不支持 BC 时顺便转码成 RGBA8)
+//    AssetBaker 烘焙过的 .vasset 不用解码，像素段直接拷贝
+//    优先级由 touch() 给出：这一帧用到它的物体离相机多近；一帧没被用到的排到可见的后面
+// 3. 主线程 update() 把解码好的图像拷进 staging buffer，录制拷贝 + blit 生成 mip，单独提交
+// 4. 上传的 fence 完成后才把下标切到真正的纹理，渲染线程从头到尾都不会等待
+// 5. 显存超预算时，最久没用过的纹理被驱逐 (下标退回占位纹理)，再次 touch 时重新加载
+class TextureManager {
+public:
+	static constexpr uint64_t RETIRE_FRAMES = SlotAllocator::RETIRE_FRAMES;
+	static constexpr VkDeviceSize UPLOAD_BUDGET = 64ull * 1024 * 1024; // 每帧最多提交的 staging 字节数
+	static constexpr float HIDDEN_PRIORITY = 1.0e6f; // 上一帧没被用到的纹理的优先级偏移 (排在所有可见的之后)
+
+	bool init(VkDevice device, VkPhysicalDevice gpu, MemoryManager* memory, VkQueue queue, uint32_t queueFamily,
+		BindlessHeap* bindless, JobSystem* jobs, AssetStreamer* streamer, bool supportsBC);
+	void cleanup();
+
+	// 返回 bindless 下标，可以直接写进 GPUMaterial::textureIndex
+	// priority 越小越先读 (通常是到相机的距离)
+	uint32_t load(const std::string& path, bool srgb = true, float priority = HIDDEN_PRIORITY);
+	// 还在排队的读会被取消
+	void destroy(uint32_t textureIndex);
+
+	// 标记这一帧用到了这张纹理 (决定驱逐顺序)；已经被驱逐的会重新加载
+	// 还没加载完的按这一帧最小的 priority 排队
+	void touch(uint32_t textureIndex, float priority = 0.0f);
+
+	// 每帧调用一次，必须在等待完帧 fence 之后 (此时没有命令缓冲区在使用 bindless set)
+	// scratch：这一帧的临时列表从这里分配
+	void update(uint64_t frameNumber, LinearArena& scratch);
+
+	bool is_resident(uint32_t textureIndex) const;
+	uint32_t pending_count() const { return (uint32_t)(_loading.load() + _pendingUploads.size() + _batches.size()); }
+
+private:
+	enum class TextureState {
+		Loading,   // 工作线程在解码
+		Uploading, // 已提交拷贝，等 fence
+		Resident,
+		Evicted,   // 为了腾显存被释放，指向占位纹理，touch 时重新加载
+		Failed,    // 解码失败，一直使用占位纹理
+	};
+
+	struct Texture {
+		AllocatedImage image{};
+		uint32_t mipLevels{ 0 };
+		uint64_t ticket{ 0 }; // 每次 load 唯一，防止槽位被复用后收到旧的解码结果
+		StreamHandle stream{ INVALID_STREAM };
+		float priority{ HIDDEN_PRIORITY };
+		TextureState state{ TextureState::Loading };
+		std::string path;     // 驱逐之后重新加载用
+		bool srgb{ true };
+		VkDeviceSize bytes{ 0 };
+		uint64_t lastUsed{ 0 };
+	};
+
+	struct DecodedImage {
+		uint32_t index;
+		uint64_t ticket;
+		bool ok;
+		ImageData image;
+	};
+
+	struct UploadBatch {
+		VkCommandBuffer cmd;
+		VkFence fence;
+		AllocatedBuffer staging;
+		std::vector<uint32_t> textures;
+		std::vector<AllocatedImage> orphans; // 上传途中被 destroy 的纹理，等 fence 后再释放
+	};
+
+	void start_load(uint32_t index);
+	VkDeviceSize evict(VkDeviceSize bytesNeeded);
+	void relocate(uint32_t index, VkImage newImage);
+	bool create_image(const ImageData& data, AllocatedImage& out, uint32_t& mipLevels);
+	void record_upload(VkCommandBuffer cmd, const AllocatedImage& image, uint32_t mipLevels, const ImageData& data, VkBuffer staging, VkDeviceSize stagingOffset);
+	bool begin_batch(UploadBatch& batch, VkDeviceSize stagingSize, uint8_t** mapped);
+	bool end_batch(UploadBatch& batch);
+	void finish_batch(UploadBatch& batch);
+	void destroy_image(AllocatedImage& image);
+	bool supports_blit(VkFormat format);
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	VkPhysicalDevice _gpu{ VK_NULL_HANDLE };
+	MemoryManager* _memory{ nullptr };
+	VmaAllocator _allocator{ nullptr };
+	VkQueue _queue{ VK_NULL_HANDLE };
+	VkCommandPool _pool{ VK_NULL_HANDLE };
+	BindlessHeap* _bindless{ nullptr };
+	JobSystem* _jobs{ nullptr };
+	AssetStreamer* _streamer{ nullptr };
+	bool _supportsBC{ false };
+
+	AllocatedImage _placeholder{};
+	std::unordered_map<uint32_t, Texture> _textures;
+	std::unordered_map<VkFormat, bool> _blitSupport;
+	uint64_t _nextTicket{ 0 };
+	uint64_t _frameNumber{ 0 };
+
+	// 工作线程 -> 主线程
+	std::mutex _decodedMutex;
+	std::vector<DecodedImage> _decoded;
+	std::atomic<uint32_t> _loading{ 0 };
+	std::vector<uint32_t> _streaming; // Loading 状态的纹理 (每帧给没用到的降优先级)
+
+	std::vector<DecodedImage> _pendingUploads; // 超出本帧预算，留到下一帧
+	std::vector<UploadBatch> _batches;
+	std::deque<std::pair<uint64_t, AllocatedImage>> _retired;
+};
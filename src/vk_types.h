@@ -8,7 +8,6 @@
 #include <array>
 #include <functional>
 #include <deque>
-#include <iostream>
 
 // Vulkan
 #include <vulkan/vulkan.h>
@@ -23,12 +22,44 @@
 // VMA
 #include <vk_mem_alloc.h>
 
+// 日志 (vklog::info() / vklog::error() ...)
+#include "vk_log.h"
+
 
 struct MeshPushConstants {// 推送常量结构体
 	glm::vec4 data; // 预留一些额外数据 (比如颜色倍增等)
 	glm::mat4 render_matrix; // 对应 shader 里的 renderMatrix
+	uint32_t material_index; // 材质表下标 (bindless)
+};
+
+// 材质表里的一项，和 shaders/bindless.glsl 里的 Material 一致 (std430)
+struct GPUMaterial {
+	glm::vec4 baseColor;   // 颜色倍增
+	uint32_t textureIndex; // 全局 textures[] 下标，INVALID_SLOT 表示没有贴图
+	uint32_t samplerIndex; // 全局 samplers[] 下标
+	uint32_t virtualTexture; // 虚拟纹理页表的 buffers[] 下标，INVALID_SLOT 表示不用
+	uint32_t pad0;
 };
 
+// 每帧的场景数据 (全局 set 的 SCENE_BINDING)，和 shaders/bindless.glsl 里的 SceneData 一致 (std430)
+// 片段着色器用 gl_FragCoord + 深度和 invViewProj 还原世界坐标，所有绘制路径的顶点着色器都不用改
+constexpr uint32_t MAX_SHADOW_CASCADES = 4;
+struct GPUSceneData {
+	glm::mat4 invViewProj;
+	glm::vec4 lightDirection; // xyz 是光传播的方向，w 是阴影里剩下的亮度
+	glm::vec2 renderExtent;   // 这一帧实际渲染的大小 (gl_FragCoord -> NDC)
+	uint32_t cascadeCount;    // 0 表示没有阴影
+	uint32_t shadowSampler;   // 比较采样器的 samplers[] 下标
+	glm::mat4 cascadeViewProj[MAX_SHADOW_CASCADES]; // 每层阴影图渲染时用的矩阵
+	uint32_t shadowTextures[MAX_SHADOW_CASCADES];   // 每层阴影图的 textures[] 下标
+	glm::vec4 shadowParams;   // x: 一个纹素在阴影图 UV 里的大小
+	glm::uvec4 clusterGrid;   // xyz: froxel 格子数，w: 光源数 (0 表示没有点光源)
+	glm::vec4 clusterDepth;   // x: near，y: far，z / w: 深度切分 slice = log(depth) * z + w
+	glm::vec4 clusterProjection; // xy: 半视角的正切 (gl_FragCoord + 深度 -> 相机空间)
+	glm::uvec4 clusterBuffers;   // buffers[] 下标：x 光源表，y 格子表，z 下标表，w 下标计数
+};
+static_assert(sizeof(GPUSceneData) == 448, "GPUSceneData must match the std430 SceneData block");
+
 // [新增] 简单的分配缓冲区结构体
 // 每次我们用 VMA 分配内存，都会得到一个 VkBuffer (Vulkan句柄) 和 VmaAllocation (VMA句柄)
 struct AllocatedBuffer {
@@ -62,9 +93,9 @@ struct Vertex {
     }
 
     // [新增] 2. 描述“每个属性在结构体里的哪里” (Attribute)
-    static std::vector<VkVertexInputAttributeDescription> get_attribute_descriptions() {
-        std::vector<VkVertexInputAttributeDescription> attributes;
-        attributes.resize(3); // 我们目前Shader里用了 Location 0, 1, 2
+    // 固定大小的数组，不在堆上分配
+    static std::array<VkVertexInputAttributeDescription, 5> get_attribute_descriptions() {
+        std::array<VkVertexInputAttributeDescription, 5> attributes = {}; // Shader里用了 Location 0 ~ 4
 
         // Location 0: Position
         attributes[0].binding = 0;
@@ -84,6 +115,17 @@ struct Vertex {
         attributes[2].format = VK_FORMAT_R32G32B32_SFLOAT; // vec3
         attributes[2].offset = offsetof(Vertex, color);
 
+        // Location 3/4: UV (uv_x / uv_y 分别塞在 position 和 normal 后面的空位里)
+        attributes[3].binding = 0;
+        attributes[3].location = 3;
+        attributes[3].format = VK_FORMAT_R32_SFLOAT;
+        attributes[3].offset = offsetof(Vertex, uv_x);
+
+        attributes[4].binding = 0;
+        attributes[4].location = 4;
+        attributes[4].format = VK_FORMAT_R32_SFLOAT;
+        attributes[4].offset = offsetof(Vertex, uv_y);
+
         return attributes;
     }
 };
\ No newline at end of file
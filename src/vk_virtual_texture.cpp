@@ -0,0 +1,411 @@
+#include "vk_virtual_texture.h"
+
+#include <algorithm>
+#include <cstring>
+
+// ============================================================
+// VirtualTexture
+// ============================================================
+
+bool VirtualTexture::init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless, JobSystem* jobs,
+	const char* path, uint32_t tilesPerRow, VkExtent2D maxFeedbackExtent)
+{
+	_device = device;
+	_memory = memory;
+	_allocator = memory->allocator();
+	_bindless = bindless;
+	_jobs = jobs;
+
+	// 1. 映射并校验 .vtex
+	if (!_file.open(path)) {
+		vklog::error() << "Could not map virtual texture: " << path;
+		return false;
+	}
+	if (_file.size() < sizeof(vkvt::VtexHeader)) {
+		vklog::error() << "Invalid virtual texture: " << path;
+		_file.close();
+		return false;
+	}
+	memcpy(&_header, _file.data(), sizeof(_header));
+
+	uint32_t mipOffsets[vkvt::MAX_MIPS];
+	const uint32_t sizeInPages = _header.pageSize ? _header.size / _header.pageSize : 0;
+	const bool validShape = sizeInPages > 0 && (sizeInPages & (sizeInPages - 1)) == 0 &&
+		_header.mipCount > 0 && _header.mipCount <= vkvt::MAX_MIPS && (sizeInPages >> (_header.mipCount - 1)) == 1 &&
+		sizeInPages <= 4096;
+	_tileSize = _header.pageSize + 2 * _header.border;
+
+	if (_header.magic != vkvt::VTEX_MAGIC || _header.version != vkvt::VTEX_VERSION || !validShape ||
+		(_header.format != VK_FORMAT_R8G8B8A8_UNORM && _header.format != VK_FORMAT_R8G8B8A8_SRGB) ||
+		_header.tileBytes != _tileSize * _tileSize * 4 ||
+		_header.pageCount != vkvt::mip_offsets(sizeInPages, _header.mipCount, mipOffsets) ||
+		_header.pagesOffset + (uint64_t)_header.pageCount * _header.tileBytes > _file.size()) {
+		vklog::error() << "Invalid or outdated virtual texture: " << path;
+		_file.close();
+		return false;
+	}
+
+	if (tilesPerRow == 0 || tilesPerRow > 256) {
+		vklog::error() << "Virtual texture cache must be 1..256 tiles per row";
+		_file.close();
+		return false;
+	}
+	_tilesPerRow = tilesPerRow;
+	_cache.init(sizeInPages, _header.mipCount, tilesPerRow);
+
+	// 2. 物理页缓存：固定大小，和源数据多大无关
+	const uint32_t physicalSize = tilesPerRow * _tileSize;
+
+	VkImageCreateInfo imageInfo = {};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.pNext = nullptr;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = (VkFormat)_header.format;
+	imageInfo.extent = { physicalSize, physicalSize, 1 };
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	if (!_memory->create_image(imageInfo, MemoryCategory::Textures, _physical)) {
+		vklog::error() << "Failed to allocate virtual texture page cache";
+		return false;
+	}
+
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.pNext = nullptr;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.image = _physical._image;
+	viewInfo.format = imageInfo.format;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	if (vkCreateImageView(_device, &viewInfo, nullptr, &_physical._imageView) != VK_SUCCESS) {
+		vklog::error() << "Failed to create virtual texture page cache view";
+		return false;
+	}
+
+	// 页之间有 border，双线性 + clamp 就够了，物理缓存本身没有 mip
+	VkSamplerCreateInfo samplerInfo = {};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.pNext = nullptr;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+	if (vkCreateSampler(_device, &samplerInfo, nullptr, &_sampler) != VK_SUCCESS) {
+		vklog::error() << "Failed to create virtual texture sampler";
+		return false;
+	}
+	_physicalIndex = _bindless->add_texture(_physical._imageView);
+	_samplerIndex = _bindless->add_sampler(_sampler);
+
+	// 3. 页表：头部参数 + 每个虚拟页一个条目
+	const VkDeviceSize tableSize = (HEADER_UINTS + (VkDeviceSize)_header.pageCount) * sizeof(uint32_t);
+	if (!create_buffer(tableSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::Other, _table, (void**)&_tableData)) {
+		return false;
+	}
+	_tableIndex = _bindless->add_storage_buffer(_table._buffer);
+
+	// 4. 反馈缓冲区 (GPU 写) + 回读缓冲区 (CPU 读) + staging
+	_feedbackCapacity = ((maxFeedbackExtent.width + FEEDBACK_DIVISOR - 1) / FEEDBACK_DIVISOR) *
+		((maxFeedbackExtent.height + FEEDBACK_DIVISOR - 1) / FEEDBACK_DIVISOR);
+	const VkDeviceSize feedbackSize = (VkDeviceSize)_feedbackCapacity * sizeof(uint32_t);
+	if (!create_buffer(feedbackSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::Other, _feedback, nullptr)) {
+		return false;
+	}
+	_feedbackIndex = _bindless->add_storage_buffer(_feedback._buffer);
+
+	for (uint32_t i = 0; i < READBACK_FRAMES; i++) {
+		if (!create_buffer(feedbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU, MemoryCategory::Staging, _readback[i], (void**)&_readbackData[i]) ||
+			!create_buffer((VkDeviceSize)UPLOAD_BUDGET * _header.tileBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, MemoryCategory::Staging, _staging[i], (void**)&_stagingData[i])) {
+			return false;
+		}
+	}
+
+	write_header();
+	set_feedback_extent(maxFeedbackExtent);
+	_cache.clear_dirty();
+	memset(_tableData + HEADER_UINTS, 0xFF, (size_t)_header.pageCount * sizeof(uint32_t));
+
+	// 5. 最粗的一页常驻，保证任何位置都有东西可采
+	request_page(vkvt::page_id(_header.mipCount - 1, 0, 0), true);
+
+	vklog::info() << "Virtual texture: " << path << " (" << _header.size << "x" << _header.size << ", "
+		<< _header.pageCount << " pages, cache " << physicalSize << "x" << physicalSize << ")";
+	return true;
+}
+
+void VirtualTexture::cleanup()
+{
+	if (_jobs) {
+		_jobs->wait_idle();
+	}
+	_loaded.clear();
+	_inFlight.clear();
+	_pinned.clear();
+
+	if (_tableIndex != INVALID_SLOT) {
+		_bindless->remove_storage_buffer(_tableIndex);
+	}
+	if (_feedbackIndex != INVALID_SLOT) {
+		_bindless->remove_storage_buffer(_feedbackIndex);
+	}
+	if (_physicalIndex != INVALID_SLOT) {
+		_bindless->remove_texture(_physicalIndex);
+	}
+	if (_samplerIndex != INVALID_SLOT) {
+		_bindless->remove_sampler(_samplerIndex);
+	}
+	_tableIndex = _feedbackIndex = _physicalIndex = _samplerIndex = INVALID_SLOT;
+
+	auto destroy_buffer = [this](AllocatedBuffer& buffer, bool mapped) {
+		if (buffer._buffer == VK_NULL_HANDLE) {
+			return;
+		}
+		if (mapped) {
+			vmaUnmapMemory(_allocator, buffer._allocation);
+		}
+		_memory->destroy_buffer(buffer);
+	};
+	destroy_buffer(_table, true);
+	destroy_buffer(_feedback, false);
+	for (uint32_t i = 0; i < READBACK_FRAMES; i++) {
+		destroy_buffer(_readback[i], true);
+		destroy_buffer(_staging[i], true);
+	}
+
+	if (_sampler != VK_NULL_HANDLE) {
+		vkDestroySampler(_device, _sampler, nullptr);
+		_sampler = VK_NULL_HANDLE;
+	}
+	if (_physical._image != VK_NULL_HANDLE) {
+		vkDestroyImageView(_device, _physical._imageView, nullptr);
+		_memory->destroy_image(_physical);
+		_physical = {};
+	}
+	_file.close();
+}
+
+void VirtualTexture::set_feedback_extent(VkExtent2D extent)
+{
+	const uint32_t width = (extent.width + FEEDBACK_DIVISOR - 1) / FEEDBACK_DIVISOR;
+	const uint32_t height = (extent.height + FEEDBACK_DIVISOR - 1) / FEEDBACK_DIVISOR;
+	_feedbackCount = std::min(width * height, _feedbackCapacity);
+	_tableData[10] = width;
+	_tableData[11] = _feedbackCount;
+}
+
+void VirtualTexture::write_header()
+{
+	// 布局必须和 shaders/virtual_texture.glsl 一致
+	uint32_t* h = _tableData;
+	memset(h, 0, HEADER_UINTS * sizeof(uint32_t));
+	h[0] = _header.size / _header.pageSize;
+	h[1] = _header.mipCount;
+	h[2] = _header.pageSize;
+	h[3] = _header.border;
+	h[4] = _tilesPerRow;
+	h[5] = _tileSize;
+	h[6] = _tilesPerRow * _tileSize;
+	h[7] = _physicalIndex;
+	h[8] = _samplerIndex;
+	h[9] = _feedbackIndex;
+	// h[10] / h[11]: 反馈缓冲区行宽 / 条目数，h[12]: 抖动帧号
+	memcpy(h + 16, _cache.mip_offsets(), _header.mipCount * sizeof(uint32_t));
+}
+
+void VirtualTexture::flush_table()
+{
+	if (_cache.dirty_begin() >= _cache.dirty_end()) {
+		return;
+	}
+	// 页表在主机可见内存里，调用时上一帧已经结束，可以直接写
+	const uint32_t begin = _cache.dirty_begin();
+	const uint32_t count = _cache.dirty_end() - begin;
+	memcpy(_tableData + HEADER_UINTS + begin, _cache.entries().data() + begin, count * sizeof(uint32_t));
+	_cache.clear_dirty();
+}
+
+void VirtualTexture::request_page(uint32_t page, bool pinned)
+{
+	_inFlight.insert(page);
+	if (pinned) {
+		_pinned.insert(page);
+	}
+
+	const uint32_t sizeInPages = _header.size / _header.pageSize;
+	const uint32_t mip = vkvt::page_mip(page);
+	const uint32_t tile = _cache.mip_offsets()[mip] + vkvt::page_y(page) * vkvt::pages_per_side(sizeInPages, mip) + vkvt::page_x(page);
+	const uint8_t* src = _file.data() + _header.pagesOffset + (uint64_t)tile * _header.tileBytes;
+	const uint32_t bytes = _header.tileBytes;
+
+	// 读 mmap 的内存可能触发缺页 IO，放到工作线程上
+	_jobs->submit([this, page, src, bytes]() {
+		LoadedPage loaded;
+		loaded.page = page;
+		loaded.texels.assign(src, src + bytes);
+
+		std::lock_guard<std::mutex> lock(_loadedMutex);
+		_loaded.push_back(std::move(loaded));
+	});
+}
+
+void VirtualTexture::begin_frame(VkCommandBuffer cmd, uint64_t frameNumber, LinearArena& scratch)
+{
+	_frameNumber = frameNumber;
+	_tableData[12] = (uint32_t)frameNumber;
+
+	// 1. 解析上一帧的反馈 (它的 fence 已经等过了)
+	std::pmr::vector<uint32_t> requests(&scratch);
+	if (frameNumber > 0) {
+		const uint32_t previous = (uint32_t)((frameNumber - 1) % READBACK_FRAMES);
+		if (_readbackCount[previous] > 0) {
+			vmaInvalidateAllocation(_allocator, _readback[previous]._allocation, 0, VK_WHOLE_SIZE);
+			_cache.process_feedback(_readbackData[previous], _readbackCount[previous], frameNumber, requests);
+			_readbackCount[previous] = 0;
+		}
+	}
+
+	// 2. 发起新的读取
+	for (uint32_t page : requests) {
+		if (_inFlight.size() >= MAX_LOADS_IN_FLIGHT) {
+			break;
+		}
+		if (_inFlight.count(page) == 0) {
+			request_page(page, false);
+		}
+	}
+
+	// 3. 上传读好的页 (每帧不超过预算，剩下的留到下一帧)
+	std::pmr::vector<LoadedPage> uploads(&scratch);
+	{
+		std::lock_guard<std::mutex> lock(_loadedMutex);
+		const size_t count = std::min<size_t>(_loaded.size(), UPLOAD_BUDGET);
+		uploads.assign(std::make_move_iterator(_loaded.begin()), std::make_move_iterator(_loaded.begin() + count));
+		_loaded.erase(_loaded.begin(), _loaded.begin() + count);
+	}
+
+	const uint32_t ring = (uint32_t)(frameNumber % READBACK_FRAMES);
+	std::pmr::vector<VkBufferImageCopy> regions(&scratch);
+	for (LoadedPage& loaded : uploads) {
+		_inFlight.erase(loaded.page);
+		const bool pinned = _pinned.erase(loaded.page) != 0;
+		if (_cache.is_resident(loaded.page)) {
+			continue;
+		}
+
+		uint32_t slot;
+		uint32_t evicted;
+		if (!_cache.allocate_slot(frameNumber, slot, evicted)) {
+			continue; // 缓存装不下，等反馈下次再请求
+		}
+
+		const VkDeviceSize offset = (VkDeviceSize)regions.size() * _header.tileBytes;
+		memcpy(_stagingData[ring] + offset, loaded.texels.data(), _header.tileBytes);
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { (int32_t)(_cache.slot_x(slot) * _tileSize), (int32_t)(_cache.slot_y(slot) * _tileSize), 0 };
+		region.imageExtent = { _tileSize, _tileSize, 1 };
+		regions.push_back(region);
+
+		_cache.make_resident(loaded.page, slot, frameNumber, pinned);
+	}
+
+	if (!regions.empty()) {
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = _physicalInitialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = _physical._image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		vkCmdCopyBufferToImage(cmd, _staging[ring]._buffer, _physical._image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)regions.size(), regions.data());
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		_physicalInitialized = true;
+	}
+	flush_table();
+
+	// 4. 清空反馈缓冲区，渲染时片段着色器往里写
+	vkCmdFillBuffer(cmd, _feedback._buffer, 0, VK_WHOLE_SIZE, vkvt::INVALID_PAGE);
+
+	VkBufferMemoryBarrier clearBarrier = {};
+	clearBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	clearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	clearBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	clearBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	clearBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	clearBarrier.buffer = _feedback._buffer;
+	clearBarrier.offset = 0;
+	clearBarrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 1, &clearBarrier, 0, nullptr);
+}
+
+void VirtualTexture::end_frame(VkCommandBuffer cmd, uint64_t frameNumber)
+{
+	const uint32_t ring = (uint32_t)(frameNumber % READBACK_FRAMES);
+
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = _feedback._buffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	VkBufferCopy copy = {};
+	copy.size = (VkDeviceSize)_feedbackCount * sizeof(uint32_t);
+	vkCmdCopyBuffer(cmd, _feedback._buffer, _readback[ring]._buffer, 1, &copy);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.buffer = _readback[ring]._buffer;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	_readbackCount[ring] = _feedbackCount;
+}
+
+bool VirtualTexture::create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, MemoryCategory category,
+	AllocatedBuffer& out, void** mapped)
+{
+	VkBufferCreateInfo bufferInfo = {};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.pNext = nullptr;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+
+	if (!_memory->create_buffer(bufferInfo, memoryUsage, category, out)) {
+		vklog::error() << "Failed to allocate virtual texture buffer (" << size << " bytes)";
+		return false;
+	}
+	if (mapped) {
+		vmaMapMemory(_allocator, out._allocation, mapped);
+	}
+	return true;
+}
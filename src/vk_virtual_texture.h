@@ -0,0 +1,100 @@
+#pragma once
+
+#include "vk_types.h"
+#include "vk_arena.h"
+#include "vk_descriptors.h"
+#include "vk_file.h"
+#include "vk_jobs.h"
+#include "vk_memory.h"
+#include "vk_page_cache.h"
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+// GPU 虚拟纹理
+// - 物理页缓存：一张固定大小的纹理，显存占用和源数据大小无关
+// - 页表：bindless storage buffer，头部是参数，后面是每个虚拟页的映射
+// - 反馈：片段着色器按 1/8 分辨率 (逐帧抖动) 把需要的页 ID 写进反馈缓冲区
+//   帧末拷贝到回读缓冲区，下一帧 fence 之后在 CPU 上解析，全程不额外等待 GPU
+// - 工作线程从 mmap 的 .vtex 里读页，主线程每帧最多上传 UPLOAD_BUDGET 页
+class VirtualTexture {
+public:
+	static constexpr uint32_t HEADER_UINTS = 32;        // 和 shaders/virtual_texture.glsl 保持一致
+	static constexpr uint32_t FEEDBACK_DIVISOR = 8;
+	static constexpr uint32_t READBACK_FRAMES = 2;
+	static constexpr uint32_t UPLOAD_BUDGET = 16;        // 每帧最多上传的页数
+	static constexpr uint32_t MAX_LOADS_IN_FLIGHT = 64;  // 同时在工作线程上读的页数
+
+	bool init(VkDevice device, MemoryManager* memory, BindlessHeap* bindless, JobSystem* jobs,
+		const char* path, uint32_t tilesPerRow, VkExtent2D maxFeedbackExtent);
+	void cleanup();
+
+	// 页表所在的 buffers[] 下标，写进 GPUMaterial::virtualTexture
+	uint32_t table_index() const { return _tableIndex; }
+
+	// 渲染分辨率变化时调用，决定反馈缓冲区的行宽
+	void set_feedback_extent(VkExtent2D extent);
+
+	// 在帧命令缓冲区开头 (渲染之前) 调用：解析上一帧反馈、发起读取、上传页、清空反馈缓冲区
+	// 这一帧的临时列表都从 scratch 上分配
+	void begin_frame(VkCommandBuffer cmd, uint64_t frameNumber, LinearArena& scratch);
+	// 渲染之后调用：把反馈拷贝到这一帧的回读缓冲区
+	void end_frame(VkCommandBuffer cmd, uint64_t frameNumber);
+
+	const VirtualPageCache& cache() const { return _cache; }
+	// 正在读或者等着上传的页
+	uint32_t pending_count() const { return (uint32_t)_inFlight.size(); }
+
+private:
+	struct LoadedPage {
+		uint32_t page;
+		std::vector<uint8_t> texels;
+	};
+
+	bool create_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, MemoryCategory category,
+		AllocatedBuffer& out, void** mapped);
+	void request_page(uint32_t page, bool pinned);
+	void write_header();
+	void flush_table();
+
+	VkDevice _device{ VK_NULL_HANDLE };
+	MemoryManager* _memory{ nullptr };
+	VmaAllocator _allocator{ nullptr }; // 映射 / invalidate 用
+	BindlessHeap* _bindless{ nullptr };
+	JobSystem* _jobs{ nullptr };
+
+	MappedFile _file;
+	vkvt::VtexHeader _header{};
+	VirtualPageCache _cache;
+	uint32_t _tilesPerRow{ 0 };
+	uint32_t _tileSize{ 0 };     // pageSize + 2 * border
+
+	AllocatedImage _physical{};
+	bool _physicalInitialized{ false };
+	VkSampler _sampler{ VK_NULL_HANDLE };
+	uint32_t _physicalIndex{ INVALID_SLOT };
+	uint32_t _samplerIndex{ INVALID_SLOT };
+
+	AllocatedBuffer _table{};
+	uint32_t* _tableData{ nullptr }; // 常驻映射
+	uint32_t _tableIndex{ INVALID_SLOT };
+
+	AllocatedBuffer _feedback{};
+	uint32_t _feedbackIndex{ INVALID_SLOT };
+	uint32_t _feedbackCapacity{ 0 };
+	uint32_t _feedbackCount{ 0 }; // 当前分辨率下用到的条目数
+	AllocatedBuffer _readback[READBACK_FRAMES]{};
+	uint32_t* _readbackData[READBACK_FRAMES]{};
+	uint32_t _readbackCount[READBACK_FRAMES]{};
+
+	AllocatedBuffer _staging[READBACK_FRAMES]{};
+	uint8_t* _stagingData[READBACK_FRAMES]{};
+
+	// 工作线程 -> 主线程
+	std::mutex _loadedMutex;
+	std::vector<LoadedPage> _loaded;
+	std::unordered_set<uint32_t> _inFlight;
+	std::unordered_set<uint32_t> _pinned;
+	uint64_t _frameNumber{ 0 };
+};
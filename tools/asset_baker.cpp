@@ -0,0 +1,401 @@
+// AssetBaker: 把源资源烘焙成运行时直接内存映射的 .vasset
+// 用法: AssetBaker [--force] [--linear] <输出.vasset> <输入.obj|.tga|.ktx2>
+//   网格 (.obj)：三角化 + 焊接 + LOD 链，顶点就是引擎的 Vertex 布局
+//   纹理 (.tga/.ktx2)：解码 (RGBA8 在这里生成完整的 mip 链)，运行时整段拷进 staging
+// 增量：输出文件里记着源文件内容 + 烘焙参数的哈希，没变就跳过 (只更新时间戳，构建系统不会再触发)
+#include "vk_asset.h"
+#include "vk_spirv.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <glm/geometric.hpp>
+
+namespace {
+
+	// 烘焙逻辑改变时加一，所有输出都会重新生成
+	constexpr uint64_t BAKER_REVISION = 1;
+
+	uint64_t align_up(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	struct Section {
+		vkasset::SectionType type;
+		std::vector<uint8_t> data;
+	};
+
+	template<typename T>
+	Section make_section(vkasset::SectionType type, const T* data, size_t count)
+	{
+		Section section{ type, {} };
+		section.data.resize(count * sizeof(T));
+		if (count > 0) {
+			memcpy(section.data.data(), data, section.data.size());
+		}
+		return section;
+	}
+
+	// ---------------- OBJ ----------------
+
+	bool parse_floats(std::string_view line, float* out, int count)
+	{
+		for (int i = 0; i < count; i++) {
+			while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) {
+				line.remove_prefix(1);
+			}
+			const auto [end, ec] = std::from_chars(line.data(), line.data() + line.size(), out[i]);
+			if (ec != std::errc()) {
+				return false;
+			}
+			line.remove_prefix(end - line.data());
+		}
+		return true;
+	}
+
+	// OBJ 的下标从 1 开始，负数表示从末尾数；0 表示没有
+	int32_t resolve_index(int32_t index, size_t count)
+	{
+		return index > 0 ? index - 1 : index < 0 ? (int32_t)count + index : -1;
+	}
+
+	bool load_obj(const uint8_t* data, size_t size, std::vector<Vertex>& out)
+	{
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> uvs;
+
+		struct Corner {
+			int32_t position;
+			int32_t uv;
+			int32_t normal;
+		};
+		std::vector<Corner> face;
+
+		std::string_view text(reinterpret_cast<const char*>(data), size);
+		while (!text.empty()) {
+			const size_t end = text.find('\n');
+			std::string_view line = text.substr(0, end);
+			text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+			if (!line.empty() && line.back() == '\r') {
+				line.remove_suffix(1);
+			}
+
+			if (line.starts_with("v ")) {
+				glm::vec3 p;
+				if (!parse_floats(line.substr(2), &p.x, 3)) {
+					return false;
+				}
+				positions.push_back(p);
+			}
+			else if (line.starts_with("vn ")) {
+				glm::vec3 n;
+				if (!parse_floats(line.substr(3), &n.x, 3)) {
+					return false;
+				}
+				normals.push_back(n);
+			}
+			else if (line.starts_with("vt ")) {
+				glm::vec2 uv;
+				if (!parse_floats(line.substr(3), &uv.x, 2)) {
+					return false;
+				}
+				uvs.push_back(uv);
+			}
+			else if (line.starts_with("f ")) {
+				// v、v/vt、v//vn、v/vt/vn，多边形按扇形三角化
+				face.clear();
+				std::string_view rest = line.substr(2);
+				while (!rest.empty()) {
+					while (!rest.empty() && (rest.front() == ' ' || rest.front() == '\t')) {
+						rest.remove_prefix(1);
+					}
+					if (rest.empty()) {
+						break;
+					}
+					int32_t values[3] = { 0, 0, 0 };
+					for (int slot = 0; slot < 3 && !rest.empty() && rest.front() != ' ' && rest.front() != '\t'; slot++) {
+						if (rest.front() != '/') {
+							const auto [end, ec] = std::from_chars(rest.data(), rest.data() + rest.size(), values[slot]);
+							if (ec != std::errc()) {
+								return false;
+							}
+							rest.remove_prefix(end - rest.data());
+						}
+						if (!rest.empty() && rest.front() == '/') {
+							rest.remove_prefix(1);
+						}
+					}
+					Corner corner = { resolve_index(values[0], positions.size()), resolve_index(values[1], uvs.size()), resolve_index(values[2], normals.size()) };
+					if (corner.position < 0 || corner.position >= (int32_t)positions.size() ||
+						corner.uv >= (int32_t)uvs.size() || corner.normal >= (int32_t)normals.size()) {
+						return false;
+					}
+					face.push_back(corner);
+				}
+
+				for (size_t i = 2; i < face.size(); i++) {
+					const Corner corners[3] = { face[0], face[i - 1], face[i] };
+					const glm::vec3 faceNormal = glm::cross(positions[corners[1].position] - positions[corners[0].position],
+						positions[corners[2].position] - positions[corners[0].position]);
+					const float length = glm::length(faceNormal);
+					for (const Corner& corner : corners) {
+						Vertex vertex = {};
+						vertex.position = positions[corner.position];
+						vertex.normal = corner.normal >= 0 ? normals[corner.normal] : (length > 0.0f ? faceNormal / length : glm::vec3(0.0f, 1.0f, 0.0f));
+						// OBJ 的 v 从下往上，Vulkan 的纹理从上往下
+						vertex.uv_x = corner.uv >= 0 ? uvs[corner.uv].x : 0.0f;
+						vertex.uv_y = corner.uv >= 0 ? 1.0f - uvs[corner.uv].y : 0.0f;
+						vertex.color = glm::vec3(1.0f);
+						out.push_back(vertex);
+					}
+				}
+			}
+		}
+		return !out.empty();
+	}
+
+	bool bake_mesh(const uint8_t* data, size_t size, std::vector<Section>& sections)
+	{
+		std::vector<Vertex> vertices;
+		if (!load_obj(data, size, vertices)) {
+			std::cout << "[ERROR] Failed to parse OBJ (or it has no faces)" << std::endl;
+			return false;
+		}
+
+		const vklod::MeshLodChain chain = vklod::build_chain(vertices, {});
+
+		vkasset::MeshInfo info = {};
+		info.vertexLayout = vkasset::VertexLayout::Full;
+		info.vertexCount = (uint32_t)chain.vertices.size();
+		info.indexCount = (uint32_t)chain.indices.size();
+		info.lodCount = (uint32_t)chain.lods.size();
+		info.center = chain.center;
+		info.radius = chain.radius;
+		std::copy(chain.lods.begin(), chain.lods.end(), info.lods);
+
+		sections.push_back(make_section(vkasset::SectionType::MeshInfo, &info, 1));
+		sections.push_back(make_section(vkasset::SectionType::Vertices, chain.vertices.data(), chain.vertices.size()));
+		sections.push_back(make_section(vkasset::SectionType::Indices, chain.indices.data(), chain.indices.size()));
+
+		std::cout << "[INFO] Mesh: " << vertices.size() / 3 << " triangles -> " << chain.vertices.size() << " vertices, " << chain.lods.size() << " LODs" << std::endl;
+		return true;
+	}
+
+	// ---------------- 纹理 ----------------
+
+	float srgb_to_linear(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float linear_to_srgb(float c)
+	{
+		return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+	}
+
+	// 2x2 盒式滤波 (奇数边 clamp)；sRGB 在线性空间里平均，alpha 始终线性
+	void build_mips(ImageData& image)
+	{
+		const bool srgb = image.format == VK_FORMAT_R8G8B8A8_SRGB;
+		std::vector<uint8_t> level(image.pixels.begin(), image.pixels.begin() + image.levels[0].size);
+		uint32_t width = image.width;
+		uint32_t height = image.height;
+
+		while (width > 1 || height > 1) {
+			const uint32_t nextWidth = std::max(width / 2, 1u);
+			const uint32_t nextHeight = std::max(height / 2, 1u);
+			std::vector<uint8_t> next((size_t)nextWidth * nextHeight * 4);
+			for (uint32_t y = 0; y < nextHeight; y++) {
+				for (uint32_t x = 0; x < nextWidth; x++) {
+					for (uint32_t c = 0; c < 4; c++) {
+						const bool convert = srgb && c < 3;
+						float sum = 0.0f;
+						for (uint32_t dy = 0; dy < 2; dy++) {
+							for (uint32_t dx = 0; dx < 2; dx++) {
+								const uint32_t sx = std::min(x * 2 + dx, width - 1);
+								const uint32_t sy = std::min(y * 2 + dy, height - 1);
+								const float value = level[((size_t)sy * width + sx) * 4 + c] / 255.0f;
+								sum += convert ? srgb_to_linear(value) : value;
+							}
+						}
+						const float average = sum * 0.25f;
+						const float encoded = convert ? linear_to_srgb(average) : average;
+						next[((size_t)y * nextWidth + x) * 4 + c] = (uint8_t)std::clamp(encoded * 255.0f + 0.5f, 0.0f, 255.0f);
+					}
+				}
+			}
+
+			image.levels.push_back({ (VkDeviceSize)image.pixels.size(), (VkDeviceSize)next.size(), nextWidth, nextHeight });
+			image.pixels.insert(image.pixels.end(), next.begin(), next.end());
+			level = std::move(next);
+			width = nextWidth;
+			height = nextHeight;
+		}
+		image.generateMips = false;
+	}
+
+	bool bake_texture(const char* path, const uint8_t* data, size_t size, bool srgb, std::vector<Section>& sections)
+	{
+		ImageData image;
+		if (!vkimage::decode(path, data, size, srgb, image)) {
+			return false;
+		}
+		const bool rgba8 = image.format == VK_FORMAT_R8G8B8A8_UNORM || image.format == VK_FORMAT_R8G8B8A8_SRGB;
+		if (image.generateMips && rgba8) {
+			image.pixels.resize(image.levels[0].size);
+			image.levels.resize(1);
+			build_mips(image);
+		}
+
+		vkasset::TextureInfo info = {};
+		info.format = image.format;
+		info.width = image.width;
+		info.height = image.height;
+		info.levelCount = (uint32_t)image.levels.size();
+		info.generateMips = image.generateMips ? 1 : 0;
+
+		sections.push_back(make_section(vkasset::SectionType::TextureInfo, &info, 1));
+		sections.push_back(make_section(vkasset::SectionType::Levels, image.levels.data(), image.levels.size()));
+		sections.push_back(make_section(vkasset::SectionType::Pixels, image.pixels.data(), image.pixels.size()));
+
+		std::cout << "[INFO] Texture: " << image.width << "x" << image.height << ", " << image.levels.size() << " mips"
+			<< (image.generateMips ? " (rest generated on GPU)" : "") << std::endl;
+		return true;
+	}
+
+	// 输出已经是同一个源 + 同样参数烘焙出来的
+	bool up_to_date(const char* path, uint64_t sourceHash)
+	{
+		MappedFile existing;
+		if (!existing.open(path) || !vkasset::is_asset(existing.data(), existing.size())) {
+			return false;
+		}
+		const vkasset::AssetHeader* header = reinterpret_cast<const vkasset::AssetHeader*>(existing.data());
+		return header->version == vkasset::ASSET_VERSION && header->sourceHash == sourceHash && header->fileSize == existing.size();
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	bool force = false;
+	bool srgb = true;
+	std::vector<const char*> paths;
+	for (int i = 1; i < argc; i++) {
+		const std::string_view arg(argv[i]);
+		if (arg == "--force") {
+			force = true;
+		}
+		else if (arg == "--linear") {
+			srgb = false;
+		}
+		else {
+			paths.push_back(argv[i]);
+		}
+	}
+	if (paths.size() != 2) {
+		std::cout << "Usage: AssetBaker [--force] [--linear] <output.vasset> <input.obj|input.tga|input.ktx2>" << std::endl;
+		return 1;
+	}
+	const char* outputPath = paths[0];
+	const char* inputPath = paths[1];
+
+	// 1. 源文件 + 参数的哈希，没变就不用重新烘焙
+	MappedFile source;
+	if (!source.open(inputPath)) {
+		std::cout << "[ERROR] Could not open " << inputPath << std::endl;
+		return 1;
+	}
+	const uint64_t settings[] = { BAKER_REVISION, vkasset::ASSET_VERSION, srgb ? 1u : 0u };
+	const uint64_t sourceHash = vkspirv::hash_fnv1a(source.data(), source.size(), vkspirv::hash_fnv1a(settings, sizeof(settings)));
+	if (!force && up_to_date(outputPath, sourceHash)) {
+		std::filesystem::last_write_time(outputPath, std::filesystem::file_time_type::clock::now());
+		std::cout << "[INFO] Up to date: " << outputPath << std::endl;
+		return 0;
+	}
+
+	// 2. 按扩展名烘焙成若干段
+	std::string extension = std::filesystem::path(inputPath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+
+	std::vector<Section> sections;
+	vkasset::AssetKind kind;
+	bool ok;
+	if (extension == ".obj") {
+		kind = vkasset::AssetKind::Mesh;
+		ok = bake_mesh(source.data(), source.size(), sections);
+	}
+	else if (extension == ".tga" || extension == ".ktx2") {
+		kind = vkasset::AssetKind::Texture;
+		ok = bake_texture(inputPath, source.data(), source.size(), srgb, sections);
+	}
+	else {
+		std::cout << "[ERROR] Unsupported input: " << inputPath << std::endl;
+		return 1;
+	}
+	if (!ok) {
+		return 1;
+	}
+
+	// 3. 布局：头 + 段表，之后每段对齐
+	vkasset::AssetHeader header = {};
+	header.magic = vkasset::ASSET_MAGIC;
+	header.version = vkasset::ASSET_VERSION;
+	header.kind = kind;
+	header.sectionCount = (uint32_t)sections.size();
+	header.sourceHash = sourceHash;
+
+	std::vector<vkasset::SectionEntry> entries(sections.size());
+	uint64_t cursor = sizeof(header) + sections.size() * sizeof(vkasset::SectionEntry);
+	for (size_t i = 0; i < sections.size(); i++) {
+		cursor = align_up(cursor, vkasset::ASSET_ALIGNMENT);
+		entries[i].type = sections[i].type;
+		entries[i].offset = cursor;
+		entries[i].size = sections[i].data.size();
+		entries[i].contentHash = vkspirv::hash_fnv1a(sections[i].data.data(), sections[i].data.size());
+		cursor += sections[i].data.size();
+	}
+	header.fileSize = align_up(cursor, vkasset::ASSET_ALIGNMENT);
+
+	std::vector<uint8_t> blob((size_t)header.fileSize, 0);
+	memcpy(blob.data(), &header, sizeof(header));
+	memcpy(blob.data() + sizeof(header), entries.data(), entries.size() * sizeof(vkasset::SectionEntry));
+	for (size_t i = 0; i < sections.size(); i++) {
+		if (!sections[i].data.empty()) {
+			memcpy(blob.data() + entries[i].offset, sections[i].data.data(), sections[i].data.size());
+		}
+	}
+
+	// 4. 先写临时文件再改名，烘焙中途失败不会留下半个输出
+	const std::string tempPath = std::string(outputPath) + ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out.is_open()) {
+			std::cout << "[ERROR] Could not open " << tempPath << " for writing" << std::endl;
+			return 1;
+		}
+		out.write((const char*)blob.data(), blob.size());
+		if (!out) {
+			std::cout << "[ERROR] Failed to write " << tempPath << std::endl;
+			return 1;
+		}
+	}
+	source.close();
+	std::error_code error;
+	std::filesystem::rename(tempPath, outputPath, error);
+	if (error) {
+		std::cout << "[ERROR] Could not replace " << outputPath << ": " << error.message() << std::endl;
+		return 1;
+	}
+
+	std::cout << "[INFO] Baked " << outputPath << ": " << sections.size() << " sections, " << blob.size() << " bytes" << std::endl;
+	return 0;
+}
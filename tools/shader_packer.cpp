@@ -0,0 +1,153 @@
+// ShaderPacker: 把 shaders/ 下编译好的 SPIR-V 打成一个带索引、带内容哈希的 shaders.pak
+// 用法: ShaderPacker <输出.pak> <输入.spv>...
+// 每个 shader 在打包时做一次反射，descriptor 绑定和 push constant 范围写进包里，运行时不用再解析
+#include "vk_spirv.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+	struct InputShader {
+		std::string name;
+		std::vector<uint32_t> code;
+		vkspirv::ShaderReflection reflection;
+		uint64_t contentHash;
+	};
+
+	bool read_spirv(const std::filesystem::path& path, std::vector<uint32_t>& out)
+	{
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) {
+			return false;
+		}
+		size_t fileSize = (size_t)file.tellg();
+		if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0) {
+			return false;
+		}
+		out.resize(fileSize / sizeof(uint32_t));
+		file.seekg(0);
+		file.read((char*)out.data(), fileSize);
+		return (bool)file;
+	}
+
+	uint64_t align_up(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3) {
+		std::cout << "Usage: ShaderPacker <output.pak> <input.spv>..." << std::endl;
+		return 1;
+	}
+
+	// 1. 读取并反射所有输入
+	std::vector<InputShader> shaders;
+	for (int i = 2; i < argc; i++) {
+		std::filesystem::path path(argv[i]);
+
+		InputShader shader;
+		shader.name = path.filename().string();
+		if (shader.name.size() > 4 && shader.name.ends_with(".spv")) {
+			shader.name.resize(shader.name.size() - 4);
+		}
+
+		if (!read_spirv(path, shader.code)) {
+			std::cout << "[ERROR] Could not read " << path.string() << std::endl;
+			return 1;
+		}
+		if (!vkspirv::reflect(shader.code.data(), shader.code.size(), shader.reflection)) {
+			std::cout << "[ERROR] Failed to reflect " << path.string() << std::endl;
+			return 1;
+		}
+		shader.contentHash = vkspirv::hash_fnv1a(shader.code.data(), shader.code.size() * sizeof(uint32_t));
+		shaders.push_back(std::move(shader));
+	}
+
+	// 按名字哈希排序，运行时二分查找
+	std::sort(shaders.begin(), shaders.end(), [](const InputShader& a, const InputShader& b) {
+		return vkspirv::hash_name(a.name) < vkspirv::hash_name(b.name);
+	});
+
+	// 2. 计算布局：头 -> 条目表 -> 绑定表 -> 名字 -> 代码 (内容相同的代码只存一份)
+	std::vector<vkspirv::PackEntry> entries(shaders.size());
+	std::vector<vkspirv::ReflectedBinding> bindings;
+	std::string strings;
+
+	for (size_t i = 0; i < shaders.size(); i++) {
+		const InputShader& shader = shaders[i];
+		vkspirv::PackEntry& entry = entries[i];
+		entry = {};
+		entry.nameHash = vkspirv::hash_name(shader.name);
+		entry.contentHash = shader.contentHash;
+		entry.codeSize = (uint32_t)(shader.code.size() * sizeof(uint32_t));
+		entry.nameOffset = (uint32_t)strings.size();
+		entry.nameLength = (uint32_t)shader.name.size();
+		entry.stage = shader.reflection.stage;
+		entry.firstBinding = (uint32_t)bindings.size();
+		entry.bindingCount = (uint32_t)shader.reflection.bindings.size();
+		entry.pushConstantOffset = shader.reflection.pushConstantOffset;
+		entry.pushConstantSize = shader.reflection.pushConstantSize;
+
+		strings += shader.name;
+		bindings.insert(bindings.end(), shader.reflection.bindings.begin(), shader.reflection.bindings.end());
+	}
+
+	vkspirv::PackHeader header = {};
+	header.magic = vkspirv::PACK_MAGIC;
+	header.version = vkspirv::PACK_VERSION;
+	header.entryCount = (uint32_t)entries.size();
+	header.bindingCount = (uint32_t)bindings.size();
+	header.entriesOffset = align_up(sizeof(header), vkspirv::PACK_ALIGNMENT);
+	header.bindingsOffset = align_up(header.entriesOffset + entries.size() * sizeof(vkspirv::PackEntry), vkspirv::PACK_ALIGNMENT);
+	header.stringsOffset = align_up(header.bindingsOffset + bindings.size() * sizeof(vkspirv::ReflectedBinding), vkspirv::PACK_ALIGNMENT);
+
+	uint64_t cursor = align_up(header.stringsOffset + strings.size(), vkspirv::PACK_ALIGNMENT);
+	std::unordered_map<uint64_t, uint64_t> codeByHash;
+	size_t deduplicated = 0;
+	for (size_t i = 0; i < shaders.size(); i++) {
+		auto it = codeByHash.find(entries[i].contentHash);
+		if (it != codeByHash.end()) {
+			entries[i].codeOffset = it->second;
+			deduplicated++;
+			continue;
+		}
+		entries[i].codeOffset = cursor;
+		codeByHash.emplace(entries[i].contentHash, cursor);
+		cursor = align_up(cursor + entries[i].codeSize, vkspirv::PACK_ALIGNMENT);
+	}
+	header.fileSize = cursor;
+
+	// 3. 写文件
+	std::vector<uint8_t> blob(header.fileSize, 0);
+	memcpy(blob.data(), &header, sizeof(header));
+	memcpy(blob.data() + header.entriesOffset, entries.data(), entries.size() * sizeof(vkspirv::PackEntry));
+	memcpy(blob.data() + header.bindingsOffset, bindings.data(), bindings.size() * sizeof(vkspirv::ReflectedBinding));
+	memcpy(blob.data() + header.stringsOffset, strings.data(), strings.size());
+	for (size_t i = 0; i < shaders.size(); i++) {
+		memcpy(blob.data() + entries[i].codeOffset, shaders[i].code.data(), entries[i].codeSize);
+	}
+
+	std::ofstream out(argv[1], std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		std::cout << "[ERROR] Could not open " << argv[1] << " for writing" << std::endl;
+		return 1;
+	}
+	out.write((const char*)blob.data(), blob.size());
+	if (!out) {
+		std::cout << "[ERROR] Failed to write " << argv[1] << std::endl;
+		return 1;
+	}
+
+	std::cout << "[INFO] Packed " << shaders.size() << " shaders (" << deduplicated << " deduplicated) into "
+		<< argv[1] << " (" << blob.size() << " bytes)" << std::endl;
+	return 0;
+}
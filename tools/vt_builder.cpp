@@ -0,0 +1,129 @@
+// VTBuilder: 把一张大纹理切成虚拟纹理页，生成 .vtex
+// 用法: VTBuilder <输出.vtex> <输入.tga|.ktx2> [页大小=128] [边=4]
+// 输入必须是 2 的幂的正方形 RGBA8 图像；mip 在这里用 2x2 盒式滤波生成，一直生成到只剩一页
+#include "vk_image_loader.h"
+#include "vk_page_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+
+	struct Mip {
+		uint32_t size;
+		std::vector<uint8_t> texels;
+	};
+
+	Mip downsample(const Mip& src)
+	{
+		Mip dst;
+		dst.size = src.size / 2;
+		dst.texels.resize((size_t)dst.size * dst.size * 4);
+		for (uint32_t y = 0; y < dst.size; y++) {
+			for (uint32_t x = 0; x < dst.size; x++) {
+				for (uint32_t c = 0; c < 4; c++) {
+					auto at = [&](uint32_t sx, uint32_t sy) { return (uint32_t)src.texels[((size_t)sy * src.size + sx) * 4 + c]; };
+					const uint32_t sum = at(2 * x, 2 * y) + at(2 * x + 1, 2 * y) + at(2 * x, 2 * y + 1) + at(2 * x + 1, 2 * y + 1);
+					dst.texels[((size_t)y * dst.size + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+				}
+			}
+		}
+		return dst;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3) {
+		std::cout << "Usage: VTBuilder <output.vtex> <input.tga|input.ktx2> [pageSize=128] [border=4]" << std::endl;
+		return 1;
+	}
+
+	const uint32_t pageSize = argc > 3 ? (uint32_t)std::stoul(argv[3]) : 128;
+	const uint32_t border = argc > 4 ? (uint32_t)std::stoul(argv[4]) : 4;
+
+	// 1. 读入源图像
+	ImageData image;
+	if (!vkimage::load(argv[2], true, image)) {
+		return 1;
+	}
+	if (image.format != VK_FORMAT_R8G8B8A8_UNORM && image.format != VK_FORMAT_R8G8B8A8_SRGB) {
+		std::cout << "[ERROR] Virtual textures must be built from RGBA8 images" << std::endl;
+		return 1;
+	}
+
+	const uint32_t size = image.width;
+	const bool powerOfTwo = (size & (size - 1)) == 0;
+	if (image.width != image.height || !powerOfTwo || pageSize == 0 || size < pageSize || size / pageSize > 4096) {
+		std::cout << "[ERROR] Input must be a square power-of-two image of at least one page ("
+			<< image.width << "x" << image.height << ", page " << pageSize << ")" << std::endl;
+		return 1;
+	}
+
+	// 2. 生成 mip 链，直到整张图只剩一页
+	std::vector<Mip> mips;
+	mips.push_back({ size, std::vector<uint8_t>(image.pixels.begin(), image.pixels.begin() + image.levels[0].size) });
+	while (mips.back().size > pageSize) {
+		mips.push_back(downsample(mips.back()));
+	}
+	if (mips.size() > vkvt::MAX_MIPS) {
+		std::cout << "[ERROR] Too many mip levels" << std::endl;
+		return 1;
+	}
+
+	// 3. 切页：每页四周带 border，越过图像边缘的部分 clamp
+	vkvt::VtexHeader header = {};
+	header.magic = vkvt::VTEX_MAGIC;
+	header.version = vkvt::VTEX_VERSION;
+	header.size = size;
+	header.pageSize = pageSize;
+	header.border = border;
+	header.mipCount = (uint32_t)mips.size();
+	header.format = image.format;
+
+	const uint32_t tileSize = pageSize + 2 * border;
+	header.tileBytes = tileSize * tileSize * 4;
+
+	uint32_t mipOffsets[vkvt::MAX_MIPS];
+	header.pageCount = vkvt::mip_offsets(size / pageSize, header.mipCount, mipOffsets);
+	header.pagesOffset = (sizeof(header) + 15) & ~15ull;
+
+	std::vector<uint8_t> blob(header.pagesOffset + (size_t)header.pageCount * header.tileBytes, 0);
+	memcpy(blob.data(), &header, sizeof(header));
+
+	for (uint32_t mip = 0; mip < header.mipCount; mip++) {
+		const Mip& level = mips[mip];
+		const uint32_t side = level.size / pageSize;
+		for (uint32_t py = 0; py < side; py++) {
+			for (uint32_t px = 0; px < side; px++) {
+				uint8_t* tile = blob.data() + header.pagesOffset + (size_t)(mipOffsets[mip] + py * side + px) * header.tileBytes;
+				for (uint32_t ty = 0; ty < tileSize; ty++) {
+					const int32_t sy = std::clamp((int32_t)(py * pageSize + ty) - (int32_t)border, 0, (int32_t)level.size - 1);
+					for (uint32_t tx = 0; tx < tileSize; tx++) {
+						const int32_t sx = std::clamp((int32_t)(px * pageSize + tx) - (int32_t)border, 0, (int32_t)level.size - 1);
+						memcpy(tile + ((size_t)ty * tileSize + tx) * 4, level.texels.data() + ((size_t)sy * level.size + sx) * 4, 4);
+					}
+				}
+			}
+		}
+	}
+
+	// 4. 写文件
+	std::ofstream out(argv[1], std::ios::binary | std::ios::trunc);
+	if (!out.is_open()) {
+		std::cout << "[ERROR] Could not open " << argv[1] << " for writing" << std::endl;
+		return 1;
+	}
+	out.write((const char*)blob.data(), blob.size());
+	if (!out) {
+		std::cout << "[ERROR] Failed to write " << argv[1] << std::endl;
+		return 1;
+	}
+
+	std::cout << "[INFO] Built " << argv[1] << ": " << size << "x" << size << ", " << header.mipCount << " mips, "
+		<< header.pageCount << " pages (" << blob.size() << " bytes)" << std::endl;
+	return 0;
+}
@@ -0,0 +1,112 @@
+// VTCacheCheck: 不用 GPU 驱动虚拟纹理的页缓存 (VirtualPageCache)，检查反馈解析、页表映射、LRU 淘汰和预算
+// 用法: VTCacheCheck  (全部通过返回 0；ctest 里也会跑)
+#include "vk_page_cache.h"
+
+#include <iostream>
+
+namespace {
+
+	uint32_t g_failures = 0;
+
+	void check(bool condition, const char* what)
+	{
+		if (!condition) {
+			std::cout << "[FAIL] " << what << std::endl;
+			g_failures++;
+		}
+	}
+
+	// 页表里 (mip, x, y) 这个虚拟页当前映射到的条目
+	uint32_t entry_at(const VirtualPageCache& cache, uint32_t sizeInPages, uint32_t mip, uint32_t x, uint32_t y)
+	{
+		return cache.entries()[cache.mip_offsets()[mip] + y * vkvt::pages_per_side(sizeInPages, mip) + x];
+	}
+
+	uint32_t expected_entry(const VirtualPageCache& cache, uint32_t slot, uint32_t mip)
+	{
+		return VirtualPageCache::pack_entry(cache.slot_x(slot), cache.slot_y(slot), mip);
+	}
+
+	// 分配一个槽位并把页放进去，返回槽位 (失败返回 UINT32_MAX)
+	uint32_t load(VirtualPageCache& cache, uint32_t page, uint64_t frameNumber, uint32_t& evicted, bool pinned = false)
+	{
+		uint32_t slot;
+		if (!cache.allocate_slot(frameNumber, slot, evicted)) {
+			return UINT32_MAX;
+		}
+		cache.make_resident(page, slot, frameNumber, pinned);
+		return slot;
+	}
+}
+
+int main()
+{
+	using vkvt::page_id;
+
+	// 4x4 页、3 个 mip (4x4 / 2x2 / 1x1)，物理缓存 2x2 = 4 个槽位
+	constexpr uint32_t SIZE = 4;
+	VirtualPageCache cache;
+	cache.init(SIZE, 3, 2);
+	check(cache.slot_count() == 4, "cache has 4 slots");
+	check(entry_at(cache, SIZE, 0, 3, 3) == vkvt::INVALID_PAGE, "empty page table is unmapped");
+
+	// 1. 缺一个最细的页：它和缺失的祖先都被请求，粗的在前；重复和越界的 ID 被忽略
+	std::pmr::vector<uint32_t> requests;
+	const uint32_t feedback[] = { page_id(0, 1, 1), page_id(0, 1, 1), vkvt::INVALID_PAGE, page_id(0, 7, 0), page_id(5, 0, 0) };
+	cache.process_feedback(feedback, std::size(feedback), 1, requests);
+	check(requests.size() == 3, "missing page requests itself and both ancestors");
+	check(requests.size() == 3 && requests[0] == page_id(2, 0, 0) && requests[1] == page_id(1, 0, 0) && requests[2] == page_id(0, 1, 1),
+		"requests are ordered coarsest first");
+
+	uint32_t evicted;
+	const uint32_t rootSlot = load(cache, page_id(2, 0, 0), 1, evicted);
+	const uint32_t midSlot = load(cache, page_id(1, 0, 0), 1, evicted);
+	const uint32_t fineSlot = load(cache, page_id(0, 1, 1), 1, evicted);
+	check(rootSlot != UINT32_MAX && midSlot != UINT32_MAX && fineSlot != UINT32_MAX, "free slots are handed out");
+	check(cache.resident_count() == 3, "three pages resident");
+
+	// 2. 页表：每个虚拟页映射到最细的驻留祖先
+	check(entry_at(cache, SIZE, 0, 1, 1) == expected_entry(cache, fineSlot, 0), "resident page maps to itself");
+	check(entry_at(cache, SIZE, 0, 0, 0) == expected_entry(cache, midSlot, 1), "sibling falls back to the resident parent");
+	check(entry_at(cache, SIZE, 0, 3, 3) == expected_entry(cache, rootSlot, 2), "far page falls back to the root");
+	check(entry_at(cache, SIZE, 1, 1, 1) == expected_entry(cache, rootSlot, 2), "coarser level maps to the root");
+
+	// 3. 命中的页刷新 LRU：第 3 帧用到 (0,1,1) 和根页，(1,0,0) 最久没用
+	const uint32_t lastSlot = load(cache, page_id(0, 0, 0), 2, evicted);
+	check(lastSlot != UINT32_MAX && evicted == vkvt::INVALID_PAGE, "last free slot is used without eviction");
+
+	requests.clear();
+	const uint32_t frame3[] = { page_id(0, 1, 1), page_id(0, 2, 2) };
+	cache.process_feedback(frame3, std::size(frame3), 3, requests);
+	check(requests.size() == 2 && requests[0] == page_id(1, 1, 1) && requests[1] == page_id(0, 2, 2),
+		"only the missing pages under a resident ancestor are requested");
+
+	// 4. 缓存满了：淘汰最久没用的页，原来映射到它的条目退回到它的父页
+	const uint32_t reused = load(cache, page_id(1, 1, 1), 3, evicted);
+	check(reused == midSlot && evicted == page_id(1, 0, 0), "least recently used page is evicted first");
+	check(!cache.is_resident(page_id(1, 0, 0)), "evicted page is no longer resident");
+	check(entry_at(cache, SIZE, 0, 1, 0) == expected_entry(cache, rootSlot, 2), "evicted subtree falls back to the parent");
+	check(entry_at(cache, SIZE, 0, 0, 0) == expected_entry(cache, lastSlot, 0), "finer resident page keeps its mapping");
+	check(entry_at(cache, SIZE, 0, 3, 3) == expected_entry(cache, reused, 1), "new page maps its subtree");
+
+	const uint32_t second = load(cache, page_id(0, 2, 2), 3, evicted);
+	check(second == lastSlot && evicted == page_id(0, 0, 0), "next eviction takes the next oldest page");
+
+	// 5. 预算：所有页这一帧都在用，装不下更多页时拒绝而不是淘汰正在用的页
+	uint32_t slot;
+	check(!cache.allocate_slot(3, slot, evicted), "pages used this frame are never evicted");
+	check(cache.allocate_slot(4, slot, evicted), "next frame the oldest page can be evicted again");
+
+	// 6. 固定页不进 LRU，永远不被淘汰
+	VirtualPageCache pinnedCache;
+	pinnedCache.init(SIZE, 3, 1);
+	check(load(pinnedCache, page_id(2, 0, 0), 1, evicted, true) != UINT32_MAX, "pinned page is loaded");
+	check(!pinnedCache.allocate_slot(100, slot, evicted), "pinned page is never evicted");
+
+	if (g_failures > 0) {
+		std::cout << "VTCacheCheck: " << g_failures << " checks failed" << std::endl;
+		return 1;
+	}
+	std::cout << "VTCacheCheck: all checks passed" << std::endl;
+	return 0;
+}